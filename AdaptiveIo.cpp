@@ -0,0 +1,100 @@
+// AdaptiveIo.cpp - Perfil de RX a partir da taxa observada (ver AdaptiveIo.h)
+
+#include "AdaptiveIo.h"
+
+#include <algorithm>
+#include <cmath>
+
+AdaptiveIo::AdaptiveIo(const AdaptiveIoConfig& cfg) : m_cfg(cfg) {
+    m_cfg.minBatchMs = std::max<uint32_t>(m_cfg.minBatchMs, 1);
+    m_cfg.maxBatchMs = std::max(m_cfg.maxBatchMs, m_cfg.minBatchMs);
+    m_cfg.maxChunk = std::max(m_cfg.maxChunk, m_cfg.minChunk);
+    m_cfg.maxQueue = std::max(m_cfg.maxQueue, m_cfg.minQueue);
+
+    // Antes de medir: a taxa nominal (se conhecida) já dimensiona o buffer e a
+    // fila do driver, que é melhor ajustada antes do primeiro byte.
+    double nominal = m_cfg.expectedBytesPerSec;
+    m_profile.readChunk = FitPow2(nominal * m_cfg.maxBatchMs / 1000.0 * 2, m_cfg.minChunk, m_cfg.maxChunk);
+    m_profile.rxQueue = nominal > 0 ? QueueFor(nominal) : 0;
+}
+
+uint32_t AdaptiveIo::FitPow2(double v, uint32_t lo, uint32_t hi) {
+    uint32_t p = 1;
+    while (p < v && p < hi) p <<= 1;
+    return std::min(std::max(p, lo), hi);
+}
+
+uint32_t AdaptiveIo::QueueFor(double bytesPerSec) const {
+    double ms = (double)m_cfg.queueMarginMs + m_profile.batchMs;
+    return FitPow2(bytesPerSec * ms / 1000.0, m_cfg.minQueue, m_cfg.maxQueue);
+}
+
+int64_t AdaptiveIo::NextReadNs(size_t bytes, int64_t nowNs) const {
+    if (bytes >= 2 * (size_t)m_cfg.targetReadBytes) return nowNs;
+    return nowNs + (int64_t)m_profile.batchMs * 1000000;
+}
+
+bool AdaptiveIo::OnRead(size_t bytes, int64_t nowNs) {
+    if (m_windowNs == 0) m_windowNs = nowNs;
+    m_reads++;
+    m_bytes += bytes;
+    if (bytes == 0) m_empty++;
+    m_maxRead = std::max(m_maxRead, bytes);
+    if (nowNs - m_windowNs < kEvalMs * 1000000) return false;
+
+    AdaptiveIoProfile before = m_profile;
+    Evaluate(nowNs);
+    m_windowNs = nowNs;
+    m_bytes = m_reads = m_empty = 0;
+    m_maxRead = 0;
+    if (m_profile == before) return false;
+    m_changes++;
+    return true;
+}
+
+void AdaptiveIo::Evaluate(int64_t nowNs) {
+    double secs = (double)(nowNs - m_windowNs) / 1e9;
+    double rate = (double)m_bytes / secs;
+    m_rate = m_haveRate ? 0.5 * m_rate + 0.5 * rate : rate;
+    m_haveRate = true;
+
+    // Intervalo que junta targetReadBytes na taxa atual.
+    uint32_t ideal = m_cfg.maxBatchMs;
+    if (m_rate > 0) {
+        double ms = std::ceil(m_cfg.targetReadBytes * 1000.0 / m_rate);
+        ideal = (uint32_t)std::min<double>(std::max<double>(ms, m_cfg.minBatchMs), m_cfg.maxBatchMs);
+    }
+
+    // Bem acima da taxa nominal: o link não é uma UART no baud configurado
+    // (CDC-ACM, pty) e o transmissor espera o leitor; ler em lote só o frearia.
+    bool readerPaced = m_cfg.expectedBytesPerSec > 0 && m_rate > 2.0 * m_cfg.expectedBytesPerSec;
+
+    uint32_t batch = m_profile.batchMs;
+    if (readerPaced) {
+        batch = 0;
+    }
+    else if (batch == 0) {
+        // Por evento: só troca se as leituras vêm pequenas e o lote faz no
+        // máximo metade delas.
+        double readsPerSec = (double)m_reads / secs;
+        double avgRead = m_reads ? (double)m_bytes / m_reads : 0;
+        if (readsPerSec >= m_cfg.enterReadsPerSec && avgRead * 2 < m_cfg.targetReadBytes &&
+            2000.0 / ideal <= readsPerSec)
+            batch = ideal;
+    }
+    else if (m_empty * 2 > m_reads) {
+        batch = 0;                                 // a maioria dos lotes veio vazia
+    }
+    else if (ideal * 4 > batch * 5 || ideal * 5 < batch * 4) {
+        batch = ideal;                             // taxa mudou mais de 25%
+    }
+    m_profile.batchMs = batch;
+
+    // Buffer: cresce na hora, encolhe só com folga de 4x.
+    double expected = m_rate * (batch ? batch : 1) / 1000.0;
+    uint32_t chunk = FitPow2(std::max(2 * expected, 2.0 * m_maxRead), m_cfg.minChunk, m_cfg.maxChunk);
+    if (chunk > m_profile.readChunk || chunk * 4 <= m_profile.readChunk) m_profile.readChunk = chunk;
+
+    uint32_t queue = QueueFor(m_rate);
+    if (queue > std::max(m_profile.rxQueue, m_cfg.minQueue)) m_profile.rxQueue = queue;
+}
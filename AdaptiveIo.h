@@ -0,0 +1,94 @@
+// AdaptiveIo.h - Ajuste do I/O de RX à taxa observada (uma porta)
+// Objetivo: não pagar o mesmo custo em 9600 baud e em 3 Mbaud. Com leitura
+//           por evento, cada chegada do driver acorda o reactor e gera uma
+//           leitura: em taxas altas são milhares de syscalls por segundo de
+//           poucas centenas de bytes, e a fila do driver (4 KB) enche em
+//           poucos ms se o reactor atrasar.
+//
+// O ajuste observa cada leitura (bytes, instante) e, a cada kEvalMs, decide:
+//  - Modo: por evento (padrão) ou lote. No lote a porta sai do epoll/IOCP e
+//    é lida por relógio a cada 'batchMs' (minBatchMs..maxBatchMs): cada
+//    leitura traz ~targetReadBytes e o atraso extra fica limitado a batchMs.
+//    Entra quando as leituras por evento passam de enterReadsPerSec e vêm
+//    pequenas; volta ao modo por evento quando a maioria das leituras do
+//    lote vem vazia (a taxa caiu) ou quando a taxa passa do dobro da nominal:
+//    aí o transmissor espera o leitor (USB CDC, pty) e o lote só o frearia.
+//  - Tamanho da leitura (buffer do reactor): 2x o maior lote esperado/visto,
+//    em potência de 2, entre minChunk e maxChunk.
+//  - Fila RX do driver: taxa x (queueMarginMs + batchMs), em potência de 2,
+//    entre minQueue e maxQueue. Só cresce (encolher com dados em trânsito é
+//    arriscado) e parte da taxa nominal (baud / 10) quando ela é conhecida.
+// Mudanças só valem com folga (histerese): o perfil não oscila a cada janela.
+//
+// Threads: só a thread do reactor que serve a porta usa o objeto.
+// Não depende de Win32.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+struct AdaptiveIoConfig {
+    bool     enabled = false;
+    uint32_t expectedBytesPerSec = 0;     // taxa nominal (baud / 10); 0 = desconhecida
+    uint32_t minBatchMs = 1;
+    uint32_t maxBatchMs = 5;              // atraso extra máximo aceito no modo lote
+    uint32_t targetReadBytes = 2048;      // lote pretendido por leitura
+    uint32_t enterReadsPerSec = 500;      // abaixo disto o modo por evento já é barato
+    uint32_t minChunk = 1024;
+    uint32_t maxChunk = 16 * 1024;        // = bloco do ChunkPool do reactor
+    uint32_t minQueue = 4096;
+    uint32_t maxQueue = 1024 * 1024;
+    uint32_t queueMarginMs = 100;         // atraso do leitor que a fila do driver absorve
+};
+
+struct AdaptiveIoProfile {
+    uint32_t batchMs = 0;                 // 0 = por evento
+    uint32_t readChunk = 0;               // bytes por ReadNow()
+    uint32_t rxQueue = 0;                 // fila RX do driver (0 = não mexer)
+
+    bool operator==(const AdaptiveIoProfile& o) const {
+        return batchMs == o.batchMs && readChunk == o.readChunk && rxQueue == o.rxQueue;
+    }
+    bool operator!=(const AdaptiveIoProfile& o) const { return !(*this == o); }
+};
+
+class AdaptiveIo {
+public:
+    static const int64_t kEvalMs = 100;
+
+    explicit AdaptiveIo(const AdaptiveIoConfig& cfg);
+
+    // Uma leitura de 'bytes' (0 = leitura do lote que veio vazia).
+    // true = o perfil mudou: aplicar Profile() antes da próxima leitura.
+    bool OnRead(size_t bytes, int64_t nowNs);
+
+    // Modo lote: quando ler de novo depois de uma leitura de 'bytes'. Mais de
+    // dois lotes = o driver está acumulando (taxa acima do previsto, ou o
+    // limite de 4 KB por read() da tty no Linux): lê de novo na hora.
+    int64_t NextReadNs(size_t bytes, int64_t nowNs) const;
+
+    const AdaptiveIoProfile& Profile() const { return m_profile; }
+    double BytesPerSec() const { return m_rate; }   // média móvel das janelas
+    uint64_t Changes() const { return m_changes; }
+
+    // Potência de 2 >= v, limitada a [lo, hi].
+    static uint32_t FitPow2(double v, uint32_t lo, uint32_t hi);
+
+private:
+    void Evaluate(int64_t nowNs);
+    uint32_t QueueFor(double bytesPerSec) const;
+
+    AdaptiveIoConfig m_cfg;
+    AdaptiveIoProfile m_profile;
+    double   m_rate = 0;
+    bool     m_haveRate = false;
+    uint64_t m_changes = 0;
+
+    // Janela atual:
+    int64_t  m_windowNs = 0;
+    uint64_t m_bytes = 0;
+    uint64_t m_reads = 0;
+    uint64_t m_empty = 0;
+    size_t   m_maxRead = 0;
+};
@@ -0,0 +1,1015 @@
+// Bench.cpp - Micro-benchmarks e loopback por pty (ver Bench.h)
+
+#include "Bench.h"
+
+#include "ChunkPool.h"
+#include "Crc16.h"
+#include "Framing.h"
+#include "HexDump.h"
+#include "MappedFile.h"
+#include "Metrics.h"
+#include "PreciseTimer.h"
+#include "Replay.h"
+#include "RxRing.h"
+#include "Scrollback.h"
+#include "ScrollbackSearch.h"
+#include "SerialPort.h"
+#include "SerialReactor.h"
+#include "SerialSession.h"
+#include "Telemetry.h"
+#include "Utf8Decoder.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#if defined(_WIN32)
+#include <windows.h>
+#endif
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+namespace {
+
+const size_t kPayloadBytes = 64 * 1024;    // dados por iteração
+const size_t kBlockBytes = 1024;           // = buffer do SerialReadLoop()
+
+// Impede o compilador de descartar o trabalho medido.
+volatile uint64_t g_sink = 0;
+
+// ============================================================================
+//                           Dados sintéticos
+// ============================================================================
+// xorshift64: mesma sequência em toda execução/plataforma.
+struct Rng {
+    uint64_t s = 0x9E3779B97F4A7C15ull;
+    uint32_t Next() {
+        s ^= s << 13;
+        s ^= s >> 7;
+        s ^= s << 17;
+        return (uint32_t)(s >> 16);
+    }
+};
+
+// Linhas de log típicas de firmware (só ASCII, CRLF).
+std::vector<uint8_t> MakeAsciiText(size_t size) {
+    Rng rng;
+    std::string s;
+    char line[128];
+    while (s.size() < size) {
+        uint32_t r = rng.Next();
+        snprintf(line, sizeof(line), "T=%08u ms  temp=%2u.%02u C  umid=%2u.%u %%  estado=%s\r\n",
+                 r, r % 40, r % 100, (r >> 8) % 100, (r >> 16) % 10, (r & 1) ? "OK" : "AGUARDANDO");
+        s += line;
+    }
+    s.resize(size);
+    return std::vector<uint8_t>(s.begin(), s.end());
+}
+
+// Telemetria a kHz: "t=... v=... i=..." (tempo, tensão, corrente).
+std::vector<uint8_t> MakeTelemetryText(size_t size) {
+    Rng rng;
+    std::string s;
+    char line[96];
+    for (uint32_t t = 0; s.size() < size; ++t) {
+        uint32_t r = rng.Next();
+        snprintf(line, sizeof(line), "t=%u v=%u.%03u i=%s0.%03u\r\n",
+                 t, 4 + (r & 1), r % 1000, (r & 2) ? "-" : "", (r >> 8) % 1000);
+        s += line;
+    }
+    s.resize(size);
+    return std::vector<uint8_t>(s.begin(), s.end());
+}
+
+// Texto com acentos, símbolos de 3 bytes e um emoji de 4 bytes de vez em quando.
+std::vector<uint8_t> MakeMixedUtf8(size_t size) {
+    static const char* const kWords[] = {
+        "ação ", "temperatura ", "25 °C ", "calibração ", "µs ", "→ ", "ok ",
+        "pressão ", "válvula ", "\xF0\x9F\x94\xA5 ", "estado ", "\r\n"
+    };
+    Rng rng;
+    std::string s;
+    while (s.size() < size) s += kWords[rng.Next() % (sizeof(kWords) / sizeof(kWords[0]))];
+    // Corta numa fronteira de caractere (não deixa sequência incompleta no fim).
+    size_t n = size;
+    while (n > 0 && ((uint8_t)s[n] & 0xC0) == 0x80) --n;
+    s.resize(n);
+    return std::vector<uint8_t>(s.begin(), s.end());
+}
+
+std::vector<uint8_t> MakeBinary(size_t size) {
+    Rng rng;
+    std::vector<uint8_t> v(size);
+    for (auto& b : v) b = (uint8_t)rng.Next();
+    return v;
+}
+
+// Frames binários de 20..200 bytes codificados em COBS (delimitador 0x00).
+std::vector<uint8_t> MakeCobsStream(size_t size) {
+    Rng rng;
+    std::vector<uint8_t> out;
+    while (out.size() < size) {
+        size_t n = 20 + rng.Next() % 181;
+        size_t codePos = out.size();
+        out.push_back(0);
+        uint8_t code = 1;
+        for (size_t i = 0; i < n; ++i) {
+            uint8_t b = (uint8_t)rng.Next();
+            if (b == 0) {
+                out[codePos] = code;
+                codePos = out.size();
+                out.push_back(0);
+                code = 1;
+                continue;
+            }
+            out.push_back(b);
+            if (++code == 0xFF) {
+                out[codePos] = code;
+                codePos = out.size();
+                out.push_back(0);
+                code = 1;
+            }
+        }
+        out[codePos] = code;
+        out.push_back(0);
+    }
+    return out;
+}
+
+// Mesmos tamanhos em SLIP (END = 0xC0, ESC = 0xDB).
+std::vector<uint8_t> MakeSlipStream(size_t size) {
+    Rng rng;
+    std::vector<uint8_t> out;
+    while (out.size() < size) {
+        size_t n = 20 + rng.Next() % 181;
+        for (size_t i = 0; i < n; ++i) {
+            uint8_t b = (uint8_t)rng.Next();
+            if (b == 0xC0) { out.push_back(0xDB); out.push_back(0xDC); }
+            else if (b == 0xDB) { out.push_back(0xDB); out.push_back(0xDD); }
+            else out.push_back(b);
+        }
+        out.push_back(0xC0);
+    }
+    return out;
+}
+
+// Mesmos tamanhos com cabeçalho de 2 bytes (little-endian) = tamanho do payload.
+std::vector<uint8_t> MakeLengthPrefixStream(size_t size) {
+    Rng rng;
+    std::vector<uint8_t> out;
+    while (out.size() < size) {
+        size_t n = 20 + rng.Next() % 181;
+        out.push_back((uint8_t)n);
+        out.push_back((uint8_t)(n >> 8));
+        for (size_t i = 0; i < n; ++i) out.push_back((uint8_t)rng.Next());
+    }
+    return out;
+}
+
+// Frames Modbus RTU de 8..64 bytes (endereço + função + dados + CRC), colados
+// sem silêncio entre eles: o pior caso para o corte só por CRC.
+std::vector<uint8_t> MakeModbusStream(size_t size) {
+    Rng rng;
+    std::vector<uint8_t> out;
+    while (out.size() < size) {
+        size_t start = out.size();
+        size_t n = 6 + rng.Next() % 57;
+        for (size_t i = 0; i < n; ++i) out.push_back((uint8_t)rng.Next());
+        uint16_t crc = Crc16Modbus(out.data() + start, n);
+        out.push_back((uint8_t)crc);
+        out.push_back((uint8_t)(crc >> 8));
+    }
+    return out;
+}
+
+// ============================================================================
+//                              Micro-benchmarks
+// ============================================================================
+bool Wanted(const BenchOptions& opt, const char* name) {
+    return opt.filter.empty() || strstr(name, opt.filter.c_str()) != nullptr;
+}
+
+// Roda 'fn' até completar minMs, 'repeats' vezes; fica com a melhor.
+template <class Fn>
+BenchMicroResult Measure(const BenchOptions& opt, const char* name, uint64_t bytesPerIter, Fn&& fn) {
+    BenchMicroResult r;
+    r.name = name;
+    r.bytesPerIter = bytesPerIter;
+
+    fn();                                           // aquecimento (caches, alocações)
+    const int64_t minNs = (int64_t)opt.minMs * 1000000;
+    int repeats = opt.repeats > 0 ? opt.repeats : 1;
+    for (int rep = 0; rep < repeats; ++rep) {
+        uint64_t iters = 0;
+        int64_t t0 = PreciseTimer::NowNs();
+        int64_t elapsed = 0;
+        do {
+            fn();
+            ++iters;
+            elapsed = PreciseTimer::NowNs() - t0;
+        } while (elapsed < minNs);
+        double perIter = (double)elapsed / (double)iters;
+        if (r.bestNsPerIter == 0 || perIter < r.bestNsPerIter) {
+            r.bestNsPerIter = perIter;
+            r.iterations = iters;
+        }
+    }
+    r.mbPerSec = r.bestNsPerIter > 0 ? (double)bytesPerIter * 1e3 / r.bestNsPerIter : 0;
+    return r;
+}
+
+// Framer alimentado em blocos de 1 KB. Inclui a cópia do bloco (a decodificação
+// é no lugar), como DrainRxRing() faz ao tirar os bytes do ring.
+template <class Framer>
+BenchMicroResult MeasureFramer(const BenchOptions& opt, const char* name, const std::vector<uint8_t>& data) {
+    Framer framer;
+    std::vector<uint8_t> work(kBlockBytes);
+    return Measure(opt, name, data.size(), [&] {
+        uint64_t acc = 0;
+        for (size_t off = 0; off < data.size(); off += kBlockBytes) {
+            size_t n = std::min(kBlockBytes, data.size() - off);
+            memcpy(work.data(), data.data() + off, n);
+            framer.Feed(work.data(), n, [&](const FrameSpan& f) { acc += f.len; });
+        }
+        g_sink += acc;
+    });
+}
+
+}  // namespace
+
+std::vector<BenchMicroResult> RunMicroBenchmarks(const BenchOptions& opt) {
+    std::vector<BenchMicroResult> results;
+    const std::vector<uint8_t> ascii = MakeAsciiText(kPayloadBytes);
+    const std::vector<uint8_t> mixed = MakeMixedUtf8(kPayloadBytes);
+    const std::vector<uint8_t> binary = MakeBinary(kPayloadBytes);
+
+    // ---- Decodificação UTF-8 (Utf8ToWide/SerialReadLoop) ----
+    auto decode = [&](const char* name, const std::vector<uint8_t>& data) {
+        if (!Wanted(opt, name)) return;
+        Utf8Decoder dec;
+        std::wstring out;
+        out.reserve(Utf8Decoder::MaxOutput(kBlockBytes));
+        results.push_back(Measure(opt, name, data.size(), [&] {
+            uint64_t acc = 0;
+            for (size_t off = 0; off < data.size(); off += kBlockBytes) {
+                out.clear();
+                dec.Decode((const char*)data.data() + off, std::min(kBlockBytes, data.size() - off), out);
+                acc += out.size();
+            }
+            g_sink += acc;
+        }));
+    };
+    decode("utf8_decode_ascii", ascii);
+    decode("utf8_decode_mixed", mixed);
+
+#if defined(_WIN32)
+    // Referência: o caminho anterior ao Utf8Decoder (Utf8ToWide() no
+    // DrainRxRing): MultiByteToWideChar em duas passadas e uma wstring nova
+    // por bloco. Sequências partidas entre blocos viram U+FFFD aqui.
+    auto decodeWin32 = [&](const char* name, const std::vector<uint8_t>& data) {
+        if (!Wanted(opt, name)) return;
+        results.push_back(Measure(opt, name, data.size(), [&] {
+            uint64_t acc = 0;
+            for (size_t off = 0; off < data.size(); off += kBlockBytes) {
+                const char* p = (const char*)data.data() + off;
+                int bytes = (int)std::min(kBlockBytes, data.size() - off);
+                int wlen = MultiByteToWideChar(CP_UTF8, 0, p, bytes, nullptr, 0);
+                std::wstring w(wlen, 0);
+                MultiByteToWideChar(CP_UTF8, 0, p, bytes, &w[0], wlen);
+                acc += w.size();
+            }
+            g_sink += acc;
+        }));
+    };
+    decodeWin32("utf8_decode_ascii_mbtowc", ascii);
+    decodeWin32("utf8_decode_mixed_mbtowc", mixed);
+#endif
+
+    // ---- HexDump (view HEX e dumps de captura) ----
+    HexDumpOptions hexOpt;
+    if (Wanted(opt, "hexdump_char")) {
+        std::vector<char> out(HexDumpBound(kBlockBytes, hexOpt));
+        results.push_back(Measure(opt, "hexdump_char", binary.size(), [&] {
+            uint64_t acc = 0;
+            for (size_t off = 0; off < binary.size(); off += kBlockBytes)
+                acc += HexDumpFormat(binary.data() + off, kBlockBytes, out.data(), hexOpt);
+            g_sink += acc;
+        }));
+    }
+    if (Wanted(opt, "hexdump_wchar")) {
+        std::vector<wchar_t> out(HexDumpBound(kBlockBytes, hexOpt));
+        results.push_back(Measure(opt, "hexdump_wchar", binary.size(), [&] {
+            uint64_t acc = 0;
+            for (size_t off = 0; off < binary.size(); off += kBlockBytes)
+                acc += HexDumpFormat(binary.data() + off, kBlockBytes, out.data(), hexOpt);
+            g_sink += acc;
+        }));
+    }
+
+    // ---- CRC e framing ----
+    if (Wanted(opt, "crc16_slice8"))
+        results.push_back(Measure(opt, "crc16_slice8", binary.size(), [&] {
+            g_sink += Crc16Modbus(binary.data(), binary.size());
+        }));
+    if (Wanted(opt, "crc16_bytewise"))
+        results.push_back(Measure(opt, "crc16_bytewise", binary.size(), [&] {
+            g_sink += Crc16ModbusBytewise(binary.data(), binary.size());
+        }));
+    if (Wanted(opt, "frame_line"))
+        results.push_back(MeasureFramer<LineFramer>(opt, "frame_line", ascii));
+    if (Wanted(opt, "frame_cobs"))
+        results.push_back(MeasureFramer<CobsFramer>(opt, "frame_cobs", MakeCobsStream(kPayloadBytes)));
+    if (Wanted(opt, "frame_slip"))
+        results.push_back(MeasureFramer<SlipFramer>(opt, "frame_slip", MakeSlipStream(kPayloadBytes)));
+    if (Wanted(opt, "frame_length_prefix"))
+        results.push_back(MeasureFramer<LengthPrefixFramer<2>>(opt, "frame_length_prefix", MakeLengthPrefixStream(kPayloadBytes)));
+    if (Wanted(opt, "frame_modbus"))
+        results.push_back(MeasureFramer<ModbusRtuFramer>(opt, "frame_modbus", MakeModbusStream(kPayloadBytes)));
+
+    // ---- Scrollback (AppendToTerminal) ----
+    // Limite pequeno para medir o regime com descarte das linhas antigas.
+    if (Wanted(opt, "scrollback_append")) {
+        std::wstring text;
+        Utf8Decoder dec;
+        dec.Decode((const char*)ascii.data(), ascii.size(), text);
+        Scrollback sb(16u * 1024 * 1024);
+        results.push_back(Measure(opt, "scrollback_append", ascii.size(), [&] {
+            for (size_t off = 0; off < text.size(); off += kBlockBytes)
+                sb.Append(text.data() + off, std::min(kBlockBytes, text.size() - off));
+            g_sink += sb.LineCount();
+        }));
+    }
+
+    // ---- Histórico frio: compressão (timer da UI) e leitura de volta ----
+    // 4 blocos de texto; só o último fica quente. Inclui o Append().
+    if (Wanted(opt, "scrollback_compact") || Wanted(opt, "scrollback_cold_read")) {
+        std::wstring text;
+        Utf8Decoder dec;
+        for (int i = 0; i < 4; ++i) dec.Decode((const char*)ascii.data(), ascii.size(), text);
+        if (Wanted(opt, "scrollback_compact")) {
+            Scrollback sb(64u * 1024 * 1024);
+            sb.SetHotChunks(1);
+            results.push_back(Measure(opt, "scrollback_compact", text.size(), [&] {
+                sb.Clear();
+                sb.Append(text);
+                sb.Compact(SIZE_MAX);
+                g_sink += sb.RetainedBytes();
+            }));
+        }
+        if (Wanted(opt, "scrollback_cold_read")) {
+            Scrollback sb(0);
+            sb.SetHotChunks(1);
+            sb.Append(text);
+            sb.Compact(SIZE_MAX);
+            results.push_back(Measure(opt, "scrollback_cold_read", text.size(), [&] {
+                uint64_t acc = 0;
+                const wchar_t* p;
+                size_t n;
+                for (uint64_t line = sb.FirstLine(); line < sb.EndLine(); ++line)
+                    if (sb.GetLine(line, &p, &n)) acc += n;
+                g_sink += acc;
+            }));
+        }
+    }
+
+    // ---- Índice de busca (timer da UI) e consulta sobre ~16 MB retidos ----
+    if (Wanted(opt, "search_index") || Wanted(opt, "search_query")) {
+        std::wstring text;
+        Utf8Decoder dec;
+        dec.Decode((const char*)ascii.data(), ascii.size(), text);
+        Scrollback sb(16u * 1024 * 1024);
+        ScrollbackIndex index(sb);
+        if (Wanted(opt, "search_index"))
+            results.push_back(Measure(opt, "search_index", ascii.size(), [&] {
+                sb.Append(text);
+                index.Update(SIZE_MAX);
+                g_sink += index.IndexedEnd();
+            }));
+
+        // Consulta que não casa em nenhum bloco: custo do índice, não da verificação.
+        while (sb.RetainedBytes() < 15u * 1024 * 1024) sb.Append(text);
+        index.Update(SIZE_MAX);
+        SearchQuery q;
+        q.text = L"estado=FALHA";
+        SearchMatcher m;
+        m.Compile(q, nullptr);
+        if (Wanted(opt, "search_query"))
+            results.push_back(Measure(opt, "search_query", sb.RetainedBytes(), [&] {
+                uint64_t line = 0;
+                g_sink += index.Find(m, sb.FirstLine(), true, &line) ? line : 1;
+            }));
+    }
+
+    // ---- Telemetria: extração dos valores (DrainRxRing) e um quadro do gráfico ----
+    if (Wanted(opt, "telemetry_parse")) {
+        const std::vector<uint8_t> tele = MakeTelemetryText(kPayloadBytes);
+        TelemetryStore store;
+        LineFramer framer;
+        std::vector<uint8_t> work(kBlockBytes);
+        results.push_back(Measure(opt, "telemetry_parse", tele.size(), [&] {
+            uint64_t acc = 0;
+            for (size_t off = 0; off < tele.size(); off += kBlockBytes) {
+                size_t n = std::min(kBlockBytes, tele.size() - off);
+                memcpy(work.data(), tele.data() + off, n);
+                framer.Feed(work.data(), n, [&](const FrameSpan& f) { acc += store.FeedLine(f.data, f.len); });
+            }
+            g_sink += acc;
+        }));
+    }
+    // 4 M amostras num canal em 1000 colunas de pixel: "bytes" = amostras
+    // cobertas (4 por float), para ver que o custo não cresce com elas.
+    if (Wanted(opt, "telemetry_plot")) {
+        TelemetryChannel ch("v", TelemetryStore::kDefaultSamples);
+        Rng rng;
+        for (size_t i = 0; i < TelemetryStore::kDefaultSamples; ++i) ch.Push((float)(rng.Next() % 10000) * 1e-3f);
+        std::vector<MinMax> cols(1000);
+        results.push_back(Measure(opt, "telemetry_plot", TelemetryStore::kDefaultSamples * sizeof(float), [&] {
+            DecimateMinMax(ch, ch.FirstIndex(), ch.EndIndex(), cols.size(), cols.data());
+            g_sink += (uint64_t)cols[0].max;
+        }));
+    }
+
+    // ---- RxRing (SerialReadLoop -> DrainRxRing), uma thread só ----
+    if (Wanted(opt, "rxring_write_read")) {
+        RxRing ring(1 << 20);
+        std::vector<uint8_t> out(kBlockBytes);
+        results.push_back(Measure(opt, "rxring_write_read", binary.size(), [&] {
+            uint64_t acc = 0;
+            for (size_t off = 0; off < binary.size(); off += kBlockBytes) {
+                ring.Write(binary.data() + off, kBlockBytes);
+                acc += ring.Read(out.data(), out.size());
+            }
+            g_sink += acc;
+        }));
+    }
+
+    // ---- Leitura entregue a dois consumidores (tela + captura) ----
+    // Antes: cada consumidor copiava o bloco para o seu ring. Agora: o bloco
+    // é lido uma vez num ChunkPool e cada fila guarda um RxSpan.
+    if (Wanted(opt, "rx_fanout_copy")) {
+        RxRing ui(1 << 20), cap(1 << 20);
+        std::vector<uint8_t> in(kBlockBytes), out(kBlockBytes);
+        results.push_back(Measure(opt, "rx_fanout_copy", binary.size(), [&] {
+            uint64_t acc = 0;
+            for (size_t off = 0; off < binary.size(); off += kBlockBytes) {
+                memcpy(in.data(), binary.data() + off, kBlockBytes);         // o read() do driver
+                ui.Write(in.data(), kBlockBytes);
+                cap.Write(in.data(), kBlockBytes);
+                acc += ui.Read(out.data(), out.size());
+                acc += cap.Read(out.data(), out.size());
+            }
+            g_sink += acc;
+        }));
+    }
+    if (Wanted(opt, "rx_fanout_span")) {
+        ChunkPool pool(SerialReactor::kChunkBytes, 16);
+        RxSpanQueue ui(1 << 20), cap(1 << 20);
+        results.push_back(Measure(opt, "rx_fanout_span", binary.size(), [&] {
+            uint64_t acc = 0;
+            RxChunk* chunk = nullptr;
+            size_t used = pool.ChunkBytes();
+            RxSpan span;
+            for (size_t off = 0; off < binary.size(); off += kBlockBytes) {
+                if (used + kBlockBytes > pool.ChunkBytes()) {
+                    if (chunk) ChunkPool::Release(chunk);
+                    chunk = pool.Acquire();
+                    used = 0;
+                }
+                memcpy(chunk->data + used, binary.data() + off, kBlockBytes);   // o read() do driver
+                RxSpan in(chunk, chunk->data + used, kBlockBytes);
+                used += kBlockBytes;
+                ui.Push(in);
+                cap.Push(in);
+                if (ui.Pop(&span)) acc += span.Data()[0] + span.Size();
+                if (cap.Pop(&span)) acc += span.Data()[0] + span.Size();
+            }
+            span.Reset();
+            if (chunk) ChunkPool::Release(chunk);
+            g_sink += acc;
+        }));
+    }
+
+    // ---- Métricas por leitura (SerialSession::OnRxData), custo por bloco ----
+    if (Wanted(opt, "metrics_record_read")) {
+        RxMetrics m;
+        results.push_back(Measure(opt, "metrics_record_read", binary.size(), [&] {
+            for (size_t off = 0; off < binary.size(); off += kBlockBytes)
+                m.RecordRead(kBlockBytes - ((off / kBlockBytes) & 1023));   // tamanhos variados, várias faixas
+            g_sink += m.reads.load(std::memory_order_relaxed);
+        }));
+    }
+
+    // ---- Captura de campo (--replay=arquivo.scap): ReplayToSink em
+    // velocidade máxima -> LineFramer -> Utf8Decoder, como o RX de uma aba ----
+    if (!opt.replayPath.empty() && Wanted(opt, "replay_decode")) {
+        ReplayOptions ro;
+        ro.mode = ReplayMode::MaxSpeed;
+        LineFramer framer;
+        Utf8Decoder dec;
+        std::wstring text;
+        std::vector<uint8_t> work;
+        uint64_t acc = 0;
+        auto sink = [&](const uint8_t* p, size_t n) {
+            work.assign(p, p + n);                  // o framer decodifica no lugar
+            framer.Feed(work.data(), n, [&](const FrameSpan& f) {
+                text.clear();
+                dec.Decode((const char*)f.data, f.len, text);
+                acc += text.size();
+            });
+        };
+        ReplayStats rs;
+        std::string error;
+        if (!ReplayToSink(opt.replayPath, ro, sink, &rs, &error)) {
+            fprintf(stderr, "replay_decode: %s: %s\n", opt.replayPath.c_str(), error.c_str());
+        }
+        else {
+            results.push_back(Measure(opt, "replay_decode", rs.bytes, [&] {
+                ReplayToSink(opt.replayPath, ro, sink, nullptr);
+                g_sink += acc;
+            }));
+        }
+    }
+    return results;
+}
+
+// ============================================================================
+//                       Loopback por pseudo-terminal
+// ============================================================================
+#if defined(__linux__)
+
+namespace {
+
+// Cada escrita do produtor é um registro de 'chunk' bytes:
+//   magic (4) | seq (4) | sendNs (8) | enchimento
+const uint32_t kRecordMagic = 0x4B4E4253;  // "SBNK"
+const size_t kRecordHeader = 16;
+
+// Consumidor: remonta os registros (o pty junta/parte as escritas à vontade)
+// e mede a latência até o byte ficar visível para quem drena o ring.
+struct LoopbackConsumer {
+    size_t chunk = 0;
+    std::vector<uint8_t> acc;
+    std::vector<int64_t> latencies;
+    uint32_t nextSeq = 0;
+    uint64_t records = 0;
+    uint64_t lost = 0;
+
+    void Feed(const uint8_t* data, size_t len, int64_t nowNs) {
+        acc.insert(acc.end(), data, data + len);
+        size_t pos = 0;
+        while (acc.size() - pos >= kRecordHeader) {
+            uint32_t magic;
+            memcpy(&magic, acc.data() + pos, 4);
+            if (magic != kRecordMagic) {        // perda no meio de um registro: ressincroniza
+                ++pos;
+                continue;
+            }
+            if (acc.size() - pos < chunk) break;
+            uint32_t seq;
+            int64_t sendNs;
+            memcpy(&seq, acc.data() + pos + 4, 4);
+            memcpy(&sendNs, acc.data() + pos + 8, 8);
+            if (seq > nextSeq) lost += seq - nextSeq;
+            nextSeq = seq + 1;
+            latencies.push_back(nowNs - sendNs);
+            ++records;
+            pos += chunk;
+        }
+        acc.erase(acc.begin(), acc.begin() + pos);
+    }
+};
+
+double PercentileUs(std::vector<int64_t>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t i = (size_t)(p * (double)(sorted.size() - 1) + 0.5);
+    return (double)sorted[i] / 1000.0;
+}
+
+// Um par de pseudo-terminais: o mestre é o "dispositivo", o escravo é a porta.
+struct LoopbackPort {
+    int master = -1;
+    std::unique_ptr<SerialSession> session;
+    LoopbackConsumer consumer;
+    uint32_t seq = 0;
+    uint64_t sent = 0;
+    uint64_t received = 0;
+};
+
+bool OpenLoopbackPort(LoopbackPort* p, uint32_t id, SerialReactor* reactor, const SessionEvents& events,
+                      const AdaptiveIoConfig& adaptive, const BenchOptions& opt, std::string* error) {
+    p->master = posix_openpt(O_RDWR | O_NOCTTY);
+    char slaveName[128];
+    if (p->master < 0 || grantpt(p->master) != 0 || unlockpt(p->master) != 0 ||
+        ptsname_r(p->master, slaveName, sizeof(slaveName)) != 0) {
+        *error = std::string("posix_openpt: ") + strerror(errno);
+        return false;
+    }
+    p->session.reset(new SerialSession(id, reactor, events, opt.ringBytes));
+    p->session->SetAdaptiveIo(adaptive);
+    if (!p->session->Open(slaveName, SerialConfig())) {
+        *error = p->session->LastError();
+        return false;
+    }
+    return true;
+}
+
+// 'ports' portas no mesmo SerialReactor, cada uma recebendo 'rate' bytes/s em
+// escritas de 'chunk' bytes. O consumo é UMA thread drenando todas as
+// sessões, como a thread da UI.
+BenchLoopbackResult RunLoopbackOnce(const BenchOptions& opt, uint32_t ports, uint32_t rate, uint32_t chunk,
+                                    bool adaptive) {
+    BenchLoopbackResult r;
+    r.ports = ports;
+    r.rate = rate;
+    r.chunk = chunk;
+    r.adaptive = adaptive;
+    if (chunk < kRecordHeader) {
+        r.error = "chunk minimo de 16 bytes (cabecalho do registro)";
+        return r;
+    }
+
+    SerialReactor reactor;
+    if (!reactor.Start(opt.reactorThreads)) {
+        r.error = reactor.LastError();
+        return r;
+    }
+
+    std::mutex lock;
+    std::condition_variable wake;
+    bool pending = false;                       // como o PostMessage coalescido da GUI
+    bool stop = false;
+    SessionEvents events;
+    events.rxReady = [&](uint32_t) {
+        std::lock_guard<std::mutex> g(lock);
+        if (!pending) {
+            pending = true;
+            wake.notify_one();
+        }
+    };
+
+    AdaptiveIoConfig adaptiveCfg;
+    adaptiveCfg.enabled = adaptive;
+    adaptiveCfg.expectedBytesPerSec = rate;     // sem limite: o baud padrão (115200) do pty
+    std::vector<LoopbackPort> lp(ports);
+    for (uint32_t i = 0; i < ports; ++i) {
+        lp[i].consumer.chunk = chunk;
+        if (rate) lp[i].consumer.latencies.reserve((size_t)(opt.loopbackSeconds * rate / chunk) + 1024);
+        if (r.error.empty()) OpenLoopbackPort(&lp[i], i + 1, &reactor, events, adaptiveCfg, opt, &r.error);
+    }
+    auto closeAll = [&] {
+        for (LoopbackPort& p : lp) {
+            if (p.session) p.session->Close();
+            if (p.master >= 0) close(p.master);
+        }
+        reactor.Stop();
+    };
+    if (!r.error.empty()) {
+        closeAll();
+        return r;
+    }
+
+    std::atomic<uint64_t> received{ 0 };
+    std::atomic<int64_t> lastRecvNs{ 0 };
+    std::thread drain([&] {
+        RxSpan span;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> g(lock);
+                wake.wait(g, [&] { return pending || stop; });
+                if (!pending && stop) break;
+                pending = false;
+            }
+            for (LoopbackPort& p : lp) {
+                p.session->AckRxReady();
+                while (p.session->Rx().Pop(&span)) {
+                    int64_t now = PreciseTimer::NowNs();
+                    size_t n = span.Size();
+                    p.consumer.Feed(span.Data(), n, now);
+                    span.Reset();
+                    p.received += n;
+                    received.fetch_add(n, std::memory_order_relaxed);
+                    lastRecvNs.store(now, std::memory_order_relaxed);
+                }
+            }
+        }
+    });
+
+    // Produção nos mestres, no ritmo pedido (PreciseTimer, não sleep): a cada
+    // intervalo, um registro para cada porta.
+    std::vector<uint8_t> record(chunk);
+    for (size_t i = kRecordHeader; i < chunk; ++i) record[i] = (uint8_t)('A' + i % 26);
+    PreciseTimer timer;
+    const int64_t intervalNs = rate ? (int64_t)((double)chunk * 1e9 / rate) : 0;
+    ReactorStats before = reactor.Stats();
+    const int64_t t0 = PreciseTimer::NowNs();
+    const int64_t tEnd = t0 + (int64_t)(opt.loopbackSeconds * 1e9);
+    int64_t due = t0;
+    while (r.error.empty() && PreciseTimer::NowNs() < tEnd) {
+        if (intervalNs) {
+            timer.SleepUntil(due);
+            due += intervalNs;
+        }
+        for (LoopbackPort& p : lp) {
+            int64_t now = PreciseTimer::NowNs();
+            memcpy(record.data(), &kRecordMagic, 4);
+            memcpy(record.data() + 4, &p.seq, 4);
+            memcpy(record.data() + 8, &now, 8);
+            size_t off = 0;
+            while (off < chunk) {
+                ssize_t w = write(p.master, record.data() + off, chunk - off);
+                if (w < 0 && errno == EINTR) continue;
+                if (w <= 0) {
+                    r.error = std::string("write(pty): ") + strerror(errno);
+                    break;
+                }
+                off += (size_t)w;
+            }
+            p.sent += off;
+            r.sentBytes += off;
+            if (off < chunk) break;
+            ++p.seq;
+        }
+    }
+
+    // Dá até 1 s para o que está nos ptys/rings chegar ao consumidor.
+    auto ringDropped = [&] {
+        uint64_t d = 0;
+        for (LoopbackPort& p : lp) d += p.session->Rx().DroppedBytes();
+        return d;
+    };
+    const int64_t drainEnd = PreciseTimer::NowNs() + 1000000000;
+    while (received.load() + ringDropped() < r.sentBytes && PreciseTimer::NowNs() < drainEnd)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    const int64_t tStop = PreciseTimer::NowNs();
+    ReactorStats after = reactor.Stats();
+    r.batchedPorts = after.batchedPorts;
+    r.poolHighWater = reactor.PoolStats().highWater;
+    r.poolHeapAllocs = after.chunkHeapAllocs;
+
+    r.ringDroppedBytes = ringDropped();
+    closeAll();
+    {
+        std::lock_guard<std::mutex> g(lock);
+        stop = true;
+        wake.notify_one();
+    }
+    drain.join();
+
+    r.receivedBytes = received.load();
+    r.droppedBytes = r.sentBytes > r.receivedBytes ? r.sentBytes - r.receivedBytes : 0;
+    std::vector<int64_t> lat;
+    for (LoopbackPort& p : lp) {
+        r.records += p.consumer.records;
+        r.lostRecords += p.seq > p.consumer.records ? p.seq - p.consumer.records : 0;
+        lat.insert(lat.end(), p.consumer.latencies.begin(), p.consumer.latencies.end());
+    }
+    int64_t last = lastRecvNs.load();
+    r.seconds = last > t0 ? (double)(last - t0) / 1e9 : 0;
+    r.mbPerSec = r.seconds > 0 ? (double)r.receivedBytes / r.seconds / 1e6 : 0;
+
+    // Portas por núcleo: quantas portas iguais a estas um núcleo inteiro do
+    // reactor aguentaria, extrapolando a CPU gasta nesta rodada.
+    r.reactorCpuSeconds = (double)(after.cpuNs - before.cpuNs) / 1e9;
+    double wall = (double)(tStop - t0) / 1e9;
+    double coreFraction = wall > 0 ? r.reactorCpuSeconds / wall : 0;
+    r.portsPerCore = coreFraction > 0 ? ports / coreFraction : 0;
+
+    uint64_t reads = after.reads - before.reads;
+    uint64_t syscalls = (after.wakeups - before.wakeups) + reads + (after.emptyReads - before.emptyReads);
+    r.syscallsPerSec = wall > 0 ? (double)syscalls / wall : 0;
+    r.readsPerSec = wall > 0 ? (double)reads / wall : 0;
+    r.bytesPerRead = reads ? (double)(after.bytes - before.bytes) / reads : 0;
+    r.profileChanges = after.profileChanges - before.profileChanges;
+
+    std::sort(lat.begin(), lat.end());
+    r.p50Us = PercentileUs(lat, 0.50);
+    r.p99Us = PercentileUs(lat, 0.99);
+    r.p999Us = PercentileUs(lat, 0.999);
+    r.maxUs = lat.empty() ? 0 : (double)lat.back() / 1000.0;
+    return r;
+}
+
+}  // namespace
+
+std::vector<BenchLoopbackResult> RunLoopbackBenchmarks(const BenchOptions& opt) {
+    std::vector<BenchLoopbackResult> results;
+    for (uint32_t ports : opt.ports)
+        for (uint32_t rate : opt.rates)
+            for (uint32_t chunk : opt.chunks)
+                for (uint32_t adaptive : opt.adaptive)
+                    results.push_back(RunLoopbackOnce(opt, ports, rate, chunk, adaptive != 0));
+    return results;
+}
+
+#else
+
+std::vector<BenchLoopbackResult> RunLoopbackBenchmarks(const BenchOptions& opt) {
+    BenchLoopbackResult r;
+    r.error = "loopback requer Linux (pares de pseudo-terminais)";
+    (void)opt;
+    return std::vector<BenchLoopbackResult>(1, r);
+}
+
+#endif
+
+// ============================================================================
+//                         Argumentos e saída JSON
+// ============================================================================
+namespace {
+
+bool ParseList(const char* s, std::vector<uint32_t>* out) {
+    out->clear();
+    while (*s) {
+        char* end;
+        unsigned long v = strtoul(s, &end, 10);
+        if (end == s || (*end && *end != ',')) return false;
+        out->push_back((uint32_t)v);
+        s = *end ? end + 1 : end;
+    }
+    return !out->empty();
+}
+
+void JsonString(std::string& out, const std::string& s) {
+    out += '"';
+    for (char c : s) {
+        if (c == '"' || c == '\\') { out += '\\'; out += c; }
+        else if ((unsigned char)c < 0x20) { char esc[8]; snprintf(esc, sizeof(esc), "\\u%04x", c); out += esc; }
+        else out += c;
+    }
+    out += '"';
+}
+
+void JsonNumber(std::string& out, const char* key, double v, bool comma = true) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "\"%s\": %.3f%s", key, v, comma ? ", " : "");
+    out += buf;
+}
+
+void JsonInt(std::string& out, const char* key, uint64_t v, bool comma = true) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "\"%s\": %llu%s", key, (unsigned long long)v, comma ? ", " : "");
+    out += buf;
+}
+
+}  // namespace
+
+bool ParseBenchArgs(int argc, char** argv, BenchOptions* opt, std::string* error) {
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        const char* eq = strchr(a, '=');
+        std::string key = eq ? std::string(a, eq) : std::string(a);
+        const char* val = eq ? eq + 1 : "";
+        bool ok = true;
+        if (key == "--bench") {}
+        else if (key == "--loopback") opt->loopback = true;
+        else if (key == "--no-micro") opt->micro = false;
+        else if (key == "--filter") opt->filter = val;
+        else if (key == "--json") opt->jsonPath = val;
+        else if (key == "--replay") ok = !(opt->replayPath = val).empty();
+        else if (key == "--repeats") ok = (opt->repeats = atoi(val)) > 0;
+        else if (key == "--min-ms") ok = (opt->minMs = (uint32_t)strtoul(val, nullptr, 10)) > 0;
+        else if (key == "--seconds") ok = (opt->loopbackSeconds = atof(val)) > 0;
+        else if (key == "--ring") ok = (opt->ringBytes = (size_t)strtoul(val, nullptr, 10)) > 0;
+        else if (key == "--rate") ok = ParseList(val, &opt->rates);
+        else if (key == "--chunk") ok = ParseList(val, &opt->chunks);
+        else if (key == "--ports") ok = ParseList(val, &opt->ports) && opt->ports[0] > 0;
+        else if (key == "--adaptive") ok = ParseList(val, &opt->adaptive);
+        else if (key == "--reactor-threads") ok = (opt->reactorThreads = (size_t)strtoul(val, nullptr, 10)) > 0;
+        else ok = false;
+        if (!ok) {
+            if (error) *error = std::string("argumento invalido: ") + a;
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string BenchToJson(const std::vector<BenchMicroResult>& micro,
+                        const std::vector<BenchLoopbackResult>& loopback) {
+    std::string out = "{\n  \"suite\": \"SerialCPP\",\n  \"schema\": 1,\n";
+#if defined(_WIN32)
+    out += "  \"platform\": \"windows\",\n";
+#elif defined(__linux__)
+    out += "  \"platform\": \"linux\",\n";
+#else
+    out += "  \"platform\": \"other\",\n";
+#endif
+
+    out += "  \"micro\": [";
+    for (size_t i = 0; i < micro.size(); ++i) {
+        const BenchMicroResult& m = micro[i];
+        out += i ? ",\n    {" : "\n    {";
+        out += "\"name\": ";
+        JsonString(out, m.name);
+        out += ", ";
+        JsonInt(out, "bytes_per_iter", m.bytesPerIter);
+        JsonInt(out, "iterations", m.iterations);
+        JsonNumber(out, "ns_per_iter", m.bestNsPerIter);
+        JsonNumber(out, "mb_per_s", m.mbPerSec, false);
+        out += "}";
+    }
+    out += micro.empty() ? "],\n" : "\n  ],\n";
+
+    out += "  \"loopback\": [";
+    for (size_t i = 0; i < loopback.size(); ++i) {
+        const BenchLoopbackResult& l = loopback[i];
+        out += i ? ",\n    {" : "\n    {";
+        JsonInt(out, "ports", l.ports);
+        JsonInt(out, "rate_bytes_per_s", l.rate);
+        JsonInt(out, "chunk_bytes", l.chunk);
+        JsonInt(out, "adaptive", l.adaptive ? 1 : 0);
+        if (!l.error.empty()) {
+            out += "\"error\": ";
+            JsonString(out, l.error);
+            out += "}";
+            continue;
+        }
+        JsonNumber(out, "seconds", l.seconds);
+        JsonInt(out, "sent_bytes", l.sentBytes);
+        JsonInt(out, "received_bytes", l.receivedBytes);
+        JsonInt(out, "dropped_bytes", l.droppedBytes);
+        JsonInt(out, "ring_dropped_bytes", l.ringDroppedBytes);
+        JsonInt(out, "records", l.records);
+        JsonInt(out, "lost_records", l.lostRecords);
+        JsonNumber(out, "mb_per_s", l.mbPerSec);
+        JsonNumber(out, "reactor_cpu_s", l.reactorCpuSeconds);
+        JsonNumber(out, "ports_per_core", l.portsPerCore);
+        JsonNumber(out, "syscalls_per_s", l.syscallsPerSec);
+        JsonNumber(out, "reads_per_s", l.readsPerSec);
+        JsonNumber(out, "bytes_per_read", l.bytesPerRead);
+        JsonInt(out, "profile_changes", l.profileChanges);
+        JsonInt(out, "batched_ports", l.batchedPorts);
+        JsonInt(out, "pool_high_water", l.poolHighWater);
+        JsonInt(out, "pool_heap_allocs", l.poolHeapAllocs);
+        out += "\"latency_us\": {";
+        JsonNumber(out, "p50", l.p50Us);
+        JsonNumber(out, "p99", l.p99Us);
+        JsonNumber(out, "p999", l.p999Us);
+        JsonNumber(out, "max", l.maxUs, false);
+        out += "}}";
+    }
+    out += loopback.empty() ? "]\n}\n" : "\n  ]\n}\n";
+    return out;
+}
+
+int BenchMain(int argc, char** argv) {
+    BenchOptions opt;
+    std::string error;
+    if (!ParseBenchArgs(argc, argv, &opt, &error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 2;
+    }
+
+    std::vector<BenchMicroResult> micro;
+    if (opt.micro) {
+        micro = RunMicroBenchmarks(opt);
+        for (const BenchMicroResult& m : micro)
+            fprintf(stderr, "%-20s %10.1f MB/s %12.0f ns/iter\n", m.name.c_str(), m.mbPerSec, m.bestNsPerIter);
+    }
+
+    std::vector<BenchLoopbackResult> loopback;
+    int rc = 0;
+    if (opt.loopback) {
+        loopback = RunLoopbackBenchmarks(opt);
+        for (const BenchLoopbackResult& l : loopback) {
+            if (!l.error.empty()) {
+                fprintf(stderr, "loopback ports=%u rate=%u chunk=%u: %s\n", l.ports, l.rate, l.chunk, l.error.c_str());
+                rc = 1;
+                continue;
+            }
+            fprintf(stderr, "loopback ports=%-3u rate=%-8u chunk=%-5u %s %8.2f MB/s  p50 %7.1f us  p99 %7.1f us"
+                            "  p999 %7.1f us  perdidos %llu B  %.0f portas/nucleo  %.0f syscalls/s"
+                            "  %.0f B/leitura  blocos %zu (heap %llu)\n",
+                    l.ports, l.rate, l.chunk, l.adaptive ? "adapt" : "fixo ", l.mbPerSec, l.p50Us, l.p99Us,
+                    l.p999Us, (unsigned long long)l.droppedBytes, l.portsPerCore, l.syscallsPerSec,
+                    l.bytesPerRead, l.poolHighWater, (unsigned long long)l.poolHeapAllocs);
+        }
+    }
+
+    std::string json = BenchToJson(micro, loopback);
+    if (opt.jsonPath.empty()) {
+        fputs(json.c_str(), stdout);
+        fflush(stdout);
+    }
+    else {
+        std::FILE* f = FOpenUtf8(opt.jsonPath, "wb");
+        if (!f) {
+            fprintf(stderr, "nao foi possivel criar %s\n", opt.jsonPath.c_str());
+            return 1;
+        }
+        fwrite(json.data(), 1, json.size(), f);
+        fclose(f);
+    }
+    return rc;
+}
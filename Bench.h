@@ -0,0 +1,105 @@
+// Bench.h - Benchmarks do pipeline de RX (modo "--bench")
+// Objetivo: medir antes/depois de mexer em SerialReadLoop(), no decodificador
+//           UTF-8, no HexDump, nos framers ou no Scrollback, com resultado
+//           comparável entre execuções (JSON).
+//
+//  - Micro-benchmarks: cada caso roda repetidamente sobre dados sintéticos
+//    determinísticos (texto ASCII, UTF-8 misto, binário) em blocos de 1 KB,
+//    o mesmo tamanho de leitura do SerialReadLoop(). Reporta a MELHOR de N
+//    repetições (menos sensível a ruído do SO). No Windows,
+//    utf8_decode_*_mbtowc medem o caminho anterior (MultiByteToWideChar)
+//    sobre os mesmos dados, para comparar com utf8_decode_*.
+//  - Captura real (--replay=arquivo.scap): replay_decode reproduz o RX da
+//    captura com ReplayToSink() em velocidade máxima pelo LineFramer e pelo
+//    Utf8Decoder (o caminho de uma aba), sem porta e sem janela.
+//  - Loopback (só Linux): pares de pseudo-terminais; uma thread escreve
+//    registros com carimbo de tempo nos mestres e os escravos são abertos
+//    como na GUI (SerialSession + SerialReactor -> spans do ChunkPool na
+//    fila RX -> UMA thread consumidora). Reporta vazão, latência p50/p99/p999/máx, bytes perdidos
+//    e portas por núcleo (CPU do reactor) para cada combinação de
+//    portas x taxa x tamanho de bloco x leitura fixa/adaptativa, com as
+//    syscalls do reactor por segundo (esperas + leituras) e o uso do pool de
+//    blocos (pico e blocos tirados do heap por falta de bloco livre).
+//    --adaptive=0,1 compara as duas leituras na mesma execução; a taxa
+//    nominal do AdaptiveIo é a própria taxa pedida.
+//
+// Uso (Windows: SerialCPP.exe --bench ...; Linux: ver MainPosix.cpp):
+//   --bench [--filter=utf8] [--repeats=5] [--min-ms=200] [--json=saida.json]
+//           [--replay=captura.scap]
+//           [--loopback] [--no-micro] [--rate=100000,1000000,0]
+//           [--chunk=16,256,4096] [--ports=1,8,16] [--reactor-threads=1]
+//           [--seconds=3] [--adaptive=0,1]
+// Taxa (por porta) 0 = sem limite (o mais rápido que o pty aceita).
+// 12 Mbaud ~ 1200000 B/s.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct BenchOptions {
+    std::string filter;                    // só casos cujo nome contém isto
+    std::string jsonPath;                  // vazio = stdout
+    std::string replayPath;                // captura .scap para replay_decode (vazio = não roda)
+    int      repeats = 5;                  // melhor de N
+    uint32_t minMs = 200;                  // duração mínima de cada repetição
+    bool     micro = true;
+    bool     loopback = false;
+    std::vector<uint32_t> rates = { 100000, 1000000, 0 };   // bytes/s (0 = sem limite)
+    std::vector<uint32_t> chunks = { 16, 256, 4096 };       // bytes por escrita
+    std::vector<uint32_t> ports = { 1 };                    // portas simultâneas
+    std::vector<uint32_t> adaptive = { 0 };                 // 0 = leitura fixa, 1 = AdaptiveIo
+    size_t   reactorThreads = 1;
+    double   loopbackSeconds = 3.0;        // por combinação
+    size_t   ringBytes = 1 << 20;          // igual ao rxRing da GUI
+};
+
+struct BenchMicroResult {
+    std::string name;
+    uint64_t bytesPerIter = 0;
+    uint64_t iterations = 0;               // da melhor repetição
+    double   bestNsPerIter = 0;
+    double   mbPerSec = 0;                 // 1 MB = 1e6 bytes
+};
+
+struct BenchLoopbackResult {
+    uint32_t ports = 0;
+    uint32_t rate = 0;                     // por porta
+    uint32_t chunk = 0;
+    bool     adaptive = false;
+    double   seconds = 0;                  // do primeiro envio ao último recebido
+    uint64_t sentBytes = 0;
+    uint64_t receivedBytes = 0;
+    uint64_t droppedBytes = 0;             // enviados - recebidos após drenar
+    uint64_t ringDroppedBytes = 0;         // dos quais descartados pela fila RX
+    uint64_t records = 0;                  // registros recebidos íntegros
+    uint64_t lostRecords = 0;
+    double   mbPerSec = 0;                 // soma das portas
+    double   reactorCpuSeconds = 0;
+    double   portsPerCore = 0;             // portas / fração de núcleo usada pelo reactor
+    double   syscallsPerSec = 0;           // reactor: esperas + leituras (com e sem bytes)
+    double   readsPerSec = 0;              // leituras com bytes
+    double   bytesPerRead = 0;
+    uint64_t profileChanges = 0;           // perfis do AdaptiveIo aplicados
+    size_t   batchedPorts = 0;             // portas no modo lote ao fim da produção
+    size_t   poolHighWater = 0;            // pico de blocos do ChunkPool em uso
+    uint64_t poolHeapAllocs = 0;           // blocos tirados do heap (pool vazio)
+    double   p50Us = 0, p99Us = 0, p999Us = 0, maxUs = 0;
+    std::string error;                     // não vazio = combinação não rodou
+};
+
+// Interpreta argv (ignora argv[0] e "--bench"). false = argumento inválido
+// (mensagem em 'error').
+bool ParseBenchArgs(int argc, char** argv, BenchOptions* opt, std::string* error);
+
+std::vector<BenchMicroResult> RunMicroBenchmarks(const BenchOptions& opt);
+std::vector<BenchLoopbackResult> RunLoopbackBenchmarks(const BenchOptions& opt);
+
+std::string BenchToJson(const std::vector<BenchMicroResult>& micro,
+                        const std::vector<BenchLoopbackResult>& loopback);
+
+// Ponto de entrada do modo --bench: roda, imprime resumo em stderr e o JSON
+// em stdout/arquivo. Retorna o código de saída do processo.
+int BenchMain(int argc, char** argv);
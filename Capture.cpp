@@ -0,0 +1,355 @@
+// Capture.cpp - Gravação e leitura de capturas binárias (ver Capture.h)
+
+#include "Capture.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+static const char kHeaderMagic[8] = { 'S', 'E', 'R', 'C', 'A', 'P', '0', '1' };
+static const char kFooterMagic[8] = { 'S', 'E', 'R', 'C', 'A', 'P', 'I', 'X' };
+
+static int64_t SteadyNs() {
+    return (int64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// ============================================================================
+//                                  Gravação
+// ============================================================================
+CaptureWriter::CaptureWriter(size_t ringBytes)
+    : m_rx(ringBytes, 16384), m_tx(ringBytes) {
+}
+
+CaptureWriter::~CaptureWriter() {
+    Stop();
+}
+
+uint64_t CaptureWriter::NowNs() const {
+    return (uint64_t)(SteadyNs() - m_startSteadyNs);
+}
+
+bool CaptureWriter::Start(const std::string& path, const std::string& portName, uint32_t baudRate) {
+    Stop();
+
+    m_file = FOpenUtf8(path, "wb");
+    if (!m_file) {
+        SetError("não foi possível criar o arquivo de captura");
+        return false;
+    }
+    // O bloco de 1 MB já é o buffer: stdio não precisa de outro.
+    setvbuf(m_file, nullptr, _IONBF, 0);
+
+    CaptureHeader h = {};
+    memcpy(h.magic, kHeaderMagic, sizeof(h.magic));
+    h.version = 1;
+    h.headerSize = sizeof(CaptureHeader);
+    h.startUnixNs = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    h.baudRate = baudRate;
+    strncpy(h.port, portName.c_str(), sizeof(h.port) - 1);
+
+    m_buf.resize(1u << 20);
+    memcpy(&m_buf[0], &h, sizeof(h));
+    m_bufUsed = sizeof(h);
+    m_fileOffset = 0;
+    m_nextIndexAt = 0;
+    m_index.clear();
+    m_ioError = false;
+    SetError("");
+    m_records = 0;
+    m_bytes = 0;
+    m_dropped = 0;
+    m_fileBytes = 0;
+
+    // Nenhum produtor ativo aqui (Stop() esperou os que estavam em Record()):
+    m_rx.Reset();
+    m_tx.Reset();
+    m_startSteadyNs = SteadyNs();
+    m_stopThread = false;
+    m_thread = std::thread(&CaptureWriter::CaptureLoop, this);
+    m_active.store(true);
+    return true;
+}
+
+void CaptureWriter::Stop() {
+    if (!m_thread.joinable()) return;
+
+    // Fecha a porta para novos registros e espera quem já entrou em Record():
+    m_active.store(false);
+    while (m_inFlight.load() != 0) std::this_thread::yield();
+
+    // A thread esvazia as filas antes de sair:
+    m_stopThread.store(true, std::memory_order_release);
+    m_thread.join();
+
+    if (!m_ioError) {
+        CaptureFooter f = {};
+        f.indexOffset = m_fileOffset;
+        f.indexCount = m_index.size();
+        memcpy(f.magic, kFooterMagic, sizeof(f.magic));
+        size_t indexBytes = m_index.size() * sizeof(CaptureIndexEntry);
+        bool ok = (indexBytes == 0 || fwrite(m_index.data(), 1, indexBytes, m_file) == indexBytes) &&
+                  fwrite(&f, 1, sizeof(f), m_file) == sizeof(f);
+        if (!ok) SetError("falha ao gravar o índice da captura");
+        else m_fileBytes = m_fileOffset + indexBytes + sizeof(f);
+    }
+    fclose(m_file);
+    m_file = nullptr;
+}
+
+// seq_cst nos dois lados (m_inFlight/m_active): ou Stop() vê m_inFlight > 0,
+// ou o Record*() vê m_active == false.
+void CaptureWriter::RecordRx(const RxSpan& span) {
+    m_inFlight.fetch_add(1);
+    if (m_active.load() && !m_rx.Push(span, NowNs()))
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+    m_inFlight.fetch_sub(1);
+}
+
+void CaptureWriter::RecordTx(const void* data, size_t len) {
+    m_inFlight.fetch_add(1);
+    if (m_active.load()) {
+        const uint64_t ts = NowNs();
+        const uint8_t* p = (const uint8_t*)data;
+        while (len > 0) {
+            size_t n = (len < kMaxRecordData) ? len : kMaxRecordData;
+            CaptureRecordHeader h = {};
+            h.tsNs = ts;
+            h.len = (uint32_t)n;
+            h.dir = (uint8_t)CaptureDir::Tx;
+            if (!m_tx.WriteAll(&h, sizeof(h), p, n))
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+            p += n;
+            len -= n;
+        }
+    }
+    m_inFlight.fetch_sub(1);
+}
+
+CaptureStats CaptureWriter::Stats() const {
+    CaptureStats s;
+    s.records = m_records.load(std::memory_order_relaxed);
+    s.bytes = m_bytes.load(std::memory_order_relaxed);
+    s.droppedRecords = m_dropped.load(std::memory_order_relaxed);
+    s.fileBytes = m_fileBytes.load(std::memory_order_relaxed);
+    return s;
+}
+
+// O produtor publica cabeçalho+dados de uma vez: se o cabeçalho está visível,
+// os dados também estão.
+bool CaptureWriter::PeekHeader(RxRing& ring, CaptureRecordHeader& h) {
+    return ring.Peek(&h, sizeof(h)) == sizeof(h);
+}
+
+uint8_t* CaptureWriter::BeginRecord(const CaptureRecordHeader& h) {
+    const size_t total = sizeof(h) + h.len;
+    if (m_bufUsed + total > m_buf.size()) FlushBuffer();
+
+    uint64_t offset = m_fileOffset + m_bufUsed;
+    if (offset >= m_nextIndexAt) {
+        m_index.push_back(CaptureIndexEntry{ h.tsNs, offset });
+        m_nextIndexAt = offset + kIndexStride;
+    }
+
+    uint8_t* p = &m_buf[m_bufUsed];
+    m_bufUsed += total;
+    m_records.fetch_add(1, std::memory_order_relaxed);
+    m_bytes.fetch_add(h.len, std::memory_order_relaxed);
+    return p;
+}
+
+void CaptureWriter::MoveRecord(RxRing& ring, const CaptureRecordHeader& h) {
+    ring.Read(BeginRecord(h), sizeof(h) + h.len);
+}
+
+// Única cópia do RX: do bloco do reactor para o buffer de saída. O span é
+// solto em seguida (o bloco volta ao pool quando a UI também soltar).
+void CaptureWriter::MoveRxSpan() {
+    RxSpan span;
+    uint64_t ts = 0;
+    m_rx.Pop(&span, &ts);
+    const uint8_t* p = span.Data();
+    size_t len = span.Size();
+    while (len > 0) {
+        size_t n = (len < kMaxRecordData) ? len : kMaxRecordData;
+        CaptureRecordHeader h = {};
+        h.tsNs = ts;
+        h.len = (uint32_t)n;
+        h.dir = (uint8_t)CaptureDir::Rx;
+        uint8_t* out = BeginRecord(h);
+        memcpy(out, &h, sizeof(h));
+        memcpy(out + sizeof(h), p, n);
+        p += n;
+        len -= n;
+    }
+}
+
+void CaptureWriter::SetError(const char* what) {
+    std::lock_guard<std::mutex> lock(m_errorLock);
+    m_lastError = what;
+}
+
+std::string CaptureWriter::LastError() const {
+    std::lock_guard<std::mutex> lock(m_errorLock);
+    return m_lastError;
+}
+
+void CaptureWriter::FlushBuffer() {
+    if (m_bufUsed == 0) return;
+    if (!m_ioError && fwrite(&m_buf[0], 1, m_bufUsed, m_file) != m_bufUsed) {
+        // Disco cheio etc.: continua drenando as filas (o RX não pode parar),
+        // mas não grava mais nada.
+        m_ioError = true;
+        SetError("falha de escrita no arquivo de captura (disco cheio?)");
+    }
+    m_fileOffset += m_bufUsed;
+    m_bufUsed = 0;
+    if (!m_ioError) m_fileBytes.store(m_fileOffset, std::memory_order_relaxed);
+}
+
+// Junta RX e TX pelo timestamp e grava em blocos de 1 MB. Sem dados, grava o
+// bloco parcial no máximo a cada 100 ms (limita o que se perde num crash).
+// Os produtores nunca são acordados/sinalizados: a thread faz polling curto.
+void CaptureWriter::CaptureLoop() {
+    int64_t lastFlush = SteadyNs();
+
+    for (;;) {
+        bool stopping = m_stopThread.load(std::memory_order_acquire);
+        bool moved = false;
+
+        CaptureRecordHeader ht;
+        for (;;) {
+            uint64_t tsRx = 0;
+            bool r = m_rx.Front(&tsRx) != nullptr;
+            bool t = PeekHeader(m_tx, ht);
+            if (!r && !t) break;
+            if (r && (!t || tsRx <= ht.tsNs)) MoveRxSpan();
+            else MoveRecord(m_tx, ht);
+            moved = true;
+        }
+
+        if (moved) continue;
+        if (stopping) break;
+
+        int64_t now = SteadyNs();
+        if (m_bufUsed >= 64 * 1024 || now - lastFlush >= 100 * 1000000LL) {
+            FlushBuffer();
+            lastFlush = now;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    FlushBuffer();
+}
+
+// ============================================================================
+//                                  Leitura
+// ============================================================================
+bool CaptureReader::Open(const std::string& path) {
+    Close();
+
+    if (!m_map.Open(path)) {
+        m_lastError = m_map.LastError();
+        return false;
+    }
+    const uint64_t size = m_map.Size();
+    if (size < sizeof(CaptureHeader)) {
+        m_lastError = "arquivo pequeno demais para ser uma captura";
+        Close();
+        return false;
+    }
+    memcpy(&m_header, m_map.Data(), sizeof(m_header));
+    if (memcmp(m_header.magic, kHeaderMagic, sizeof(kHeaderMagic)) != 0 || m_header.version != 1) {
+        m_lastError = "não é uma captura (cabeçalho inválido)";
+        Close();
+        return false;
+    }
+
+    // Captura fechada direito: rodapé + índice no fim.
+    m_dataEnd = size;
+    if (size >= sizeof(CaptureHeader) + sizeof(CaptureFooter)) {
+        CaptureFooter f;
+        memcpy(&f, m_map.Data() + size - sizeof(f), sizeof(f));
+        // Rodapé corrompido: o número de entradas é limitado antes da
+        // multiplicação (um indexCount enorme daria a volta no produto).
+        const uint64_t maxEntries = (size - sizeof(CaptureHeader) - sizeof(f)) / sizeof(CaptureIndexEntry);
+        uint64_t indexBytes = (f.indexCount <= maxEntries) ? f.indexCount * sizeof(CaptureIndexEntry) : 0;
+        if (memcmp(f.magic, kFooterMagic, sizeof(kFooterMagic)) == 0 &&
+            f.indexCount <= maxEntries &&
+            f.indexOffset >= sizeof(CaptureHeader) &&
+            f.indexOffset <= size - sizeof(f) - indexBytes &&
+            f.indexOffset + indexBytes + sizeof(f) == size) {
+            m_index.resize((size_t)f.indexCount);
+            if (indexBytes) memcpy(m_index.data(), m_map.Data() + f.indexOffset, (size_t)indexBytes);
+            m_dataEnd = f.indexOffset;
+            m_indexFromFile = true;
+        }
+    }
+    if (!m_indexFromFile) RebuildIndex();
+
+    // Último timestamp: varre a partir da última entrada do índice.
+    uint64_t off = m_index.empty() ? FirstOffset() : m_index.back().offset;
+    CaptureRecord rec;
+    while (Next(&off, &rec)) m_lastTsNs = rec.tsNs;
+    return true;
+}
+
+void CaptureReader::Close() {
+    m_map.Close();
+    m_header = CaptureHeader();
+    m_dataEnd = 0;
+    m_lastTsNs = 0;
+    m_indexFromFile = false;
+    m_index.clear();
+}
+
+// Sem rodapé (captura interrompida): percorre os registros, recria o índice e
+// corta no último registro completo.
+void CaptureReader::RebuildIndex() {
+    uint64_t off = FirstOffset(), nextIndexAt = 0;
+    CaptureRecordHeader h;
+    while (ReadRecordHeader(off, &h)) {
+        uint64_t end = off + sizeof(h) + h.len;
+        if (end > m_map.Size()) break;
+        if (off >= nextIndexAt) {
+            m_index.push_back(CaptureIndexEntry{ h.tsNs, off });
+            nextIndexAt = off + 256 * 1024;
+        }
+        off = end;
+    }
+    m_dataEnd = off;
+}
+
+bool CaptureReader::ReadRecordHeader(uint64_t offset, CaptureRecordHeader* h) const {
+    if (offset + sizeof(*h) > m_map.Size()) return false;
+    memcpy(h, m_map.Data() + offset, sizeof(*h));
+    return true;
+}
+
+bool CaptureReader::Next(uint64_t* offset, CaptureRecord* rec) const {
+    CaptureRecordHeader h;
+    if (*offset + sizeof(h) > m_dataEnd || !ReadRecordHeader(*offset, &h)) return false;
+    uint64_t dataAt = *offset + sizeof(h);
+    if (dataAt + h.len > m_dataEnd) return false;
+
+    rec->tsNs = h.tsNs;
+    rec->dir = (CaptureDir)h.dir;
+    rec->data = m_map.Data() + dataAt;
+    rec->len = h.len;
+    *offset = dataAt + h.len;
+    return true;
+}
+
+uint64_t CaptureReader::SeekTime(uint64_t tsNs) const {
+    // Última entrada do índice com tsNs <= alvo (o alvo está depois dela):
+    auto it = std::upper_bound(m_index.begin(), m_index.end(), tsNs,
+        [](uint64_t t, const CaptureIndexEntry& e) { return t < e.tsNs; });
+    uint64_t off = (it == m_index.begin()) ? FirstOffset() : (it - 1)->offset;
+
+    CaptureRecord rec;
+    for (;;) {
+        uint64_t here = off;
+        if (!Next(&off, &rec)) return m_dataEnd;
+        if (rec.tsNs >= tsNs) return here;
+    }
+}
@@ -0,0 +1,209 @@
+// Capture.h - Captura binária de tráfego (RX/TX) com timestamps e índice
+// Objetivo: guardar os bytes crus com o instante de chegada/envio, sem passar
+//           pelo terminal (que perde o tempo e expande binário em HEX), e
+//           reabrir capturas de vários GB com seek instantâneo.
+//
+// Formato do arquivo (little-endian, só anexado):
+//
+//   CaptureHeader (64 bytes)
+//   registros:  CaptureRecordHeader (16 bytes) + 'len' bytes de dados
+//   ...
+//   índice:     CaptureIndexEntry[count]   (a cada ~256 KB de arquivo)
+//   CaptureFooter (24 bytes, fim do arquivo)
+//
+// O índice só existe se a captura foi fechada direito; sem ele o leitor
+// reconstrói o índice varrendo os registros (e ignora um último registro
+// cortado ao meio).
+//
+// Threads (CaptureWriter):
+//  - RecordRx() é chamado só pela thread de leitura e RecordTx() só pela
+//    thread de escrita. Cada direção tem sua fila SPSC e o produtor nunca
+//    espera (sem lock, sem syscall). O RX não é copiado na fila: ela guarda
+//    o RxSpan (referência ao bloco do reactor, ver ChunkPool.h) e os bytes
+//    só são copiados uma vez, do bloco para o buffer de saída. O TX é
+//    copiado para um RxRing (o buffer da TxQueue é reaproveitado).
+//  - Uma thread de captura junta as duas filas em ordem de tempo e grava no
+//    disco em blocos grandes. Fila cheia = registro descartado e contado.
+//    A ordem entre RX e TX é aproximada (um registro pode chegar à fila
+//    depois de um mais novo da outra direção); o tsNs de cada um é exato.
+//  - Start()/Stop() pela thread de controle (UI); Record() é seguro durante
+//    essas chamadas.
+//
+// Não depende de Win32.
+
+#pragma once
+
+#include "ChunkPool.h"
+#include "MappedFile.h"
+#include "RxRing.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class CaptureDir : uint8_t { Rx = 0, Tx = 1 };
+
+#pragma pack(push, 1)
+struct CaptureHeader {
+    char     magic[8];          // "SERCAP01"
+    uint32_t version;           // 1
+    uint32_t headerSize;        // sizeof(CaptureHeader)
+    uint64_t startUnixNs;       // relógio de parede no início (ns desde 1970)
+    uint32_t baudRate;
+    uint32_t flags;             // reservado
+    char     port[32];          // nome da porta (UTF-8, terminado em NUL)
+};
+
+struct CaptureRecordHeader {
+    uint64_t tsNs;              // ns desde o início da captura (relógio monotônico)
+    uint32_t len;               // bytes de dados que seguem
+    uint8_t  dir;               // CaptureDir
+    uint8_t  reserved[3];
+};
+
+struct CaptureIndexEntry {
+    uint64_t tsNs;
+    uint64_t offset;            // início de um CaptureRecordHeader
+};
+
+struct CaptureFooter {
+    uint64_t indexOffset;
+    uint64_t indexCount;
+    char     magic[8];          // "SERCAPIX"
+};
+#pragma pack(pop)
+
+static_assert(sizeof(CaptureHeader) == 64, "CaptureHeader: layout do arquivo");
+static_assert(sizeof(CaptureRecordHeader) == 16, "CaptureRecordHeader: layout do arquivo");
+static_assert(sizeof(CaptureFooter) == 24, "CaptureFooter: layout do arquivo");
+
+struct CaptureStats {
+    uint64_t records = 0;       // registros gravados
+    uint64_t bytes = 0;         // dados gravados (sem cabeçalhos)
+    uint64_t droppedRecords = 0;
+    uint64_t fileBytes = 0;
+};
+
+// ============================================================================
+//                                  Gravação
+// ============================================================================
+class CaptureWriter {
+public:
+    // 'ringBytes' por direção: 4 MB seguram ~3 s de 12 Mbaud sem o disco.
+    explicit CaptureWriter(size_t ringBytes = 4u << 20);
+    ~CaptureWriter();
+
+    CaptureWriter(const CaptureWriter&) = delete;
+    CaptureWriter& operator=(const CaptureWriter&) = delete;
+
+    // Cria/trunca o arquivo ('path' em UTF-8) e inicia a thread de captura.
+    bool Start(const std::string& path, const std::string& portName, uint32_t baudRate);
+
+    // Grava o que falta, escreve índice e rodapé e fecha o arquivo.
+    void Stop();
+
+    bool Active() const { return m_active.load(std::memory_order_acquire); }
+
+    // Produtores: registram um bloco com o timestamp atual.
+    // Sem captura ativa custam uma leitura atômica.
+    void RecordRx(const RxSpan& span);
+    void RecordTx(const void* data, size_t len);
+
+    // ns desde o início da captura (mesma base dos registros).
+    uint64_t NowNs() const;
+
+    CaptureStats Stats() const;
+    // Cópia: a thread de captura pode trocar o texto (FlushBuffer) a qualquer momento.
+    std::string LastError() const;
+
+private:
+    // Maior bloco por registro (blocos maiores são divididos).
+    static const size_t kMaxRecordData = 64 * 1024;
+    static const uint64_t kIndexStride = 256 * 1024;
+
+    bool PeekHeader(RxRing& ring, CaptureRecordHeader& h);
+    void MoveRecord(RxRing& ring, const CaptureRecordHeader& h);
+    void MoveRxSpan();
+    uint8_t* BeginRecord(const CaptureRecordHeader& h);   // espaço para cabeçalho + dados em m_buf
+    void FlushBuffer();
+    void CaptureLoop();
+    void SetError(const char* what);
+
+    RxSpanQueue m_rx;                         // tag = tsNs
+    RxRing m_tx;
+
+    std::atomic<bool> m_active{ false };
+    std::atomic<int> m_inFlight{ 0 };         // produtores dentro de Record()
+    std::atomic<bool> m_stopThread{ false };
+    std::thread m_thread;
+
+    std::FILE* m_file = nullptr;
+    std::vector<uint8_t> m_buf;               // bloco de saída (1 MB)
+    size_t m_bufUsed = 0;
+    uint64_t m_fileOffset = 0;                // offset do fim de m_buf no arquivo
+    uint64_t m_nextIndexAt = 0;
+    std::vector<CaptureIndexEntry> m_index;
+    int64_t m_startSteadyNs = 0;
+    bool m_ioError = false;
+
+    mutable std::mutex m_errorLock;           // m_lastError: thread de captura x UI
+    std::string m_lastError;
+
+    std::atomic<uint64_t> m_records{ 0 };
+    std::atomic<uint64_t> m_bytes{ 0 };
+    std::atomic<uint64_t> m_dropped{ 0 };
+    std::atomic<uint64_t> m_fileBytes{ 0 };
+};
+
+// ============================================================================
+//                                  Leitura
+// ============================================================================
+struct CaptureRecord {
+    uint64_t tsNs;
+    CaptureDir dir;
+    const uint8_t* data;        // aponta para o arquivo mapeado
+    uint32_t len;
+};
+
+class CaptureReader {
+public:
+    bool Open(const std::string& path);
+    void Close();
+
+    const CaptureHeader& Header() const { return m_header; }
+    bool HasIndex() const { return m_indexFromFile; }
+    uint64_t FirstOffset() const { return sizeof(CaptureHeader); }
+    uint64_t EndOffset() const { return m_dataEnd; }
+    uint64_t LastTsNs() const { return m_lastTsNs; }
+
+    // Lê o registro em '*offset' e avança para o próximo.
+    // Retorna false no fim dos dados.
+    bool Next(uint64_t* offset, CaptureRecord* rec) const;
+
+    // Offset do primeiro registro com tsNs >= 'tsNs' (busca binária no índice
+    // e varredura curta a partir dele).
+    uint64_t SeekTime(uint64_t tsNs) const;
+
+    // Índice (do arquivo ou reconstruído): offsets de início de registro em
+    // ordem, usados para dividir a captura entre threads (OfflineAnalysis.h).
+    const std::vector<CaptureIndexEntry>& Index() const { return m_index; }
+
+    const std::string& LastError() const { return m_lastError; }
+
+private:
+    bool ReadRecordHeader(uint64_t offset, CaptureRecordHeader* h) const;
+    void RebuildIndex();
+
+    MappedFile m_map;
+    CaptureHeader m_header = {};
+    uint64_t m_dataEnd = 0;
+    uint64_t m_lastTsNs = 0;
+    bool m_indexFromFile = false;
+    std::vector<CaptureIndexEntry> m_index;
+    std::string m_lastError;
+};
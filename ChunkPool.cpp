@@ -0,0 +1,155 @@
+// ChunkPool.cpp - Pool lock-free de blocos e fila de spans (ver ChunkPool.h)
+
+#include "ChunkPool.h"
+
+ChunkPool::ChunkPool(size_t chunkBytes, size_t count)
+    : m_chunkBytes(chunkBytes), m_count(count),
+      m_memory(new uint8_t[chunkBytes * count]), m_chunks(new RxChunk[count]) {
+    m_inUse.store(count);
+    for (size_t i = count; i-- > 0;) {
+        RxChunk& c = m_chunks[i];
+        c.index = (uint32_t)i;
+        c.pool = this;
+        c.data = m_memory.get() + i * chunkBytes;
+        Push(&c);
+    }
+}
+
+// Pilha de Treiber: a versão nos 32 bits altos muda a cada operação, então um
+// CAS com um topo velho (bloco tirado e devolvido no meio) falha.
+void ChunkPool::Push(RxChunk* c) {
+    uint64_t head = m_head.load(std::memory_order_relaxed);
+    for (;;) {
+        c->next.store((uint32_t)head, std::memory_order_relaxed);
+        uint64_t next = ((head >> 32) + 1) << 32 | (uint64_t)(c->index + 1);
+        if (m_head.compare_exchange_weak(head, next, std::memory_order_release, std::memory_order_relaxed))
+            break;
+    }
+    m_inUse.fetch_sub(1, std::memory_order_relaxed);
+}
+
+RxChunk* ChunkPool::Pop() {
+    uint64_t head = m_head.load(std::memory_order_acquire);
+    for (;;) {
+        uint32_t top = (uint32_t)head;
+        if (top == 0) return nullptr;
+        RxChunk* c = &m_chunks[top - 1];
+        uint64_t next = ((head >> 32) + 1) << 32 | c->next.load(std::memory_order_relaxed);
+        if (m_head.compare_exchange_weak(head, next, std::memory_order_acquire, std::memory_order_acquire))
+            return c;
+    }
+}
+
+RxChunk* ChunkPool::Acquire() {
+    m_acquired.fetch_add(1, std::memory_order_relaxed);
+    RxChunk* c = Pop();
+    if (!c) {
+        c = new RxChunk();
+        c->index = kLoose;
+        c->pool = this;
+        c->data = new uint8_t[m_chunkBytes];
+        m_heapAllocs.fetch_add(1, std::memory_order_relaxed);
+    }
+    c->refs.store(1, std::memory_order_relaxed);
+
+    size_t used = m_inUse.fetch_add(1, std::memory_order_relaxed) + 1;
+    size_t high = m_highWater.load(std::memory_order_relaxed);
+    while (used > high && !m_highWater.compare_exchange_weak(high, used, std::memory_order_relaxed)) {}
+    return c;
+}
+
+// acq_rel: quem solta por último vê tudo o que os outros fizeram com os
+// bytes antes de o bloco ser reaproveitado.
+void ChunkPool::Release(RxChunk* c) {
+    if (c->refs.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+    ChunkPool* pool = c->pool;
+    if (c->index == kLoose) {
+        delete[] c->data;
+        delete c;
+        pool->m_inUse.fetch_sub(1, std::memory_order_relaxed);
+        return;
+    }
+    pool->Push(c);
+}
+
+ChunkPoolStats ChunkPool::Stats() const {
+    ChunkPoolStats s;
+    s.chunks = m_count;
+    s.chunkBytes = m_chunkBytes;
+    s.inUse = m_inUse.load(std::memory_order_relaxed);
+    s.highWater = m_highWater.load(std::memory_order_relaxed);
+    s.acquired = m_acquired.load(std::memory_order_relaxed);
+    s.heapAllocs = m_heapAllocs.load(std::memory_order_relaxed);
+    return s;
+}
+
+// ============================================================================
+//                                RxSpanQueue
+// ============================================================================
+static size_t RoundUpPow2(size_t v) {
+    size_t p = 1;
+    while (p < v) p <<= 1;
+    return p;
+}
+
+RxSpanQueue::RxSpanQueue(size_t maxBytes, size_t maxSpans)
+    : m_slots(RoundUpPow2(maxSpans < 2 ? 2 : maxSpans)), m_mask(m_slots.size() - 1), m_maxBytes(maxBytes) {
+}
+
+bool RxSpanQueue::Push(const RxSpan& span, uint64_t tag) {
+    size_t head = m_head.load(std::memory_order_relaxed);
+    size_t tail = m_tail.load(std::memory_order_acquire);
+    uint64_t pushed = m_pushedBytes.load(std::memory_order_relaxed);
+    size_t queued = (size_t)(pushed - m_poppedBytes.load(std::memory_order_acquire));
+    if (head - tail == m_slots.size() || queued + span.Size() > m_maxBytes) {
+        m_droppedBytes.fetch_add(span.Size(), std::memory_order_relaxed);
+        m_overflowEvents.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    Slot& s = m_slots[head & m_mask];
+    s.span = span;
+    s.tag = tag;
+    m_pushedBytes.store(pushed + span.Size(), std::memory_order_relaxed);
+    m_head.store(head + 1, std::memory_order_release);
+
+    queued += span.Size();
+    if (queued > m_highWater.load(std::memory_order_relaxed)) m_highWater.store(queued, std::memory_order_relaxed);
+    return true;
+}
+
+bool RxSpanQueue::Pop(RxSpan* out, uint64_t* tag) {
+    size_t tail = m_tail.load(std::memory_order_relaxed);
+    if (m_head.load(std::memory_order_acquire) == tail) return false;
+    Slot& s = m_slots[tail & m_mask];
+    if (tag) *tag = s.tag;
+    size_t len = s.span.Size();
+    *out = std::move(s.span);
+    m_poppedBytes.store(m_poppedBytes.load(std::memory_order_relaxed) + len, std::memory_order_release);
+    m_tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+const RxSpan* RxSpanQueue::Front(uint64_t* tag) const {
+    size_t tail = m_tail.load(std::memory_order_relaxed);
+    if (m_head.load(std::memory_order_acquire) == tail) return nullptr;
+    const Slot& s = m_slots[tail & m_mask];
+    if (tag) *tag = s.tag;
+    return &s.span;
+}
+
+size_t RxSpanQueue::Size() const {
+    uint64_t popped = m_poppedBytes.load(std::memory_order_acquire);
+    return (size_t)(m_pushedBytes.load(std::memory_order_acquire) - popped);
+}
+
+void RxSpanQueue::Reset() {
+    for (Slot& s : m_slots) s.span.Reset();
+    m_head.store(0);
+    m_tail.store(0);
+    m_pushedBytes.store(0);
+    m_poppedBytes.store(0);
+    m_droppedBytes.store(0);
+    m_overflowEvents.store(0);
+    m_highWater.store(0);
+}
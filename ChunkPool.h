@@ -0,0 +1,182 @@
+// ChunkPool.h - Blocos de RX em pool, repartidos por contagem de referências
+// Objetivo: o byte lido da porta não é copiado de novo para cada consumidor
+//           (tela, captura, framing, métricas). O reactor lê direto num
+//           bloco do pool e entrega um RxSpan (ponteiro + tamanho + referência
+//           ao bloco); cada consumidor que precisa guardar os bytes guarda o
+//           span (uma contagem a mais), não uma cópia. O bloco volta ao pool
+//           quando o último span é solto.
+//
+//  - ChunkPool: N blocos de tamanho fixo alocados de uma vez. A lista livre é
+//    uma pilha lock-free (Treiber) com índice + contador de versão numa
+//    palavra de 64 bits (sem ABA): pegam blocos as threads do reactor, soltam
+//    a UI, a captura ou o próprio reactor, sem trava.
+//  - Pool vazio não bloqueia nem perde dados: o bloco sai do heap e é
+//    liberado no último Release() (contado em heapAllocs; em regime, zero).
+//  - Um bloco guarda várias leituras seguidas (o reactor continua no fim da
+//    última): leituras pequenas não desperdiçam um bloco cada.
+//  - RxSpanQueue: fila SPSC de spans com limite em bytes (mesmo papel do
+//    RxRing: cheia = descarta e conta, o produtor nunca espera).
+//
+// O pool precisa viver mais que todos os spans tirados dele.
+// Não depende de Win32.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class ChunkPool;
+
+struct RxChunk {
+    std::atomic<uint32_t> refs{ 0 };
+    std::atomic<uint32_t> next{ 0 };   // lista livre: índice + 1 do próximo (0 = fim)
+    uint32_t index = 0;                // posição no pool (kLoose = veio do heap)
+    ChunkPool* pool = nullptr;
+    uint8_t* data = nullptr;
+};
+
+struct ChunkPoolStats {
+    size_t   chunks = 0;               // blocos do pool
+    size_t   chunkBytes = 0;
+    size_t   inUse = 0;                // fora da lista livre agora (inclui os do heap)
+    size_t   highWater = 0;
+    uint64_t acquired = 0;
+    uint64_t heapAllocs = 0;           // pool vazio: blocos avulsos
+};
+
+class ChunkPool {
+public:
+    static const uint32_t kLoose = UINT32_MAX;
+
+    ChunkPool(size_t chunkBytes, size_t count);
+
+    ChunkPool(const ChunkPool&) = delete;
+    ChunkPool& operator=(const ChunkPool&) = delete;
+
+    // Bloco com uma referência (de quem pediu). Nunca nullptr.
+    RxChunk* Acquire();
+
+    static void AddRef(RxChunk* c) { c->refs.fetch_add(1, std::memory_order_relaxed); }
+    // Última referência: o bloco volta ao pool (ou ao heap).
+    static void Release(RxChunk* c);
+
+    size_t ChunkBytes() const { return m_chunkBytes; }
+    ChunkPoolStats Stats() const;
+
+private:
+    void Push(RxChunk* c);
+    RxChunk* Pop();
+
+    const size_t m_chunkBytes;
+    const size_t m_count;
+    std::unique_ptr<uint8_t[]> m_memory;
+    std::unique_ptr<RxChunk[]> m_chunks;
+
+    alignas(64) std::atomic<uint64_t> m_head{ 0 };   // (versão << 32) | (índice + 1)
+    alignas(64) std::atomic<size_t> m_inUse{ 0 };
+    std::atomic<size_t> m_highWater{ 0 };
+    std::atomic<uint64_t> m_acquired{ 0 };
+    std::atomic<uint64_t> m_heapAllocs{ 0 };
+};
+
+// Trecho de um bloco. Copiar = mais uma referência ao bloco (não copia bytes).
+class RxSpan {
+public:
+    RxSpan() {}
+    RxSpan(RxChunk* chunk, const uint8_t* data, size_t len)
+        : m_chunk(chunk), m_data(data), m_len(len) {
+        if (m_chunk) ChunkPool::AddRef(m_chunk);
+    }
+    RxSpan(const RxSpan& o) : RxSpan(o.m_chunk, o.m_data, o.m_len) {}
+    RxSpan(RxSpan&& o) noexcept : m_chunk(o.m_chunk), m_data(o.m_data), m_len(o.m_len) {
+        o.m_chunk = nullptr;
+        o.m_data = nullptr;
+        o.m_len = 0;
+    }
+    RxSpan& operator=(const RxSpan& o) {
+        if (this != &o) *this = RxSpan(o);
+        return *this;
+    }
+    RxSpan& operator=(RxSpan&& o) noexcept {
+        if (this != &o) {
+            Reset();
+            m_chunk = o.m_chunk;
+            m_data = o.m_data;
+            m_len = o.m_len;
+            o.m_chunk = nullptr;
+            o.m_data = nullptr;
+            o.m_len = 0;
+        }
+        return *this;
+    }
+    ~RxSpan() { Reset(); }
+
+    void Reset() {
+        if (m_chunk) ChunkPool::Release(m_chunk);
+        m_chunk = nullptr;
+        m_data = nullptr;
+        m_len = 0;
+    }
+
+    const uint8_t* Data() const { return m_data; }
+    size_t Size() const { return m_len; }
+    bool Empty() const { return m_len == 0; }
+
+private:
+    RxChunk* m_chunk = nullptr;
+    const uint8_t* m_data = nullptr;
+    size_t m_len = 0;
+};
+
+// Fila de spans, 1 produtor / 1 consumidor. 'tag' acompanha cada span (ex.:
+// timestamp da captura).
+class RxSpanQueue {
+public:
+    // 'maxSpans' é arredondado para a próxima potência de 2.
+    explicit RxSpanQueue(size_t maxBytes, size_t maxSpans = 4096);
+
+    RxSpanQueue(const RxSpanQueue&) = delete;
+    RxSpanQueue& operator=(const RxSpanQueue&) = delete;
+
+    // Produtor: guarda o span (uma referência a mais). false = fila cheia
+    // (em bytes ou em spans): descartado e contado.
+    bool Push(const RxSpan& span, uint64_t tag = 0);
+
+    // Consumidor: tira o próximo span (a referência passa para 'out').
+    bool Pop(RxSpan* out, uint64_t* tag = nullptr);
+    // Consumidor: o próximo span sem tirar (nullptr = vazia).
+    const RxSpan* Front(uint64_t* tag = nullptr) const;
+
+    size_t Size() const;                  // bytes na fila (aproximado fora do consumidor)
+    bool   Empty() const { return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire); }
+
+    // Solta tudo e zera contadores. Sem produtor nem consumidor ativos!
+    void Reset();
+
+    uint64_t TotalWritten() const { return m_pushedBytes.load(std::memory_order_relaxed); }
+    uint64_t DroppedBytes() const { return m_droppedBytes.load(std::memory_order_relaxed); }
+    uint64_t OverflowEvents() const { return m_overflowEvents.load(std::memory_order_relaxed); }
+    size_t   HighWater() const { return m_highWater.load(std::memory_order_relaxed); }
+
+private:
+    struct Slot {
+        RxSpan span;
+        uint64_t tag = 0;
+    };
+
+    std::vector<Slot> m_slots;
+    size_t m_mask;
+    const size_t m_maxBytes;
+
+    alignas(64) std::atomic<size_t> m_head{ 0 };            // só o produtor escreve
+    std::atomic<uint64_t> m_pushedBytes{ 0 };
+    alignas(64) std::atomic<size_t> m_tail{ 0 };            // só o consumidor escreve
+    std::atomic<uint64_t> m_poppedBytes{ 0 };
+
+    alignas(64) std::atomic<uint64_t> m_droppedBytes{ 0 };
+    std::atomic<uint64_t> m_overflowEvents{ 0 };
+    std::atomic<size_t>   m_highWater{ 0 };
+};
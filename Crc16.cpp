@@ -0,0 +1,57 @@
+// Crc16.cpp - CRC-16/MODBUS slice-by-8 (ver Crc16.h)
+
+#include "Crc16.h"
+
+#include <cstring>
+
+namespace {
+
+// kTable[0] é a tabela clássica; kTable[k][b] = CRC de 'b' seguido de k zeros.
+struct Crc16Tables {
+    uint16_t t[8][256];
+
+    Crc16Tables() {
+        for (int b = 0; b < 256; ++b) {
+            uint16_t crc = (uint16_t)b;
+            for (int i = 0; i < 8; ++i)
+                crc = (crc & 1) ? (uint16_t)((crc >> 1) ^ 0xA001) : (uint16_t)(crc >> 1);
+            t[0][b] = crc;
+        }
+        for (int k = 1; k < 8; ++k)
+            for (int b = 0; b < 256; ++b)
+                t[k][b] = (uint16_t)((t[k - 1][b] >> 8) ^ t[0][t[k - 1][b] & 0xFF]);
+    }
+};
+
+const Crc16Tables kTables;
+
+}  // namespace
+
+const uint16_t* Crc16ModbusTable() {
+    return kTables.t[0];
+}
+
+uint16_t Crc16ModbusBytewise(const uint8_t* data, size_t len, uint16_t crc) {
+    const uint16_t* t0 = kTables.t[0];
+    for (size_t i = 0; i < len; ++i)
+        crc = (uint16_t)((crc >> 8) ^ t0[(crc ^ data[i]) & 0xFF]);
+    return crc;
+}
+
+uint16_t Crc16Modbus(const uint8_t* data, size_t len, uint16_t crc) {
+    const uint16_t(*t)[256] = kTables.t;
+
+    // CRC refletido: o CRC atual entra nos 2 primeiros bytes do bloco; cada
+    // byte do bloco passa pela tabela correspondente à sua distância do fim.
+    while (len >= 8) {
+        uint8_t b[8];
+        memcpy(b, data, 8);
+        b[0] ^= (uint8_t)crc;
+        b[1] ^= (uint8_t)(crc >> 8);
+        crc = (uint16_t)(t[7][b[0]] ^ t[6][b[1]] ^ t[5][b[2]] ^ t[4][b[3]] ^
+                         t[3][b[4]] ^ t[2][b[5]] ^ t[1][b[6]] ^ t[0][b[7]]);
+        data += 8;
+        len -= 8;
+    }
+    return Crc16ModbusBytewise(data, len, crc);
+}
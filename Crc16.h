@@ -0,0 +1,27 @@
+// Crc16.h - CRC-16/MODBUS (poly 0x8005 refletido = 0xA001, init 0xFFFF)
+// Slice-by-8: 8 tabelas de 256 entradas, 8 bytes por iteração sem laço de
+// bits. Crc16ModbusBytewise() é a versão de uma tabela (referência/benchmark).
+// Verificação: Crc16Modbus("123456789") == 0x4B37.
+// Não depende de Win32.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// 'crc' permite continuar um cálculo em pedaços (padrão: valor inicial).
+uint16_t Crc16Modbus(const uint8_t* data, size_t len, uint16_t crc = 0xFFFF);
+uint16_t Crc16ModbusBytewise(const uint8_t* data, size_t len, uint16_t crc = 0xFFFF);
+
+// CRC byte a byte sem chamada por byte (ex.: ModbusRtuFramer, que testa o
+// CRC a cada byte): busca a tabela uma vez e avança com Crc16ModbusStep().
+const uint16_t* Crc16ModbusTable();
+inline uint16_t Crc16ModbusStep(const uint16_t* table, uint16_t crc, uint8_t b) {
+    return (uint16_t)((crc >> 8) ^ table[(crc ^ b) & 0xFF]);
+}
+
+// Frame Modbus RTU = dados + CRC (byte baixo primeiro). O CRC de um frame
+// íntegro, incluindo os 2 bytes finais, é zero.
+inline bool Crc16ModbusFrameOk(const uint8_t* frame, size_t len) {
+    return len >= 2 && Crc16Modbus(frame, len) == 0;
+}
@@ -0,0 +1,541 @@
+// DeviceSim.cpp - Dispositivo serial simulado (ver DeviceSim.h)
+
+#include "DeviceSim.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__linux__)
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+// ============================================================================
+//                          "sim:modo,chave=valor"
+// ============================================================================
+namespace {
+const char kSimPrefix[] = "sim:";
+
+struct SimModeEntry {
+    const char* name;
+    SimMode mode;
+};
+const SimModeEntry kSimModes[] = {
+    { "rate", SimMode::Rate },
+    { "burst", SimMode::Burst },
+    { "binary", SimMode::Binary },
+    { "telemetry", SimMode::Telemetry },
+    { "echo", SimMode::Echo },
+};
+
+bool ParseU64(const std::string& s, uint64_t* out) {
+    if (s.empty()) return false;
+    char* end = nullptr;
+    unsigned long long v = strtoull(s.c_str(), &end, 10);
+    if (*end != '\0') return false;
+    *out = v;
+    return true;
+}
+
+inline uint64_t XorShift(uint64_t* s) {
+    uint64_t x = *s;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *s = x;
+    return x;
+}
+}
+
+bool IsDeviceSimName(const std::string& name) {
+    return name.compare(0, sizeof(kSimPrefix) - 1, kSimPrefix) == 0;
+}
+
+const char* SimModeName(SimMode mode) {
+    for (const SimModeEntry& e : kSimModes)
+        if (e.mode == mode) return e.name;
+    return "?";
+}
+
+bool ParseDeviceSimSpec(const std::string& name, DeviceSimConfig* cfg, std::string* error) {
+    if (!IsDeviceSimName(name)) {
+        *error = "porta simulada precisa comecar com sim:";
+        return false;
+    }
+    DeviceSimConfig c;
+    std::string rest = name.substr(sizeof(kSimPrefix) - 1);
+    size_t comma = rest.find(',');
+    std::string mode = rest.substr(0, comma);
+    bool found = mode.empty();                     // "sim:" = rate
+    for (const SimModeEntry& e : kSimModes) {
+        if (mode == e.name) {
+            c.mode = e.mode;
+            found = true;
+        }
+    }
+    if (!found) {
+        *error = "modo de simulacao invalido: " + mode + " (rate|burst|binary|telemetry|echo)";
+        return false;
+    }
+
+    while (comma != std::string::npos) {
+        size_t start = comma + 1;
+        comma = rest.find(',', start);
+        std::string item = rest.substr(start, comma == std::string::npos ? std::string::npos : comma - start);
+        size_t eq = item.find('=');
+        std::string key = item.substr(0, eq);
+        std::string value = eq == std::string::npos ? "" : item.substr(eq + 1);
+        uint64_t v = 0;
+        bool ok = eq != std::string::npos;
+        if (ok && key == "reply") {
+            // O texto vai até o fim: pode ter vírgulas.
+            c.reply = rest.substr(start + eq + 1);
+            comma = std::string::npos;
+        }
+        else if (ok && key == "bps" && value == "max") {
+            c.bytesPerSec = UINT64_MAX;
+        }
+        else if (ok && key == "bps") {
+            ok = ParseU64(value, &c.bytesPerSec) && c.bytesPerSec > 0;
+        }
+        else if (ok && key == "seed") {
+            ok = ParseU64(value, &c.seed);
+        }
+        else if (ok && ParseU64(value, &v) && v <= UINT32_MAX) {
+            if (key == "burst" && v > 0) c.burstBytes = (uint32_t)v;
+            else if (key == "period" && v > 0) c.burstPeriodMs = (uint32_t)v;
+            else if (key == "latency") c.latencyUs = (uint32_t)v;
+            else if (key == "jitter") c.jitterUs = (uint32_t)v;
+            else ok = false;
+        }
+        else {
+            ok = false;
+        }
+        if (!ok) {
+            *error = "opcao de simulacao invalida: " + item;
+            return false;
+        }
+    }
+    if (c.seed == 0) c.seed = 1;                   // xorshift não sai do zero
+    *cfg = c;
+    return true;
+}
+
+// ============================================================================
+//                         Conteúdo (determinístico)
+// ============================================================================
+SimTrafficGenerator::SimTrafficGenerator(SimMode mode, uint64_t seed)
+    : m_mode(mode), m_state(seed ? seed : 1) {}
+
+uint32_t SimTrafficGenerator::Next() {
+    return (uint32_t)(XorShift(&m_state) >> 16);
+}
+
+// rate/burst: log com sequência (perda aparece como salto no seq=).
+// telemetry: tensão em rampa triangular lenta + ruído, corrente em dente de serra.
+void SimTrafficGenerator::NextLine() {
+    uint32_t r = Next();
+    unsigned long long seq = (unsigned long long)m_seq++;
+    int n;
+    if (m_mode == SimMode::Telemetry) {
+        uint32_t tri = (uint32_t)(seq % 2000);
+        if (tri > 1000) tri = 2000 - tri;
+        uint32_t mv = 4500 + tri + r % 10;
+        int32_t ma = (int32_t)(seq % 700) - 350;
+        n = snprintf(m_line, sizeof(m_line), "t=%llu v=%u.%03u i=%s%d.%03d\r\n",
+                     seq, mv / 1000, mv % 1000, ma < 0 ? "-" : "", abs(ma) / 1000, abs(ma) % 1000);
+    }
+    else {
+        n = snprintf(m_line, sizeof(m_line), "seq=%llu temp=%u.%02u C umid=%u.%u %% estado=%s\r\n",
+                     seq, 20 + r % 15, (r >> 8) % 100, 30 + (r >> 16) % 60, (r >> 24) % 10,
+                     (r & 1) ? "OK" : "AGUARDANDO");
+    }
+    m_lineLen = n > 0 ? (size_t)n : 0;
+    m_linePos = 0;
+}
+
+void SimTrafficGenerator::Fill(uint8_t* out, size_t n) {
+    if (m_mode == SimMode::Binary) {
+        for (size_t i = 0; i < n; ++i) out[i] = (uint8_t)Next();
+        return;
+    }
+    while (n > 0) {
+        if (m_linePos == m_lineLen) NextLine();
+        size_t k = std::min(n, m_lineLen - m_linePos);
+        memcpy(out, m_line + m_linePos, k);
+        m_linePos += k;
+        out += k;
+        n -= k;
+    }
+}
+
+// ============================================================================
+//                              SimSerialPort
+// ============================================================================
+bool SimSerialPort::Open(const std::string& name, const SerialConfig& cfg) {
+    Close();
+    if (!ParseDeviceSimSpec(name, &m_cfg, &m_lastError)) return false;
+    if (cfg.baudRate == 0) {
+        m_lastError = "baud invalido";
+        return false;
+    }
+
+    m_lineBytesPerSec = cfg.baudRate / 10.0;      // 8N1: 10 bits por byte
+    m_bytesPerSec = m_cfg.bytesPerSec ? (double)m_cfg.bytesPerSec : m_lineBytesPerSec;
+    if (m_cfg.mode == SimMode::Burst && m_cfg.bytesPerSec != UINT64_MAX) {
+        // Rajada mais longa que o período: a linha não dá conta, vira fluxo contínuo.
+        double burstNs = m_cfg.burstBytes * 1e9 / m_lineBytesPerSec;
+        if (burstNs > m_cfg.burstPeriodMs * 1e6) m_cfg.burstPeriodMs = (uint32_t)(burstNs / 1e6) + 1;
+    }
+    m_gen.reset(new SimTrafficGenerator(m_cfg.mode, m_cfg.seed));
+    m_jitterState = m_cfg.seed;
+    m_sent = 0;
+    m_timer.Reset();
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_replies.clear();
+        m_lineIn.clear();
+        m_cancelled = false;
+    }
+    m_rxBytes = 0;
+    m_txBytes = 0;
+    m_replyCount = 0;
+    m_lateMaxNs = 0;
+    m_t0 = PreciseTimer::NowNs();
+    m_open = true;
+    return true;
+}
+
+void SimSerialPort::Close() {
+    m_open = false;
+    m_gen.reset();
+}
+
+void SimSerialPort::CancelRead() {
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_cancelled = true;
+    }
+    m_wake.notify_all();
+    m_timer.Cancel();
+}
+
+std::string SimSerialPort::LastError() const {
+    return m_lastError;
+}
+
+DeviceSimStats SimSerialPort::Stats() const {
+    DeviceSimStats s;
+    s.rxBytes = m_rxBytes.load(std::memory_order_relaxed);
+    s.txBytes = m_txBytes.load(std::memory_order_relaxed);
+    s.replies = m_replyCount.load(std::memory_order_relaxed);
+    s.lateMaxNs = m_lateMaxNs.load(std::memory_order_relaxed);
+    return s;
+}
+
+long SimSerialPort::Read(void* buf, size_t len) {
+    if (!m_open || len == 0) return -1;
+    long n = m_cfg.mode == SimMode::Echo ? ReadEcho((uint8_t*)buf, len) : ReadStream((uint8_t*)buf, len);
+    if (n > 0) m_rxBytes.fetch_add((uint64_t)n, std::memory_order_relaxed);
+    return n;
+}
+
+// Bytes que já teriam chegado 'ns' depois do Open(). Rajada: 'burst' bytes
+// na velocidade da linha no começo de cada período.
+uint64_t SimSerialPort::BytesDue(int64_t ns) const {
+    if (ns <= 0) return 0;
+    if (m_cfg.mode != SimMode::Burst) return (uint64_t)((double)ns * m_bytesPerSec / 1e9);
+    const int64_t period = (int64_t)m_cfg.burstPeriodMs * 1000000;
+    const uint64_t k = (uint64_t)(ns / period);
+    const double inBurst = (double)(ns - (int64_t)k * period) * m_lineBytesPerSec / 1e9;
+    return k * m_cfg.burstBytes + std::min<uint64_t>(m_cfg.burstBytes, (uint64_t)inBurst);
+}
+
+int64_t SimSerialPort::TimeOf(uint64_t bytes) const {
+    if (m_cfg.mode != SimMode::Burst) return (int64_t)std::ceil((double)bytes * 1e9 / m_bytesPerSec);
+    const uint64_t k = bytes / m_cfg.burstBytes;
+    const uint64_t r = bytes % m_cfg.burstBytes;
+    return (int64_t)k * m_cfg.burstPeriodMs * 1000000 + (int64_t)std::ceil((double)r * 1e9 / m_lineBytesPerSec);
+}
+
+long SimSerialPort::ReadStream(uint8_t* out, size_t len) {
+    if (m_timer.Cancelled()) return 0;
+    if (m_cfg.bytesPerSec == UINT64_MAX) {          // sem limite: o consumidor dita o ritmo
+        m_gen->Fill(out, len);
+        m_sent += len;
+        return (long)len;
+    }
+
+    // Espera ~1 ms de linha (ou o fim da rajada atual), como o FIFO/latência
+    // de um adaptador USB: nada de leituras de 1 byte a 12 Mbaud.
+    uint64_t chunk = std::max<uint64_t>(1, std::min<uint64_t>((uint64_t)(m_lineBytesPerSec / 1000), len));
+    uint64_t target = m_sent + chunk;
+    if (m_cfg.mode == SimMode::Burst)
+        target = std::min<uint64_t>(target, (m_sent / m_cfg.burstBytes + 1) * m_cfg.burstBytes);
+    uint64_t due = BytesDue(PreciseTimer::NowNs() - m_t0);
+    if (due < target) {
+        if (!m_timer.SleepUntil(m_t0 + TimeOf(target))) return 0;
+        due = std::max(target, BytesDue(PreciseTimer::NowNs() - m_t0));
+    }
+
+    // Consumidor atrasado: entrega o acumulado (buffer do driver sem limite).
+    size_t n = (size_t)std::min<uint64_t>(len, due - m_sent);
+    m_gen->Fill(out, n);
+    m_sent += n;
+    return (long)n;
+}
+
+uint32_t SimSerialPort::Jitter() {
+    if (m_cfg.jitterUs == 0) return 0;
+    return (uint32_t)(XorShift(&m_jitterState) % ((uint64_t)m_cfg.jitterUs + 1));
+}
+
+// A ordem das respostas é a do fio: com jitter, uma não passa a anterior.
+long SimSerialPort::Write(const void* data, size_t len) {
+    if (!m_open) return -1;
+    m_txBytes.fetch_add(len, std::memory_order_relaxed);
+    if (m_cfg.mode != SimMode::Echo || len == 0) return (long)len;
+
+    const int64_t now = PreciseTimer::NowNs();
+    std::lock_guard<std::mutex> lock(m_lock);
+    auto schedule = [&](std::string text) {
+        int64_t due = now + ((int64_t)m_cfg.latencyUs + Jitter()) * 1000;
+        if (!m_replies.empty()) due = std::max(due, m_replies.back().dueNs);
+        m_replies.push_back(Reply{ due, std::move(text) });
+    };
+    if (m_cfg.reply.empty()) {
+        schedule(std::string((const char*)data, len));
+    }
+    else {
+        const char* p = (const char*)data;
+        for (size_t i = 0; i < len; ++i) {
+            if (p[i] != '\n') {
+                if (m_lineIn.size() < 4096) m_lineIn += p[i];
+                continue;
+            }
+            m_lineIn.clear();
+            schedule(m_cfg.reply + "\r\n");
+        }
+    }
+    m_wake.notify_one();
+    return (long)len;
+}
+
+// Dorme na condição até perto do prazo e termina no PreciseTimer (a
+// condição sozinha teria a granularidade do SO, ~1-15 ms).
+long SimSerialPort::ReadEcho(uint8_t* out, size_t len) {
+    const int64_t kFineNs = 2000000;
+    std::unique_lock<std::mutex> lock(m_lock);
+    for (;;) {
+        if (m_cancelled) return 0;
+        if (m_replies.empty()) {
+            m_wake.wait(lock);
+            continue;
+        }
+        const int64_t due = m_replies.front().dueNs;
+        const int64_t now = PreciseTimer::NowNs();
+        if (now >= due) break;
+        if (due - now > kFineNs) {
+            m_wake.wait_for(lock, std::chrono::nanoseconds(due - now - kFineNs));
+            continue;
+        }
+        lock.unlock();
+        bool ok = m_timer.SleepUntil(due);
+        lock.lock();
+        if (!ok) return 0;
+    }
+
+    // Todas as respostas vencidas que couberem (a última pode sair em parte).
+    const int64_t now = PreciseTimer::NowNs();
+    size_t n = 0;
+    while (n < len && !m_replies.empty() && m_replies.front().dueNs <= now) {
+        Reply& r = m_replies.front();
+        int64_t late = now - r.dueNs;
+        if (late > m_lateMaxNs.load(std::memory_order_relaxed)) m_lateMaxNs.store(late, std::memory_order_relaxed);
+        size_t k = std::min(len - n, r.data.size());
+        memcpy(out + n, r.data.data(), k);
+        n += k;
+        if (k < r.data.size()) {
+            r.data.erase(0, k);
+            r.dueNs = now;                      // o resto já venceu
+            break;
+        }
+        m_replies.pop_front();
+        m_replyCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    return (long)n;
+}
+
+// ============================================================================
+//                       Linux: o modelo atrás de um pty
+// ============================================================================
+#if defined(__linux__)
+bool SimPtyDevice::Start(const std::string& spec, uint32_t baudRate, std::string* error) {
+    Stop();
+    SerialConfig cfg;
+    cfg.baudRate = baudRate;
+    if (!m_port.Open(spec, cfg)) {
+        *error = m_port.LastError();
+        return false;
+    }
+
+    m_master = posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC);
+    char slaveName[128];
+    if (m_master < 0 || grantpt(m_master) != 0 || unlockpt(m_master) != 0 ||
+        ptsname_r(m_master, slaveName, sizeof(slaveName)) != 0) {
+        *error = std::string("posix_openpt: ") + strerror(errno);
+        Stop();
+        return false;
+    }
+    m_slavePath = slaveName;
+
+    // Escravo aberto em raw desde já: sem eco da tty (que voltaria ao mestre
+    // como "recebido") e sem EIO no mestre enquanto ninguém abriu a porta.
+    m_slaveHold = open(slaveName, O_RDWR | O_NOCTTY | O_CLOEXEC);
+    termios tio;
+    if (m_slaveHold < 0 || tcgetattr(m_slaveHold, &tio) != 0) {
+        *error = std::string("open ") + slaveName + ": " + strerror(errno);
+        Stop();
+        return false;
+    }
+    cfmakeraw(&tio);
+    tcsetattr(m_slaveHold, TCSANOW, &tio);
+
+    if (pipe2(m_stopPipe, O_CLOEXEC) != 0) {
+        *error = std::string("pipe: ") + strerror(errno);
+        Stop();
+        return false;
+    }
+    m_stop = false;
+    m_writer = std::thread([this] { WriterLoop(); });
+    m_reader = std::thread([this] { ReaderLoop(); });
+    return true;
+}
+
+void SimPtyDevice::Stop() {
+    m_stop = true;
+    if (m_stopPipe[1] >= 0) {
+        char b = 1;
+        ssize_t ignored = write(m_stopPipe[1], &b, 1);
+        (void)ignored;
+    }
+    m_port.CancelRead();
+    if (m_writer.joinable()) m_writer.join();
+    if (m_reader.joinable()) m_reader.join();
+    for (int* fd : { &m_master, &m_slaveHold, &m_stopPipe[0], &m_stopPipe[1] }) {
+        if (*fd >= 0) close(*fd);
+        *fd = -1;
+    }
+    m_port.Close();
+}
+
+// Gerador -> mestre. Espera o mestre aceitar (poll) ou o pedido de parada.
+void SimPtyDevice::WriterLoop() {
+    uint8_t buf[16384];
+    while (!m_stop.load()) {
+        long n = m_port.Read(buf, sizeof(buf));
+        if (n <= 0) break;
+        size_t off = 0;
+        while (off < (size_t)n && !m_stop.load()) {
+            pollfd fds[2] = { { m_master, POLLOUT, 0 }, { m_stopPipe[0], POLLIN, 0 } };
+            if (poll(fds, 2, -1) < 0 && errno != EINTR) return;
+            if (fds[1].revents) return;
+            if (!(fds[0].revents & POLLOUT)) continue;
+            ssize_t w = write(m_master, buf + off, (size_t)n - off);
+            if (w > 0) off += (size_t)w;
+            else if (w < 0 && errno != EAGAIN && errno != EINTR) return;
+        }
+    }
+}
+
+// Mestre -> Write() do modelo (echo/reply; nos outros modos só conta).
+void SimPtyDevice::ReaderLoop() {
+    uint8_t buf[4096];
+    while (!m_stop.load()) {
+        pollfd fds[2] = { { m_master, POLLIN, 0 }, { m_stopPipe[0], POLLIN, 0 } };
+        if (poll(fds, 2, -1) < 0 && errno != EINTR) return;
+        if (fds[1].revents) return;
+        if (!(fds[0].revents & POLLIN)) continue;
+        ssize_t n = read(m_master, buf, sizeof(buf));
+        if (n > 0) m_port.Write(buf, (size_t)n);
+        else if (n < 0 && errno != EAGAIN && errno != EINTR) return;
+    }
+}
+#endif
+
+// ============================================================================
+//                                  --sim
+// ============================================================================
+namespace {
+std::atomic<bool> g_simStop{ false };
+
+void OnSimStopSignal(int) {
+    g_simStop.store(true);
+}
+}
+
+int DeviceSimMain(int argc, char** argv) {
+    std::string spec = "sim:rate";
+    uint32_t baud = 115200;
+    double seconds = 0;
+    for (int i = 1; i < argc; i++) {
+        const char* a = argv[i];
+        if (strcmp(a, "--sim") == 0) continue;
+        if (strncmp(a, "--sim=", 6) == 0) spec = std::string("sim:") + (a + 6);
+        else if (strncmp(a, "--baud=", 7) == 0) baud = (uint32_t)strtoul(a + 7, nullptr, 10);
+        else if (strncmp(a, "--seconds=", 10) == 0) seconds = atof(a + 10);
+        else {
+            fprintf(stderr, "argumento invalido: %s\n"
+                            "uso: --sim=modo[,chave=valor...] [--baud=N] [--seconds=S] (ver DeviceSim.h)\n", a);
+            return 2;
+        }
+    }
+    DeviceSimConfig cfg;
+    std::string error;
+    if (!ParseDeviceSimSpec(spec, &cfg, &error) || baud == 0) {
+        fprintf(stderr, "%s\n", baud == 0 ? "baud invalido" : error.c_str());
+        return 2;
+    }
+
+#if defined(__linux__)
+    SimPtyDevice dev;
+    if (!dev.Start(spec, baud, &error)) {
+        fprintf(stderr, "erro: %s\n", error.c_str());
+        return 1;
+    }
+    // Só o caminho em stdout: scripts fazem PORT=$(... --sim=... | head -1).
+    printf("%s\n", dev.SlavePath().c_str());
+    fflush(stdout);
+
+    signal(SIGINT, OnSimStopSignal);
+    signal(SIGTERM, OnSimStopSignal);
+    const int64_t t0 = PreciseTimer::NowNs();
+    while (!g_simStop.load()) {
+        double elapsed = (PreciseTimer::NowNs() - t0) / 1e9;
+        if (seconds > 0 && elapsed >= seconds) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    double elapsed = (PreciseTimer::NowNs() - t0) / 1e9;
+    DeviceSimStats s = dev.Stats();
+    dev.Stop();
+    fprintf(stderr, "sim %s @ %u: %llu bytes gerados em %.2f s (%.0f B/s), %llu recebidos, %llu respostas",
+            SimModeName(cfg.mode), baud, (unsigned long long)s.rxBytes, elapsed,
+            elapsed > 0 ? s.rxBytes / elapsed : 0.0, (unsigned long long)s.txBytes,
+            (unsigned long long)s.replies);
+    if (cfg.mode == SimMode::Echo) fprintf(stderr, " (atraso max. %.3f ms)", s.lateMaxNs / 1e6);
+    fprintf(stderr, "\n");
+    return 0;
+#else
+    fprintf(stderr, "--sim precisa de pseudo-terminal (Linux). No Windows, conecte na porta %s direto.\n",
+            spec.c_str());
+    return 2;
+#endif
+}
@@ -0,0 +1,183 @@
+// DeviceSim.h - Dispositivo serial simulado (gerador de tráfego embutido)
+// Objetivo: testar e medir OpenSerialPort()/RX/decodificação/tela sem um
+//           dispositivo físico, com tráfego reproduzível em qualquer máquina.
+//
+// O dispositivo é SimSerialPort: implementa SerialPort (como a reprodução
+// de captura) e entra no mesmo caminho de uma porta real (SerialSession,
+// reactor, fila RX, TxQueue). Nome de porta "sim:modo[,chave=valor...]":
+// a GUI lista os modos no combo de portas, o --headless aceita
+// --port=sim:... e a SerialSession escolhe o backend pelo prefixo.
+//
+// Modos:
+//   rate       linhas de log com número de sequência, em taxa fixa
+//   burst      as mesmas linhas em rajadas: 'burst' bytes na velocidade da
+//              linha a cada 'period' ms, silêncio no resto
+//   binary     bytes aleatórios (xorshift), em taxa fixa
+//   telemetry  "t=... v=... i=..." em taxa fixa (ver Telemetry.h)
+//   echo       devolve o que recebe depois de 'latency' us (+ até 'jitter'
+//              us aleatórios); com reply=texto, responde cada linha recebida
+//              com o texto (+ "\r\n") em vez de ecoar
+// Chaves: bps=bytes/s (padrão baud/10 = linha saturada em 8N1; "max" = sem
+// limite, o mais rápido que o consumidor lê), burst=bytes, period=ms,
+// latency=us, jitter=us, reply=texto, seed=N.
+// Ex.: "sim:telemetry", "sim:burst,burst=8192,period=50", "sim:echo,latency=2000".
+//
+// Taxa: Read() entrega os bytes que já "chegaram" pelo relógio desde o
+// Open() (PreciseTimer), em blocos de ~1 ms de linha, como o FIFO de um
+// adaptador USB. O conteúdo depende só da 'seed': duas execuções geram os
+// mesmos bytes.
+//
+// Linux: SimPtyDevice liga o mesmo modelo ao mestre de um pseudo-terminal
+// e o escravo (/dev/pts/N) vira uma porta de verdade para qualquer programa
+// (--sim, ver DeviceSimMain). No Windows não há pty: use sim:... direto.
+//
+// Não depende de Win32.
+
+#pragma once
+
+#include "PreciseTimer.h"
+#include "SerialPort.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class SimMode { Rate, Burst, Binary, Telemetry, Echo };
+
+struct DeviceSimConfig {
+    SimMode  mode = SimMode::Rate;
+    uint64_t bytesPerSec = 0;      // 0 = baud / 10 (saturado); UINT64_MAX = sem limite
+    uint32_t burstBytes = 4096;
+    uint32_t burstPeriodMs = 100;
+    uint32_t latencyUs = 1000;
+    uint32_t jitterUs = 0;
+    std::string reply;             // echo: vazio = ecoa os bytes
+    uint64_t seed = 1;
+};
+
+// "sim:..." (o prefixo é o que decide o backend).
+bool IsDeviceSimName(const std::string& name);
+
+// Interpreta "sim:modo[,chave=valor...]". false = inválido (motivo em 'error').
+bool ParseDeviceSimSpec(const std::string& name, DeviceSimConfig* cfg, std::string* error);
+
+const char* SimModeName(SimMode mode);
+
+struct DeviceSimStats {
+    uint64_t rxBytes = 0;          // gerados (entregues a Read())
+    uint64_t txBytes = 0;          // recebidos por Write()
+    uint64_t replies = 0;          // echo: respostas entregues
+    int64_t  lateMaxNs = 0;        // echo: maior atraso além do agendado
+};
+
+// Conteúdo dos modos de fluxo (rate/burst/telemetry/binary): gera sempre a
+// mesma sequência para a mesma seed, em pedaços de qualquer tamanho.
+class SimTrafficGenerator {
+public:
+    SimTrafficGenerator(SimMode mode, uint64_t seed);
+    void Fill(uint8_t* out, size_t n);
+
+private:
+    uint32_t Next();
+    void NextLine();
+
+    SimMode m_mode;
+    uint64_t m_state;
+    uint64_t m_seq = 0;
+    char m_line[96];
+    size_t m_lineLen = 0;
+    size_t m_linePos = 0;
+};
+
+class SimSerialPort : public SerialPort {
+public:
+    SimSerialPort() {}
+
+    // 'name' = "sim:..."; cfg.baudRate define a velocidade da linha.
+    bool Open(const std::string& name, const SerialConfig& cfg) override;
+    void Close() override;
+    bool IsOpen() const override { return m_open; }
+    long Read(void* buf, size_t len) override;
+    long Write(const void* data, size_t len) override;
+    void CancelRead() override;
+    std::string LastError() const override;
+
+    const DeviceSimConfig& Config() const { return m_cfg; }
+    DeviceSimStats Stats() const;
+
+private:
+    struct Reply {
+        int64_t dueNs;
+        std::string data;
+    };
+
+    long ReadStream(uint8_t* out, size_t len);
+    long ReadEcho(uint8_t* out, size_t len);
+    uint64_t BytesDue(int64_t ns) const;   // bytes "chegados" em 'ns' desde m_t0
+    int64_t TimeOf(uint64_t bytes) const;  // inverso: instante (desde m_t0) do byte
+    uint32_t Jitter();
+
+    DeviceSimConfig m_cfg;
+    bool m_open = false;
+    double m_lineBytesPerSec = 11520;      // baud / 10
+    double m_bytesPerSec = 11520;          // taxa média (rate/binary/telemetry)
+    std::unique_ptr<SimTrafficGenerator> m_gen;
+    int64_t m_t0 = 0;
+    uint64_t m_sent = 0;                   // só a thread de leitura
+    PreciseTimer m_timer;
+
+    // echo: Write() (thread de escrita) agenda, Read() entrega.
+    std::mutex m_lock;
+    std::condition_variable m_wake;
+    std::deque<Reply> m_replies;
+    std::string m_lineIn;                  // reply=: linha recebida incompleta
+    uint64_t m_jitterState = 1;
+    bool m_cancelled = false;
+
+    std::atomic<uint64_t> m_rxBytes{ 0 };
+    std::atomic<uint64_t> m_txBytes{ 0 };
+    std::atomic<uint64_t> m_replyCount{ 0 };
+    std::atomic<int64_t> m_lateMaxNs{ 0 };
+    std::string m_lastError;
+};
+
+#if defined(__linux__)
+// O modelo acima do lado mestre de um pty: uma thread lê o SimSerialPort e
+// escreve no mestre; outra lê o mestre e chama Write() (echo). Escrita
+// bloqueada (o programa do lado escravo não lê) atrasa o gerador, como o
+// controle de fluxo de um adaptador.
+class SimPtyDevice {
+public:
+    ~SimPtyDevice() { Stop(); }
+
+    bool Start(const std::string& spec, uint32_t baudRate, std::string* error);
+    void Stop();
+
+    const std::string& SlavePath() const { return m_slavePath; }
+    DeviceSimStats Stats() const { return m_port.Stats(); }
+
+private:
+    void WriterLoop();
+    void ReaderLoop();
+
+    SimSerialPort m_port;
+    int m_master = -1;
+    int m_slaveHold = -1;       // mantém o escravo aberto e em modo raw
+    int m_stopPipe[2] = { -1, -1 };
+    std::string m_slavePath;
+    std::atomic<bool> m_stop{ false };
+    std::thread m_writer;
+    std::thread m_reader;
+};
+#endif
+
+// Ponto de entrada do modo --sim: --sim=modo[,chave=valor...] [--baud=N]
+// [--seconds=S]. Linux: cria o pty, imprime o escravo em stdout e gera até
+// Ctrl+C; resumo em stderr. Retorna 0, 1 (erro) ou 2 (argumentos).
+int DeviceSimMain(int argc, char** argv);
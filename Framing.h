@@ -0,0 +1,477 @@
+// Framing.h - Separação de mensagens (frames) no fluxo de bytes recebido
+// Objetivo: entre o leitor e os consumidores, transformar blocos de Read()
+//           (que cortam mensagens em qualquer ponto) em frames completos.
+//
+// Framers disponíveis:
+//   DelimiterFramer<D>     fim de frame = byte D (LineFramer: '\n', tira '\r')
+//   CobsFramer             COBS, frames terminados em 0x00
+//   SlipFramer             SLIP (RFC 1055), END = 0xC0
+//   LengthPrefixFramer<N>  cabeçalho de N bytes com o tamanho do payload
+//   ModbusRtuFramer        Modbus RTU: CRC-16 válido + silêncio (FeedTimed()/Gap())
+// Filtros (frame -> frame):
+//   Crc16ModbusCheck       valida e remove o CRC-16/MODBUS final
+// Composição em tempo de compilação (sem virtual por byte):
+//   Compose<SlipFramer, Crc16ModbusCheck>  = SLIP cujos frames levam CRC
+//
+// Interface comum (por convenção, não por herança virtual):
+//   template <class Sink> void Feed(uint8_t* data, size_t len, Sink&& sink);
+//   sink(FrameSpan) é chamado para cada frame completo, na mesma thread.
+//
+// Zero-cópia: 'data' é MUTÁVEL. Um frame inteiro dentro do bloco sai como
+// FrameSpan apontando para o próprio bloco (COBS/SLIP decodificam no lugar:
+// a saída nunca é maior que a entrada). Só frames partidos entre dois Feed()
+// passam por um buffer interno. O span vale até o sink retornar.
+//
+// Não depende de Win32.
+
+#pragma once
+
+#include "Crc16.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+struct FrameSpan {
+    uint8_t* data;
+    size_t len;
+};
+
+struct FramerStats {
+    uint64_t frames = 0;       // frames entregues
+    uint64_t errors = 0;       // frames inválidos (codificação, CRC, tamanho)
+    uint64_t overflows = 0;    // frames maiores que o limite (descartados/cortados)
+};
+
+// ============================================================================
+//               Base para framers com delimitador (CRTP, memchr)
+// ============================================================================
+// Derived fornece:
+//   bool Decode(uint8_t* p, size_t n, size_t* outLen);  // no lugar; false = inválido
+//   static const bool kSkipEmpty;                       // ignora frames vazios?
+//   static const bool kSplitLong;                       // frame > MaxFrame: corta (true) ou descarta
+template <class Derived, uint8_t Delim, size_t MaxFrame>
+class DelimitedFramer {
+public:
+    template <class Sink>
+    void Feed(uint8_t* data, size_t len, Sink&& sink) {
+        uint8_t* p = data;
+        uint8_t* end = data + len;
+        while (p < end) {
+            uint8_t* d = (uint8_t*)memchr(p, Delim, (size_t)(end - p));
+            if (!d) {
+                Carry(p, (size_t)(end - p), m_fed + (uint64_t)(p - data), sink);
+                break;
+            }
+            size_t n = (size_t)(d - p);
+            if (m_discarding) {
+                m_discarding = false;              // fim do frame grande demais
+            }
+            else if (m_carry.empty()) {
+                m_frameOffset = m_fed + (uint64_t)(p - data);
+                Emit(p, n, sink);                  // caso comum: zero-cópia
+            }
+            else if (!Derived::kSplitLong && m_carry.size() + n > MaxFrame) {
+                ++m_stats.overflows;
+                m_carry.clear();
+            }
+            else {
+                m_carry.insert(m_carry.end(), p, d);
+                m_frameOffset = m_carryOffset;
+                Emit(m_carry.data(), m_carry.size(), sink);
+                m_carry.clear();
+            }
+            p = d + 1;
+        }
+        m_fed += len;
+    }
+
+    // Entrega o frame incompleto pendente (ex.: prompt sem '\n' após timeout).
+    template <class Sink>
+    void Flush(Sink&& sink) {
+        if (m_carry.empty()) return;
+        m_frameOffset = m_carryOffset;
+        Emit(m_carry.data(), m_carry.size(), sink);
+        m_carry.clear();
+    }
+
+    size_t Pending() const { return m_carry.size(); }
+    void Reset() {
+        m_carry.clear();
+        m_discarding = false;
+        m_fed = 0;
+    }
+
+    // Offset no fluxo do primeiro byte do frame em entrega (válido no sink).
+    uint64_t FrameOffset() const { return m_frameOffset; }
+    const FramerStats& Stats() const { return m_stats; }
+
+protected:
+    template <class Sink>
+    void Emit(uint8_t* p, size_t n, Sink& sink) {
+        size_t out = n;
+        if (!static_cast<Derived*>(this)->Decode(p, n, &out)) {
+            ++m_stats.errors;
+            return;
+        }
+        if (out == 0 && Derived::kSkipEmpty) return;
+        ++m_stats.frames;
+        sink(FrameSpan{ p, out });
+    }
+
+    FramerStats m_stats;
+
+private:
+    // Sobra sem delimitador: guarda até o próximo bloco. Acima de MaxFrame o
+    // comportamento depende do framer (linhas são cortadas; binários descartados).
+    template <class Sink>
+    void Carry(uint8_t* p, size_t n, uint64_t streamOffset, Sink& sink) {
+        if (m_discarding) return;
+        if (m_carry.empty()) m_carryOffset = streamOffset;
+        if (m_carry.size() + n <= MaxFrame) {
+            m_carry.insert(m_carry.end(), p, p + n);
+            return;
+        }
+        ++m_stats.overflows;
+        if (Derived::kSplitLong) {
+            // Texto: entrega em pedaços de MaxFrame e continua.
+            m_carry.insert(m_carry.end(), p, p + n);
+            size_t off = 0;
+            while (m_carry.size() - off >= MaxFrame) {
+                m_frameOffset = m_carryOffset + off;
+                Emit(m_carry.data() + off, MaxFrame, sink);
+                off += MaxFrame;
+            }
+            m_carry.erase(m_carry.begin(), m_carry.begin() + off);
+            m_carryOffset += off;
+        }
+        else {
+            m_carry.clear();
+            m_discarding = true;                   // ignora até o próximo delimitador
+        }
+    }
+
+    std::vector<uint8_t> m_carry;
+    bool m_discarding = false;
+    uint64_t m_fed = 0;
+    uint64_t m_frameOffset = 0;
+    uint64_t m_carryOffset = 0;    // offset no fluxo do início de m_carry
+};
+
+// ---- Delimitador simples / linhas ----
+template <uint8_t Delim = '\n', bool StripCR = true, size_t MaxFrame = 4096>
+class DelimiterFramer : public DelimitedFramer<DelimiterFramer<Delim, StripCR, MaxFrame>, Delim, MaxFrame> {
+public:
+    static const bool kSkipEmpty = false;   // linha vazia é uma linha
+    static const bool kSplitLong = true;
+
+    bool Decode(uint8_t* p, size_t n, size_t* outLen) {
+        *outLen = (StripCR && n > 0 && p[n - 1] == '\r') ? n - 1 : n;
+        return true;
+    }
+};
+
+using LineFramer = DelimiterFramer<'\n', true, 4096>;
+
+// ---- COBS (Consistent Overhead Byte Stuffing) ----
+template <size_t MaxFrame = 4096>
+class CobsFramerT : public DelimitedFramer<CobsFramerT<MaxFrame>, 0x00, MaxFrame> {
+public:
+    static const bool kSkipEmpty = true;
+    static const bool kSplitLong = false;
+
+    // Decodifica no lugar: a escrita (w) nunca passa a leitura (r).
+    bool Decode(uint8_t* p, size_t n, size_t* outLen) {
+        size_t r = 0, w = 0;
+        while (r < n) {
+            uint8_t code = p[r++];
+            if (code == 0 || r + code - 1 > n) return false;
+            for (uint8_t i = 1; i < code; ++i) p[w++] = p[r++];
+            if (code != 0xFF && r < n) p[w++] = 0;
+        }
+        *outLen = w;
+        return true;
+    }
+};
+
+using CobsFramer = CobsFramerT<>;
+
+// ---- SLIP (RFC 1055) ----
+template <size_t MaxFrame = 4096>
+class SlipFramerT : public DelimitedFramer<SlipFramerT<MaxFrame>, 0xC0, MaxFrame> {
+public:
+    static const bool kSkipEmpty = true;    // END duplo (início de frame) é comum
+    static const bool kSplitLong = false;
+
+    bool Decode(uint8_t* p, size_t n, size_t* outLen) {
+        uint8_t* esc = (uint8_t*)memchr(p, 0xDB, n);
+        if (!esc) {                         // sem escape: nada a mudar
+            *outLen = n;
+            return true;
+        }
+        size_t w = (size_t)(esc - p);
+        for (size_t r = w; r < n; ++r) {
+            uint8_t c = p[r];
+            if (c == 0xDB) {
+                if (++r >= n) return false;
+                if (p[r] == 0xDC) c = 0xC0;
+                else if (p[r] == 0xDD) c = 0xDB;
+                else return false;
+            }
+            p[w++] = c;
+        }
+        *outLen = w;
+        return true;
+    }
+};
+
+using SlipFramer = SlipFramerT<>;
+
+// ============================================================================
+//                    Prefixo de tamanho (N bytes, LE ou BE)
+// ============================================================================
+// O frame entregue é só o payload. Tamanho acima de MaxFrame = fluxo
+// dessincronizado: descarta 1 byte e tenta de novo.
+template <size_t HeaderBytes = 2, bool BigEndian = false, size_t MaxFrame = 4096>
+class LengthPrefixFramer {
+    static_assert(HeaderBytes >= 1 && HeaderBytes <= 4, "cabeçalho de 1 a 4 bytes");
+
+public:
+    template <class Sink>
+    void Feed(uint8_t* data, size_t len, Sink&& sink) {
+        uint8_t* p = data;
+        uint8_t* end = data + len;
+
+        // Completa o frame partido do bloco anterior:
+        while (!m_carry.empty() && p < end) {
+            size_t need = (m_carry.size() < HeaderBytes)
+                ? HeaderBytes - m_carry.size()
+                : HeaderBytes + PayloadLen(m_carry.data()) - m_carry.size();
+            size_t n = (need < (size_t)(end - p)) ? need : (size_t)(end - p);
+            m_carry.insert(m_carry.end(), p, p + n);
+            p += n;
+            if (m_carry.size() < HeaderBytes) break;
+            size_t payload = PayloadLen(m_carry.data());
+            if (payload > MaxFrame) {
+                ++m_stats.errors;
+                // Ressincroniza: o que sobrou no carry volta a ser analisado.
+                std::vector<uint8_t> rest(m_carry.begin() + 1, m_carry.end());
+                m_carry.clear();
+                Feed(rest.data(), rest.size(), sink);
+                continue;
+            }
+            if (m_carry.size() == HeaderBytes + payload) {
+                ++m_stats.frames;
+                sink(FrameSpan{ m_carry.data() + HeaderBytes, payload });
+                m_carry.clear();
+            }
+        }
+
+        // Frames inteiros dentro do bloco: zero-cópia.
+        while (p < end) {
+            size_t avail = (size_t)(end - p);
+            if (avail < HeaderBytes) break;
+            size_t payload = PayloadLen(p);
+            if (payload > MaxFrame) {
+                ++m_stats.errors;
+                ++p;
+                continue;
+            }
+            if (avail < HeaderBytes + payload) break;
+            ++m_stats.frames;
+            sink(FrameSpan{ p + HeaderBytes, payload });
+            p += HeaderBytes + payload;
+        }
+        if (p < end) m_carry.insert(m_carry.end(), p, end);
+    }
+
+    size_t Pending() const { return m_carry.size(); }
+    void Reset() { m_carry.clear(); }
+    const FramerStats& Stats() const { return m_stats; }
+
+private:
+    static size_t PayloadLen(const uint8_t* h) {
+        size_t v = 0;
+        for (size_t i = 0; i < HeaderBytes; ++i) {
+            size_t b = h[BigEndian ? i : HeaderBytes - 1 - i];
+            v = (v << 8) | b;
+        }
+        return v;
+    }
+
+    std::vector<uint8_t> m_carry;
+    FramerStats m_stats;
+};
+
+// ============================================================================
+//                               Modbus RTU
+// ============================================================================
+// O RTU não tem delimitador: frames são separados por silêncio >= 3,5
+// caracteres (t3.5). Sem o tempo, o framer corta pelo CRC: o CRC corre
+// byte a byte sobre o que está acumulado e o frame fecha no primeiro
+// prefixo (>= kMinFrame) cujo CRC, incluindo os 2 bytes finais, dá zero.
+// Assim vários frames no mesmo bloco saem um a um, sem cópia; só o frame
+// partido entre blocos passa pelo buffer interno. Entregue: endereço +
+// função + dados + CRC.
+//
+// Um CRC casar por acaso no meio de um frame (1/65536 por posição) ou
+// bytes de lixo antes de um frame desalinham o corte até o próximo
+// silêncio. Por isso quem lê a porta deve informar o tempo: FeedTimed()
+// com o instante de cada leitura chama Gap() sozinho quando o intervalo
+// desde a leitura anterior passa de t3.5 (GapMicros()); ou o chamador
+// chama Gap() ao detectar o silêncio. O reactor/sessão não fazem isso por
+// conta própria (as abas da GUI usam só o LineFramer).
+//
+// Acumulado chegando a kMaxFrame sem CRC válido = lixo: é descartado e a
+// busca recomeça nos bytes novos (contado em overflows).
+class ModbusRtuFramer {
+public:
+    static const size_t kMaxFrame = 256;
+    static const size_t kMinFrame = 4;       // endereço + função + CRC
+
+    template <class Sink>
+    void Feed(uint8_t* data, size_t len, Sink&& sink) {
+        uint8_t* p = data;
+        uint8_t* end = data + len;
+        const uint16_t* table = Crc16ModbusTable();
+
+        // Completa o frame partido do bloco anterior (o CRC continua de onde parou):
+        while (!m_carry.empty() && p < end) {
+            if (m_carry.size() >= kMaxFrame) {
+                ++m_stats.overflows;
+                m_carry.clear();             // recomeça nos bytes novos
+                break;
+            }
+            m_carry.push_back(*p);
+            m_crc = Crc16ModbusStep(table, m_crc, *p);
+            ++p;
+            if (m_carry.size() >= kMinFrame && m_crc == 0) {
+                ++m_stats.frames;
+                sink(FrameSpan{ m_carry.data(), m_carry.size() });
+                m_carry.clear();
+            }
+        }
+
+        // Frames dentro do bloco: zero-cópia.
+        while (p < end) {
+            size_t avail = (size_t)(end - p);
+            size_t limit = avail < kMaxFrame ? avail : kMaxFrame;
+            uint16_t crc = 0xFFFF;
+            size_t n = 0;
+            while (n < limit) {
+                crc = Crc16ModbusStep(table, crc, p[n]);
+                ++n;
+                if (n >= kMinFrame && crc == 0) break;
+            }
+            if (n >= kMinFrame && crc == 0) {
+                ++m_stats.frames;
+                sink(FrameSpan{ p, n });
+                p += n;
+                continue;
+            }
+            if (n == kMaxFrame) {            // kMaxFrame bytes sem frame: lixo
+                ++m_stats.overflows;
+                p += n;
+                continue;
+            }
+            m_carry.assign(p, end);          // início de frame: espera o resto
+            m_crc = crc;
+            break;
+        }
+    }
+
+    // Feed() com o instante da leitura (mesma base de PreciseTimer::NowNs()):
+    // intervalo >= t3.5 desde a leitura anterior = Gap() antes dos bytes novos.
+    template <class Sink>
+    void FeedTimed(uint8_t* data, size_t len, int64_t rxNs, Sink&& sink) {
+        if (m_lastRxNs && rxNs - m_lastRxNs >= (int64_t)m_gapUs * 1000) Gap();
+        m_lastRxNs = rxNs;
+        Feed(data, len, sink);
+    }
+
+    // Silêncio de 3,5 caracteres: o que estava acumulado não fechou CRC.
+    void Gap() {
+        if (m_carry.empty()) return;
+        ++m_stats.errors;
+        m_carry.clear();
+    }
+
+    // t3.5 em microssegundos (acima de 19200 baud a norma fixa 1750 us).
+    static uint32_t GapMicros(uint32_t baudRate) {
+        if (baudRate == 0 || baudRate > 19200) return 1750;
+        return (uint32_t)(35ull * 11 * 1000000 / 10 / baudRate);
+    }
+    // Baud da linha (para o t3.5 de FeedTimed()). Padrão: 1750 us.
+    void SetBaudRate(uint32_t baudRate) { m_gapUs = GapMicros(baudRate); }
+
+    size_t Pending() const { return m_carry.size(); }
+    void Reset() {
+        m_carry.clear();
+        m_lastRxNs = 0;
+    }
+    const FramerStats& Stats() const { return m_stats; }
+
+private:
+    std::vector<uint8_t> m_carry;
+    uint16_t m_crc = 0xFFFF;                 // CRC de m_carry até aqui
+    uint32_t m_gapUs = 1750;
+    int64_t m_lastRxNs = 0;
+    FramerStats m_stats;
+};
+
+// ============================================================================
+//                                  Filtros
+// ============================================================================
+// Cada Feed() é UM frame. Valida o CRC-16/MODBUS final e o remove.
+class Crc16ModbusCheck {
+public:
+    template <class Sink>
+    void Feed(uint8_t* data, size_t len, Sink&& sink) {
+        if (!Crc16ModbusFrameOk(data, len)) {
+            ++m_stats.errors;
+            return;
+        }
+        ++m_stats.frames;
+        sink(FrameSpan{ data, len - 2 });
+    }
+
+    void Reset() {}
+    const FramerStats& Stats() const { return m_stats; }
+
+private:
+    FramerStats m_stats;
+};
+
+// ============================================================================
+//                                Composição
+// ============================================================================
+// Compose<A, B, C>: frames de A alimentam B (um Feed por frame), os de B
+// alimentam C e os de C vão para o sink. Tudo resolvido em compilação.
+template <class First, class... Rest>
+class Compose;
+
+template <class Only>
+class Compose<Only> : public Only {};
+
+template <class First, class Second, class... Rest>
+class Compose<First, Second, Rest...> {
+public:
+    template <class Sink>
+    void Feed(uint8_t* data, size_t len, Sink&& sink) {
+        m_first.Feed(data, len, [&](FrameSpan f) { m_rest.Feed(f.data, f.len, sink); });
+    }
+
+    void Reset() {
+        m_first.Reset();
+        m_rest.Reset();
+    }
+
+    First& Outer() { return m_first; }
+    Compose<Second, Rest...>& Inner() { return m_rest; }
+
+private:
+    First m_first;
+    Compose<Second, Rest...> m_rest;
+};
@@ -0,0 +1,481 @@
+// Headless.cpp - Modo sem janela: porta <-> stdout/stdin (ver Headless.h)
+
+#include "Headless.h"
+#include "DeviceSim.h"
+#include "MappedFile.h"
+#include "PreciseTimer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <thread>
+
+#if defined(_WIN32)
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const size_t kIoBytes = 64 * 1024;         // por syscall (= capacidade padrão de um pipe no Linux)
+
+std::atomic<bool> g_stopRequested{ false };
+
+int FileFd(std::FILE* f) {
+#if defined(_WIN32)
+    return _fileno(f);
+#else
+    return fileno(f);
+#endif
+}
+
+void OnStopSignal(int) {
+    g_stopRequested.store(true);
+}
+
+// Estado compartilhado entre a thread principal e as de RX/TX.
+struct HeadlessIo {
+    std::shared_ptr<SerialPort> port;
+    int outFd = -1;
+    int inFd = -1;                         // -1 = sem TX
+    bool zeroCopy = true;
+#if defined(__linux__)
+    int stopFd = -1;                       // eventfd: legível = parar
+#endif
+
+    std::atomic<uint64_t> rxBytes{ 0 };
+    std::atomic<uint64_t> txBytes{ 0 };
+    std::atomic<bool> rxDone{ false };
+    std::atomic<bool> txDone{ false };
+
+    // Escritos pela thread dona antes de marcar rxDone/txDone:
+    bool portLost = false;
+    std::string rxError, txError;
+    const char* rxMode = "read/write";
+    const char* txMode = "-";
+};
+
+// Escreve tudo em 'fd' (bloqueante). false = erro (ex.: EPIPE, disco cheio).
+bool WriteAll(int fd, const char* data, size_t len) {
+    while (len > 0) {
+#if defined(_WIN32)
+        int w = _write(fd, data, (unsigned)std::min(len, (size_t)INT_MAX));
+#else
+        ssize_t w = write(fd, data, len);
+        if (w < 0 && errno == EINTR) continue;
+#endif
+        if (w <= 0) return false;
+        data += w;
+        len -= (size_t)w;
+    }
+    return true;
+}
+
+// Envia o bloco pela porta. Write() desiste após writeTimeoutMs (flow
+// control): tenta de novo até sair tudo ou pedirem para parar.
+bool PortWriteAll(SerialPort& port, const char* data, size_t len, std::string* error) {
+    while (len > 0) {
+        long w = port.Write(data, len);
+        if (w < 0) {
+            *error = "escrita na porta falhou: " + port.LastError();
+            return false;
+        }
+        if (w == 0 && g_stopRequested.load()) return false;
+        data += w;
+        len -= (size_t)w;
+    }
+    return true;
+}
+
+// RX pelo Read() bloqueante da porta: Windows e portas sem descritor
+// (dispositivo simulado, ver DeviceSim.h). Para com CancelRead().
+void RxLoopBlocking(HeadlessIo* io) {
+    std::unique_ptr<char[]> buf(new char[kIoBytes]);
+    for (;;) {
+        long n = io->port->Read(buf.get(), kIoBytes);
+        if (n == 0) break;   // CancelRead()
+        if (n < 0) {
+            io->portLost = true;
+            io->rxError = io->port->LastError();
+            break;
+        }
+        if (!WriteAll(io->outFd, buf.get(), (size_t)n)) {
+            io->rxError = std::string("escrita da saida falhou: ") + strerror(errno);
+            break;
+        }
+        io->rxBytes += (uint64_t)n;
+    }
+    io->rxDone.store(true);
+}
+
+#if defined(__linux__)
+// ============================================================================
+//                       Linux: poll + splice/sendfile
+// ============================================================================
+// Espera 'fd' ficar legível (ou hangup/erro: a leitura seguinte diz o quê).
+// false = pediram para parar.
+bool WaitReadable(int fd, int stopFd) {
+    pollfd p[2] = { { fd, POLLIN, 0 }, { stopFd, POLLIN, 0 } };
+    for (;;) {
+        int n = poll(p, 2, -1);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 || p[1].revents) return false;
+        return true;
+    }
+}
+
+// RX: tty -> saída. Saída pipe: um splice() direto. Arquivo/tty: tty -> pipe
+// intermediário -> saída (as páginas passam de um lado ao outro sem cópia para
+// o usuário). O primeiro EINVAL (driver/kernel sem splice) troca para read()/
+// write() num buffer só.
+void RxLoop(HeadlessIo* io) {
+    int portFd = (int)io->port->NativeHandle();
+    if (portFd < 0) {
+        RxLoopBlocking(io);
+        return;
+    }
+    struct stat st;
+    bool outIsPipe = fstat(io->outFd, &st) == 0 && S_ISFIFO(st.st_mode);
+    int pipeFds[2] = { -1, -1 };
+    bool spliceIn = io->zeroCopy && (outIsPipe || pipe2(pipeFds, O_CLOEXEC) == 0);
+    bool spliceOut = spliceIn && !outIsPipe;
+    std::unique_ptr<char[]> buf(new char[kIoBytes]);
+    io->rxMode = spliceIn ? (outIsPipe ? "splice" : "splice+pipe") : "read/write";
+
+    while (WaitReadable(portFd, io->stopFd)) {
+        if (!spliceIn) {
+            long n = io->port->ReadNow(buf.get(), kIoBytes);
+            if (n == 0) continue;
+            if (n < 0) {
+                io->portLost = true;
+                io->rxError = io->port->LastError();
+                break;
+            }
+            if (!WriteAll(io->outFd, buf.get(), (size_t)n)) {
+                io->rxError = std::string("escrita da saida falhou: ") + strerror(errno);
+                break;
+            }
+            io->rxBytes += (uint64_t)n;
+            continue;
+        }
+
+        int dst = outIsPipe ? io->outFd : pipeFds[1];
+        ssize_t n = splice(portFd, nullptr, dst, nullptr, kIoBytes, SPLICE_F_MOVE);
+        if (n < 0 && (errno == EINTR || errno == EAGAIN)) continue;
+        if (n < 0 && errno == EINVAL && io->rxBytes == 0) {
+            spliceIn = spliceOut = false;
+            io->rxMode = "read/write";
+            continue;
+        }
+        if (n < 0 && errno == EPIPE) {
+            io->rxError = "saida fechada";
+            break;
+        }
+        if (n <= 0) {
+            io->portLost = true;   // EIO (USB removido) ou hangup
+            io->rxError = n < 0 ? strerror(errno) : "hangup";
+            break;
+        }
+
+        // Esvazia o pipe intermediário na saída:
+        size_t left = outIsPipe ? 0 : (size_t)n;
+        while (left > 0) {
+            if (spliceOut) {
+                ssize_t m = splice(pipeFds[0], nullptr, io->outFd, nullptr, left, SPLICE_F_MOVE);
+                if (m > 0) {
+                    left -= (size_t)m;
+                    continue;
+                }
+                if (m < 0 && errno == EINTR) continue;
+                if (m < 0 && errno == EINVAL) {
+                    spliceOut = false;   // saída sem splice_write: copia o resto
+                    io->rxMode = "splice+read/write";
+                    continue;
+                }
+                break;
+            }
+            ssize_t r = read(pipeFds[0], buf.get(), std::min(left, kIoBytes));
+            if (r <= 0 || !WriteAll(io->outFd, buf.get(), (size_t)r)) break;
+            left -= (size_t)r;
+        }
+        if (left > 0) {
+            io->rxError = std::string("escrita da saida falhou: ") + strerror(errno);
+            break;
+        }
+        io->rxBytes += (uint64_t)n;
+    }
+
+    if (pipeFds[0] >= 0) close(pipeFds[0]);
+    if (pipeFds[1] >= 0) close(pipeFds[1]);
+    io->rxDone.store(true);
+}
+
+// TX: entrada -> tty. stdin pipe: splice(); arquivo: sendfile(); senão read()
+// + Write(). A escrita na tty é bloqueante: flow control segura só esta thread.
+void TxLoop(HeadlessIo* io) {
+    int portFd = (int)io->port->NativeHandle();
+    struct stat st;
+    bool isPipe = false, isFile = false;
+    if (fstat(io->inFd, &st) == 0) {
+        isPipe = S_ISFIFO(st.st_mode);
+        isFile = S_ISREG(st.st_mode);
+    }
+    enum { kSplice, kSendfile, kCopy } mode =
+        !io->zeroCopy || portFd < 0 ? kCopy : isPipe ? kSplice : isFile ? kSendfile : kCopy;
+    std::unique_ptr<char[]> buf(new char[kIoBytes]);
+
+    for (;;) {
+        io->txMode = (mode == kSplice) ? "splice" : (mode == kSendfile) ? "sendfile" : "read/write";
+        if (!WaitReadable(io->inFd, io->stopFd)) break;
+
+        if (mode != kCopy) {
+            ssize_t n = (mode == kSplice)
+                ? splice(io->inFd, nullptr, portFd, nullptr, kIoBytes, SPLICE_F_MOVE)
+                : sendfile(portFd, io->inFd, nullptr, kIoBytes);
+            if (n > 0) {
+                io->txBytes += (uint64_t)n;
+                continue;
+            }
+            if (n == 0) break;   // fim da entrada
+            if (errno == EINTR || errno == EAGAIN) continue;
+            if ((errno == EINVAL || errno == ENOSYS) && io->txBytes == 0) {
+                mode = kCopy;    // tty sem splice_write (kernels antigos)
+                continue;
+            }
+            io->txError = std::string("escrita na porta falhou: ") + strerror(errno);
+            break;
+        }
+
+        ssize_t n = read(io->inFd, buf.get(), kIoBytes);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        if (!PortWriteAll(*io->port, buf.get(), (size_t)n, &io->txError)) break;
+        io->txBytes += (uint64_t)n;
+    }
+    io->txDone.store(true);
+}
+
+#else
+// ============================================================================
+//                  Windows: Read() bloqueante + descritores da CRT
+// ============================================================================
+void RxLoop(HeadlessIo* io) {
+    RxLoopBlocking(io);
+}
+
+// Bloqueia em _read() do stdin: não dá para cancelar; ao parar, a thread
+// principal a solta (detach) se ainda estiver esperando.
+void TxLoop(HeadlessIo* io) {
+    io->txMode = "read/write";
+    std::unique_ptr<char[]> buf(new char[kIoBytes]);
+    for (;;) {
+        int n = _read(io->inFd, buf.get(), (unsigned)kIoBytes);
+        if (n <= 0 || g_stopRequested.load()) break;
+        if (!PortWriteAll(*io->port, buf.get(), (size_t)n, &io->txError)) break;
+        io->txBytes += (uint64_t)n;
+    }
+    io->txDone.store(true);
+}
+#endif
+
+double CpuSeconds() {
+#if defined(_WIN32)
+    return -1;
+#else
+    rusage ru = {};
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_utime.tv_sec + ru.ru_stime.tv_sec + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+#endif
+}
+
+void PrintUsage() {
+    fprintf(stderr,
+            "uso: --headless --port=/dev/ttyUSB0|COM6|sim:... [--baud=115200] [--data-bits=8]\n"
+            "                [--parity=none|odd|even] [--stop-bits=1|2] [--no-dtr] [--no-rts]\n"
+            "                [--out=-|arquivo] [--append] [--in=-|arquivo|none]\n"
+            "                [--seconds=S] [--no-splice] [--quiet]\n");
+}
+
+}  // namespace
+
+bool ParseHeadlessArgs(int argc, char** argv, HeadlessOptions* opt, std::string* error) {
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        const char* eq = strchr(a, '=');
+        std::string key = eq ? std::string(a, eq) : std::string(a);
+        std::string val = eq ? eq + 1 : "";
+        bool ok = true;
+        if (key == "--headless") {}
+        else if (key == "--port") ok = !(opt->port = val).empty();
+        else if (key == "--baud") ok = (opt->cfg.baudRate = (uint32_t)strtoul(val.c_str(), nullptr, 10)) > 0;
+        else if (key == "--data-bits") {
+            int bits = atoi(val.c_str());
+            ok = bits >= 5 && bits <= 8;
+            opt->cfg.dataBits = (uint8_t)bits;
+        }
+        else if (key == "--parity") {
+            if (val == "none") opt->cfg.parity = SerialParity::None;
+            else if (val == "odd") opt->cfg.parity = SerialParity::Odd;
+            else if (val == "even") opt->cfg.parity = SerialParity::Even;
+            else ok = false;
+        }
+        else if (key == "--stop-bits") {
+            if (val == "1") opt->cfg.stopBits = SerialStopBits::One;
+            else if (val == "2") opt->cfg.stopBits = SerialStopBits::Two;
+            else ok = false;
+        }
+        else if (key == "--no-dtr") opt->cfg.dtr = false;
+        else if (key == "--no-rts") opt->cfg.rts = false;
+        else if (key == "--out") ok = !(opt->outPath = val).empty();
+        else if (key == "--append") opt->append = true;
+        else if (key == "--in") ok = !(opt->inPath = val).empty();
+        else if (key == "--seconds") ok = (opt->seconds = atof(val.c_str())) > 0;
+        else if (key == "--no-splice") opt->zeroCopy = false;
+        else if (key == "--quiet") opt->quiet = true;
+        else ok = false;
+        if (!ok) {
+            if (error) *error = std::string("argumento invalido: ") + a;
+            return false;
+        }
+    }
+    if (opt->port.empty()) {
+        if (error) *error = "falta --port=";
+        return false;
+    }
+    return true;
+}
+
+int HeadlessMain(int argc, char** argv) {
+    HeadlessOptions opt;
+    std::string error;
+    if (!ParseHeadlessArgs(argc, argv, &opt, &error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        PrintUsage();
+        return 2;
+    }
+
+#if defined(_WIN32)
+    _setmode(_fileno(stdout), _O_BINARY);   // sem CRLF nem ^Z: bytes como vieram
+    _setmode(_fileno(stdin), _O_BINARY);
+#else
+    signal(SIGPIPE, SIG_IGN);               // saída fechada vira EPIPE, não morte
+#endif
+    signal(SIGINT, OnStopSignal);
+    signal(SIGTERM, OnStopSignal);
+
+    // ---- Saída, entrada e porta ----
+    std::FILE* outFile = nullptr;
+    std::FILE* inFile = nullptr;
+    std::shared_ptr<HeadlessIo> io(new HeadlessIo());
+    io->zeroCopy = opt.zeroCopy;
+    io->outFd = FileFd(stdout);
+    if (opt.outPath != "-") {
+        outFile = FOpenUtf8(opt.outPath, opt.append ? "ab" : "wb");
+        if (!outFile) {
+            fprintf(stderr, "nao foi possivel abrir %s: %s\n", opt.outPath.c_str(), strerror(errno));
+            return 1;
+        }
+        io->outFd = FileFd(outFile);
+    }
+    if (opt.inPath == "-") {
+        io->inFd = FileFd(stdin);
+    }
+    else if (opt.inPath != "none") {
+        inFile = FOpenUtf8(opt.inPath, "rb");
+        if (!inFile) {
+            fprintf(stderr, "nao foi possivel abrir %s: %s\n", opt.inPath.c_str(), strerror(errno));
+            if (outFile) fclose(outFile);
+            return 1;
+        }
+        io->inFd = FileFd(inFile);
+    }
+
+    io->port.reset(IsDeviceSimName(opt.port) ? new SimSerialPort() : CreateSerialPort().release());
+    if (!io->port->Open(opt.port, opt.cfg)) {
+        fprintf(stderr, "%s: %s\n", opt.port.c_str(), io->port->LastError().c_str());
+        if (outFile) fclose(outFile);
+        if (inFile) fclose(inFile);
+        return 1;
+    }
+#if defined(__linux__)
+    io->stopFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+#endif
+
+    // ---- Cópia nos dois sentidos até parar ----
+    int64_t t0 = PreciseTimer::NowNs();
+    double cpu0 = CpuSeconds();
+    std::thread rx([io] { RxLoop(io.get()); });
+    std::thread tx;
+    if (io->inFd >= 0) tx = std::thread([io] { TxLoop(io.get()); });
+    else io->txDone.store(true);
+
+    int64_t deadline = opt.seconds > 0 ? t0 + (int64_t)(opt.seconds * 1e9) : INT64_MAX;
+    while (!g_stopRequested.load() && !io->rxDone.load() && PreciseTimer::NowNs() < deadline)
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+#if defined(__linux__)
+    uint64_t one = 1;
+    ssize_t w = write(io->stopFd, &one, sizeof(one));
+    (void)w;
+    if (io->port->NativeHandle() < 0) io->port->CancelRead();
+#else
+    g_stopRequested.store(true);
+    io->port->CancelRead();
+#endif
+    rx.join();
+    bool txDetached = false;
+    if (tx.joinable()) {
+#if defined(__linux__)
+        tx.join();
+#else
+        // Ainda preso no _read() do stdin: segue solto até o processo sair
+        // (o HeadlessIo e a porta ficam vivos pelo shared_ptr da thread).
+        if (io->txDone.load()) tx.join();
+        else { tx.detach(); txDetached = true; }
+#endif
+    }
+
+    HeadlessStats stats;
+    stats.seconds = (PreciseTimer::NowNs() - t0) / 1e9;
+    stats.cpuSeconds = cpu0 >= 0 ? CpuSeconds() - cpu0 : -1;
+    stats.rxBytes = io->rxBytes.load();
+    stats.txBytes = io->txBytes.load();
+    stats.rxMode = io->rxMode;
+    stats.txMode = io->txMode;
+    stats.portLost = io->portLost;
+    stats.error = !io->rxError.empty() ? io->rxError : io->txError;
+
+    if (!txDetached) io->port->Close();
+#if defined(__linux__)
+    close(io->stopFd);
+#endif
+    if (outFile) fclose(outFile);
+    if (inFile && !txDetached) fclose(inFile);
+
+    if (!opt.quiet) {
+        char cpu[32] = "n/d";
+        if (stats.cpuSeconds >= 0) snprintf(cpu, sizeof(cpu), "%.3f s", stats.cpuSeconds);
+        fprintf(stderr, "headless: RX %llu B, TX %llu B em %.2f s (RX %.1f KB/s), CPU %s, RX %s, TX %s\n",
+                (unsigned long long)stats.rxBytes, (unsigned long long)stats.txBytes, stats.seconds,
+                stats.seconds > 0 ? stats.rxBytes / stats.seconds / 1000.0 : 0.0, cpu,
+                stats.rxMode, stats.txMode);
+        if (!stats.error.empty())
+            fprintf(stderr, "headless: %s%s\n", stats.portLost ? "porta perdida: " : "", stats.error.c_str());
+    }
+    return (stats.portLost || !stats.error.empty()) ? 1 : 0;
+}
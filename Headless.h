@@ -0,0 +1,58 @@
+// Headless.h - Modo sem janela ("--headless"): porta <-> stdout/stdin/arquivos
+// Objetivo: usar o terminal em racks de CI e scripts: abre a porta pelos
+//           argumentos, manda os bytes RX para stdout (ou arquivo) e envia
+//           o que chegar em stdin (ou arquivo), sem GUI.
+//
+//  - Bytes crus nos dois sentidos: nada de UTF-8/UTF-16, HEX ou linhas.
+//  - Linux: RX tty -> saída com splice() (via pipe intermediário quando a
+//    saída não é um pipe); TX com splice() (stdin pipe) ou sendfile()
+//    (arquivo). Kernel/driver sem suporte: read()/write() num buffer único.
+//  - Windows: uma thread lê a porta (Read() overlapped) e escreve direto no
+//    descritor de saída; outra lê stdin e chama Write().
+//  - Para com Ctrl+C/SIGTERM, depois de --seconds, ou se a porta cair.
+//    Resumo (bytes, vazão, CPU, modo de cópia) vai para stderr.
+//
+// Uso (Windows: SerialCPP.exe --headless ...; Linux: ver MainPosix.cpp):
+//   --headless --port=/dev/ttyUSB0|COM6|sim:... [--baud=115200] [--data-bits=8]
+//              [--parity=none|odd|even] [--stop-bits=1|2] [--no-dtr] [--no-rts]
+//              [--out=-|arquivo] [--append] [--in=-|arquivo|none]
+//              [--seconds=S] [--no-splice] [--quiet]
+//
+// Não depende de Win32.
+
+#pragma once
+
+#include "SerialPort.h"
+
+#include <cstdint>
+#include <string>
+
+struct HeadlessOptions {
+    std::string port;
+    SerialConfig cfg;
+    std::string outPath = "-";             // "-" = stdout
+    bool     append = false;               // acrescenta ao arquivo em vez de truncar
+    std::string inPath = "-";              // "-" = stdin, "none" = não envia nada
+    double   seconds = 0;                  // 0 = até Ctrl+C ou a porta cair
+    bool     zeroCopy = true;              // Linux: splice/sendfile quando der
+    bool     quiet = false;                // sem resumo em stderr
+};
+
+struct HeadlessStats {
+    uint64_t rxBytes = 0;
+    uint64_t txBytes = 0;
+    double   seconds = 0;
+    double   cpuSeconds = -1;              // < 0 = não medido (Windows)
+    const char* rxMode = "read/write";     // "splice", "splice+pipe", "read/write"
+    const char* txMode = "read/write";     // "splice", "sendfile", "read/write", "-"
+    bool     portLost = false;
+    std::string error;                     // falha de E/S que encerrou o modo
+};
+
+// Interpreta argv (ignora argv[0] e "--headless"). false = argumento inválido
+// (mensagem em 'error').
+bool ParseHeadlessArgs(int argc, char** argv, HeadlessOptions* opt, std::string* error);
+
+// Ponto de entrada do modo --headless. Retorna o código de saída do
+// processo: 0 = parou normalmente, 1 = erro de porta/E-S, 2 = argumentos.
+int HeadlessMain(int argc, char** argv);
@@ -0,0 +1,146 @@
+// HexDump.cpp - Formatador HEX/ASCII (ver HexDump.h)
+
+#include "HexDump.h"
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#include <emmintrin.h>
+#define HEXDUMP_USE_SSE2 1
+#endif
+
+// Par HEX de cada byte: kHexPairs[2*b], kHexPairs[2*b+1].
+static const char kHexPairs[] =
+    "000102030405060708090A0B0C0D0E0F101112131415161718191A1B1C1D1E1F"
+    "202122232425262728292A2B2C2D2E2F303132333435363738393A3B3C3D3E3F"
+    "404142434445464748494A4B4C4D4E4F505152535455565758595A5B5C5D5E5F"
+    "606162636465666768696A6B6C6D6E6F707172737475767778797A7B7C7D7E7F"
+    "808182838485868788898A8B8C8D8E8F909192939495969798999A9B9C9D9E9F"
+    "A0A1A2A3A4A5A6A7A8A9AAABACADAEAFB0B1B2B3B4B5B6B7B8B9BABBBCBDBEBF"
+    "C0C1C2C3C4C5C6C7C8C9CACBCCCDCECFD0D1D2D3D4D5D6D7D8D9DADBDCDDDEDF"
+    "E0E1E2E3E4E5E6E7E8E9EAEBECEDEEEFF0F1F2F3F4F5F6F7F8F9FAFBFCFDFEFF";
+
+static const char kHexDigits[] = "0123456789ABCDEF";
+
+// Converte um bloco de até 16 bytes: 'hex' recebe 2 chars por byte e 'asc'
+// o caractere da coluna ASCII ('.' para não imprimíveis). Blocos cheios vão
+// pelo SSE2; o resto (fim do buffer ou CPU sem SSE2) pela tabela de pares.
+static void EncodeBlock16(const uint8_t* p, size_t n, char hex[32], char asc[16]) {
+#if defined(HEXDUMP_USE_SSE2)
+    if (n == 16) {
+        const __m128i v = _mm_loadu_si128((const __m128i*)p);
+        const __m128i low4 = _mm_set1_epi8(0x0F);
+        const __m128i nine = _mm_set1_epi8(9);
+        const __m128i ascii0 = _mm_set1_epi8('0');
+        const __m128i gapAF = _mm_set1_epi8('A' - '0' - 10);
+
+        // nibble -> '0'..'9' / 'A'..'F' sem tabela: n + '0' + (n > 9 ? 7 : 0)
+        __m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), low4);
+        __m128i lo = _mm_and_si128(v, low4);
+        hi = _mm_add_epi8(_mm_add_epi8(hi, ascii0), _mm_and_si128(_mm_cmpgt_epi8(hi, nine), gapAF));
+        lo = _mm_add_epi8(_mm_add_epi8(lo, ascii0), _mm_and_si128(_mm_cmpgt_epi8(lo, nine), gapAF));
+        _mm_storeu_si128((__m128i*)hex, _mm_unpacklo_epi8(hi, lo));
+        _mm_storeu_si128((__m128i*)(hex + 16), _mm_unpackhi_epi8(hi, lo));
+
+        // Imprimível = 0x20..0x7E. Em comparação com sinal, bytes >= 0x80 são
+        // negativos e já falham no "> 0x1F".
+        __m128i printable = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(0x1F)),
+                                          _mm_cmplt_epi8(v, _mm_set1_epi8(0x7F)));
+        __m128i out = _mm_or_si128(_mm_and_si128(printable, v),
+                                   _mm_andnot_si128(printable, _mm_set1_epi8('.')));
+        _mm_storeu_si128((__m128i*)asc, out);
+        return;
+    }
+#endif
+    for (size_t i = 0; i < n; ++i) {
+        hex[2 * i] = kHexPairs[2 * p[i]];
+        hex[2 * i + 1] = kHexPairs[2 * p[i] + 1];
+        asc[i] = (p[i] >= 0x20 && p[i] < 0x7F) ? (char)p[i] : '.';
+    }
+}
+
+static size_t ClampBytesPerRow(size_t bpr) {
+    if (bpr < 1) return 1;
+    if (bpr > 256) return 256;
+    return bpr;
+}
+
+static int OffsetDigits(size_t len, const HexDumpOptions& opt) {
+    return (opt.baseOffset + len > 0xFFFFFFFFull) ? 16 : 8;
+}
+
+static size_t RowWidth(size_t len, const HexDumpOptions& opt) {
+    size_t bpr = ClampBytesPerRow(opt.bytesPerRow);
+    size_t w = bpr * 3 + (bpr - 1) / 8;            // "XX " + espaço a cada 8 bytes
+    if (opt.showOffset) w += OffsetDigits(len, opt) + 2;
+    if (opt.showAscii) w += 2 + bpr + 1;           // " |" ... "|"
+    w += opt.crlf ? 2 : 1;
+    return w;
+}
+
+size_t HexDumpBound(size_t len, const HexDumpOptions& opt) {
+    size_t bpr = ClampBytesPerRow(opt.bytesPerRow);
+    size_t rows = (len + bpr - 1) / bpr;
+    return rows * RowWidth(len, opt);
+}
+
+template <class CharT>
+static size_t Format(const uint8_t* data, size_t len, CharT* out, const HexDumpOptions& opt) {
+    const size_t bpr = ClampBytesPerRow(opt.bytesPerRow);
+    const int offDigits = OffsetDigits(len, opt);
+    CharT* o = out;
+
+    // HEX/ASCII da linha atual, convertidos em blocos de 16 antes do scatter:
+    char hex[2 * 256], asc[256];
+
+    for (size_t row = 0; row < len; row += bpr) {
+        size_t n = (len - row < bpr) ? len - row : bpr;
+        for (size_t k = 0; k < n; k += 16)
+            EncodeBlock16(data + row + k, (n - k < 16) ? n - k : 16, hex + 2 * k, asc + k);
+
+        if (opt.showOffset) {
+            uint64_t off = opt.baseOffset + row;
+            for (int d = offDigits - 1; d >= 0; --d)
+                *o++ = (CharT)kHexDigits[(off >> (4 * d)) & 0xF];
+            *o++ = ' ';
+            *o++ = ' ';
+        }
+
+        // Grupos de 8 bytes separados por um espaço extra:
+        for (size_t g = 0; g < bpr; g += 8) {
+            if (g) *o++ = ' ';
+            size_t gEnd = (g + 8 < bpr) ? g + 8 : bpr;
+            size_t j = g;
+            for (; j < gEnd && j < n; ++j) {
+                o[0] = (CharT)hex[2 * j];
+                o[1] = (CharT)hex[2 * j + 1];
+                o[2] = ' ';
+                o += 3;
+            }
+            // Última linha curta: completa para alinhar a coluna ASCII.
+            for (; j < gEnd; ++j) {
+                o[0] = ' ';
+                o[1] = ' ';
+                o[2] = ' ';
+                o += 3;
+            }
+        }
+
+        if (opt.showAscii) {
+            *o++ = ' ';
+            *o++ = '|';
+            for (size_t j = 0; j < n; ++j) *o++ = (CharT)asc[j];
+            *o++ = '|';
+        }
+
+        if (opt.crlf) *o++ = '\r';
+        *o++ = '\n';
+    }
+    return (size_t)(o - out);
+}
+
+size_t HexDumpFormat(const uint8_t* data, size_t len, char* out, const HexDumpOptions& opt) {
+    return Format(data, len, out, opt);
+}
+
+size_t HexDumpFormat(const uint8_t* data, size_t len, wchar_t* out, const HexDumpOptions& opt) {
+    return Format(data, len, out, opt);
+}
@@ -0,0 +1,32 @@
+// HexDump.h - Formatação HEX/ASCII rápida para frames binários
+// Objetivo: trocar o wstringstream + StringCchPrintf (1 chamada por byte) por
+//           um formatador que escreve direto num buffer pré-alocado.
+//
+// Layout clássico (offset / hex / ASCII), com bytes por linha configuráveis:
+//
+//   00000000  48 65 6C 6C 6F 00 01 02  |Hello...|
+//
+// Tabela de pares HEX + caminho SSE2 para blocos de 16 bytes. Serve tanto
+// para a view ao vivo (wchar_t) quanto para dumps de captura (char).
+// Não depende de Win32.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+struct HexDumpOptions {
+    size_t   bytesPerRow = 16;     // 1..256
+    bool     showOffset = true;    // coluna "00000000  "
+    bool     showAscii = true;     // coluna "|....|"
+    bool     crlf = true;          // fim de linha "\r\n" (false = "\n")
+    uint64_t baseOffset = 0;       // offset do primeiro byte (ex.: posição no stream)
+};
+
+// Tamanho máximo (em caracteres, sem o NUL) que HexDumpFormat() escreve.
+size_t HexDumpBound(size_t len, const HexDumpOptions& opt);
+
+// Formata 'len' bytes em 'out' (capacidade >= HexDumpBound). Não escreve NUL.
+// Retorna quantos caracteres foram escritos.
+size_t HexDumpFormat(const uint8_t* data, size_t len, char* out, const HexDumpOptions& opt);
+size_t HexDumpFormat(const uint8_t* data, size_t len, wchar_t* out, const HexDumpOptions& opt);
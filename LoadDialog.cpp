@@ -0,0 +1,170 @@
+// LoadDialog.cpp - Plano de carga (ver LoadDialog.h)
+
+#include "LoadDialog.h"
+
+#define LOAD_DIALOG_CLASS L"SerialLoadDialog"
+
+#define ID_LOAD_PLAN    301
+
+// Estado da janela (GWLP_USERDATA), vive na pilha de ShowLoadDialog():
+struct LoadDialogState {
+    std::string* planText = nullptr;
+    TxPlan* plan = nullptr;
+    HWND hPlan = nullptr;
+    bool done = false;
+    bool accepted = false;
+};
+
+static std::wstring ToWide(const std::string& s) {
+    if (s.empty()) return {};
+    int len = MultiByteToWideChar(CP_UTF8, 0, s.c_str(), (int)s.size(), nullptr, 0);
+    std::wstring out(len, 0);
+    MultiByteToWideChar(CP_UTF8, 0, s.c_str(), (int)s.size(), &out[0], len);
+    return out;
+}
+
+static std::string ToUtf8(const std::wstring& w) {
+    if (w.empty()) return {};
+    int len = WideCharToMultiByte(CP_UTF8, 0, w.c_str(), (int)w.size(), nullptr, 0, nullptr, nullptr);
+    std::string out(len, 0);
+    WideCharToMultiByte(CP_UTF8, 0, w.c_str(), (int)w.size(), &out[0], len, nullptr, nullptr);
+    return out;
+}
+
+// O EDIT multilinha só quebra linha com "\r\n".
+static std::wstring ToEditText(const std::string& s) {
+    std::wstring w = ToWide(s), out;
+    for (size_t i = 0; i < w.size(); ++i) {
+        if (w[i] == L'\n' && (i == 0 || w[i - 1] != L'\r')) out += L'\r';
+        out += w[i];
+    }
+    return out;
+}
+
+static void CreateControls(HWND hwnd, LoadDialogState* st) {
+    st->hPlan = CreateWindowW(L"EDIT", ToEditText(*st->planText).c_str(),
+        WS_CHILD | WS_VISIBLE | WS_BORDER | WS_TABSTOP | WS_VSCROLL | WS_HSCROLL |
+        ES_MULTILINE | ES_AUTOVSCROLL | ES_AUTOHSCROLL | ES_WANTRETURN,
+        10, 10, 400, 210, hwnd, (HMENU)ID_LOAD_PLAN, nullptr, nullptr);
+    SendMessage(st->hPlan, WM_SETFONT, (WPARAM)GetStockObject(ANSI_FIXED_FONT), FALSE);
+
+    HWND hint = CreateWindowW(L"STATIC",
+        L"every MS \"texto\"|hex .. [count=N]   send ..   wait MS   expect \"padrão\" MS\r\n"
+        L"repeat N (0 = sem fim)   duration S   # comentário",
+        WS_CHILD | WS_VISIBLE, 10, 226, 400, 30, hwnd, nullptr, nullptr, nullptr);
+    SendMessage(hint, WM_SETFONT, (WPARAM)GetStockObject(DEFAULT_GUI_FONT), FALSE);
+
+    HWND ok = CreateWindowW(L"BUTTON", L"Iniciar", WS_CHILD | WS_VISIBLE | WS_TABSTOP,
+        230, 262, 85, 26, hwnd, (HMENU)IDOK, nullptr, nullptr);
+    HWND cancel = CreateWindowW(L"BUTTON", L"Cancelar", WS_CHILD | WS_VISIBLE | WS_TABSTOP,
+        325, 262, 85, 26, hwnd, (HMENU)IDCANCEL, nullptr, nullptr);
+    SendMessage(ok, WM_SETFONT, (WPARAM)GetStockObject(DEFAULT_GUI_FONT), FALSE);
+    SendMessage(cancel, WM_SETFONT, (WPARAM)GetStockObject(DEFAULT_GUI_FONT), FALSE);
+    SetFocus(st->hPlan);
+}
+
+// Valida o plano; erro mantém a janela aberta (a mensagem diz a linha).
+static bool Accept(HWND hwnd, LoadDialogState* st) {
+    int len = GetWindowTextLengthW(st->hPlan);
+    std::wstring w(len, 0);
+    if (len > 0) GetWindowTextW(st->hPlan, &w[0], len + 1);
+    std::string text = ToUtf8(w);
+
+    TxPlan plan;
+    std::string error;
+    if (!ParseTxPlan(text, &plan, &error)) {
+        MessageBoxW(hwnd, ToWide(error).c_str(), L"Plano de carga", MB_OK | MB_ICONWARNING);
+        return false;
+    }
+    *st->planText = text;
+    *st->plan = plan;
+    return true;
+}
+
+static LRESULT CALLBACK LoadDialogProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
+    LoadDialogState* st = (LoadDialogState*)GetWindowLongPtrW(hwnd, GWLP_USERDATA);
+    switch (msg) {
+    case WM_CREATE:
+        st = (LoadDialogState*)((CREATESTRUCTW*)lParam)->lpCreateParams;
+        SetWindowLongPtrW(hwnd, GWLP_USERDATA, (LONG_PTR)st);
+        CreateControls(hwnd, st);
+        return 0;
+
+    case WM_COMMAND:
+        if (LOWORD(wParam) == IDOK) {
+            if (Accept(hwnd, st)) {
+                st->accepted = true;
+                DestroyWindow(hwnd);
+            }
+            return 0;
+        }
+        if (LOWORD(wParam) == IDCANCEL) {
+            DestroyWindow(hwnd);
+            return 0;
+        }
+        break;
+
+    case WM_CLOSE:
+        DestroyWindow(hwnd);
+        return 0;
+
+    case WM_DESTROY:
+        if (st) st->done = true;
+        return 0;
+    }
+    return DefWindowProcW(hwnd, msg, wParam, lParam);
+}
+
+bool ShowLoadDialog(HWND owner, std::string* planText, TxPlan* plan) {
+    HINSTANCE hInstance = (HINSTANCE)GetWindowLongPtrW(owner, GWLP_HINSTANCE);
+    static bool registered = false;
+    if (!registered) {
+        WNDCLASSW wc = {};
+        wc.lpfnWndProc = LoadDialogProc;
+        wc.hInstance = hInstance;
+        wc.hCursor = LoadCursor(nullptr, IDC_ARROW);
+        wc.hbrBackground = (HBRUSH)(COLOR_BTNFACE + 1);
+        wc.lpszClassName = LOAD_DIALOG_CLASS;
+        registered = RegisterClassW(&wc) != 0;
+    }
+
+    // Centraliza sobre a janela principal:
+    RECT rc = { 0, 0, 420, 298 };
+    DWORD style = WS_POPUP | WS_CAPTION | WS_SYSMENU;
+    AdjustWindowRect(&rc, style, FALSE);
+    RECT owr;
+    GetWindowRect(owner, &owr);
+    int w = rc.right - rc.left, h = rc.bottom - rc.top;
+    int x = owr.left + ((owr.right - owr.left) - w) / 2;
+    int y = owr.top + ((owr.bottom - owr.top) - h) / 2;
+
+    LoadDialogState st;
+    st.planText = planText;
+    st.plan = plan;
+    HWND hwnd = CreateWindowExW(WS_EX_DLGMODALFRAME, LOAD_DIALOG_CLASS, L"Gerar carga (TX agendado)",
+        style, x, y, w, h, owner, nullptr, hInstance, &st);
+    if (!hwnd) return false;
+
+    // Laço modal: a janela principal fica desabilitada até fechar.
+    EnableWindow(owner, FALSE);
+    ShowWindow(hwnd, SW_SHOW);
+    MSG msg;
+    while (!st.done) {
+        if (GetMessageW(&msg, nullptr, 0, 0) <= 0) {
+            PostQuitMessage((int)msg.wParam);   // devolve o WM_QUIT ao laço principal
+            DestroyWindow(hwnd);
+            break;
+        }
+        if (msg.message == WM_KEYDOWN && msg.wParam == VK_ESCAPE) {
+            DestroyWindow(hwnd);
+            continue;
+        }
+        if (!IsDialogMessageW(hwnd, &msg)) {
+            TranslateMessage(&msg);
+            DispatchMessageW(&msg);
+        }
+    }
+    EnableWindow(owner, TRUE);
+    SetForegroundWindow(owner);
+    return st.accepted;
+}
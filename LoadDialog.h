@@ -0,0 +1,16 @@
+// LoadDialog.h - Janela do plano de carga (TxScheduler.h)
+// Objetivo: digitar/colar o plano (fluxos "every", roteiro send/wait/expect)
+//           sem arquivo de recurso (.rc): controles criados em código, modal
+//           sobre a janela principal, como a RttDialog.
+
+#pragma once
+
+#include <windows.h>
+
+#include <string>
+
+#include "TxScheduler.h"
+
+// Modal. 'planText' (UTF-8) entra como texto inicial e sai com o digitado;
+// 'plan' recebe o plano já validado. false = cancelado.
+bool ShowLoadDialog(HWND owner, std::string* planText, TxPlan* plan);
@@ -0,0 +1,140 @@
+// LzCodec.cpp - Compressor/descompressor LZ de blocos (ver LzCodec.h)
+
+#include "LzCodec.h"
+
+#include <cstring>
+
+namespace {
+const int kHashLog = 12;
+const size_t kMinMatch = 4;
+const size_t kMaxOffset = 65535;
+const size_t kLastLiterals = 5;      // o bloco termina sempre em literais
+const size_t kMatchStartLimit = 12;  // nenhum match começa nos últimos 12 bytes
+
+inline uint32_t Read32(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline uint32_t Hash(uint32_t v) {
+    return (v * 2654435761u) >> (32 - kHashLog);
+}
+
+// Comprimento em bytes 255 + resto (o token já guarda até 15).
+inline bool PutLength(size_t len, uint8_t** op, const uint8_t* end) {
+    while (len >= 255) {
+        if (*op >= end) return false;
+        *(*op)++ = 255;
+        len -= 255;
+    }
+    if (*op >= end) return false;
+    *(*op)++ = (uint8_t)len;
+    return true;
+}
+
+inline bool GetLength(const uint8_t** ip, const uint8_t* end, size_t* len) {
+    uint8_t b;
+    do {
+        if (*ip >= end) return false;
+        b = *(*ip)++;
+        *len += b;
+    } while (b == 255);
+    return true;
+}
+
+// Uma sequência: literais [anchor, anchor + litLen) e, se matchLen > 0, o match.
+bool EmitSequence(const uint8_t* lit, size_t litLen, size_t offset, size_t matchLen,
+                  uint8_t** op, const uint8_t* end) {
+    if ((size_t)(end - *op) < 1 + litLen) return false;
+    uint8_t* token = (*op)++;
+    size_t ml = matchLen ? matchLen - kMinMatch : 0;
+    *token = (uint8_t)(((litLen < 15 ? litLen : 15) << 4) | (ml < 15 ? ml : 15));
+    if (litLen >= 15 && !PutLength(litLen - 15, op, end)) return false;
+    if ((size_t)(end - *op) < litLen) return false;
+    if (litLen) memcpy(*op, lit, litLen);
+    *op += litLen;
+    if (!matchLen) return true;
+    if (end - *op < 2) return false;
+    *(*op)++ = (uint8_t)offset;
+    *(*op)++ = (uint8_t)(offset >> 8);
+    if (ml >= 15 && !PutLength(ml - 15, op, end)) return false;
+    return true;
+}
+}
+
+size_t LzCompress(const uint8_t* src, size_t n, uint8_t* dst, size_t cap) {
+    uint8_t* op = dst;
+    const uint8_t* oend = dst + cap;
+    size_t anchor = 0;
+
+    if (n > kMatchStartLimit) {
+        uint32_t table[1 << kHashLog];
+        memset(table, 0, sizeof(table));
+        const size_t limit = n - kMatchStartLimit;
+        const size_t matchEnd = n - kLastLiterals;
+        size_t ip = 1;
+        while (ip < limit) {
+            uint32_t v = Read32(src + ip);
+            uint32_t h = Hash(v);
+            size_t ref = table[h];
+            table[h] = (uint32_t)ip;
+            if (ip - ref > kMaxOffset || Read32(src + ref) != v) {
+                ip += 1 + ((ip - anchor) >> 6);   // sem repetição: passo cresce
+                continue;
+            }
+
+            // Estende para trás (literais iguais antes do match) e para frente.
+            while (ip > anchor && ref > 0 && src[ip - 1] == src[ref - 1]) {
+                --ip;
+                --ref;
+            }
+            size_t len = kMinMatch;
+            while (ip + len < matchEnd && src[ref + len] == src[ip + len]) ++len;
+
+            if (!EmitSequence(src + anchor, ip - anchor, ip - ref, len, &op, oend)) return 0;
+            ip += len;
+            anchor = ip;
+            if (ip < limit) table[Hash(Read32(src + ip - 2))] = (uint32_t)(ip - 2);
+        }
+    }
+
+    if (!EmitSequence(src + anchor, n - anchor, 0, 0, &op, oend)) return 0;
+    return (size_t)(op - dst);
+}
+
+bool LzDecompress(const uint8_t* src, size_t n, uint8_t* dst, size_t outLen) {
+    const uint8_t* ip = src;
+    const uint8_t* iend = src + n;
+    uint8_t* op = dst;
+    uint8_t* oend = dst + outLen;
+
+    while (ip < iend) {
+        uint8_t token = *ip++;
+        size_t lit = token >> 4;
+        if (lit == 15 && !GetLength(&ip, iend, &lit)) return false;
+        if ((size_t)(iend - ip) < lit || (size_t)(oend - op) < lit) return false;
+        if (lit) memcpy(op, ip, lit);
+        ip += lit;
+        op += lit;
+        if (ip == iend) break;                 // última sequência: só literais
+
+        if (iend - ip < 2) return false;
+        size_t offset = (size_t)ip[0] | ((size_t)ip[1] << 8);
+        ip += 2;
+        size_t len = token & 15;
+        if (len == 15 && !GetLength(&ip, iend, &len)) return false;
+        len += kMinMatch;
+        if (offset == 0 || offset > (size_t)(op - dst) || (size_t)(oend - op) < len) return false;
+
+        const uint8_t* ref = op - offset;
+        if (offset >= len) {
+            memcpy(op, ref, len);
+            op += len;
+        }
+        else {
+            for (size_t i = 0; i < len; ++i) *op++ = *ref++;   // sobreposto: repete o padrão
+        }
+    }
+    return op == oend;
+}
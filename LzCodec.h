@@ -0,0 +1,31 @@
+// LzCodec.h - Compressão LZ rápida de blocos (formato de sequências do LZ4)
+// Objetivo: guardar o histórico antigo do terminal comprimido sem depender
+//           de biblioteca externa. Texto de log (linhas parecidas, prefixos
+//           "[RX] ") comprime 4-10x a centenas de MB/s.
+//
+// Formato (o mesmo do bloco LZ4, sem moldura): sequências de
+//   token (4 bits literais | 4 bits match - 4) [+ bytes 255.. de literais]
+//   literais  offset (2 bytes, LE)  [+ bytes 255.. de match]
+// e a última sequência só com literais. Janela de 64 KB.
+//
+// Compressor guloso de uma tabela de hash (4096 posições, na pilha), com
+// passo crescente em trechos sem repetição. Descompressor com verificação de
+// limites: dado corrompido retorna false, nunca escreve fora de 'dst'
+// (--selftest --filter=lz: ida e volta, entrada truncada e corrompida).
+//
+// Não depende de Win32.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Pior caso da saída para 'n' bytes de entrada (sem nenhuma repetição).
+inline size_t LzCompressBound(size_t n) { return n + n / 255 + 16; }
+
+// Comprime 'src' em 'dst' (até 'cap' bytes). Retorna o tamanho comprimido ou
+// 0 se não coube em 'cap' (passe cap < n para só aceitar ganho).
+size_t LzCompress(const uint8_t* src, size_t n, uint8_t* dst, size_t cap);
+
+// Descomprime exatamente 'outLen' bytes. false = dado inválido/truncado.
+bool LzDecompress(const uint8_t* src, size_t n, uint8_t* dst, size_t outLen);
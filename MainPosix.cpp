@@ -0,0 +1,52 @@
+// MainPosix.cpp - Ponto de entrada fora do Windows (sem GUI)
+// A interface é Win32; no Linux o executável só expõe os modos de linha de
+// comando (--bench, --selftest, --headless, --list-ports, --sim, --bridge,
+// --analyze). No Windows os mesmos modos saem do WinMain().
+
+#ifndef _WIN32
+
+#include "Bench.h"
+#include "DeviceSim.h"
+#include "Headless.h"
+#include "OfflineAnalysis.h"
+#include "PortEnumerator.h"
+#include "SelfTest.h"
+#include "TcpBridge.h"
+
+#include <cstdio>
+#include <cstring>
+
+int main(int argc, char** argv) {
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0)
+        return BenchMain(argc, argv);
+    if (argc > 1 && strcmp(argv[1], "--selftest") == 0)
+        return SelfTestMain(argc, argv);
+    if (argc > 1 && strcmp(argv[1], "--headless") == 0)
+        return HeadlessMain(argc, argv);
+    if (argc > 1 && strcmp(argv[1], "--list-ports") == 0)
+        return ListPortsMain(argc, argv);
+    if (argc > 1 && strncmp(argv[1], "--sim", 5) == 0)
+        return DeviceSimMain(argc, argv);
+    if (argc > 1 && strcmp(argv[1], "--bridge") == 0)
+        return BridgeMain(argc, argv);
+    if (argc > 1 && strncmp(argv[1], "--analyze=", 10) == 0)
+        return AnalyzeMain(argc, argv);
+
+    fprintf(stderr,
+            "uso: %s --bench [--filter=nome] [--repeats=N] [--min-ms=N] [--json=arquivo]\n"
+            "                [--loopback] [--no-micro] [--rate=B/s,...] [--chunk=N,...] [--ports=N,...]\n"
+            "                [--reactor-threads=N] [--seconds=S] [--adaptive=0,1] [--replay=captura.scap]\n"
+            "     %s --selftest [--filter=nome] [--verbose] (testes de correcao, ver SelfTest.h)\n"
+            "     %s --headless --port=/dev/ttyUSB0 [--baud=115200] [--out=-|arquivo] [--in=-|arquivo|none]\n"
+            "                [--seconds=S] [--no-splice] (ver Headless.h)\n"
+            "     %s --sim=rate|burst|binary|telemetry|echo[,chave=valor...] [--baud=N] [--seconds=S]\n"
+            "                (dispositivo simulado num pty, ver DeviceSim.h)\n"
+            "     %s --bridge --port=/dev/ttyUSB0|sim:... [--baud=N] [--raw-port=7000] [--rfc2217-port=7001]\n"
+            "                [--slow=drop|disconnect] [--seconds=S] (ponte TCP, ver TcpBridge.h)\n"
+            "     %s --analyze=arquivo [--framing=lines|cobs|slip] [--pattern=texto ...] [--threads=N]\n"
+            "                (analise offline de log/captura, ver OfflineAnalysis.h)\n",
+            argv[0], argv[0], argv[0], argv[0], argv[0], argv[0]);
+    return 2;
+}
+
+#endif
@@ -0,0 +1,120 @@
+// MappedFile.cpp - Mapeamento de arquivo somente leitura (ver MappedFile.h)
+
+#include "MappedFile.h"
+
+#include <cstring>
+
+#ifdef _WIN32
+
+#include <windows.h>
+
+static std::wstring Utf8ToWidePath(const std::string& s) {
+    int len = MultiByteToWideChar(CP_UTF8, 0, s.c_str(), -1, nullptr, 0);
+    std::wstring w(len > 0 ? len : 1, 0);
+    MultiByteToWideChar(CP_UTF8, 0, s.c_str(), -1, &w[0], len);
+    w.resize(wcslen(w.c_str()));
+    return w;
+}
+
+bool MappedFile::Open(const std::string& path) {
+    Close();
+
+    HANDLE f = CreateFileW(Utf8ToWidePath(path).c_str(), GENERIC_READ,
+        FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING,
+        FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (f == INVALID_HANDLE_VALUE) {
+        m_lastError = "CreateFile falhou (erro " + std::to_string(GetLastError()) + ")";
+        return false;
+    }
+    LARGE_INTEGER size = {};
+    GetFileSizeEx(f, &size);
+    m_file = f;
+    m_size = (uint64_t)size.QuadPart;
+    m_open = true;
+    if (m_size == 0) return true;   // CreateFileMapping recusa arquivo vazio
+
+    if ((uint64_t)(SIZE_T)m_size != m_size) {
+        m_lastError = "arquivo grande demais para este processo (32 bits)";
+        Close();
+        return false;
+    }
+    m_mapping = CreateFileMappingW(f, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (m_mapping) m_data = (const uint8_t*)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!m_data) {
+        m_lastError = "MapViewOfFile falhou (erro " + std::to_string(GetLastError()) + ")";
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::Close() {
+    if (m_data) UnmapViewOfFile(m_data);
+    if (m_mapping) CloseHandle(m_mapping);
+    if (m_file) CloseHandle(m_file);
+    m_data = nullptr;
+    m_mapping = nullptr;
+    m_file = nullptr;
+    m_size = 0;
+    m_open = false;
+}
+
+std::FILE* FOpenUtf8(const std::string& path, const char* mode) {
+    std::wstring wmode(mode, mode + strlen(mode));
+    return _wfopen(Utf8ToWidePath(path).c_str(), wmode.c_str());
+}
+
+#else
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+
+bool MappedFile::Open(const std::string& path) {
+    Close();
+
+    m_fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (m_fd < 0) {
+        m_lastError = std::string("open falhou: ") + strerror(errno);
+        return false;
+    }
+    struct stat st;
+    fstat(m_fd, &st);
+    m_size = (uint64_t)st.st_size;
+    m_open = true;
+    if (m_size == 0) return true;   // mmap de tamanho 0 é inválido
+
+    if ((uint64_t)(size_t)m_size != m_size) {
+        m_lastError = "arquivo grande demais para este processo (32 bits)";
+        Close();
+        return false;
+    }
+    void* p = mmap(nullptr, (size_t)m_size, PROT_READ, MAP_SHARED, m_fd, 0);
+    if (p == MAP_FAILED) {
+        m_lastError = std::string("mmap falhou: ") + strerror(errno);
+        Close();
+        return false;
+    }
+    // Leitura quase sempre sequencial (replay/análise): read-ahead agressivo.
+    madvise(p, (size_t)m_size, MADV_SEQUENTIAL);
+    m_data = (const uint8_t*)p;
+    return true;
+}
+
+void MappedFile::Close() {
+    if (m_data) munmap((void*)m_data, (size_t)m_size);
+    if (m_fd >= 0) close(m_fd);
+    m_data = nullptr;
+    m_fd = -1;
+    m_size = 0;
+    m_open = false;
+}
+
+std::FILE* FOpenUtf8(const std::string& path, const char* mode) {
+    return std::fopen(path.c_str(), mode);
+}
+
+#endif
@@ -0,0 +1,46 @@
+// MappedFile.h - Arquivo mapeado em memória (somente leitura) + fopen UTF-8
+// Objetivo: abrir capturas de vários GB sem ler tudo: o SO pagina sob demanda
+//           e o seek vira aritmética de ponteiro.
+//
+// Backends: CreateFileMapping/MapViewOfFile (Win32) e mmap (POSIX).
+// Em processo 32 bits o arquivo inteiro precisa caber no espaço de endereços.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+class MappedFile {
+public:
+    MappedFile() {}
+    ~MappedFile() { Close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // 'path' em UTF-8. Arquivo vazio abre com Data() == nullptr e Size() == 0.
+    bool Open(const std::string& path);
+    void Close();
+
+    bool IsOpen() const { return m_open; }
+    const uint8_t* Data() const { return m_data; }
+    uint64_t Size() const { return m_size; }
+    const std::string& LastError() const { return m_lastError; }
+
+private:
+    bool m_open = false;
+    const uint8_t* m_data = nullptr;
+    uint64_t m_size = 0;
+    std::string m_lastError;
+#ifdef _WIN32
+    void* m_file = nullptr;       // HANDLE
+    void* m_mapping = nullptr;    // HANDLE
+#else
+    int m_fd = -1;
+#endif
+};
+
+// fopen() com caminho UTF-8 (no Windows converte para _wfopen).
+std::FILE* FOpenUtf8(const std::string& path, const char* mode);
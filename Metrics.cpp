@@ -0,0 +1,145 @@
+// Metrics.cpp - Histogramas, amostras por intervalo e export JSON (ver Metrics.h)
+
+#include "Metrics.h"
+#include "MappedFile.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+uint64_t HistogramSnapshot::Percentile(double p) const {
+    if (count == 0) return 0;
+    uint64_t rank = (uint64_t)(p * (double)count);
+    if (rank >= count) rank = count - 1;
+    uint64_t seen = 0;
+    for (int b = 0; b < kBuckets; ++b) {
+        seen += buckets[b];
+        if (seen > rank) {
+            uint64_t upper = (b == 0) ? 0 : ((uint64_t)1 << b) - 1;
+            return upper < max ? upper : max;
+        }
+    }
+    return max;
+}
+
+HistogramSnapshot HistogramSnapshot::Since(const HistogramSnapshot& prev) const {
+    HistogramSnapshot d;
+    d.count = count - prev.count;
+    d.sum = sum - prev.sum;
+    d.max = max;
+    for (int b = 0; b < kBuckets; ++b) d.buckets[b] = buckets[b] - prev.buckets[b];
+    return d;
+}
+
+// Leitura sem trava enquanto o escritor grava: as faixas podem somar um pouco
+// diferente de 'count' no meio de um Record(). 'count' vira a soma das faixas
+// para os percentis ficarem coerentes.
+HistogramSnapshot LogHistogram::Snapshot() const {
+    HistogramSnapshot s;
+    uint64_t total = 0;
+    for (int b = 0; b < kBuckets; ++b) {
+        s.buckets[b] = m_buckets[b].load(std::memory_order_relaxed);
+        total += s.buckets[b];
+    }
+    s.count = total;
+    s.sum = m_sum.load(std::memory_order_relaxed);
+    s.max = m_max.load(std::memory_order_relaxed);
+    return s;
+}
+
+MetricsSample MakeMetricsSample(const std::string& port, const PortMetricsSnapshot& prev,
+                                const PortMetricsSnapshot& cur) {
+    MetricsSample m;
+    m.port = port;
+    m.seconds = (cur.takenNs - prev.takenNs) / 1e9;
+    double secs = m.seconds > 0 ? m.seconds : 1.0;
+
+    // Contadores que voltaram (sessão reaberta, fila reiniciada) contam do zero.
+    auto delta = [](uint64_t now, uint64_t before) { return now >= before ? now - before : now; };
+    m.rxBytesPerSec = delta(cur.rxBytes, prev.rxBytes) / secs;
+    m.readsPerSec = delta(cur.rxReads, prev.rxReads) / secs;
+    m.txBytesPerSec = delta(cur.tx.bytesWritten, prev.tx.bytesWritten) / secs;
+
+    HistogramSnapshot reads = cur.readBytes.count >= prev.readBytes.count
+        ? cur.readBytes.Since(prev.readBytes) : cur.readBytes;
+    m.readP50 = reads.Percentile(0.50);
+    m.readP99 = reads.Percentile(0.99);
+    m.readMax = reads.max;
+
+    HistogramSnapshot screen = cur.rxToScreenUs.count >= prev.rxToScreenUs.count
+        ? cur.rxToScreenUs.Since(prev.rxToScreenUs) : cur.rxToScreenUs;
+    m.screenP50Us = screen.Percentile(0.50);
+    m.screenP99Us = screen.Percentile(0.99);
+    m.screenMaxUs = screen.max;
+
+    m.rxQueued = cur.rxQueued;
+    m.rxHighWater = cur.rxHighWater;
+    m.txQueuedMessages = cur.tx.queuedMessages;
+    m.txQueuedBytes = cur.tx.queuedBytes;
+    m.rxDropped = cur.rxDropped;
+    m.txDropped = cur.tx.dropped;
+    m.txFailed = cur.tx.messagesFailed;
+    m.errors = cur.errors;
+    return m;
+}
+
+std::string MetricsToJson(const MetricsSample& s, int64_t unixMs) {
+    std::string port;
+    for (char c : s.port) {
+        if (c == '"' || c == '\\') port += '\\';
+        port += c;
+    }
+
+    char buf[1024];
+    snprintf(buf, sizeof(buf),
+        "{\"ts_ms\":%lld,\"port\":\"%s\",\"interval_s\":%.3f,"
+        "\"rx_bps\":%.0f,\"tx_bps\":%.0f,\"reads_per_s\":%.0f,"
+        "\"read_bytes\":{\"p50\":%llu,\"p99\":%llu,\"max\":%llu},"
+        "\"rx_to_screen_us\":{\"p50\":%llu,\"p99\":%llu,\"max\":%llu},"
+        "\"rx_queue_bytes\":%zu,\"rx_queue_high_water\":%zu,"
+        "\"tx_queue_messages\":%zu,\"tx_queue_bytes\":%zu,"
+        "\"rx_dropped\":%llu,\"tx_dropped\":%llu,\"tx_failed\":%llu,"
+        "\"errors\":{\"overrun\":%llu,\"parity\":%llu,\"framing\":%llu,\"buffer_full\":%llu,\"break\":%llu}}",
+        (long long)unixMs, port.c_str(), s.seconds,
+        s.rxBytesPerSec, s.txBytesPerSec, s.readsPerSec,
+        (unsigned long long)s.readP50, (unsigned long long)s.readP99, (unsigned long long)s.readMax,
+        (unsigned long long)s.screenP50Us, (unsigned long long)s.screenP99Us, (unsigned long long)s.screenMaxUs,
+        s.rxQueued, s.rxHighWater, s.txQueuedMessages, s.txQueuedBytes,
+        (unsigned long long)s.rxDropped, (unsigned long long)s.txDropped, (unsigned long long)s.txFailed,
+        (unsigned long long)s.errors.overrun, (unsigned long long)s.errors.parity,
+        (unsigned long long)s.errors.framing, (unsigned long long)s.errors.bufferFull,
+        (unsigned long long)s.errors.breaks);
+    return buf;
+}
+
+bool MetricsExporter::Open(const std::string& path) {
+    Close();
+    if (path == "-") {
+        m_out = stdout;
+        return true;
+    }
+    m_out = FOpenUtf8(path, "ab");
+    if (!m_out) {
+        m_lastError = "não foi possível abrir " + path + ": " + strerror(errno);
+        return false;
+    }
+    m_ownsFile = true;
+    return true;
+}
+
+void MetricsExporter::Close() {
+    if (m_out && m_ownsFile) fclose(m_out);
+    m_out = nullptr;
+    m_ownsFile = false;
+}
+
+// 1 linha por porta e intervalo; flush para o painel ver na hora.
+void MetricsExporter::Write(const MetricsSample& s) {
+    if (!m_out) return;
+    int64_t unixMs = (int64_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    std::string line = MetricsToJson(s, unixMs);
+    line += '\n';
+    fwrite(line.data(), 1, line.size(), m_out);
+    fflush(m_out);
+}
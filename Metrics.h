@@ -0,0 +1,143 @@
+// Metrics.h - Métricas do caminho quente (RX/TX, leituras, atraso até a tela)
+// Objetivo: ver como o link se comporta (vazão, tamanho das leituras, atraso
+//           RX -> tela, filas, erros de linha do driver) sem pesar no I/O.
+//
+// Funcionamento:
+//  - Cada contador/histograma tem UM escritor (a thread do reactor, a de
+//    escrita ou a da UI): Record() é load + store relaxed, sem lock nem
+//    instrução atômica de leitura-modificação-escrita.
+//  - Qualquer thread tira um Snapshot(); a UI faz isso 1x por segundo e
+//    MetricsSample calcula taxas e percentis do intervalo (diferença entre
+//    dois snapshots).
+//  - Histograma em potências de 2 (64 faixas): percentis com erro < 2x,
+//    suficiente para ver "leituras de 1 byte" ou "atraso de 200 ms".
+//  - MetricsToJson(): uma linha JSON por porta e intervalo (JSON Lines),
+//    para painéis (--metrics=arquivo.jsonl ou --metrics=- para stdout).
+//
+// Não depende de Win32.
+
+#pragma once
+
+#include "SerialPort.h"
+#include "TxQueue.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+struct HistogramSnapshot {
+    static const int kBuckets = 64;
+
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    uint64_t max = 0;                  // desde o início (não por intervalo)
+    uint64_t buckets[kBuckets] = {};   // [0] = valor 0; [i] = [2^(i-1), 2^i)
+
+    double Mean() const { return count ? (double)sum / count : 0.0; }
+    // Limite superior da faixa que contém o percentil 'p' (0..1), até 'max'.
+    uint64_t Percentile(double p) const;
+    // Só o que foi registrado depois de 'prev' (mesmo histograma).
+    HistogramSnapshot Since(const HistogramSnapshot& prev) const;
+};
+
+class LogHistogram {
+public:
+    static const int kBuckets = HistogramSnapshot::kBuckets;
+
+    // Só o escritor dono do histograma chama.
+    void Record(uint64_t v) {
+        int b = BucketOf(v);
+        Bump(m_buckets[b], 1);
+        Bump(m_count, 1);
+        Bump(m_sum, v);
+        if (v > m_max.load(std::memory_order_relaxed)) m_max.store(v, std::memory_order_relaxed);
+    }
+
+    HistogramSnapshot Snapshot() const;
+
+    static int BucketOf(uint64_t v) {
+        int b = 0;
+        while (v) { ++b; v >>= 1; }
+        return b < kBuckets ? b : kBuckets - 1;
+    }
+
+private:
+    static void Bump(std::atomic<uint64_t>& c, uint64_t n) {
+        c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    std::atomic<uint64_t> m_buckets[kBuckets] = {};
+    std::atomic<uint64_t> m_count{ 0 };
+    std::atomic<uint64_t> m_sum{ 0 };
+    std::atomic<uint64_t> m_max{ 0 };
+};
+
+// Escrito pela thread que lê a porta (reactor).
+struct RxMetrics {
+    std::atomic<uint64_t> bytes{ 0 };
+    std::atomic<uint64_t> reads{ 0 };
+    LogHistogram readBytes;            // bytes por ReadFile/read()
+
+    void RecordRead(size_t n) {
+        reads.store(reads.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        bytes.store(bytes.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        readBytes.Record(n);
+    }
+};
+
+// Retrato cumulativo de uma porta (ver SerialSession::MetricsNow()).
+struct PortMetricsSnapshot {
+    int64_t  takenNs = 0;              // PreciseTimer::NowNs()
+    uint64_t rxBytes = 0;
+    uint64_t rxReads = 0;
+    uint64_t rxDropped = 0;            // descartados pela fila RX
+    size_t   rxQueued = 0;             // bytes na fila RX agora
+    size_t   rxHighWater = 0;
+    HistogramSnapshot readBytes;
+    HistogramSnapshot rxToScreenUs;    // chegada -> append na view (pior byte do lote)
+    TxStats  tx;
+    SerialErrorCounts errors;
+};
+
+// Um intervalo entre dois snapshots: o que vai para a barra de status e o JSON.
+struct MetricsSample {
+    std::string port;
+    double   seconds = 0;
+    double   rxBytesPerSec = 0;
+    double   txBytesPerSec = 0;
+    double   readsPerSec = 0;
+    uint64_t readP50 = 0, readP99 = 0, readMax = 0;           // bytes por leitura no intervalo
+    uint64_t screenP50Us = 0, screenP99Us = 0, screenMaxUs = 0;
+    size_t   rxQueued = 0, rxHighWater = 0;
+    size_t   txQueuedMessages = 0, txQueuedBytes = 0;
+    uint64_t rxDropped = 0, txDropped = 0, txFailed = 0;      // cumulativos
+    SerialErrorCounts errors;                                 // cumulativos
+};
+
+MetricsSample MakeMetricsSample(const std::string& port, const PortMetricsSnapshot& prev,
+                                const PortMetricsSnapshot& cur);
+
+// Uma linha JSON (sem '\n'). 'unixMs' = relógio de parede do intervalo.
+std::string MetricsToJson(const MetricsSample& s, int64_t unixMs);
+
+// Destino do export periódico: arquivo (append) ou "-" = stdout.
+class MetricsExporter {
+public:
+    MetricsExporter() {}
+    ~MetricsExporter() { Close(); }
+
+    MetricsExporter(const MetricsExporter&) = delete;
+    MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+    bool Open(const std::string& path);
+    void Close();
+    bool Active() const { return m_out != nullptr; }
+    void Write(const MetricsSample& s);
+    std::string LastError() const { return m_lastError; }
+
+private:
+    FILE* m_out = nullptr;
+    bool m_ownsFile = false;
+    std::string m_lastError;
+};
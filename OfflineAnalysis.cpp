@@ -0,0 +1,595 @@
+// OfflineAnalysis.cpp - Análise paralela de logs/capturas (ver OfflineAnalysis.h)
+
+#include "OfflineAnalysis.h"
+
+#include "Framing.h"
+#include "MappedFile.h"
+#include "PreciseTimer.h"
+#include "Telemetry.h"
+#include "Utf8Decoder.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+namespace {
+const uint64_t kMinChunk = 1u << 20;
+const uint64_t kMaxChunk = 64u << 20;
+const uint64_t kContinueStep = 1u << 20;   // log cru: passo ao continuar além do pedaço
+const size_t kMatchText = 120;
+
+void AddSample(HistogramSnapshot& h, uint64_t v) {
+    ++h.buckets[LogHistogram::BucketOf(v)];
+    ++h.count;
+    h.sum += v;
+    if (v > h.max) h.max = v;
+}
+
+void AddHistogram(HistogramSnapshot& into, const HistogramSnapshot& h) {
+    for (int i = 0; i < HistogramSnapshot::kBuckets; ++i) into.buckets[i] += h.buckets[i];
+    into.count += h.count;
+    into.sum += h.sum;
+    if (h.max > into.max) into.max = h.max;
+}
+
+bool ContainsBytes(const uint8_t* p, size_t n, const std::string& pat) {
+    const size_t m = pat.size();
+    if (m == 0 || m > n) return false;
+    const uint8_t first = (uint8_t)pat[0];
+    const uint8_t* last = p + (n - m);
+    while (p <= last) {
+        p = (const uint8_t*)memchr(p, first, (size_t)(last - p) + 1);
+        if (!p) return false;
+        if (memcmp(p + 1, pat.data() + 1, m - 1) == 0) return true;
+        ++p;
+    }
+    return false;
+}
+
+// Texto do frame para o relatório: linhas com controles trocados por '.',
+// binário em HEX.
+std::string MatchText(const uint8_t* p, size_t n, bool text) {
+    std::string s;
+    if (text) {
+        size_t k = std::min(n, kMatchText);
+        s.reserve(k);
+        for (size_t i = 0; i < k; ++i) s.push_back((p[i] < 0x20 || p[i] == 0x7F) ? '.' : (char)p[i]);
+    }
+    else {
+        static const char kHex[] = "0123456789ABCDEF";
+        size_t k = std::min(n, kMatchText / 3);
+        for (size_t i = 0; i < k; ++i) {
+            if (i) s.push_back(' ');
+            s.push_back(kHex[p[i] >> 4]);
+            s.push_back(kHex[p[i] & 15]);
+        }
+    }
+    if (n > (text ? kMatchText : kMatchText / 3)) s += "...";
+    return s;
+}
+
+void AppendF(std::string& s, const char* fmt, ...) {
+    char line[512];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(line, sizeof(line), fmt, ap);
+    va_end(ap);
+    s += line;
+}
+
+// ============================================================================
+//                         Resultado local de um pedaço
+// ============================================================================
+struct ChunkResult {
+    uint64_t streamBytes = 0;          // só os bytes do próprio pedaço (base dos offsets)
+    uint64_t records = 0;
+    uint64_t frames = 0;
+    uint64_t emptyFrames = 0;
+    uint64_t framingErrors = 0;
+    uint64_t tailBytes = 0;
+    uint64_t utf8Invalid = 0;
+    HistogramSnapshot frameBytes;
+    HistogramSnapshot frameGapUs;
+    bool     anyFrame = false;
+    uint64_t firstTsNs = 0;
+    uint64_t lastTsNs = 0;
+    std::vector<PatternResult> patterns;     // frame/offset relativos ao pedaço
+    std::vector<FieldSummary> fields;
+    uint64_t droppedFields = 0;
+};
+
+// ============================================================================
+//                 Um pedaço: fluxo -> frames -> estatísticas
+// ============================================================================
+// Recebe o fluxo do pedaço em trechos (Feed) a partir do seu início; trechos
+// com own = false são a continuação além do fim, até o primeiro delimitador.
+class ChunkWorker {
+public:
+    ChunkWorker(const AnalysisOptions& opt, bool capture, bool skipHead, ChunkResult* out)
+        : m_opt(opt), m_capture(capture), m_skipping(skipHead), m_out(out) {
+        switch (opt.framing) {
+        case AnalysisFraming::Lines: m_delim = '\n'; break;
+        case AnalysisFraming::Cobs:  m_delim = 0x00; break;
+        case AnalysisFraming::Slip:  m_delim = 0xC0; break;
+        }
+        m_out->patterns.resize(opt.patterns.size());
+    }
+
+    // false = o pedaço terminou (não precisa de mais trechos).
+    bool Feed(const uint8_t* p, size_t n, uint64_t tsNs, bool own) {
+        if (own) m_out->streamBytes += n;
+        const uint8_t* base = p;
+        const uint8_t* end = p + n;
+        bool more = true;
+        while (p < end) {
+            if (m_skipping) {
+                // Cabeça do pedaço: pertence ao anterior (que continua até aqui).
+                if (!own) { more = false; break; }
+                const uint8_t* d = (const uint8_t*)memchr(p, m_delim, (size_t)(end - p));
+                if (!d) break;
+                p = d + 1;
+                m_skipping = false;
+                continue;
+            }
+            if (!m_inFrame) {
+                m_inFrame = true;
+                m_frame = nullptr;
+                m_frameLen = 0;
+                m_inScratch = false;
+                m_frameOffset = m_pos + (uint64_t)(p - base);
+                m_frameTs = tsNs;
+            }
+            const uint8_t* d = (const uint8_t*)memchr(p, m_delim, (size_t)(end - p));
+            if (!d) {
+                Append(p, (size_t)(end - p));
+                break;
+            }
+            Append(p, (size_t)(d - p));
+            EndFrame();
+            p = d + 1;
+            if (!own) { more = false; break; }
+        }
+        m_pos += n;
+        return more;
+    }
+
+    // Fim do fluxo (arquivo acabou) com um frame aberto: sobra sem delimitador.
+    void Finish() {
+        if (!m_inFrame) return;
+        m_out->tailBytes += m_frameLen;
+        if (m_opt.framing == AnalysisFraming::Lines) EndFrame();    // como LineFramer::Flush()
+        m_inFrame = false;
+    }
+
+private:
+    // Log cru: os trechos são contíguos no mapeamento e o frame fica no
+    // lugar. Só vai para m_scratch se um trecho não emenda no anterior
+    // (registros de captura).
+    void Append(const uint8_t* p, size_t n) {
+        if (!m_inScratch) {
+            if (!m_frame) {
+                m_frame = p;
+                m_frameLen = n;
+                return;
+            }
+            if (m_frame + m_frameLen == p) {
+                m_frameLen += n;
+                return;
+            }
+            m_scratch.assign(m_frame, m_frame + m_frameLen);
+            m_inScratch = true;
+        }
+        m_scratch.insert(m_scratch.end(), p, p + n);
+        m_frameLen += n;
+    }
+
+    void EndFrame() {
+        m_inFrame = false;
+        const uint8_t* data = m_inScratch ? m_scratch.data() : m_frame;
+        size_t len = m_frameLen;
+
+        if (m_opt.framing == AnalysisFraming::Lines) {
+            if (len > 0 && data[len - 1] == '\r') --len;             // mesmo Decode() do LineFramer
+        }
+        else {
+            // COBS/SLIP decodificam no lugar: o mapeamento é só leitura.
+            if (!m_inScratch) m_scratch.assign(data, data + len);
+            size_t out = len;
+            bool ok = m_opt.framing == AnalysisFraming::Cobs ? m_cobs.Decode(m_scratch.data(), len, &out)
+                                                             : m_slip.Decode(m_scratch.data(), len, &out);
+            if (!ok) {
+                ++m_out->framingErrors;
+                return;
+            }
+            if (out == 0) return;                                    // kSkipEmpty
+            data = m_scratch.data();
+            len = out;
+        }
+        Analyze(data, len);
+    }
+
+    void Analyze(const uint8_t* data, size_t len) {
+        ChunkResult& r = *m_out;
+        const uint64_t frame = r.frames++;
+        const bool lines = m_opt.framing == AnalysisFraming::Lines;
+        if (len == 0) ++r.emptyFrames;
+        AddSample(r.frameBytes, len);
+
+        if (m_capture) {
+            if (!r.anyFrame) r.firstTsNs = m_frameTs;
+            else AddSample(r.frameGapUs, m_frameTs > r.lastTsNs ? (m_frameTs - r.lastTsNs) / 1000 : 0);
+            r.lastTsNs = m_frameTs;
+        }
+        r.anyFrame = true;
+
+        for (size_t k = 0; k < m_opt.patterns.size(); ++k) {
+            if (!ContainsBytes(data, len, m_opt.patterns[k])) continue;
+            PatternResult& pr = r.patterns[k];
+            ++pr.frames;
+            if (pr.first.size() < m_opt.maxMatches) {
+                PatternMatch m;
+                m.frame = frame;
+                m.offset = m_frameOffset;
+                m.tsNs = m_capture ? m_frameTs : 0;
+                m.text = MatchText(data, len, lines);
+                pr.first.push_back(std::move(m));
+            }
+        }
+
+        if (!lines) return;
+
+        m_wide.clear();
+        r.utf8Invalid += m_utf8.Decode((const char*)data, len, m_wide);
+        if (m_utf8.Pending()) {                                      // sequência cortada no fim da linha
+            ++r.utf8Invalid;
+            m_utf8.Reset();
+        }
+
+        size_t field = 0;
+        ForEachTelemetryField(data, len, [&](const char* name, size_t nameLen, double v) {
+            FieldSummary* f = FindField(name, nameLen, field++);
+            if (!f) {
+                ++r.droppedFields;
+                return;
+            }
+            if (f->count == 0 || v < f->min) f->min = v;
+            if (f->count == 0 || v > f->max) f->max = v;
+            f->sum += v;
+            ++f->count;
+        });
+    }
+
+    // Mesma dica por posição de campo de TelemetryStore::FindChannel().
+    FieldSummary* FindField(const char* name, size_t len, size_t field) {
+        std::vector<FieldSummary>& fields = m_out->fields;
+        auto same = [&](size_t i) {
+            const std::string& n = fields[i].name;
+            return n.size() == len && memcmp(n.data(), name, len) == 0;
+        };
+        if (field < m_fieldHint.size() && m_fieldHint[field] < fields.size() && same(m_fieldHint[field]))
+            return &fields[m_fieldHint[field]];
+
+        size_t idx = SIZE_MAX;
+        for (size_t i = 0; i < fields.size(); ++i) {
+            if (same(i)) {
+                idx = i;
+                break;
+            }
+        }
+        if (idx == SIZE_MAX) {
+            if (fields.size() >= m_opt.maxFields) return nullptr;
+            idx = fields.size();
+            fields.push_back(FieldSummary());
+            fields.back().name.assign(name, len);
+        }
+        if (field >= m_fieldHint.size()) m_fieldHint.resize(field + 1, SIZE_MAX);
+        m_fieldHint[field] = idx;
+        return &fields[idx];
+    }
+
+    const AnalysisOptions& m_opt;
+    const bool m_capture;
+    bool m_skipping;
+    ChunkResult* m_out;
+    uint8_t m_delim = '\n';
+
+    uint64_t m_pos = 0;                // bytes recebidos desde o início do pedaço
+    bool m_inFrame = false;
+    const uint8_t* m_frame = nullptr;
+    size_t m_frameLen = 0;
+    bool m_inScratch = false;
+    uint64_t m_frameOffset = 0;
+    uint64_t m_frameTs = 0;
+    std::vector<uint8_t> m_scratch;
+
+    CobsFramerT<SIZE_MAX> m_cobs;      // só Decode()
+    SlipFramerT<SIZE_MAX> m_slip;
+    Utf8Decoder m_utf8;
+    std::wstring m_wide;
+    std::vector<size_t> m_fieldHint;
+};
+
+// Pedaço i do log cru: [starts[i], starts[i+1]).
+void RunRawChunk(const AnalysisOptions& opt, const MappedFile& map, const std::vector<uint64_t>& starts,
+                 size_t i, ChunkResult* out) {
+    const uint8_t* data = map.Data();
+    const uint64_t size = map.Size();
+    const uint64_t s = starts[i];
+    const uint64_t e = starts[i + 1];
+    ChunkWorker w(opt, false, i > 0, out);
+    bool more = w.Feed(data + s, (size_t)(e - s), 0, true);
+    uint64_t at = e;
+    while (more && at < size) {
+        uint64_t n = std::min(kContinueStep, size - at);
+        more = w.Feed(data + at, (size_t)n, 0, false);
+        at += n;
+    }
+    if (more) w.Finish();
+}
+
+// Pedaço i da captura: registros que começam em [starts[i], starts[i+1]).
+void RunCaptureChunk(const AnalysisOptions& opt, const CaptureReader& reader,
+                     const std::vector<uint64_t>& starts, size_t i, ChunkResult* out) {
+    const uint64_t e = starts[i + 1];
+    ChunkWorker w(opt, true, i > 0, out);
+    uint64_t off = starts[i];
+    CaptureRecord rec;
+    bool more = true;
+    for (;;) {
+        const bool own = off < e;
+        if (!reader.Next(&off, &rec)) break;
+        if (rec.dir != opt.dir) continue;
+        if (own) ++out->records;
+        if (!(more = w.Feed(rec.data, rec.len, rec.tsNs, own))) break;
+    }
+    if (more) w.Finish();
+}
+
+unsigned ThreadCount(unsigned requested) {
+    if (requested) return requested;
+    unsigned n = std::thread::hardware_concurrency();
+    return n ? n : 1;
+}
+
+uint64_t ChunkSize(const AnalysisOptions& opt, uint64_t bytes, unsigned threads) {
+    if (opt.chunkBytes) return opt.chunkBytes;
+    uint64_t c = bytes / ((uint64_t)threads * 4);
+    return std::max(kMinChunk, std::min(kMaxChunk, c));
+}
+}
+
+// ============================================================================
+//                               AnalyzeFile
+// ============================================================================
+bool AnalyzeFile(const AnalysisOptions& opt, AnalysisReport* report, std::string* error) {
+    const int64_t t0 = PreciseTimer::NowNs();
+    AnalysisReport& r = *report;
+    r = AnalysisReport();
+    r.threads = ThreadCount(opt.threads);
+
+    MappedFile map;
+    if (!map.Open(opt.path)) {
+        *error = map.LastError();
+        return false;
+    }
+    r.fileBytes = map.Size();
+    r.capture = map.Size() >= sizeof(CaptureHeader) && memcmp(map.Data(), "SERCAP01", 8) == 0;
+
+    // Pontos de corte: starts[i] = início do pedaço i, starts.back() = fim.
+    std::vector<uint64_t> starts;
+    CaptureReader reader;
+    const uint64_t chunk = ChunkSize(opt, map.Size(), r.threads);
+    if (r.capture) {
+        map.Close();
+        if (!reader.Open(opt.path)) {
+            *error = reader.LastError();
+            return false;
+        }
+        starts.push_back(reader.FirstOffset());
+        for (const CaptureIndexEntry& ix : reader.Index())
+            if (ix.offset < reader.EndOffset() && ix.offset - starts.back() >= chunk) starts.push_back(ix.offset);
+        starts.push_back(reader.EndOffset());
+    }
+    else {
+        for (uint64_t at = 0; at < map.Size(); at += chunk) starts.push_back(at);
+        starts.push_back(map.Size());
+    }
+
+    const size_t chunks = starts.size() > 1 ? starts.size() - 1 : 0;
+    std::vector<ChunkResult> results(chunks);
+    std::atomic<size_t> next{ 0 };
+    auto work = [&]() {
+        for (size_t i; (i = next.fetch_add(1)) < chunks;) {
+            if (r.capture) RunCaptureChunk(opt, reader, starts, i, &results[i]);
+            else RunRawChunk(opt, map, starts, i, &results[i]);
+        }
+    };
+    r.threads = (unsigned)std::max<size_t>(1, std::min<size_t>(r.threads, chunks));
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < r.threads; ++t) pool.emplace_back(work);
+    work();
+    for (std::thread& t : pool) t.join();
+
+    // Junção em ordem: prefixos de frames/bytes viram números globais.
+    r.chunks = chunks;
+    r.patterns.resize(opt.patterns.size());
+    for (size_t k = 0; k < opt.patterns.size(); ++k) r.patterns[k].pattern = opt.patterns[k];
+    uint64_t frameBase = 0, streamBase = 0;
+    bool anyFrame = false;
+    for (const ChunkResult& c : results) {
+        r.records += c.records;
+        r.frames += c.frames;
+        r.emptyFrames += c.emptyFrames;
+        r.framingErrors += c.framingErrors;
+        r.tailBytes += c.tailBytes;
+        r.utf8Invalid += c.utf8Invalid;
+        r.droppedFields += c.droppedFields;
+        AddHistogram(r.frameBytes, c.frameBytes);
+        AddHistogram(r.frameGapUs, c.frameGapUs);
+        if (c.anyFrame && r.capture) {
+            if (!anyFrame) r.firstTsNs = c.firstTsNs;
+            else AddSample(r.frameGapUs, c.firstTsNs > r.lastTsNs ? (c.firstTsNs - r.lastTsNs) / 1000 : 0);
+            r.lastTsNs = c.lastTsNs;
+        }
+        anyFrame = anyFrame || c.anyFrame;
+
+        for (size_t k = 0; k < c.patterns.size(); ++k) {
+            PatternResult& pr = r.patterns[k];
+            pr.frames += c.patterns[k].frames;
+            for (const PatternMatch& m : c.patterns[k].first) {
+                if (pr.first.size() >= opt.maxMatches) break;
+                pr.first.push_back(m);
+                pr.first.back().frame += frameBase;
+                pr.first.back().offset += streamBase;
+            }
+        }
+
+        for (const FieldSummary& f : c.fields) {
+            auto it = std::find_if(r.fields.begin(), r.fields.end(),
+                                   [&](const FieldSummary& g) { return g.name == f.name; });
+            if (it == r.fields.end()) {
+                if (r.fields.size() >= opt.maxFields) {
+                    r.droppedFields += f.count;
+                    continue;
+                }
+                r.fields.push_back(f);
+                continue;
+            }
+            if (f.min < it->min) it->min = f.min;
+            if (f.max > it->max) it->max = f.max;
+            it->sum += f.sum;
+            it->count += f.count;
+        }
+
+        frameBase += c.frames;
+        streamBase += c.streamBytes;
+    }
+    r.streamBytes = streamBase;
+    r.seconds = (PreciseTimer::NowNs() - t0) / 1e9;
+    return true;
+}
+
+// ============================================================================
+//                                 Relatório
+// ============================================================================
+std::string AnalysisReportToText(const AnalysisReport& r) {
+    std::string s;
+    typedef unsigned long long ull;
+
+    AppendF(s, "arquivo: %llu B (%s), fluxo %llu B", (ull)r.fileBytes, r.capture ? "captura" : "log cru",
+        (ull)r.streamBytes);
+    if (r.capture) AppendF(s, ", %llu registros, %.3f s", (ull)r.records, (r.lastTsNs - r.firstTsNs) / 1e9);
+    AppendF(s, "\n%u threads, %zu pedacos, %.3f s (%.1f MB/s)\n", r.threads, r.chunks, r.seconds, r.MBps());
+    AppendF(s, "frames: %llu (vazios %llu, erros %llu, sobra %llu B), tamanho medio %.1f p50 %llu p99 %llu max %llu\n",
+        (ull)r.frames, (ull)r.emptyFrames, (ull)r.framingErrors, (ull)r.tailBytes, r.frameBytes.Mean(),
+        (ull)r.frameBytes.Percentile(0.50), (ull)r.frameBytes.Percentile(0.99), (ull)r.frameBytes.max);
+    if (r.capture && r.frameGapUs.count)
+        AppendF(s, "intervalo entre frames (us): medio %.1f p50 %llu p99 %llu max %llu\n", r.frameGapUs.Mean(),
+            (ull)r.frameGapUs.Percentile(0.50), (ull)r.frameGapUs.Percentile(0.99), (ull)r.frameGapUs.max);
+    if (r.utf8Invalid) AppendF(s, "UTF-8 invalido: %llu trechos\n", (ull)r.utf8Invalid);
+
+    for (const PatternResult& p : r.patterns) {
+        AppendF(s, "padrao \"%s\": %llu frames\n", p.pattern.c_str(), (ull)p.frames);
+        for (const PatternMatch& m : p.first) {
+            if (r.capture)
+                AppendF(s, "  #%llu @%llu t=%.6f s: %s\n", (ull)m.frame, (ull)m.offset, m.tsNs / 1e9, m.text.c_str());
+            else
+                AppendF(s, "  #%llu @%llu: %s\n", (ull)m.frame, (ull)m.offset, m.text.c_str());
+        }
+    }
+
+    for (const FieldSummary& f : r.fields)
+        AppendF(s, "campo %s: %llu valores, min %g max %g media %g\n", f.name.c_str(), (ull)f.count, f.min, f.max,
+            f.Mean());
+    if (r.droppedFields) AppendF(s, "campos ignorados (nomes demais): %llu\n", (ull)r.droppedFields);
+    return s;
+}
+
+// ============================================================================
+//                                 --analyze
+// ============================================================================
+namespace {
+void PrintAnalyzeUsage() {
+    fprintf(stderr,
+            "uso: --analyze=arquivo [--framing=lines|cobs|slip] [--pattern=texto ...]\n"
+            "               [--pattern-hex=DEADBEEF ...] [--threads=N] [--chunk=BYTES]\n"
+            "               [--matches=N] [--dir=rx|tx] (ver OfflineAnalysis.h)\n");
+}
+
+bool ParseHexPattern(const std::string& hex, std::string* out) {
+    out->clear();
+    int nibble = -1;
+    for (char c : hex) {
+        int v;
+        if (c >= '0' && c <= '9') v = c - '0';
+        else if (c >= 'a' && c <= 'f') v = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') v = c - 'A' + 10;
+        else if (c == ' ' || c == ':') continue;
+        else return false;
+        if (nibble < 0) nibble = v;
+        else {
+            out->push_back((char)(nibble << 4 | v));
+            nibble = -1;
+        }
+    }
+    return nibble < 0 && !out->empty();
+}
+}
+
+int AnalyzeMain(int argc, char** argv) {
+    AnalysisOptions opt;
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        const char* eq = strchr(a, '=');
+        std::string key = eq ? std::string(a, eq) : std::string(a);
+        std::string val = eq ? eq + 1 : "";
+        bool ok = true;
+        if (key == "--analyze") ok = !(opt.path = val).empty();
+        else if (key == "--framing") {
+            if (val == "lines") opt.framing = AnalysisFraming::Lines;
+            else if (val == "cobs") opt.framing = AnalysisFraming::Cobs;
+            else if (val == "slip") opt.framing = AnalysisFraming::Slip;
+            else ok = false;
+        }
+        else if (key == "--pattern") {
+            ok = !val.empty();
+            opt.patterns.push_back(val);
+        }
+        else if (key == "--pattern-hex") {
+            std::string bytes;
+            ok = ParseHexPattern(val, &bytes);
+            opt.patterns.push_back(bytes);
+        }
+        else if (key == "--threads") ok = (opt.threads = (unsigned)strtoul(val.c_str(), nullptr, 10)) > 0;
+        else if (key == "--chunk") ok = (opt.chunkBytes = strtoull(val.c_str(), nullptr, 10)) > 0;
+        else if (key == "--matches") opt.maxMatches = strtoul(val.c_str(), nullptr, 10);
+        else if (key == "--dir") {
+            if (val == "rx") opt.dir = CaptureDir::Rx;
+            else if (val == "tx") opt.dir = CaptureDir::Tx;
+            else ok = false;
+        }
+        else ok = false;
+        if (!ok) {
+            fprintf(stderr, "argumento invalido: %s\n", a);
+            PrintAnalyzeUsage();
+            return 2;
+        }
+    }
+    if (opt.path.empty()) {
+        PrintAnalyzeUsage();
+        return 2;
+    }
+
+    AnalysisReport report;
+    std::string error;
+    if (!AnalyzeFile(opt, &report, &error)) {
+        fprintf(stderr, "%s: %s\n", opt.path.c_str(), error.c_str());
+        return 1;
+    }
+    fputs(AnalysisReportToText(report).c_str(), stdout);
+    return 0;
+}
@@ -0,0 +1,120 @@
+// OfflineAnalysis.h - Análise offline de logs e capturas grandes em vários núcleos
+// Objetivo: olhar logs de campo de vários GB sem reproduzir à mão pela porta:
+//           o arquivo é mapeado (MappedFile / CaptureReader) e dividido entre
+//           todas as threads; o limite passa a ser o disco, não um núcleo.
+//
+// Entrada:
+//  - Log cru (bytes como saíram da porta, ex.: --headless --out=arquivo).
+//  - Captura .scap (Capture.h): só o fluxo de uma direção (RX por padrão),
+//    ou seja, os dados dos registros em sequência; os cabeçalhos e a outra
+//    direção são pulados. Cada frame leva o tsNs do registro onde começa.
+//
+// Frames: linhas ('\n', tira '\r'), COBS (0x00) ou SLIP (0xC0), com o mesmo
+// Decode() dos framers de Framing.h (sem o limite de MaxFrame). Por frame:
+//  - tamanho (histograma), erros de decodificação;
+//  - padrões literais: frames que contêm cada um + as primeiras ocorrências;
+//  - linhas: trechos UTF-8 inválidos (Utf8Decoder) e estatística dos campos
+//    "nome=valor" (mesmo tokenizador da telemetria, ForEachTelemetryField);
+//  - capturas: intervalo entre inícios de frames consecutivos (histograma).
+//
+// Divisão (sem nenhuma passada serial pelo arquivo):
+//  - O arquivo é cortado em pedaços de tamanho fixo (capturas: em início de
+//    registro, pelo índice). Há vários pedaços por thread e cada thread pega
+//    o próximo livre (balanceia pedaços mais caros).
+//  - Fronteira: o pedaço i (i > 0) começa logo depois do primeiro delimitador
+//    a partir do seu início; o pedaço i-1 continua além do próprio fim até
+//    esse mesmo delimitador. Assim cada byte do fluxo cai em exatamente um
+//    frame de exatamente um pedaço, sem saber nada do vizinho.
+//  - Cada pedaço produz um resultado local (contagens, frames numerados a
+//    partir de 0, offsets relativos); a junção percorre os pedaços em ordem
+//    e soma os prefixos: números de frame, offsets e "primeiras ocorrências"
+//    saem iguais aos de uma passada única, com qualquer número de threads.
+//
+// Logs crus em linhas são lidos direto do mapeamento (sem cópia); COBS/SLIP
+// decodificam no lugar e por isso copiam o frame para um buffer da thread,
+// assim como frames de captura que atravessam registros.
+//
+// Não depende de Win32.
+
+#pragma once
+
+#include "Capture.h"
+#include "Metrics.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class AnalysisFraming { Lines, Cobs, Slip };
+
+struct AnalysisOptions {
+    std::string path;                          // UTF-8
+    AnalysisFraming framing = AnalysisFraming::Lines;
+    std::vector<std::string> patterns;         // bytes literais (frames que contêm)
+    unsigned threads = 0;                      // 0 = núcleos da máquina
+    uint64_t chunkBytes = 0;                   // 0 = automático (~4 pedaços por thread, 1..64 MB)
+    size_t   maxMatches = 20;                  // primeiras ocorrências guardadas por padrão
+    size_t   maxFields = 64;                   // nomes de campo distintos (linhas)
+    CaptureDir dir = CaptureDir::Rx;           // só capturas
+};
+
+struct PatternMatch {
+    uint64_t frame = 0;                        // número do frame (0 = primeiro)
+    uint64_t offset = 0;                       // início do frame no fluxo (log: offset no arquivo)
+    uint64_t tsNs = 0;                         // só capturas
+    std::string text;                          // frame decodificado (até 120 bytes)
+};
+
+struct PatternResult {
+    std::string pattern;
+    uint64_t frames = 0;                       // frames com pelo menos uma ocorrência
+    std::vector<PatternMatch> first;           // até maxMatches, em ordem
+};
+
+struct FieldSummary {
+    std::string name;
+    uint64_t count = 0;
+    double   min = 0;
+    double   max = 0;
+    double   sum = 0;
+
+    double Mean() const { return count ? sum / count : 0.0; }
+};
+
+struct AnalysisReport {
+    bool     capture = false;
+    uint64_t fileBytes = 0;
+    uint64_t streamBytes = 0;                  // log: = fileBytes; captura: dados da direção
+    uint64_t records = 0;                      // captura: registros da direção
+    uint64_t frames = 0;                       // decodificados com sucesso
+    uint64_t emptyFrames = 0;                  // linhas vazias (COBS/SLIP: ignorados, não contam)
+    uint64_t framingErrors = 0;                // COBS/SLIP inválidos
+    uint64_t tailBytes = 0;                    // depois do último delimitador (linhas: vira frame)
+    uint64_t utf8Invalid = 0;                  // linhas
+    HistogramSnapshot frameBytes;              // tamanho decodificado
+    HistogramSnapshot frameGapUs;              // captura: entre inícios de frames
+    uint64_t firstTsNs = 0;                    // captura: primeiro/último frame
+    uint64_t lastTsNs = 0;
+    std::vector<PatternResult> patterns;       // na ordem de AnalysisOptions::patterns
+    std::vector<FieldSummary> fields;          // na ordem em que aparecem no arquivo
+    uint64_t droppedFields = 0;                // campos de nomes além de maxFields
+
+    unsigned threads = 0;
+    size_t   chunks = 0;
+    double   seconds = 0;
+
+    double MBps() const { return seconds > 0 ? fileBytes / seconds / 1e6 : 0.0; }
+};
+
+// Analisa o arquivo inteiro. false = 'error' (arquivo, captura inválida...).
+bool AnalyzeFile(const AnalysisOptions& opt, AnalysisReport* report, std::string* error);
+
+// Relatório legível (várias linhas, termina em '\n').
+std::string AnalysisReportToText(const AnalysisReport& r);
+
+// Modo --analyze (sem GUI): relatório em stdout. Retorna 0, 1 (erro) ou 2 (argumentos).
+//   --analyze=arquivo [--framing=lines|cobs|slip] [--pattern=texto ...]
+//             [--pattern-hex=DEADBEEF ...] [--threads=N] [--chunk=BYTES]
+//             [--matches=N] [--dir=rx|tx]
+int AnalyzeMain(int argc, char** argv);
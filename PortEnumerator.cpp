@@ -0,0 +1,177 @@
+// PortEnumerator.cpp - Thread e cache da lista de portas (ver PortEnumerator.h)
+// A varredura e a espera por hot-plug de cada sistema ficam em
+// PortEnumeratorWin32.cpp / PortEnumeratorPosix.cpp.
+
+#include "PortEnumerator.h"
+#include "PreciseTimer.h"
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+
+bool PortEnumerator::Start(std::function<void()> onChanged) {
+    if (m_thread.joinable()) return true;
+    m_onChanged = std::move(onChanged);
+    m_stop = false;
+    m_rescan = false;
+    OpenHotplug();                    // sem hot-plug a lista ainda sai (e Rescan() funciona)
+    m_thread = std::thread([this] { Run(); });
+    return true;
+}
+
+void PortEnumerator::Stop() {
+    if (!m_thread.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    Wake();
+    m_thread.join();
+    CloseHotplug();
+}
+
+void PortEnumerator::Rescan() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_rescan = true;
+    }
+    Wake();
+}
+
+std::vector<PortInfo> PortEnumerator::Ports(uint64_t* generation) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (generation) *generation = m_generation.load();
+    return m_ports;
+}
+
+void PortEnumerator::Publish(std::vector<PortInfo>&& ports, double ms) {
+    m_lastScanMs.store(ms);
+    m_scans.fetch_add(1);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        // Geração 0 = "ainda não varreu": a primeira lista sempre é publicada.
+        if (m_generation.load() != 0 && ports == m_ports) return;
+        m_ports = std::move(ports);
+        m_generation.fetch_add(1);
+    }
+    if (m_onChanged) m_onChanged();
+}
+
+void PortEnumerator::Run() {
+    bool pending = true;              // a primeira varredura sai sem esperar
+    bool first = true;
+    for (;;) {
+        if (pending) {
+            // Rajada de eventos (hub, driver recarregando): só varre depois
+            // de kSettleMs em silêncio.
+            if (!first)
+                while (WaitEvent(kSettleMs)) {}
+            first = false;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (m_stop) break;
+                m_rescan = false;
+            }
+            int64_t t0 = PreciseTimer::NowNs();
+            std::vector<PortInfo> ports = ScanSerialPorts();
+            Publish(std::move(ports), (PreciseTimer::NowNs() - t0) / 1e6);
+        }
+        pending = WaitEvent(-1);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_stop) break;
+    }
+}
+
+bool PortNameLess(const std::string& a, const std::string& b) {
+    size_t i = 0, j = 0;
+    while (i < a.size() && j < b.size()) {
+        bool da = a[i] >= '0' && a[i] <= '9', db = b[j] >= '0' && b[j] <= '9';
+        if (da && db) {
+            // Compara o número inteiro: mais dígitos (sem zeros à esquerda) = maior.
+            while (i < a.size() && a[i] == '0') i++;
+            while (j < b.size() && b[j] == '0') j++;
+            size_t ea = i, eb = j;
+            while (ea < a.size() && a[ea] >= '0' && a[ea] <= '9') ea++;
+            while (eb < b.size() && b[eb] >= '0' && b[eb] <= '9') eb++;
+            if (ea - i != eb - j) return ea - i < eb - j;
+            int c = a.compare(i, ea - i, b, j, eb - j);
+            if (c != 0) return c < 0;
+            i = ea;
+            j = eb;
+            continue;
+        }
+        if (a[i] != b[j]) return (unsigned char)a[i] < (unsigned char)b[j];
+        i++;
+        j++;
+    }
+    return a.size() - i < b.size() - j;
+}
+
+std::string PortUsbIdText(const PortInfo& p) {
+    if (p.vid == 0 && p.pid == 0) return {};
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%04X:%04X", p.vid, p.pid);
+    std::string s = buf;
+    if (!p.serialNumber.empty()) s += " SN " + p.serialNumber;
+    return s;
+}
+
+// ============================================================================
+//                            --list-ports [--watch]
+// ============================================================================
+namespace {
+
+std::atomic<bool> g_listStop{ false };
+
+void OnListStopSignal(int) {
+    g_listStop.store(true);
+}
+
+void PrintPorts(const std::vector<PortInfo>& ports) {
+    for (const PortInfo& p : ports) {
+        std::string usb = PortUsbIdText(p);
+        printf("%-16s %-40s %s%s%s\n", p.name.c_str(), p.description.c_str(), usb.c_str(),
+               p.manufacturer.empty() ? "" : "  ", p.manufacturer.c_str());
+    }
+    if (ports.empty()) printf("(nenhuma porta serial)\n");
+    fflush(stdout);
+}
+
+} // namespace
+
+int ListPortsMain(int argc, char** argv) {
+    bool watch = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--list-ports") == 0) continue;
+        if (strcmp(argv[i], "--watch") == 0) {
+            watch = true;
+            continue;
+        }
+        fprintf(stderr, "argumento invalido: %s\nuso: --list-ports [--watch]\n", argv[i]);
+        return 2;
+    }
+
+    if (!watch) {
+        PrintPorts(ScanSerialPorts());
+        return 0;
+    }
+
+    signal(SIGINT, OnListStopSignal);
+    signal(SIGTERM, OnListStopSignal);
+    std::atomic<uint64_t> changed{ 0 };
+    PortEnumerator ports;
+    ports.Start([&] { changed.fetch_add(1); });
+    uint64_t shown = 0;
+    while (!g_listStop.load()) {
+        if (changed.load() != shown) {
+            shown = changed.load();
+            printf("-- %s (varredura %.1f ms)\n", shown == 1 ? "portas" : "mudou", ports.LastScanMs());
+            PrintPorts(ports.Ports());
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    ports.Stop();
+    return 0;
+}
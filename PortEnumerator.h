@@ -0,0 +1,112 @@
+// PortEnumerator.h - Lista de portas seriais em cache, atualizada em segundo plano
+// Objetivo: abrir o dropdown de portas na hora. A varredura do sistema
+//           (SetupDi no Windows, sysfs no Linux) custa centenas de ms com
+//           muitas portas virtuais (Bluetooth, hubs USB) e não roda mais na
+//           thread da UI: uma thread própria varre e guarda o resultado.
+//
+//  - A varredura só se repete quando algum dispositivo entra/sai:
+//      Windows: a janela recebe WM_DEVICECHANGE e chama Rescan().
+//      Linux:   a própria thread escuta os uevents do kernel (netlink); sem
+//               netlink (container, sem permissão), compara /sys/class/tty
+//               a cada 2 s.
+//  - Pedidos em rajada (um hub com 4 portas gera vários eventos) viram UMA
+//    varredura: a thread espera kSettleMs sem eventos novos antes de varrer.
+//  - 'onChanged' só é chamado quando a lista realmente mudou.
+//
+// Backends de ScanSerialPorts(): PortEnumeratorWin32.cpp e PortEnumeratorPosix.cpp.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct PortInfo {
+    std::string name;            // "COM6", "/dev/ttyUSB0" (UTF-8): o que SerialPort::Open() aceita
+    std::string description;     // Windows: friendly name "USB Serial Port (COM6)"; Linux: produto USB ou driver
+    std::string manufacturer;
+    std::string serialNumber;    // número de série USB (vazio se o adaptador não tem)
+    uint16_t vid = 0;            // 0 = não é USB / desconhecido
+    uint16_t pid = 0;
+
+    bool operator==(const PortInfo& o) const {
+        return name == o.name && description == o.description && manufacturer == o.manufacturer &&
+               serialNumber == o.serialNumber && vid == o.vid && pid == o.pid;
+    }
+    bool operator!=(const PortInfo& o) const { return !(*this == o); }
+};
+
+// Varredura síncrona (cara): só a thread do PortEnumerator deve chamar.
+// Resultado ordenado por nome ("COM2" antes de "COM10").
+std::vector<PortInfo> ScanSerialPorts();
+
+// Ordem "natural" dos nomes: "COM2" < "COM10", "/dev/ttyUSB2" < "/dev/ttyUSB10".
+bool PortNameLess(const std::string& a, const std::string& b);
+
+// "0403:6001 SN A50285BI" (vazio se não é USB).
+std::string PortUsbIdText(const PortInfo& p);
+
+class PortEnumerator {
+public:
+    static const int kSettleMs = 150;
+
+    PortEnumerator() = default;
+    ~PortEnumerator() { Stop(); }
+
+    PortEnumerator(const PortEnumerator&) = delete;
+    PortEnumerator& operator=(const PortEnumerator&) = delete;
+
+    // Inicia a thread e a primeira varredura. 'onChanged' roda na thread do
+    // enumerador (só poste uma mensagem/sinalize dali).
+    bool Start(std::function<void()> onChanged);
+    void Stop();
+
+    // Pede uma nova varredura (não bloqueia). Seguro de qualquer thread.
+    void Rescan();
+
+    // Cópia da lista atual. 'generation' muda a cada lista nova (0 = nenhuma varredura ainda).
+    std::vector<PortInfo> Ports(uint64_t* generation = nullptr) const;
+    uint64_t Generation() const { return m_generation.load(); }
+
+    double LastScanMs() const { return m_lastScanMs.load(); }
+    uint64_t Scans() const { return m_scans.load(); }
+
+private:
+    void Run();
+    void Publish(std::vector<PortInfo>&& ports, double ms);
+
+    // Parte de cada plataforma (junto de ScanSerialPorts()):
+    //  WaitEvent(ms): espera até 'ms' (-1 = sem limite) por um evento de
+    //    hot-plug ou um Rescan(). true = houve evento; false = timeout/Stop().
+    //  Wake(): acorda o WaitEvent() (Rescan()/Stop()).
+    bool OpenHotplug();
+    void CloseHotplug();
+    bool WaitEvent(int ms);
+    void Wake();
+
+    std::function<void()> m_onChanged;
+    std::thread m_thread;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cv;
+    bool m_stop = false;
+    bool m_rescan = false;
+    std::vector<PortInfo> m_ports;
+    std::atomic<uint64_t> m_generation{ 0 };
+    std::atomic<double> m_lastScanMs{ 0 };
+    std::atomic<uint64_t> m_scans{ 0 };
+
+    // Linux: socket netlink (uevents) + eventfd do Wake().
+    int m_netlinkFd = -1;
+    int m_wakeFd = -1;
+    std::string m_ttyListing;     // sem netlink: nomes em /sys/class/tty na última olhada
+};
+
+// Modo "--list-ports [--watch]" do executável Linux (MainPosix.cpp): imprime a
+// lista (uma porta por linha) e, com --watch, reimprime a cada mudança até
+// Ctrl+C. Retorna o código de saída.
+int ListPortsMain(int argc, char** argv);
@@ -0,0 +1,196 @@
+// PortEnumeratorPosix.cpp - Varredura de portas e hot-plug no Linux (ver PortEnumerator.h)
+//  - Portas: entradas de /sys/class/tty com "device" (ttys virtuais e ptys
+//    não têm). Os 32 ttyS reservados pelo serial8250 sem UART por trás ficam
+//    de fora.
+//  - USB: sobe a partir do device até achar idVendor/idProduct e lê dali
+//    serial, manufacturer e product (ttyUSB/ttyACM ficam na interface).
+//  - Hot-plug: socket NETLINK_KOBJECT_UEVENT (grupo do kernel, não depende
+//    de udev); só eventos SUBSYSTEM=tty contam. Sem netlink, compara a
+//    listagem de /sys/class/tty a cada kPollMs.
+
+#if defined(__linux__)
+
+#include "PortEnumerator.h"
+#include "PreciseTimer.h"
+
+#include <linux/netlink.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <dirent.h>
+#include <poll.h>
+#include <unistd.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+
+const char* const kTtyClass = "/sys/class/tty";
+const int kPollMs = 2000;
+
+std::string ReadSysfs(const std::string& path) {
+    FILE* f = fopen(path.c_str(), "r");
+    if (!f) return {};
+    char buf[256];
+    size_t n = fread(buf, 1, sizeof(buf) - 1, f);
+    fclose(f);
+    while (n > 0 && (buf[n - 1] == '\n' || buf[n - 1] == ' ')) n--;
+    return std::string(buf, n);
+}
+
+std::string LinkBase(const std::string& path) {
+    char buf[PATH_MAX];
+    ssize_t n = readlink(path.c_str(), buf, sizeof(buf) - 1);
+    if (n <= 0) return {};
+    buf[n] = 0;
+    const char* slash = strrchr(buf, '/');
+    return slash ? slash + 1 : buf;
+}
+
+// Nomes em /sys/class/tty, ordenados (para o fallback sem netlink).
+std::string TtyListing() {
+    std::vector<std::string> names;
+    if (DIR* d = opendir(kTtyClass)) {
+        while (dirent* e = readdir(d))
+            if (e->d_name[0] != '.') names.push_back(e->d_name);
+        closedir(d);
+    }
+    std::sort(names.begin(), names.end());
+    std::string s;
+    for (const std::string& n : names) s += n + '\n';
+    return s;
+}
+
+bool ReadPort(const std::string& tty, PortInfo* p) {
+    std::string base = std::string(kTtyClass) + "/" + tty;
+    char real[PATH_MAX];
+    if (!realpath((base + "/device").c_str(), real)) return false;
+    std::string dev = real;
+    if (dev.size() >= 11 && dev.compare(dev.size() - 11, 11, "/serial8250") == 0) return false;
+
+    p->name = "/dev/" + tty;
+    p->description = LinkBase(dev + "/driver");
+
+    // ttyUSB: .../1-1/1-1:1.0/ttyUSB0; ttyACM: .../1-1/1-1:1.0 -> o USB está no pai.
+    std::string usb = dev;
+    for (int up = 0; up < 4 && usb.size() > 1; up++) {
+        std::string vid = ReadSysfs(usb + "/idVendor");
+        if (!vid.empty()) {
+            p->vid = (uint16_t)strtoul(vid.c_str(), nullptr, 16);
+            p->pid = (uint16_t)strtoul(ReadSysfs(usb + "/idProduct").c_str(), nullptr, 16);
+            p->serialNumber = ReadSysfs(usb + "/serial");
+            p->manufacturer = ReadSysfs(usb + "/manufacturer");
+            std::string product = ReadSysfs(usb + "/product");
+            if (!product.empty()) p->description = product;
+            break;
+        }
+        usb.erase(usb.rfind('/'));
+    }
+    if (p->description.empty()) p->description = tty;
+    return true;
+}
+
+// Um datagrama de uevent: "add@/devices/...\0ACTION=add\0SUBSYSTEM=tty\0...".
+bool IsTtyUevent(const char* msg, size_t len) {
+    for (size_t i = 0; i < len; i += strlen(msg + i) + 1)
+        if (strcmp(msg + i, "SUBSYSTEM=tty") == 0) return true;
+    return false;
+}
+
+} // namespace
+
+std::vector<PortInfo> ScanSerialPorts() {
+    std::vector<PortInfo> ports;
+    DIR* d = opendir(kTtyClass);
+    if (!d) return ports;
+    while (dirent* e = readdir(d)) {
+        if (e->d_name[0] == '.') continue;
+        PortInfo p;
+        if (ReadPort(e->d_name, &p)) ports.push_back(std::move(p));
+    }
+    closedir(d);
+    std::sort(ports.begin(), ports.end(),
+              [](const PortInfo& a, const PortInfo& b) { return PortNameLess(a.name, b.name); });
+    return ports;
+}
+
+bool PortEnumerator::OpenHotplug() {
+    m_wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    m_netlinkFd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, NETLINK_KOBJECT_UEVENT);
+    if (m_netlinkFd >= 0) {
+        sockaddr_nl addr = {};
+        addr.nl_family = AF_NETLINK;
+        addr.nl_groups = 1;               // eventos do kernel (2 = os reenviados pelo udev)
+        if (bind(m_netlinkFd, (sockaddr*)&addr, sizeof(addr)) != 0) {
+            close(m_netlinkFd);
+            m_netlinkFd = -1;
+        }
+    }
+    if (m_netlinkFd < 0) m_ttyListing = TtyListing();
+    return m_wakeFd >= 0;
+}
+
+void PortEnumerator::CloseHotplug() {
+    if (m_netlinkFd >= 0) close(m_netlinkFd);
+    if (m_wakeFd >= 0) close(m_wakeFd);
+    m_netlinkFd = m_wakeFd = -1;
+}
+
+void PortEnumerator::Wake() {
+    if (m_wakeFd < 0) return;
+    uint64_t one = 1;
+    ssize_t r = write(m_wakeFd, &one, sizeof(one));
+    (void)r;
+}
+
+bool PortEnumerator::WaitEvent(int ms) {
+    int64_t deadline = ms < 0 ? INT64_MAX : PreciseTimer::NowNs() + (int64_t)ms * 1000000;
+    for (;;) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_stop) return false;
+            if (m_rescan) {
+                m_rescan = false;
+                return true;
+            }
+        }
+
+        int64_t now = PreciseTimer::NowNs();
+        if (now >= deadline) return false;
+        int timeout = deadline == INT64_MAX ? -1 : (int)((deadline - now + 999999) / 1000000);
+        if (m_netlinkFd < 0 && (timeout < 0 || timeout > kPollMs)) timeout = kPollMs;
+
+        pollfd fds[2] = { { m_wakeFd, POLLIN, 0 }, { m_netlinkFd, POLLIN, 0 } };
+        int n = poll(fds, m_netlinkFd >= 0 ? 2 : 1, timeout);
+        if (n < 0 && errno != EINTR) return false;
+
+        if (n > 0 && (fds[0].revents & POLLIN)) {
+            uint64_t v;
+            ssize_t r = read(m_wakeFd, &v, sizeof(v));
+            (void)r;
+        }
+        bool tty = false;
+        if (n > 0 && m_netlinkFd >= 0 && (fds[1].revents & POLLIN)) {
+            char buf[8192];
+            ssize_t len;
+            while ((len = recv(m_netlinkFd, buf, sizeof(buf) - 1, 0)) > 0) {
+                buf[len] = 0;
+                tty = tty || IsTtyUevent(buf, (size_t)len);
+            }
+        }
+        if (n == 0 && m_netlinkFd < 0) {
+            std::string listing = TtyListing();
+            if (listing != m_ttyListing) {
+                m_ttyListing = listing;
+                tty = true;
+            }
+        }
+        if (tty) return true;
+    }
+}
+
+#endif // __linux__
@@ -0,0 +1,138 @@
+// PortEnumeratorWin32.cpp - Varredura de portas no Windows (ver PortEnumerator.h)
+//  - Classe "Ports (COM & LPT)" via SetupDi; o nome da porta vem do valor
+//    "PortName" da chave do dispositivo (não do friendly name), e as LPT
+//    ficam de fora.
+//  - VID/PID e número de série saem do instance ID:
+//      USB\VID_0403&PID_6001\A50285BI              (serial = último trecho)
+//      FTDIBUS\VID_0403+PID_6001+A50285BIA\0000    (serial = 3º campo, sem o
+//                                                   sufixo da interface)
+//    Um último trecho com '&' foi gerado pelo Windows: não é serial.
+//  - Hot-plug: não há watcher próprio; a janela principal recebe
+//    WM_DEVICECHANGE e chama Rescan(). WaitEvent() só espera o Rescan().
+
+#ifdef _WIN32
+
+#include "PortEnumerator.h"
+
+#include <windows.h>
+#include <setupapi.h>
+#include <initguid.h>
+#include <devguid.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cwchar>
+
+#pragma comment(lib, "setupapi.lib")
+
+namespace {
+
+std::string ToUtf8(const std::wstring& w) {
+    if (w.empty()) return {};
+    int len = WideCharToMultiByte(CP_UTF8, 0, w.c_str(), (int)w.size(), nullptr, 0, nullptr, nullptr);
+    std::string out(len, 0);
+    WideCharToMultiByte(CP_UTF8, 0, w.c_str(), (int)w.size(), &out[0], len, nullptr, nullptr);
+    return out;
+}
+
+std::wstring RegistryString(HDEVINFO h, SP_DEVINFO_DATA* dev, DWORD prop) {
+    wchar_t buf[256];
+    if (!SetupDiGetDeviceRegistryPropertyW(h, dev, prop, nullptr, (PBYTE)buf, sizeof(buf) - sizeof(wchar_t), nullptr))
+        return {};
+    buf[255] = 0;
+    return buf;
+}
+
+std::wstring PortNameOf(HDEVINFO h, SP_DEVINFO_DATA* dev) {
+    HKEY key = SetupDiOpenDevRegKey(h, dev, DICS_FLAG_GLOBAL, 0, DIREG_DEV, KEY_READ);
+    if (key == INVALID_HANDLE_VALUE) return {};
+    wchar_t buf[64] = {};
+    DWORD size = sizeof(buf) - sizeof(wchar_t), type = 0;
+    LONG r = RegQueryValueExW(key, L"PortName", nullptr, &type, (LPBYTE)buf, &size);
+    RegCloseKey(key);
+    return (r == ERROR_SUCCESS && type == REG_SZ) ? buf : std::wstring();
+}
+
+// "VID_0403" -> 0x0403 (0 se não achar).
+uint16_t HexAfter(const std::wstring& id, const wchar_t* tag) {
+    size_t p = id.find(tag);
+    if (p == std::wstring::npos) return 0;
+    return (uint16_t)wcstoul(id.c_str() + p + wcslen(tag), nullptr, 16);
+}
+
+std::wstring SerialFromInstanceId(const std::wstring& id) {
+    if (id.compare(0, 4, L"USB\\") == 0) {
+        size_t s = id.rfind(L'\\');
+        std::wstring last = id.substr(s + 1);
+        return last.find(L'&') == std::wstring::npos ? last : std::wstring();
+    }
+    if (id.compare(0, 8, L"FTDIBUS\\") == 0) {
+        size_t a = id.find(L'+');
+        size_t b = a == std::wstring::npos ? a : id.find(L'+', a + 1);
+        size_t e = b == std::wstring::npos ? b : id.find(L'\\', b + 1);
+        if (e == std::wstring::npos) return {};
+        std::wstring sn = id.substr(b + 1, e - b - 1);
+        if (sn.size() > 1) sn.pop_back();       // "A50285BIA": 'A' = interface A do chip
+        return sn;
+    }
+    return {};
+}
+
+} // namespace
+
+std::vector<PortInfo> ScanSerialPorts() {
+    std::vector<PortInfo> ports;
+    HDEVINFO h = SetupDiGetClassDevsW(&GUID_DEVCLASS_PORTS, nullptr, nullptr, DIGCF_PRESENT);
+    if (h == INVALID_HANDLE_VALUE) return ports;
+
+    SP_DEVINFO_DATA dev = { sizeof(SP_DEVINFO_DATA) };
+    for (DWORD i = 0; SetupDiEnumDeviceInfo(h, i, &dev); i++) {
+        std::wstring name = PortNameOf(h, &dev);
+        if (name.compare(0, 3, L"COM") != 0) continue;      // LPT e afins
+
+        PortInfo p;
+        p.name = ToUtf8(name);
+        p.description = ToUtf8(RegistryString(h, &dev, SPDRP_FRIENDLYNAME));
+        if (p.description.empty()) p.description = p.name;
+        p.manufacturer = ToUtf8(RegistryString(h, &dev, SPDRP_MFG));
+
+        wchar_t id[512];
+        if (SetupDiGetDeviceInstanceIdW(h, &dev, id, 512, nullptr)) {
+            std::wstring inst = id;
+            p.vid = HexAfter(inst, L"VID_");
+            p.pid = HexAfter(inst, L"PID_");
+            p.serialNumber = ToUtf8(SerialFromInstanceId(inst));
+        }
+        ports.push_back(std::move(p));
+    }
+    SetupDiDestroyDeviceInfoList(h);
+
+    std::sort(ports.begin(), ports.end(),
+              [](const PortInfo& a, const PortInfo& b) { return PortNameLess(a.name, b.name); });
+    return ports;
+}
+
+bool PortEnumerator::OpenHotplug() {
+    return true;
+}
+
+void PortEnumerator::CloseHotplug() {
+}
+
+void PortEnumerator::Wake() {
+    m_cv.notify_all();
+}
+
+bool PortEnumerator::WaitEvent(int ms) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    auto ready = [this] { return m_stop || m_rescan; };
+    if (ms < 0)
+        m_cv.wait(lock, ready);
+    else
+        m_cv.wait_for(lock, std::chrono::milliseconds(ms), ready);
+    if (m_stop || !m_rescan) return false;
+    m_rescan = false;
+    return true;
+}
+
+#endif // _WIN32
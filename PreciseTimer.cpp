@@ -0,0 +1,117 @@
+// PreciseTimer.cpp - Espera híbrida dormir+girar (ver PreciseTimer.h)
+
+#include "PreciseTimer.h"
+
+#include <chrono>
+#include <thread>
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#include <emmintrin.h>
+static inline void CpuRelax() { _mm_pause(); }
+#else
+static inline void CpuRelax() { std::this_thread::yield(); }
+#endif
+
+int64_t PreciseTimer::NowNs() {
+    return (int64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+#ifdef _WIN32
+
+#include <windows.h>
+#pragma comment(lib, "winmm.lib")
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+PreciseTimer::PreciseTimer() {
+    m_timer = CreateWaitableTimerExW(nullptr, nullptr,
+        CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    if (m_timer) {
+        m_spinNs = 500 * 1000;          // timer de alta resolução: ~0,5 ms de folga
+    }
+    else {
+        // Windows antigo: timer comum + resolução de 1 ms para o processo.
+        m_timer = CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+        m_raisedPeriod = (timeBeginPeriod(1) == TIMERR_NOERROR);
+        m_spinNs = m_raisedPeriod ? 2 * 1000 * 1000 : 16 * 1000 * 1000;
+    }
+    m_cancelEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+}
+
+PreciseTimer::~PreciseTimer() {
+    if (m_timer) CloseHandle(m_timer);
+    if (m_cancelEvent) CloseHandle(m_cancelEvent);
+    if (m_raisedPeriod) timeEndPeriod(1);
+}
+
+void PreciseTimer::Cancel() {
+    m_cancelled.store(true, std::memory_order_release);
+    SetEvent(m_cancelEvent);
+}
+
+void PreciseTimer::Reset() {
+    ResetEvent(m_cancelEvent);
+    m_cancelled.store(false, std::memory_order_release);
+}
+
+bool PreciseTimer::SleepUntil(int64_t deadlineNs) {
+    int64_t sleepNs = deadlineNs - NowNs() - m_spinNs;
+    if (sleepNs > 0 && m_timer) {
+        LARGE_INTEGER due;
+        due.QuadPart = -(sleepNs / 100);    // relativo, em unidades de 100 ns
+        if (SetWaitableTimer(m_timer, &due, 0, nullptr, nullptr, FALSE)) {
+            HANDLE waits[2] = { m_timer, m_cancelEvent };
+            if (WaitForMultipleObjects(2, waits, FALSE, INFINITE) != WAIT_OBJECT_0) {
+                CancelWaitableTimer(m_timer);
+                return false;
+            }
+        }
+    }
+    while (NowNs() < deadlineNs) {
+        if (Cancelled()) return false;
+        CpuRelax();
+    }
+    return !Cancelled();
+}
+
+#else
+
+PreciseTimer::PreciseTimer()
+    : m_spinNs(100 * 1000) {   // hrtimers: folga de ~0,1 ms basta
+}
+
+PreciseTimer::~PreciseTimer() {
+}
+
+void PreciseTimer::Cancel() {
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_cancelled.store(true, std::memory_order_release);
+    }
+    m_wake.notify_all();
+}
+
+void PreciseTimer::Reset() {
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_cancelled.store(false, std::memory_order_release);
+}
+
+bool PreciseTimer::SleepUntil(int64_t deadlineNs) {
+    int64_t wakeNs = deadlineNs - m_spinNs;
+    if (wakeNs > NowNs()) {
+        std::unique_lock<std::mutex> lock(m_lock);
+        std::chrono::steady_clock::time_point wakeAt(
+            std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds(wakeNs)));
+        if (m_wake.wait_until(lock, wakeAt, [&] { return Cancelled(); })) return false;
+    }
+    while (NowNs() < deadlineNs) {
+        if (Cancelled()) return false;
+        CpuRelax();
+    }
+    return !Cancelled();
+}
+
+#endif
@@ -0,0 +1,54 @@
+// PreciseTimer.h - Espera até um instante com precisão sub-milissegundo
+// Objetivo: agendar eventos (replay, envios periódicos) sem a granularidade do
+//           Sleep() (15,6 ms por padrão no Windows) e sem queimar um núcleo.
+//
+// Espera híbrida: dorme no SO até 'SpinNs()' antes do prazo e termina em
+// espera ativa curta. No Windows usa um waitable timer de alta resolução
+// (Windows 10 1803+); sem ele, timeBeginPeriod(1) enquanto o timer existir.
+//
+// Threads: SleepUntil() numa thread; Cancel() de qualquer thread acorda a
+// espera (e as próximas retornam na hora até Reset()).
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#ifndef _WIN32
+#include <condition_variable>
+#include <mutex>
+#endif
+
+class PreciseTimer {
+public:
+    PreciseTimer();
+    ~PreciseTimer();
+
+    PreciseTimer(const PreciseTimer&) = delete;
+    PreciseTimer& operator=(const PreciseTimer&) = delete;
+
+    // Relógio monotônico em ns (mesma base de 'deadlineNs').
+    static int64_t NowNs();
+
+    // Espera até NowNs() >= deadlineNs. Retorna false se cancelado.
+    bool SleepUntil(int64_t deadlineNs);
+
+    void Cancel();
+    void Reset();
+    bool Cancelled() const { return m_cancelled.load(std::memory_order_acquire); }
+
+    // Margem final feita em espera ativa (depende da resolução do SO).
+    int64_t SpinNs() const { return m_spinNs; }
+
+private:
+    std::atomic<bool> m_cancelled{ false };
+    int64_t m_spinNs;
+#ifdef _WIN32
+    void* m_timer = nullptr;        // HANDLE (waitable timer)
+    void* m_cancelEvent = nullptr;  // HANDLE
+    bool m_raisedPeriod = false;    // timeBeginPeriod(1) ativo
+#else
+    std::mutex m_lock;
+    std::condition_variable m_wake;
+#endif
+};
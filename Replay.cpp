@@ -0,0 +1,174 @@
+// Replay.cpp - Porta serial virtual que reproduz capturas (ver Replay.h)
+
+#include "Replay.h"
+
+#include <cstring>
+
+ReplaySerialPort::ReplaySerialPort(const ReplayOptions& opt)
+    : m_opt(opt) {
+    if (!(m_opt.speed > 0.0)) m_opt.speed = 1.0;
+}
+
+bool ReplaySerialPort::Open(const std::string& name, const SerialConfig&) {
+    Close();
+    if (!m_reader.Open(name)) {
+        m_lastError = m_reader.LastError();
+        return false;
+    }
+    m_startOffset = m_opt.startNs ? m_reader.SeekTime(m_opt.startNs) : m_reader.FirstOffset();
+    m_timer.Reset();
+    m_finished = false;
+    m_txBytes = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_statsLock);
+        m_stats = ReplayStats();
+        m_started = false;
+    }
+    Rewind();
+    m_open = true;
+    return true;
+}
+
+void ReplaySerialPort::Close() {
+    m_reader.Close();
+    m_hasCur = false;
+    m_open = false;
+}
+
+void ReplaySerialPort::CancelRead() {
+    m_timer.Cancel();
+}
+
+std::string ReplaySerialPort::LastError() const {
+    return m_lastError;
+}
+
+long ReplaySerialPort::Write(const void*, size_t len) {
+    m_txBytes.fetch_add(len, std::memory_order_relaxed);
+    return (long)len;
+}
+
+ReplayStats ReplaySerialPort::Stats() const {
+    std::lock_guard<std::mutex> lock(m_statsLock);
+    ReplayStats s = m_stats;
+    if (m_started && !Finished()) s.elapsedNs = PreciseTimer::NowNs() - m_t0;
+    return s;
+}
+
+void ReplaySerialPort::Rewind() {
+    m_offset = m_startOffset;
+    m_hasCur = false;
+    m_curPos = 0;
+}
+
+// Próximo bloco RX a partir de m_offset (pula os TX). false = fim.
+bool ReplaySerialPort::LoadNextRx() {
+    CaptureRecord rec;
+    while (m_reader.Next(&m_offset, &rec)) {
+        if (rec.dir != CaptureDir::Rx || rec.len == 0) continue;
+        m_cur = rec;
+        m_curPos = 0;
+        m_hasCur = true;
+        return true;
+    }
+    m_hasCur = false;
+    return false;
+}
+
+// Instante (NowNs) em que um bloco gravado em 'tsNs' deve ser entregue.
+int64_t ReplaySerialPort::DueNs(uint64_t tsNs) const {
+    return m_t0 + (int64_t)((double)(tsNs - m_firstTs) / m_opt.speed);
+}
+
+long ReplaySerialPort::Read(void* buf, size_t len) {
+    if (!m_open || len == 0) return -1;
+    if (m_timer.Cancelled() || Finished()) return 0;
+
+    // Bloco atual (ou próximo); no fim, recomeça ou encerra.
+    if (!m_hasCur && !LoadNextRx()) {
+        bool again = false;
+        if (m_opt.loop) {
+            Rewind();
+            again = LoadNextRx();
+            std::lock_guard<std::mutex> lock(m_statsLock);
+            if (again) ++m_stats.loops;
+            m_started = false;    // novo t = 0 na volta
+        }
+        if (!again) {
+            {
+                std::lock_guard<std::mutex> lock(m_statsLock);
+                if (m_started) m_stats.elapsedNs = PreciseTimer::NowNs() - m_t0;
+            }
+            m_finished.store(true, std::memory_order_release);
+            if (m_onEnd) m_onEnd();
+            return 0;
+        }
+    }
+
+    if (!m_started) {
+        std::lock_guard<std::mutex> lock(m_statsLock);   // Stats() lê m_t0
+        m_firstTs = m_cur.tsNs;
+        m_t0 = PreciseTimer::NowNs();
+        m_started = true;
+    }
+
+    // RealTime: espera o instante original do bloco (só no começo dele).
+    int64_t late = 0;
+    if (m_opt.mode == ReplayMode::RealTime && m_curPos == 0) {
+        int64_t due = DueNs(m_cur.tsNs);
+        if (!m_timer.SleepUntil(due)) return 0;
+        late = PreciseTimer::NowNs() - due;
+    }
+
+    // Entrega o bloco atual e, enquanto couber, os próximos que já venceram
+    // (MaxSpeed: todos). Blocos maiores que 'len' saem em pedaços.
+    uint8_t* out = (uint8_t*)buf;
+    size_t outLen = 0;
+    uint64_t chunks = 0;
+    for (;;) {
+        size_t n = m_cur.len - m_curPos;
+        if (n > len - outLen) n = len - outLen;
+        memcpy(out + outLen, m_cur.data + m_curPos, n);
+        outLen += n;
+        m_curPos += n;
+        if (m_curPos < m_cur.len) break;     // buffer cheio no meio do bloco
+
+        // Bloco entregue por inteiro: o próximo já fica carregado (m_curPos
+        // == 0), mesmo com o buffer cheio. Um bloco esgotado não pode sobrar
+        // como atual: o Read() seguinte pularia a espera e devolveria 0.
+        ++chunks;
+        if (!LoadNextRx() || outLen == len) break;
+        if (m_opt.mode == ReplayMode::RealTime && DueNs(m_cur.tsNs) > PreciseTimer::NowNs()) break;
+    }
+
+    std::lock_guard<std::mutex> lock(m_statsLock);
+    m_stats.chunks += chunks;
+    m_stats.bytes += outLen;
+    if (late > m_stats.lateMaxNs) m_stats.lateMaxNs = late;
+    if (late > 0) m_stats.lateSumNs += late;
+    return (long)outLen;
+}
+
+bool ReplayToSink(const std::string& path, const ReplayOptions& opt,
+                  const std::function<void(const uint8_t* data, size_t len)>& sink,
+                  ReplayStats* stats, std::string* error,
+                  const std::atomic<bool>* cancel) {
+    ReplayOptions once = opt;
+    once.loop = false;
+    ReplaySerialPort port(once);
+    if (!port.Open(path, SerialConfig())) {
+        if (error) *error = port.LastError();
+        return false;
+    }
+
+    // Mesmo tamanho de leitura do SerialReadLoop() da GUI.
+    uint8_t buffer[1024];
+    for (;;) {
+        if (cancel && cancel->load(std::memory_order_relaxed)) break;   // verificado entre blocos
+        long n = port.Read(buffer, sizeof(buffer));
+        if (n <= 0) break;
+        sink(buffer, (size_t)n);
+    }
+    if (stats) *stats = port.Stats();
+    return true;
+}
@@ -0,0 +1,106 @@
+// Replay.h - Reprodução de capturas como se fossem uma porta serial
+// Objetivo: reproduzir problemas de campo e medir o pipeline de RX sem
+//           hardware. ReplaySerialPort implementa SerialPort: entra no mesmo
+//           SerialReadLoop() que a porta real, lendo os blocos RX gravados
+//           por CaptureWriter (registros TX são ignorados).
+//
+// Modos:
+//  - RealTime: cada bloco é entregue no instante original (relativo ao
+//    primeiro), com PreciseTimer (dormir + girar), não com Sleep().
+//    'speed' acelera/desacelera (2.0 = duas vezes mais rápido).
+//  - MaxSpeed: entrega tudo o mais rápido possível, juntando blocos até
+//    encher o buffer de Read(): mede a folga de decodificação/exibição.
+//
+// Fim da captura: Read() retorna 0 (como num CancelRead()), Finished() fica
+// true e 'onEnd' é chamado na thread de leitura. Com 'loop' recomeça do início.
+//
+// Sem GUI: ReplayToSink() roda o mesmo Read() na thread chamadora e entrega
+// os bytes a um callback (--bench --replay=arquivo.scap e o caso
+// replay_round_trip do --selftest).
+//
+// Não depende de Win32.
+
+#pragma once
+
+#include "Capture.h"
+#include "PreciseTimer.h"
+#include "SerialPort.h"
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+
+enum class ReplayMode { RealTime, MaxSpeed };
+
+struct ReplayOptions {
+    ReplayMode mode = ReplayMode::RealTime;
+    double   speed = 1.0;          // só RealTime
+    uint64_t startNs = 0;          // começa no primeiro bloco com tsNs >= startNs
+    bool     loop = false;
+};
+
+struct ReplayStats {
+    uint64_t chunks = 0;           // blocos RX entregues
+    uint64_t bytes = 0;
+    uint64_t loops = 0;
+    int64_t  elapsedNs = 0;        // do primeiro Read() até agora/fim
+    int64_t  lateMaxNs = 0;        // RealTime: maior atraso em relação ao agendado
+    int64_t  lateSumNs = 0;        // RealTime: soma dos atrasos (média = soma/chunks)
+};
+
+class ReplaySerialPort : public SerialPort {
+public:
+    explicit ReplaySerialPort(const ReplayOptions& opt = ReplayOptions());
+
+    // 'name' = caminho da captura (UTF-8). 'cfg' é ignorado.
+    bool Open(const std::string& name, const SerialConfig& cfg) override;
+    void Close() override;
+    bool IsOpen() const override { return m_open; }
+    long Read(void* buf, size_t len) override;
+    long Write(const void* data, size_t len) override;   // descarta (conta em txBytes)
+    void CancelRead() override;
+    std::string LastError() const override;
+
+    // Chamado uma vez, na thread de leitura, quando a captura termina.
+    void SetOnEnd(std::function<void()> onEnd) { m_onEnd = onEnd; }
+
+    bool Finished() const { return m_finished.load(std::memory_order_acquire); }
+    ReplayStats Stats() const;
+    uint64_t TxBytes() const { return m_txBytes.load(std::memory_order_relaxed); }
+    const CaptureHeader& Header() const { return m_reader.Header(); }
+
+private:
+    bool LoadNextRx();
+    void Rewind();
+    int64_t DueNs(uint64_t tsNs) const;
+
+    ReplayOptions m_opt;
+    CaptureReader m_reader;
+    bool m_open = false;
+
+    // Cursor (só a thread de leitura mexe):
+    uint64_t m_offset = 0;         // próximo registro a examinar
+    uint64_t m_startOffset = 0;
+    CaptureRecord m_cur = {};      // bloco RX atual
+    size_t m_curPos = 0;           // já entregue de m_cur
+    bool m_hasCur = false;
+    uint64_t m_firstTs = 0;        // tsNs do primeiro bloco (t = 0 do agendamento)
+    int64_t m_t0 = 0;              // NowNs() correspondente a m_firstTs
+    bool m_started = false;
+
+    PreciseTimer m_timer;          // Cancel() = CancelRead()
+    std::function<void()> m_onEnd;
+    std::atomic<bool> m_finished{ false };
+    std::atomic<uint64_t> m_txBytes{ 0 };
+
+    mutable std::mutex m_statsLock;
+    ReplayStats m_stats;
+    std::string m_lastError;
+};
+
+// Reproduz 'path' entregando os bytes RX a 'sink' até o fim da captura
+// (ou 'cancel' virar true). Retorna false se a captura não abrir.
+bool ReplayToSink(const std::string& path, const ReplayOptions& opt,
+                  const std::function<void(const uint8_t* data, size_t len)>& sink,
+                  ReplayStats* stats, std::string* error = nullptr,
+                  const std::atomic<bool>* cancel = nullptr);
@@ -0,0 +1,203 @@
+// RttDialog.cpp - Configuração da medição de RTT (ver RttDialog.h)
+
+#include "RttDialog.h"
+
+#include <string>
+
+#define RTT_DIALOG_CLASS L"SerialRttDialog"
+
+#define ID_RTT_PATTERN  201
+#define ID_RTT_COUNT    202
+#define ID_RTT_INTERVAL 203
+#define ID_RTT_TIMEOUT  204
+#define ID_RTT_CRLF     205
+
+// Estado da janela (GWLP_USERDATA), vive na pilha de ShowRttDialog():
+struct RttDialogState {
+    RttDialogValues* values = nullptr;
+    HWND hPattern = nullptr, hCount = nullptr, hInterval = nullptr, hTimeout = nullptr, hCrLf = nullptr;
+    bool done = false;
+    bool accepted = false;
+};
+
+static std::wstring ToWide(const std::string& s) {
+    if (s.empty()) return {};
+    int len = MultiByteToWideChar(CP_UTF8, 0, s.c_str(), (int)s.size(), nullptr, 0);
+    std::wstring out(len, 0);
+    MultiByteToWideChar(CP_UTF8, 0, s.c_str(), (int)s.size(), &out[0], len);
+    return out;
+}
+
+static std::string ToUtf8(const std::wstring& w) {
+    if (w.empty()) return {};
+    int len = WideCharToMultiByte(CP_UTF8, 0, w.c_str(), (int)w.size(), nullptr, 0, nullptr, nullptr);
+    std::string out(len, 0);
+    WideCharToMultiByte(CP_UTF8, 0, w.c_str(), (int)w.size(), &out[0], len, nullptr, nullptr);
+    return out;
+}
+
+static std::wstring GetText(HWND h) {
+    wchar_t buf[256] = {};
+    GetWindowTextW(h, buf, 256);
+    return buf;
+}
+
+// Número positivo da caixa; inválido = mantém 'current' e marca erro.
+static uint32_t ReadNumber(HWND h, uint32_t current, bool* ok) {
+    std::wstring t = GetText(h);
+    wchar_t* end = nullptr;
+    unsigned long v = wcstoul(t.c_str(), &end, 10);
+    if (t.empty() || (end && *end) || v == 0) {
+        *ok = false;
+        return current;
+    }
+    return (uint32_t)v;
+}
+
+static HWND AddLabel(HWND parent, const wchar_t* text, int y) {
+    HWND h = CreateWindowW(L"STATIC", text, WS_CHILD | WS_VISIBLE,
+        10, y + 3, 130, 20, parent, nullptr, nullptr, nullptr);
+    SendMessage(h, WM_SETFONT, (WPARAM)GetStockObject(DEFAULT_GUI_FONT), FALSE);
+    return h;
+}
+
+static HWND AddEdit(HWND parent, int id, const std::wstring& text, int y, DWORD extra) {
+    HWND h = CreateWindowW(L"EDIT", text.c_str(), WS_CHILD | WS_VISIBLE | WS_BORDER | WS_TABSTOP | ES_AUTOHSCROLL | extra,
+        145, y, 150, 22, parent, (HMENU)(INT_PTR)id, nullptr, nullptr);
+    SendMessage(h, WM_SETFONT, (WPARAM)GetStockObject(DEFAULT_GUI_FONT), FALSE);
+    return h;
+}
+
+static void CreateControls(HWND hwnd, RttDialogState* st) {
+    const RttConfig& c = st->values->cfg;
+    AddLabel(hwnd, L"Padrão da resposta:", 10);
+    st->hPattern = AddEdit(hwnd, ID_RTT_PATTERN, ToWide(c.pattern), 10, 0);
+    AddLabel(hwnd, L"Repetições:", 40);
+    st->hCount = AddEdit(hwnd, ID_RTT_COUNT, std::to_wstring(c.count), 40, ES_NUMBER);
+    AddLabel(hwnd, L"Intervalo (ms):", 70);
+    st->hInterval = AddEdit(hwnd, ID_RTT_INTERVAL, std::to_wstring(c.intervalMs), 70, ES_NUMBER);
+    AddLabel(hwnd, L"Timeout (ms):", 100);
+    st->hTimeout = AddEdit(hwnd, ID_RTT_TIMEOUT, std::to_wstring(c.timeoutMs), 100, ES_NUMBER);
+
+    st->hCrLf = CreateWindowW(L"BUTTON", L"Terminar o envio com \\r\\n",
+        WS_CHILD | WS_VISIBLE | WS_TABSTOP | BS_AUTOCHECKBOX,
+        10, 130, 285, 20, hwnd, (HMENU)ID_RTT_CRLF, nullptr, nullptr);
+    SendMessage(st->hCrLf, WM_SETFONT, (WPARAM)GetStockObject(DEFAULT_GUI_FONT), FALSE);
+    SendMessage(st->hCrLf, BM_SETCHECK, st->values->appendCrLf ? BST_CHECKED : BST_UNCHECKED, 0);
+
+    HWND hint = AddLabel(hwnd, L"Envia a caixa selecionada; padrão vazio = qualquer byte.", 155);
+    SetWindowPos(hint, nullptr, 10, 158, 285, 20, SWP_NOZORDER);
+
+    HWND ok = CreateWindowW(L"BUTTON", L"Medir", WS_CHILD | WS_VISIBLE | WS_TABSTOP | BS_DEFPUSHBUTTON,
+        115, 185, 85, 26, hwnd, (HMENU)IDOK, nullptr, nullptr);
+    HWND cancel = CreateWindowW(L"BUTTON", L"Cancelar", WS_CHILD | WS_VISIBLE | WS_TABSTOP,
+        210, 185, 85, 26, hwnd, (HMENU)IDCANCEL, nullptr, nullptr);
+    SendMessage(ok, WM_SETFONT, (WPARAM)GetStockObject(DEFAULT_GUI_FONT), FALSE);
+    SendMessage(cancel, WM_SETFONT, (WPARAM)GetStockObject(DEFAULT_GUI_FONT), FALSE);
+    SetFocus(st->hPattern);
+}
+
+// Valida e copia para 'values'; número inválido mantém a janela aberta.
+static bool Accept(HWND hwnd, RttDialogState* st) {
+    RttDialogValues v = *st->values;
+    bool ok = true;
+    v.cfg.pattern = ToUtf8(GetText(st->hPattern));
+    v.cfg.count = ReadNumber(st->hCount, v.cfg.count, &ok);
+    v.cfg.intervalMs = ReadNumber(st->hInterval, v.cfg.intervalMs, &ok);
+    v.cfg.timeoutMs = ReadNumber(st->hTimeout, v.cfg.timeoutMs, &ok);
+    v.appendCrLf = (SendMessage(st->hCrLf, BM_GETCHECK, 0, 0) == BST_CHECKED);
+    if (!ok) {
+        MessageBoxW(hwnd, L"Repetições, intervalo e timeout devem ser números maiores que zero.",
+            L"Medir RTT", MB_OK | MB_ICONWARNING);
+        return false;
+    }
+    *st->values = v;
+    return true;
+}
+
+static LRESULT CALLBACK RttDialogProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
+    RttDialogState* st = (RttDialogState*)GetWindowLongPtrW(hwnd, GWLP_USERDATA);
+    switch (msg) {
+    case WM_CREATE:
+        st = (RttDialogState*)((CREATESTRUCTW*)lParam)->lpCreateParams;
+        SetWindowLongPtrW(hwnd, GWLP_USERDATA, (LONG_PTR)st);
+        CreateControls(hwnd, st);
+        return 0;
+
+    case WM_COMMAND:
+        if (LOWORD(wParam) == IDOK) {
+            if (Accept(hwnd, st)) {
+                st->accepted = true;
+                DestroyWindow(hwnd);
+            }
+            return 0;
+        }
+        if (LOWORD(wParam) == IDCANCEL) {
+            DestroyWindow(hwnd);
+            return 0;
+        }
+        break;
+
+    case WM_CLOSE:
+        DestroyWindow(hwnd);
+        return 0;
+
+    case WM_DESTROY:
+        if (st) st->done = true;
+        return 0;
+    }
+    return DefWindowProcW(hwnd, msg, wParam, lParam);
+}
+
+bool ShowRttDialog(HWND owner, RttDialogValues* values) {
+    HINSTANCE hInstance = (HINSTANCE)GetWindowLongPtrW(owner, GWLP_HINSTANCE);
+    static bool registered = false;
+    if (!registered) {
+        WNDCLASSW wc = {};
+        wc.lpfnWndProc = RttDialogProc;
+        wc.hInstance = hInstance;
+        wc.hCursor = LoadCursor(nullptr, IDC_ARROW);
+        wc.hbrBackground = (HBRUSH)(COLOR_BTNFACE + 1);
+        wc.lpszClassName = RTT_DIALOG_CLASS;
+        registered = RegisterClassW(&wc) != 0;
+    }
+
+    // Centraliza sobre a janela principal:
+    RECT rc = { 0, 0, 305, 220 };
+    DWORD style = WS_POPUP | WS_CAPTION | WS_SYSMENU;
+    AdjustWindowRect(&rc, style, FALSE);
+    RECT owr;
+    GetWindowRect(owner, &owr);
+    int w = rc.right - rc.left, h = rc.bottom - rc.top;
+    int x = owr.left + ((owr.right - owr.left) - w) / 2;
+    int y = owr.top + ((owr.bottom - owr.top) - h) / 2;
+
+    RttDialogState st;
+    st.values = values;
+    HWND hwnd = CreateWindowExW(WS_EX_DLGMODALFRAME, RTT_DIALOG_CLASS, L"Medir ida e volta (RTT)",
+        style, x, y, w, h, owner, nullptr, hInstance, &st);
+    if (!hwnd) return false;
+
+    // Laço modal: a janela principal fica desabilitada até fechar.
+    EnableWindow(owner, FALSE);
+    ShowWindow(hwnd, SW_SHOW);
+    MSG msg;
+    while (!st.done) {
+        if (GetMessageW(&msg, nullptr, 0, 0) <= 0) {
+            PostQuitMessage((int)msg.wParam);   // devolve o WM_QUIT ao laço principal
+            DestroyWindow(hwnd);
+            break;
+        }
+        if (msg.message == WM_KEYDOWN && msg.wParam == VK_ESCAPE) {
+            DestroyWindow(hwnd);
+            continue;
+        }
+        if (!IsDialogMessageW(hwnd, &msg)) {
+            TranslateMessage(&msg);
+            DispatchMessageW(&msg);
+        }
+    }
+    EnableWindow(owner, TRUE);
+    SetForegroundWindow(owner);
+    return st.accepted;
+}
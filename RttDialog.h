@@ -0,0 +1,20 @@
+// RttDialog.h - Janela de configuração da medição de ida e volta (RttMeter.h)
+// Objetivo: escolher padrão de resposta, repetições, intervalo e timeout sem
+//           arquivo de recurso (.rc): controles criados em código, modal
+//           sobre a janela principal.
+
+#pragma once
+
+#include <windows.h>
+
+#include "RttMeter.h"
+
+// Opções da janela além do RttConfig (o payload vem da caixa de envio).
+struct RttDialogValues {
+    RttConfig cfg;                 // pattern/count/intervalMs/timeoutMs
+    bool appendCrLf = true;        // termina o payload com "\r\n"
+};
+
+// Modal. 'values' entra como valor inicial e sai com o escolhido.
+// false = cancelado.
+bool ShowRttDialog(HWND owner, RttDialogValues* values);
@@ -0,0 +1,243 @@
+// RttMeter.cpp - Medição de ida e volta com histograma HDR (ver RttMeter.h)
+
+#include "RttMeter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+// ============================================================================
+//                                HdrHistogram
+// ============================================================================
+// Faixa b (potência de 2) tem 1024 sub-faixas de largura 2^b, exceto a
+// primeira, com 2048 de largura 1: índice = (b + 1) * 1024 + (v >> b) - 1024.
+namespace {
+
+const uint64_t kSubBucketMask = (1u << HdrHistogram::kSubBucketBits) - 1;
+const size_t kSubBucketHalf = (size_t)1 << (HdrHistogram::kSubBucketBits - 1);
+const uint64_t kMaxValue = ((uint64_t)1 << HdrHistogram::kMaxValueBits) - 1;
+
+int BitLength(uint64_t v) {
+    int n = 0;
+    while (v) { ++n; v >>= 1; }
+    return n;
+}
+
+}  // namespace
+
+HdrHistogram::HdrHistogram()
+    : m_counts((size_t)(kMaxValueBits - kSubBucketBits + 2) * kSubBucketHalf, 0) {
+}
+
+size_t HdrHistogram::IndexOf(uint64_t value) {
+    int b = BitLength(value | kSubBucketMask) - kSubBucketBits;
+    return (size_t)(b + 1) * kSubBucketHalf + (size_t)(value >> b) - kSubBucketHalf;
+}
+
+uint64_t HdrHistogram::HighestEquivalent(size_t index) {
+    if (index < 2 * kSubBucketHalf) return index;
+    int b = (int)(index / kSubBucketHalf) - 1;
+    uint64_t sub = index % kSubBucketHalf + kSubBucketHalf;
+    return ((sub + 1) << b) - 1;
+}
+
+void HdrHistogram::Record(uint64_t value) {
+    if (value > kMaxValue) value = kMaxValue;
+    m_counts[IndexOf(value)]++;
+    if (m_count == 0 || value < m_min) m_min = value;
+    if (value > m_max) m_max = value;
+    m_count++;
+    m_sum += (double)value;
+    m_sumSq += (double)value * (double)value;
+}
+
+void HdrHistogram::Reset() {
+    std::fill(m_counts.begin(), m_counts.end(), 0);
+    m_count = m_min = m_max = 0;
+    m_sum = m_sumSq = 0;
+}
+
+double HdrHistogram::StdDev() const {
+    if (m_count < 2) return 0.0;
+    double mean = m_sum / m_count;
+    double var = m_sumSq / m_count - mean * mean;
+    return var > 0 ? std::sqrt(var) : 0.0;
+}
+
+uint64_t HdrHistogram::Percentile(double p) const {
+    if (m_count == 0) return 0;
+    uint64_t rank = (uint64_t)std::ceil(p * (double)m_count);
+    if (rank < 1) rank = 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < m_counts.size(); ++i) {
+        seen += m_counts[i];
+        if (seen >= rank) {
+            uint64_t v = HighestEquivalent(i);
+            return v < m_max ? v : m_max;
+        }
+    }
+    return m_max;
+}
+
+// ============================================================================
+//                                  RttMeter
+// ============================================================================
+std::string RttReportToText(const RttReport& r) {
+    char buf[512];
+    snprintf(buf, sizeof(buf),
+        "[RTT] %u/%u respostas (%u timeouts, %u falhas de envio%s)%s | "
+        "min %llu us, p50 %llu, p90 %llu, p99 %llu, p99.9 %llu, max %llu us | "
+        "média %.0f us, desvio %.0f us, jitter %.0f us",
+        r.received, r.sent, r.timeouts, r.sendFailed,
+        r.early ? ", algumas antes do fim da escrita" : "",
+        r.finished ? "" : " [interrompido]",
+        (unsigned long long)r.minUs, (unsigned long long)r.p50Us, (unsigned long long)r.p90Us,
+        (unsigned long long)r.p99Us, (unsigned long long)r.p999Us, (unsigned long long)r.maxUs,
+        r.meanUs, r.stdDevUs, r.jitterUs);
+    return buf;
+}
+
+bool RttMeter::Start(const RttConfig& cfg, SendFn send, DoneFn onDone) {
+    Stop();
+    m_cfg = cfg;
+    m_send = send;
+    m_onDone = onDone;
+
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_match.Set(m_cfg.pattern);          // o padrão pode chegar partido entre leituras
+        m_stop = false;
+        m_armed = false;
+        m_hist.Reset();
+        m_report = RttReport();
+        m_lastRttNs = -1;
+        m_jitterSum = 0;
+    }
+    m_timer.Reset();
+    m_running.store(true, std::memory_order_release);
+    m_thread = std::thread(&RttMeter::Run, this);
+    return true;
+}
+
+void RttMeter::Stop() {
+    if (!m_thread.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_stop = true;
+    }
+    m_timer.Cancel();
+    m_cv.notify_all();
+    m_thread.join();
+    m_running.store(false, std::memory_order_release);
+}
+
+void RttMeter::Run() {
+    const int64_t t0 = PreciseTimer::NowNs();
+    bool completed = true;
+
+    for (uint32_t i = 0; i < m_cfg.count; ++i) {
+        if (!m_timer.SleepUntil(t0 + (int64_t)i * m_cfg.intervalMs * 1000000)) {
+            completed = false;
+            break;
+        }
+
+        std::unique_lock<std::mutex> lock(m_lock);
+        if (m_stop) {
+            completed = false;
+            break;
+        }
+
+        // Arma antes de enviar: a resposta pode chegar antes de Send() voltar.
+        // Send() com a trava: a conclusão (OnTxDone) espera o id ser conhecido.
+        m_armed = true;
+        m_txId = 0;
+        m_txDoneNs = 0;
+        m_txFailed = false;
+        m_rxNs = 0;
+        m_match.Reset();
+        uint64_t id = m_send(m_cfg.payload.data(), m_cfg.payload.size());
+        if (id == 0) {
+            m_armed = false;
+            m_report.sendFailed++;
+            continue;
+        }
+        m_txId = id;
+        m_report.sent++;
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(m_cfg.timeoutMs);
+        m_cv.wait_until(lock, deadline, [&] {
+            return m_stop || m_txFailed || (m_rxNs != 0 && m_txDoneNs != 0);
+        });
+        m_armed = false;
+
+        if (m_stop) {
+            completed = false;
+            break;
+        }
+        if (m_txFailed) m_report.sendFailed++;
+        else if (m_rxNs != 0 && m_txDoneNs != 0) Record(m_rxNs - m_txDoneNs);
+        else m_report.timeouts++;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_report.finished = completed;
+    }
+    m_running.store(false, std::memory_order_release);
+    if (completed && m_onDone) m_onDone();
+}
+
+void RttMeter::Record(int64_t rttNs) {
+    if (rttNs < 0) {
+        m_report.early++;
+        rttNs = 0;
+    }
+    m_hist.Record((uint64_t)((rttNs + 500) / 1000));
+    m_report.received++;
+    if (m_lastRttNs >= 0) m_jitterSum += (double)std::llabs(rttNs - m_lastRttNs);
+    m_lastRttNs = rttNs;
+}
+
+void RttMeter::OnTxDone(const TxResult& r) {
+    std::lock_guard<std::mutex> lock(m_lock);
+    if (!m_armed || r.id != m_txId) return;
+    if (r.ok) m_txDoneNs = (int64_t)r.doneNs;
+    else m_txFailed = true;
+    m_cv.notify_all();
+}
+
+// Casamento incremental (StreamMatcher) dentro da linha atual; '\n' recomeça.
+void RttMeter::OnRx(const uint8_t* data, size_t len, int64_t nowNs) {
+    std::lock_guard<std::mutex> lock(m_lock);
+    if (!m_armed || m_rxNs != 0 || len == 0) return;
+
+    bool hit = m_match.Empty();
+    for (size_t i = 0; i < len && !hit; ++i) {
+        if (data[i] == '\n') {
+            m_match.Reset();
+            continue;
+        }
+        hit = m_match.Feed(data[i]);
+    }
+    if (hit) {
+        m_rxNs = nowNs;
+        m_cv.notify_all();
+    }
+}
+
+RttReport RttMeter::Report() const {
+    std::lock_guard<std::mutex> lock(m_lock);
+    RttReport r = m_report;
+    r.minUs = m_hist.Min();
+    r.p50Us = m_hist.Percentile(0.50);
+    r.p90Us = m_hist.Percentile(0.90);
+    r.p99Us = m_hist.Percentile(0.99);
+    r.p999Us = m_hist.Percentile(0.999);
+    r.maxUs = m_hist.Max();
+    r.meanUs = m_hist.Mean();
+    r.stdDevUs = m_hist.StdDev();
+    r.jitterUs = (r.received > 1) ? m_jitterSum / (r.received - 1) / 1000.0 : 0.0;
+    return r;
+}
@@ -0,0 +1,146 @@
+// RttMeter.h - Tempo de ida e volta (pedido -> resposta) do dispositivo
+// Objetivo: qualificar o tempo de resposta do firmware sem comparar "[TX]" e
+//           "[RX]" a olho: N trocas a uma taxa fixa, cada uma medida em us,
+//           com min/p50/p99/max e jitter no fim.
+//
+// Uma troca:
+//  1) o RttMeter arma o casamento e envia o payload pela TxQueue da sessão;
+//  2) t0 = quando a escrita terminou (TxResult::doneNs, WriteFile/writev
+//     concluído na thread de escrita);
+//  3) t1 = chegada (thread do reactor) do bloco que completou o padrão numa
+//     linha RX ("frame" do LineFramer). Linhas sem o padrão (eco, logs) são
+//     ignoradas; padrão vazio = primeiro byte recebido;
+//  4) RTT = t1 - t0. Sem resposta até 'timeoutMs' conta como timeout.
+// As trocas não se sobrepõem: a próxima sai em t_inicial + i * intervalo ou
+// logo depois da resposta/timeout, o que vier por último.
+//
+// Resposta antes da conclusão da escrita (driver avisa a conclusão depois
+// dos bytes voltarem) conta como RTT 0 e em 'early'.
+//
+// Threads: thread própria para agendar (PreciseTimer); OnTxDone() na thread
+// de escrita e OnRx() na do reactor só tomam uma trava curta.
+//
+// Não depende de Win32.
+
+#pragma once
+
+#include "PreciseTimer.h"
+#include "StreamMatcher.h"
+#include "TxQueue.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Histograma no estilo HDR: 3 dígitos significativos (erro <= 0,1%) de 1 us
+// a ~71 min, em tamanho fixo (~190 KB). Valores acima do limite viram o limite.
+class HdrHistogram {
+public:
+    static const int kSubBucketBits = 11;                 // 2048 sub-faixas por potência de 2
+    static const int kMaxValueBits = 32;                  // 2^32 us ~ 71 min
+
+    HdrHistogram();
+
+    void Record(uint64_t value);
+    void Reset();
+
+    uint64_t Count() const { return m_count; }
+    uint64_t Min() const { return m_count ? m_min : 0; }
+    uint64_t Max() const { return m_max; }
+    double   Mean() const { return m_count ? m_sum / m_count : 0.0; }
+    double   StdDev() const;
+    // Maior valor equivalente da faixa que contém o percentil 'p' (0..1).
+    uint64_t Percentile(double p) const;
+
+private:
+    static size_t IndexOf(uint64_t value);
+    static uint64_t HighestEquivalent(size_t index);
+
+    std::vector<uint64_t> m_counts;
+    uint64_t m_count = 0;
+    uint64_t m_min = 0;
+    uint64_t m_max = 0;
+    double   m_sum = 0;
+    double   m_sumSq = 0;
+};
+
+struct RttConfig {
+    std::string payload;                  // bytes enviados em cada troca
+    std::string pattern;                  // procurado numa linha RX; vazio = qualquer byte
+    uint32_t count = 100;                 // trocas
+    uint32_t intervalMs = 100;            // início a início (taxa = 1000 / intervalo)
+    uint32_t timeoutMs = 1000;
+};
+
+struct RttReport {
+    uint32_t sent = 0;
+    uint32_t received = 0;
+    uint32_t timeouts = 0;
+    uint32_t sendFailed = 0;              // fila TX cheia ou escrita falhou
+    uint32_t early = 0;                   // resposta antes da conclusão da escrita
+    uint64_t minUs = 0, p50Us = 0, p90Us = 0, p99Us = 0, p999Us = 0, maxUs = 0;
+    double   meanUs = 0;
+    double   stdDevUs = 0;
+    double   jitterUs = 0;                // média de |RTT[i] - RTT[i-1]| (RFC 3550, sem suavizar)
+    bool     finished = false;            // false = interrompido por Stop()
+};
+
+// Uma linha legível ("[RTT] 100/100 ok ... p99 1234 us ...").
+std::string RttReportToText(const RttReport& r);
+
+class RttMeter {
+public:
+    using SendFn = std::function<uint64_t(const void* data, size_t len)>;   // id da TxQueue (0 = recusado)
+    using DoneFn = std::function<void()>;
+
+    RttMeter() {}
+    ~RttMeter() { Stop(); }
+
+    RttMeter(const RttMeter&) = delete;
+    RttMeter& operator=(const RttMeter&) = delete;
+
+    // 'onDone' roda na thread do medidor quando as N trocas terminam (não
+    // depois de Stop()).
+    bool Start(const RttConfig& cfg, SendFn send, DoneFn onDone);
+    void Stop();                          // interrompe e junta a thread
+    bool Running() const { return m_running.load(std::memory_order_acquire); }   // medindo agora
+
+    // Ganchos do pipeline da sessão:
+    void OnTxDone(const TxResult& r);     // thread de escrita
+    void OnRx(const uint8_t* data, size_t len, int64_t nowNs);   // thread de RX
+
+    RttReport Report() const;
+
+private:
+    void Run();
+    void Record(int64_t rttNs);           // com m_lock
+
+    RttConfig m_cfg;
+    SendFn m_send;
+    DoneFn m_onDone;
+    std::thread m_thread;
+    PreciseTimer m_timer;
+    std::atomic<bool> m_running{ false };
+
+    mutable std::mutex m_lock;
+    std::condition_variable m_cv;
+    bool m_stop = false;
+
+    // Troca em andamento (com m_lock):
+    bool     m_armed = false;
+    uint64_t m_txId = 0;                  // 0 = Send() ainda não retornou
+    int64_t  m_txDoneNs = 0;              // 0 = escrita não concluída
+    bool     m_txFailed = false;
+    int64_t  m_rxNs = 0;                  // 0 = padrão ainda não visto
+    StreamMatcher m_match;                // padrão, casado dentro da linha atual
+
+    HdrHistogram m_hist;
+    RttReport m_report;
+    int64_t  m_lastRttNs = -1;
+    double   m_jitterSum = 0;
+};
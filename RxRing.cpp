@@ -0,0 +1,136 @@
+// RxRing.cpp - Implementação da fila SPSC de bytes (ver RxRing.h)
+
+#include "RxRing.h"
+
+#include <algorithm>
+#include <cstring>
+
+static size_t RoundUpPow2(size_t v) {
+    size_t p = 1;
+    while (p < v) p <<= 1;
+    return p;
+}
+
+RxRing::RxRing(size_t capacity)
+    : m_buf(RoundUpPow2(capacity < 2 ? 2 : capacity)),
+      m_mask(m_buf.size() - 1) {
+}
+
+// Espaço livre visto pelo produtor. Só relê o índice do consumidor quando a
+// cópia local indica falta de espaço.
+size_t RxRing::FreeSpace(size_t head, size_t wanted) {
+    const size_t cap = m_buf.size();
+    size_t freeSpace = cap - (head - m_cachedTail);
+    if (freeSpace < wanted) {
+        m_cachedTail = m_tail.load(std::memory_order_acquire);
+        freeSpace = cap - (head - m_cachedTail);
+    }
+    return freeSpace;
+}
+
+// Bytes disponíveis vistos pelo consumidor (mesma ideia, com o índice do produtor).
+size_t RxRing::Available(size_t tail, size_t wanted) {
+    size_t avail = m_cachedHead - tail;
+    if (avail < wanted) {
+        m_cachedHead = m_head.load(std::memory_order_acquire);
+        avail = m_cachedHead - tail;
+    }
+    return avail;
+}
+
+// Copia em até dois pedaços (antes e depois do fim físico do buffer):
+void RxRing::CopyIn(size_t head, const void* data, size_t n) {
+    const uint8_t* src = static_cast<const uint8_t*>(data);
+    size_t pos = head & m_mask;
+    size_t first = std::min(n, m_buf.size() - pos);
+    memcpy(&m_buf[pos], src, first);
+    if (n > first) memcpy(&m_buf[0], src + first, n - first);
+}
+
+void RxRing::CopyOut(size_t tail, void* out, size_t n) const {
+    uint8_t* dst = static_cast<uint8_t*>(out);
+    size_t pos = tail & m_mask;
+    size_t first = std::min(n, m_buf.size() - pos);
+    memcpy(dst, &m_buf[pos], first);
+    if (n > first) memcpy(dst + first, &m_buf[0], n - first);
+}
+
+// Publica os bytes para o consumidor:
+void RxRing::Publish(size_t head, size_t n) {
+    m_head.store(head + n, std::memory_order_release);
+    m_totalWritten.fetch_add(n, std::memory_order_relaxed);
+
+    size_t used = head + n - m_cachedTail;
+    if (used > m_highWater.load(std::memory_order_relaxed))
+        m_highWater.store(used, std::memory_order_relaxed);
+}
+
+size_t RxRing::Write(const void* data, size_t bytes) {
+    const size_t head = m_head.load(std::memory_order_relaxed);
+
+    size_t n = std::min(bytes, FreeSpace(head, bytes));
+    if (n < bytes) {
+        m_droppedBytes.fetch_add(bytes - n, std::memory_order_relaxed);
+        m_overflowEvents.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (n == 0) return 0;
+
+    CopyIn(head, data, n);
+    Publish(head, n);
+    return n;
+}
+
+bool RxRing::WriteAll(const void* a, size_t aBytes, const void* b, size_t bBytes) {
+    const size_t head = m_head.load(std::memory_order_relaxed);
+    const size_t total = aBytes + bBytes;
+
+    if (FreeSpace(head, total) < total) {
+        m_droppedBytes.fetch_add(total, std::memory_order_relaxed);
+        m_overflowEvents.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    CopyIn(head, a, aBytes);
+    CopyIn(head + aBytes, b, bBytes);
+    Publish(head, total);
+    return true;
+}
+
+size_t RxRing::Read(void* out, size_t maxBytes) {
+    const size_t tail = m_tail.load(std::memory_order_relaxed);
+
+    size_t n = std::min(maxBytes, Available(tail, maxBytes));
+    if (n == 0) return 0;
+
+    CopyOut(tail, out, n);
+
+    // Libera o espaço para o produtor:
+    m_tail.store(tail + n, std::memory_order_release);
+    return n;
+}
+
+size_t RxRing::Peek(void* out, size_t maxBytes) {
+    const size_t tail = m_tail.load(std::memory_order_relaxed);
+
+    size_t n = std::min(maxBytes, Available(tail, maxBytes));
+    if (n == 0) return 0;
+
+    CopyOut(tail, out, n);
+    return n;
+}
+
+size_t RxRing::Size() const {
+    size_t head = m_head.load(std::memory_order_acquire);
+    size_t tail = m_tail.load(std::memory_order_acquire);
+    return head - tail;
+}
+
+void RxRing::Reset() {
+    m_head.store(0, std::memory_order_relaxed);
+    m_tail.store(0, std::memory_order_relaxed);
+    m_cachedHead = 0;
+    m_cachedTail = 0;
+    m_totalWritten.store(0, std::memory_order_relaxed);
+    m_droppedBytes.store(0, std::memory_order_relaxed);
+    m_overflowEvents.store(0, std::memory_order_relaxed);
+    m_highWater.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,81 @@
+// RxRing.h - Fila circular de bytes lock-free (1 produtor / 1 consumidor)
+// Objetivo: desacoplar a thread de leitura serial (produtor) da thread da UI
+//           (consumidor) sem locks e sem SendMessage bloqueante.
+//
+// Regras de uso:
+//  - Exatamente UMA thread chama Write() e UMA thread chama Read().
+//  - Se a fila enche, o produtor NUNCA espera: grava o que couber e conta o
+//    restante como descartado (DroppedBytes/OverflowEvents).
+//  - Reset() só pode ser chamado quando não há produtor ativo.
+//
+// Não depende de Win32: pode ser compilado e estressado em Linux
+// (--selftest --filter=rxring: produtor e consumidor em threads separadas).
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class RxRing {
+public:
+    // 'capacity' é arredondada para a próxima potência de 2.
+    explicit RxRing(size_t capacity);
+
+    RxRing(const RxRing&) = delete;
+    RxRing& operator=(const RxRing&) = delete;
+
+    // Produtor: copia até 'bytes' para a fila. Retorna quantos foram aceitos;
+    // o excedente é descartado e contabilizado.
+    size_t Write(const void* data, size_t bytes);
+
+    // Produtor: grava 'a' seguido de 'b' como uma unidade (tudo ou nada), com
+    // uma única publicação. Sem espaço, nada é gravado e tudo conta como
+    // descartado. Usado para registros cabeçalho+dados (ex.: captura).
+    bool WriteAll(const void* a, size_t aBytes, const void* b, size_t bBytes);
+
+    // Consumidor: copia até 'maxBytes' para 'out'. Retorna quantos foram lidos.
+    size_t Read(void* out, size_t maxBytes);
+
+    // Consumidor: como Read(), mas sem consumir (os bytes continuam na fila).
+    size_t Peek(void* out, size_t maxBytes);
+
+    // Bytes disponíveis para leitura (aproximado se chamado do produtor).
+    size_t Size() const;
+    size_t Capacity() const { return m_buf.size(); }
+    bool   Empty() const { return Size() == 0; }
+
+    // Esvazia a fila e zera contadores. Sem produtor ativo!
+    void Reset();
+
+    // ---- Contadores (leitura segura de qualquer thread) ----
+    uint64_t TotalWritten() const { return m_totalWritten.load(std::memory_order_relaxed); }
+    uint64_t DroppedBytes() const { return m_droppedBytes.load(std::memory_order_relaxed); }
+    uint64_t OverflowEvents() const { return m_overflowEvents.load(std::memory_order_relaxed); }
+    size_t   HighWater() const { return m_highWater.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr size_t kCacheLine = 64;
+
+    size_t FreeSpace(size_t head, size_t wanted);
+    size_t Available(size_t tail, size_t wanted);
+    void CopyIn(size_t head, const void* data, size_t n);
+    void CopyOut(size_t tail, void* out, size_t n) const;
+    void Publish(size_t head, size_t n);
+
+    std::vector<uint8_t> m_buf;
+    size_t m_mask;
+
+    // Índices monotônicos (não mascarados); cada um em sua linha de cache
+    // para que produtor e consumidor não disputem a mesma linha.
+    alignas(kCacheLine) std::atomic<size_t> m_head{ 0 };   // escrito só pelo produtor
+    size_t m_cachedTail = 0;                               // cópia local do produtor
+    alignas(kCacheLine) std::atomic<size_t> m_tail{ 0 };   // escrito só pelo consumidor
+    size_t m_cachedHead = 0;                               // cópia local do consumidor
+
+    alignas(kCacheLine) std::atomic<uint64_t> m_totalWritten{ 0 };
+    std::atomic<uint64_t> m_droppedBytes{ 0 };
+    std::atomic<uint64_t> m_overflowEvents{ 0 };
+    std::atomic<size_t>   m_highWater{ 0 };
+};
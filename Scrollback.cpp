@@ -0,0 +1,241 @@
+// Scrollback.cpp - Implementação do histórico em blocos (ver Scrollback.h)
+
+#include "Scrollback.h"
+#include "LzCodec.h"
+
+#include <algorithm>
+#include <cstring>
+
+Scrollback::Scrollback(size_t maxBytes, size_t maxLines, size_t chunkChars)
+    : m_maxBytes(maxBytes), m_maxLines(maxLines),
+      m_chunkChars(chunkChars < 256 ? 256 : chunkChars) {
+    Clear();
+}
+
+void Scrollback::Clear() {
+    m_chunks.clear();
+    m_lines.clear();
+    m_cache.clear();
+    m_chunkBytes = 0;
+    m_firstChunkSeq = 0;
+    m_coldSeq = 0;
+    m_firstLine = 0;
+    NewChunk(0);
+    // Sempre existe uma linha aberta (vazia no início):
+    m_lines.push_back(LineRef{ m_firstChunkSeq, 0, 0 });
+    ++m_generation;
+}
+
+void Scrollback::SetLimits(size_t maxBytes, size_t maxLines) {
+    m_maxBytes = maxBytes;
+    m_maxLines = maxLines;
+    EnforceLimits();
+    ++m_generation;
+}
+
+void Scrollback::NewChunk(size_t minChars) {
+    Chunk c;
+    c.cap = std::max(m_chunkChars, minChars);
+    c.data.reset(new wchar_t[c.cap]);
+    m_chunkBytes += c.cap * sizeof(wchar_t);
+    m_chunks.push_back(std::move(c));
+}
+
+void Scrollback::AppendToOpenLine(const wchar_t* text, size_t len) {
+    if (len == 0) return;
+
+    LineRef& open = m_lines.back();
+    Chunk* cur = &m_chunks.back();
+
+    if (cur->cap - cur->used < len) {
+        // Não cabe: a linha aberta muda para um bloco novo (só ela é copiada).
+        size_t need = (size_t)open.length + len;
+        const wchar_t* old = m_chunks[(size_t)(open.chunkSeq - m_firstChunkSeq)].data.get() + open.offset;
+        NewChunk(need * 2);
+        cur = &m_chunks.back();
+        memcpy(cur->data.get(), old, open.length * sizeof(wchar_t));
+        open.chunkSeq = m_firstChunkSeq + m_chunks.size() - 1;
+        open.offset = 0;
+        cur->used = open.length;
+    }
+
+    memcpy(cur->data.get() + cur->used, text, len * sizeof(wchar_t));
+    cur->used += len;
+    open.length += (uint32_t)len;
+}
+
+void Scrollback::CloseLine() {
+    // A próxima linha começa exatamente onde a atual terminou:
+    const Chunk& cur = m_chunks.back();
+    m_lines.push_back(LineRef{ m_firstChunkSeq + m_chunks.size() - 1, (uint32_t)cur.used, 0 });
+}
+
+void Scrollback::Append(const wchar_t* text, size_t len) {
+    size_t start = 0;
+    for (size_t i = 0; i < len; ++i) {
+        wchar_t c = text[i];
+        if (c == L'\n' || c == L'\r') {
+            AppendToOpenLine(text + start, i - start);
+            if (c == L'\n') CloseLine();
+            start = i + 1;
+        }
+    }
+    AppendToOpenLine(text + start, len - start);
+
+    EnforceLimits();
+    ++m_generation;
+}
+
+void Scrollback::EnforceLimits() {
+    // Por linhas: descarta as mais antigas (nunca a linha aberta).
+    if (m_maxLines) {
+        while (m_lines.size() > m_maxLines && m_lines.size() > 1) {
+            m_lines.pop_front();
+            ++m_firstLine;
+        }
+    }
+
+    // Por bytes: descarta blocos inteiros do início (com as linhas que apontam p/ eles).
+    if (m_maxBytes) {
+        while (RetainedBytes() > m_maxBytes && m_chunks.size() > 1) {
+            while (m_lines.size() > 1 && m_lines.front().chunkSeq == m_firstChunkSeq) {
+                m_lines.pop_front();
+                ++m_firstLine;
+            }
+            DropFrontChunk();
+        }
+    }
+
+    // Libera blocos que ficaram sem nenhuma linha:
+    while (m_chunks.size() > 1 && m_lines.front().chunkSeq > m_firstChunkSeq)
+        DropFrontChunk();
+}
+
+void Scrollback::DropFrontChunk() {
+    const Chunk& c = m_chunks.front();
+    m_chunkBytes -= c.data ? c.cap * sizeof(wchar_t) : c.packedBytes;
+    for (auto it = m_cache.begin(); it != m_cache.end(); ++it) {
+        if (it->chunkSeq == m_firstChunkSeq) {
+            m_cache.erase(it);
+            break;
+        }
+    }
+    m_chunks.pop_front();
+    ++m_firstChunkSeq;
+    if (m_coldSeq < m_firstChunkSeq) m_coldSeq = m_firstChunkSeq;
+}
+
+// ============================================================================
+//                          Blocos frios (comprimidos)
+// ============================================================================
+// Só blocos fechados: o último bloco (linha aberta) nunca fica frio, e nenhum
+// bloco anterior a ele volta a ser escrito.
+bool Scrollback::Compact(size_t maxChars) {
+    if (m_hotChunks == 0) return true;
+    const uint64_t hotFrom = m_firstChunkSeq + m_chunks.size() - std::min(m_chunks.size(), m_hotChunks);
+    size_t done = 0;
+    while (m_coldSeq < hotFrom && done < maxChars) {
+        Chunk& c = m_chunks[(size_t)(m_coldSeq - m_firstChunkSeq)];
+        done += c.used + 1;
+        CompressChunk(c);                // o texto não muda: m_generation fica
+        ++m_coldSeq;
+    }
+    return m_coldSeq >= hotFrom;
+}
+
+// false = não comprimiu (o LZ não ganhou nada): o bloco fica como estava.
+bool Scrollback::CompressChunk(Chunk& c) {
+    if (!c.data) return false;
+    const wchar_t* text = c.data.get();
+    bool narrow = true;
+    for (size_t i = 0; i < c.used && narrow; ++i) narrow = (uint32_t)text[i] < 0x100;
+
+    const uint8_t* src = (const uint8_t*)text;
+    size_t srcBytes = c.used * sizeof(wchar_t);
+    if (narrow) {
+        m_scratch.resize(c.used);
+        for (size_t i = 0; i < c.used; ++i) m_scratch[i] = (uint8_t)text[i];
+        src = m_scratch.data();
+        srcBytes = c.used;
+    }
+
+    std::vector<uint8_t> out(LzCompressBound(srcBytes));
+    size_t packed = LzCompress(src, srcBytes, out.data(), out.size());
+    if (packed == 0 || packed >= c.cap * sizeof(wchar_t)) return false;
+
+    c.packed.reset(new uint8_t[packed]);
+    memcpy(c.packed.get(), out.data(), packed);
+    c.packedBytes = packed;
+    c.narrow = narrow;
+    c.data.reset();
+    m_chunkBytes -= c.cap * sizeof(wchar_t);
+    m_chunkBytes += packed;
+    return true;
+}
+
+const wchar_t* Scrollback::ChunkText(uint64_t chunkSeq) const {
+    const Chunk& c = m_chunks[(size_t)(chunkSeq - m_firstChunkSeq)];
+    if (c.data) return c.data.get();
+
+    for (auto it = m_cache.begin(); it != m_cache.end(); ++it) {
+        if (it->chunkSeq != chunkSeq) continue;
+        if (it != m_cache.begin()) {
+            CacheEntry e = std::move(*it);
+            m_cache.erase(it);
+            m_cache.push_front(std::move(e));
+        }
+        return m_cache.front().text.get();
+    }
+
+    CacheEntry e;
+    e.chunkSeq = chunkSeq;
+    e.chars = c.used;
+    e.text.reset(new wchar_t[c.used ? c.used : 1]);
+    bool ok;
+    if (c.narrow) {
+        m_scratch.resize(c.used);
+        ok = LzDecompress(c.packed.get(), c.packedBytes, m_scratch.data(), c.used);
+        for (size_t i = 0; ok && i < c.used; ++i) e.text[i] = (wchar_t)m_scratch[i];
+    }
+    else {
+        ok = LzDecompress(c.packed.get(), c.packedBytes, (uint8_t*)e.text.get(), c.used * sizeof(wchar_t));
+    }
+    if (!ok) return nullptr;
+    ++m_decompressions;
+    m_cache.push_front(std::move(e));
+    if (m_cache.size() > kCacheChunks) m_cache.pop_back();
+    return m_cache.front().text.get();
+}
+
+ScrollbackStats Scrollback::Stats() const {
+    ScrollbackStats s;
+    for (const Chunk& c : m_chunks) {
+        if (c.data) {
+            ++s.hotChunks;
+            s.hotBytes += c.cap * sizeof(wchar_t);
+        }
+        else {
+            ++s.coldChunks;
+            s.coldBytes += c.packedBytes;
+            s.coldRawBytes += c.cap * sizeof(wchar_t);
+        }
+    }
+    for (const CacheEntry& e : m_cache) s.cacheBytes += e.chars * sizeof(wchar_t);
+    s.indexBytes = m_lines.size() * sizeof(LineRef);
+    s.decompressions = m_decompressions;
+    return s;
+}
+
+bool Scrollback::GetLine(uint64_t line, const wchar_t** text, size_t* len) const {
+    if (line < m_firstLine || line >= EndLine()) return false;
+    const LineRef& ref = m_lines[(size_t)(line - m_firstLine)];
+    const wchar_t* base = ChunkText(ref.chunkSeq);
+    if (!base) return false;
+    *text = base + ref.offset;
+    *len = ref.length;
+    return true;
+}
+
+size_t Scrollback::RetainedBytes() const {
+    return m_chunkBytes + m_lines.size() * sizeof(LineRef);
+}
@@ -0,0 +1,130 @@
+// Scrollback.h - Armazenamento do histórico do terminal (linhas em blocos)
+// Objetivo: substituir o EDIT multi-line como "dono" do texto exibido.
+//
+//  - Append O(1) amortizado: o texto vai para o fim do bloco atual; nada
+//    do histórico é copiado ou re-medido a cada chegada.
+//  - Índice de linhas: número absoluto da linha -> (bloco, offset, tamanho).
+//    Números absolutos não mudam quando linhas antigas são descartadas.
+//  - Retenção configurável por bytes e/ou por linhas (0 = sem limite).
+//  - Blocos frios comprimidos: Compact(), chamado em fatias por um timer da
+//    UI (fora do caminho RX), comprime os blocos fechados mais antigos que
+//    os 'hotChunks' recentes com LZ (LzCodec.h). Texto só com caracteres
+//    < 0x100 (o caso comum: ASCII/Latin-1) vira 1 byte por caractere antes
+//    do LZ; um log típico cai de 2 bytes/caractere (UTF-16) para ~0,3.
+//    GetLine() numa linha fria descomprime o bloco inteiro para um cache
+//    pequeno (os últimos kCacheChunks blocos lidos): rolar ou buscar no
+//    histórico antigo custa uma descompressão por bloco, não por linha.
+//    O limite de bytes conta o tamanho comprimido: cabe mais histórico.
+//
+// Não depende de Win32 (pode ser medido/estressado fora da UI).
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct ScrollbackStats {
+    size_t hotChunks = 0;
+    size_t coldChunks = 0;           // comprimidos
+    size_t hotBytes = 0;             // blocos em UTF-16
+    size_t coldBytes = 0;            // blocos comprimidos (tamanho atual)
+    size_t coldRawBytes = 0;         // os mesmos blocos em UTF-16
+    size_t cacheBytes = 0;           // blocos frios descomprimidos em cache
+    size_t indexBytes = 0;           // índice de linhas
+    uint64_t decompressions = 0;
+};
+
+class Scrollback {
+public:
+    static constexpr size_t kDefaultMaxBytes = 256u * 1024 * 1024;  // 256 MB
+    static constexpr size_t kDefaultChunkChars = 64 * 1024;         // 128 KB por bloco (UTF-16)
+    static constexpr size_t kDefaultHotChunks = 4;                  // recentes nunca comprimidos
+    static constexpr size_t kCacheChunks = 2;
+
+    explicit Scrollback(size_t maxBytes = kDefaultMaxBytes, size_t maxLines = 0,
+                        size_t chunkChars = kDefaultChunkChars);
+
+    Scrollback(const Scrollback&) = delete;
+    Scrollback& operator=(const Scrollback&) = delete;
+
+    // Acrescenta texto. '\n' fecha a linha atual; '\r' é descartado (CRLF/LF
+    // viram a mesma coisa). A última linha fica "aberta" até chegar um '\n'.
+    void Append(const wchar_t* text, size_t len);
+    void Append(const std::wstring& text) { Append(text.data(), text.size()); }
+
+    // Faixa de linhas retidas: [FirstLine(), EndLine()).
+    uint64_t FirstLine() const { return m_firstLine; }
+    uint64_t EndLine() const { return m_firstLine + m_lines.size(); }
+    size_t   LineCount() const { return m_lines.size(); }
+
+    // Texto da linha absoluta 'line' (sem terminador). O ponteiro vale até o
+    // próximo Append/Clear/Compact ou GetLine de outra linha (linhas frias
+    // vêm do cache). Retorna false se a linha já foi descartada.
+    bool GetLine(uint64_t line, const wchar_t** text, size_t* len) const;
+
+    // Memória ocupada (blocos, comprimidos ou não, + índice), em bytes.
+    // É o que o limite de bytes compara; o cache de leitura fica de fora.
+    size_t RetainedBytes() const;
+
+    // Comprime blocos frios até processar ~'maxChars' caracteres. true = não
+    // sobrou bloco frio por comprimir. 0 em SetHotChunks() desliga.
+    bool Compact(size_t maxChars);
+    void SetHotChunks(size_t hotChunks) { m_hotChunks = hotChunks; }
+    ScrollbackStats Stats() const;
+
+    // Incrementa a cada alteração; a view usa para saber se precisa redesenhar.
+    uint64_t Generation() const { return m_generation; }
+
+    void SetLimits(size_t maxBytes, size_t maxLines);
+    void Clear();
+
+private:
+    struct Chunk {
+        std::unique_ptr<wchar_t[]> data;     // nullptr = comprimido (ver 'packed')
+        size_t cap = 0;
+        size_t used = 0;
+        std::unique_ptr<uint8_t[]> packed;   // LZ de 'used' caracteres
+        size_t packedBytes = 0;
+        bool narrow = false;                 // antes do LZ: 1 byte por caractere
+    };
+    struct CacheEntry {
+        uint64_t chunkSeq;
+        std::unique_ptr<wchar_t[]> text;
+        size_t chars;
+    };
+    struct LineRef {
+        uint64_t chunkSeq;   // número sequencial do bloco (absoluto)
+        uint32_t offset;     // em wchar_t, dentro do bloco
+        uint32_t length;     // em wchar_t
+    };
+
+    void NewChunk(size_t minChars);
+    void AppendToOpenLine(const wchar_t* text, size_t len);
+    void CloseLine();
+    void EnforceLimits();
+    void DropFrontChunk();
+    bool CompressChunk(Chunk& c);
+    const wchar_t* ChunkText(uint64_t chunkSeq) const;   // nullptr = falha ao descomprimir
+
+    std::deque<Chunk> m_chunks;
+    uint64_t m_firstChunkSeq = 0;
+    std::deque<LineRef> m_lines;     // m_lines.back() é sempre a linha aberta
+    uint64_t m_firstLine = 0;
+    size_t m_chunkBytes = 0;         // blocos: cap em UTF-16 ou tamanho comprimido
+    uint64_t m_coldSeq = 0;          // blocos antes deste já passaram por Compact()
+
+    size_t m_maxBytes;
+    size_t m_maxLines;
+    size_t m_chunkChars;
+    size_t m_hotChunks = kDefaultHotChunks;
+    uint64_t m_generation = 0;
+
+    // Leitura de blocos frios (GetLine() é const): mais recente na frente.
+    mutable std::deque<CacheEntry> m_cache;
+    mutable std::vector<uint8_t> m_scratch;
+    mutable uint64_t m_decompressions = 0;
+};
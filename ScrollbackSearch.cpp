@@ -0,0 +1,393 @@
+// ScrollbackSearch.cpp - Índice de trigramas por bloco e busca (ver ScrollbackSearch.h)
+
+#include "ScrollbackSearch.h"
+
+#include <algorithm>
+#include <cstring>
+#include <cwctype>
+
+// ============================================================================
+//                         Normalização e trigramas
+// ============================================================================
+namespace {
+
+const uint32_t kBloomMask = ScrollbackIndex::kBloomBits - 1;
+const size_t kBloomWords = ScrollbackIndex::kBloomBits / 64;
+
+// Maiúscula -> minúscula só em ASCII e Latin-1 (acentos do português), sem
+// depender do locale: a mesma regra no índice e na verificação.
+inline uint32_t FoldChar(wchar_t c) {
+    uint32_t u = (uint32_t)c;
+    if (u >= 'A' && u <= 'Z') return u + 32;
+    if (u >= 0xC0 && u <= 0xDE && u != 0xD7) return u + 32;
+    return u;
+}
+
+inline uint64_t TrigramHash(uint32_t a, uint32_t b, uint32_t c) {
+    uint64_t key = ((uint64_t)a << 42) ^ ((uint64_t)b << 21) ^ (uint64_t)c;
+    return key * 0x9E3779B97F4A7C15ull;
+}
+
+// 3 bits por trigrama, tirados de partes diferentes do hash.
+inline void BloomSet(uint64_t* bloom, uint64_t h) {
+    uint32_t b0 = (uint32_t)(h >> 49) & kBloomMask;
+    uint32_t b1 = (uint32_t)(h >> 32) & kBloomMask;
+    uint32_t b2 = (uint32_t)(h >> 17) & kBloomMask;
+    bloom[b0 >> 6] |= 1ull << (b0 & 63);
+    bloom[b1 >> 6] |= 1ull << (b1 & 63);
+    bloom[b2 >> 6] |= 1ull << (b2 & 63);
+}
+
+inline bool BloomTest(const uint64_t* bloom, uint64_t h) {
+    uint32_t b0 = (uint32_t)(h >> 49) & kBloomMask;
+    uint32_t b1 = (uint32_t)(h >> 32) & kBloomMask;
+    uint32_t b2 = (uint32_t)(h >> 17) & kBloomMask;
+    return (bloom[b0 >> 6] >> (b0 & 63) & 1) && (bloom[b1 >> 6] >> (b1 & 63) & 1) &&
+           (bloom[b2 >> 6] >> (b2 & 63) & 1);
+}
+
+bool StartsWith(const wchar_t* text, size_t len, const wchar_t* prefix) {
+    size_t n = wcslen(prefix);
+    return len >= n && std::equal(prefix, prefix + n, text);
+}
+
+}  // namespace
+
+LineDir ClassifyLine(const wchar_t* text, size_t len, LineDir previous) {
+    if (len == 0 || text[0] != L'[') return previous;
+    if (StartsWith(text, len, L"[RX")) return LineDir::Rx;
+    if (StartsWith(text, len, L"[TX") || StartsWith(text, len, L"[ERRO TX")) return LineDir::Tx;
+    return LineDir::Other;
+}
+
+// Percorre a regex no nível de fora: caracteres literais seguidos formam um
+// trecho; metacaracteres, classes e grupos encerram o trecho, e um
+// quantificador que admite zero ('*', '?', '{') tira o último caractere dele.
+std::wstring RegexRequiredLiteral(const std::wstring& pattern) {
+    std::wstring best, cur;
+    auto flush = [&] {
+        if (cur.size() > best.size()) best = cur;
+        cur.clear();
+    };
+
+    int depth = 0;
+    for (size_t i = 0; i < pattern.size(); ++i) {
+        wchar_t c = pattern[i];
+        if (c == L'|') return L"";           // alternação: nada é obrigatório
+        if (c == L'\\') {
+            if (i + 1 >= pattern.size()) break;
+            wchar_t n = pattern[++i];
+            bool escapedLiteral = !iswalnum(n);   // \. \[ \\ ...; \d \w \n etc. são classes
+            if (depth == 0 && escapedLiteral) cur += n;
+            else flush();
+            continue;
+        }
+        switch (c) {
+        case L'(':
+            if (i + 1 < pattern.size() && pattern[i + 1] == L'?') {
+                if (i + 2 >= pattern.size() || pattern[i + 2] != L':') return L"";   // lookahead
+                i += 2;
+            }
+            ++depth;
+            flush();
+            break;
+        case L')':
+            if (depth > 0) --depth;
+            flush();
+            break;
+        case L'[': {
+            flush();
+            size_t j = i + 1;
+            if (j < pattern.size() && pattern[j] == L'^') ++j;
+            if (j < pattern.size() && pattern[j] == L']') ++j;
+            while (j < pattern.size() && pattern[j] != L']') {
+                if (pattern[j] == L'\\') ++j;
+                ++j;
+            }
+            i = j;
+            break;
+        }
+        case L'*': case L'?':
+            if (!cur.empty()) cur.pop_back();
+            flush();
+            break;
+        case L'{':
+            if (!cur.empty()) cur.pop_back();
+            flush();
+            while (i < pattern.size() && pattern[i] != L'}') ++i;
+            break;
+        case L'+':
+            flush();
+            break;
+        case L'.': case L'^': case L'$':
+            flush();
+            break;
+        default:
+            if (depth == 0) cur += c;
+            else flush();
+            break;
+        }
+    }
+    flush();
+    return best;
+}
+
+// ============================================================================
+//                                SearchMatcher
+// ============================================================================
+void SearchMatcher::Clear() {
+    m_query = SearchQuery();
+    m_needle.clear();
+    m_regex.reset();
+    m_trigrams.clear();
+}
+
+bool SearchMatcher::Compile(const SearchQuery& q, std::string* error) {
+    Clear();
+    std::wstring literal;
+    if (q.regex && !q.text.empty()) {
+        auto flags = std::regex_constants::ECMAScript | std::regex_constants::optimize;
+        if (!q.matchCase) flags |= std::regex_constants::icase;
+        try {
+            m_regex.reset(new std::wregex(q.text, flags));
+        }
+        catch (const std::regex_error& e) {
+            if (error) *error = std::string("regex inválida: ") + e.what();
+            return false;
+        }
+        literal = RegexRequiredLiteral(q.text);
+    }
+    else {
+        literal = q.text;
+        m_needle = q.text;
+        if (!q.matchCase)
+            for (wchar_t& c : m_needle) c = (wchar_t)FoldChar(c);
+    }
+    m_query = q;
+
+    // O índice não diferencia maiúsculas: trigramas sempre normalizados.
+    for (size_t i = 2; i < literal.size(); ++i) {
+        uint64_t h = TrigramHash(FoldChar(literal[i - 2]), FoldChar(literal[i - 1]), FoldChar(literal[i]));
+        if (std::find(m_trigrams.begin(), m_trigrams.end(), h) == m_trigrams.end()) m_trigrams.push_back(h);
+    }
+    return true;
+}
+
+bool SearchMatcher::AcceptsDir(LineDir d) const {
+    switch (m_query.dir) {
+    case SearchDir::Rx: return d == LineDir::Rx;
+    case SearchDir::Tx: return d == LineDir::Tx;
+    default:            return true;
+    }
+}
+
+bool SearchMatcher::Matches(const wchar_t* text, size_t len) const {
+    if (Empty()) return false;
+    if (m_regex) return std::regex_search(text, text + len, *m_regex);
+
+    if (len < m_needle.size()) return false;
+    if (m_query.matchCase)
+        return std::search(text, text + len, m_needle.begin(), m_needle.end()) != text + len;
+
+    // Normaliza durante a comparação (sem copiar a linha):
+    const size_t n = m_needle.size();
+    const uint32_t first = (uint32_t)m_needle[0];
+    for (size_t i = 0; i + n <= len; ++i) {
+        if (FoldChar(text[i]) != first) continue;
+        size_t k = 1;
+        while (k < n && FoldChar(text[i + k]) == (uint32_t)m_needle[k]) ++k;
+        if (k == n) return true;
+    }
+    return false;
+}
+
+// ============================================================================
+//                               ScrollbackIndex
+// ============================================================================
+ScrollbackIndex::ScrollbackIndex(const Scrollback& store) : m_store(store) {
+    Reset();
+}
+
+void ScrollbackIndex::Reset() {
+    m_blocks.clear();
+    m_lineDirs.clear();
+    m_dirsFirstLine = m_indexedEnd = m_store.FirstLine();
+    m_lastDir = LineDir::Other;
+}
+
+size_t ScrollbackIndex::MemoryBytes() const {
+    return m_blocks.size() * (sizeof(Block) + kBloomWords * sizeof(uint64_t)) + m_lineDirs.size();
+}
+
+// Blocos cujas linhas a retenção do Scrollback já descartou.
+void ScrollbackIndex::DropDiscarded() {
+    uint64_t first = m_store.FirstLine();
+    while (!m_blocks.empty() && m_blocks.front().firstLine + m_blocks.front().lines <= first)
+        m_blocks.pop_front();
+
+    uint64_t keepFrom = m_blocks.empty() ? m_indexedEnd : m_blocks.front().firstLine;
+    while (!m_lineDirs.empty() && m_dirsFirstLine < keepFrom) {
+        m_lineDirs.pop_front();
+        ++m_dirsFirstLine;
+    }
+
+    // O índice ficou para trás da retenção: recomeça na primeira linha retida.
+    if (m_indexedEnd < first) {
+        m_blocks.clear();
+        m_lineDirs.clear();
+        m_dirsFirstLine = m_indexedEnd = first;
+    }
+}
+
+void ScrollbackIndex::IndexLine(Block& b, const wchar_t* text, size_t len, LineDir dir) {
+    uint64_t* bloom = b.bloom.get();
+    if (len >= 3) {
+        uint32_t a = FoldChar(text[0]), c = FoldChar(text[1]);
+        for (size_t i = 2; i < len; ++i) {
+            uint32_t d = FoldChar(text[i]);
+            BloomSet(bloom, TrigramHash(a, c, d));
+            a = c;
+            c = d;
+        }
+    }
+    b.lines++;
+    b.chars += (uint32_t)len;
+    b.dirs |= (uint8_t)(1u << (unsigned)dir);
+}
+
+bool ScrollbackIndex::Update(size_t maxChars) {
+    if (m_store.EndLine() < m_indexedEnd) Reset();   // Scrollback::Clear()
+    DropDiscarded();
+
+    uint64_t closedEnd = m_store.EndLine() - 1;      // a última linha ainda está aberta
+    size_t done = 0;
+    while (m_indexedEnd < closedEnd && done < maxChars) {
+        if (m_blocks.empty() || m_blocks.back().lines >= kBlockMaxLines || m_blocks.back().chars >= kBlockMaxChars) {
+            Block b;
+            b.firstLine = m_indexedEnd;
+            b.bloom.reset(new uint64_t[kBloomWords]());
+            m_blocks.push_back(std::move(b));
+        }
+
+        const wchar_t* text = nullptr;
+        size_t len = 0;
+        m_store.GetLine(m_indexedEnd, &text, &len);
+        LineDir dir = ClassifyLine(text, len, m_lastDir);
+        IndexLine(m_blocks.back(), text, len, dir);
+        m_lineDirs.push_back((uint8_t)dir);
+        m_lastDir = dir;
+        ++m_indexedEnd;
+        done += len + 1;
+    }
+    return m_indexedEnd >= closedEnd;
+}
+
+size_t ScrollbackIndex::BlockOf(uint64_t line) const {
+    auto it = std::upper_bound(m_blocks.begin(), m_blocks.end(), line,
+        [](uint64_t l, const Block& b) { return l < b.firstLine; });
+    return (it == m_blocks.begin()) ? 0 : (size_t)(it - m_blocks.begin()) - 1;
+}
+
+bool ScrollbackIndex::BlockMayMatch(const Block& b, const SearchMatcher& m) const {
+    switch (m.Query().dir) {
+    case SearchDir::Rx: if (!(b.dirs & (1u << (unsigned)LineDir::Rx))) return false; break;
+    case SearchDir::Tx: if (!(b.dirs & (1u << (unsigned)LineDir::Tx))) return false; break;
+    default: break;
+    }
+    for (uint64_t h : m.Trigrams())
+        if (!BloomTest(b.bloom.get(), h)) return false;
+    return true;
+}
+
+bool ScrollbackIndex::LineMatches(const SearchMatcher& m, uint64_t line, LineDir dir) const {
+    if (!m.AcceptsDir(dir)) return false;
+    const wchar_t* text;
+    size_t len;
+    return m_store.GetLine(line, &text, &len) && m.Matches(text, len);
+}
+
+void ScrollbackIndex::TailDirs(std::vector<uint8_t>* dirs) const {
+    dirs->clear();
+    LineDir prev = m_lastDir;
+    for (uint64_t line = m_indexedEnd; line < m_store.EndLine(); ++line) {
+        const wchar_t* text = nullptr;
+        size_t len = 0;
+        if (m_store.GetLine(line, &text, &len)) prev = ClassifyLine(text, len, prev);
+        dirs->push_back((uint8_t)prev);
+    }
+}
+
+bool ScrollbackIndex::ScanForward(const SearchMatcher& m, uint64_t from, uint64_t end,
+                                  const std::function<bool(uint64_t)>& onMatch) const {
+    if (m.Empty()) return false;
+    from = std::max(from, m_store.FirstLine());
+    end = std::min(end, m_store.EndLine());
+    if (from >= end) return false;
+
+    // Parte indexada: só os blocos que podem conter a consulta.
+    uint64_t line = from;
+    if (line < m_indexedEnd && !m_blocks.empty()) {
+        for (size_t bi = BlockOf(line); bi < m_blocks.size(); ++bi) {
+            const Block& b = m_blocks[bi];
+            if (b.firstLine >= end) return false;
+            if (!BlockMayMatch(b, m)) continue;
+            uint64_t bEnd = std::min<uint64_t>(b.firstLine + b.lines, end);
+            for (uint64_t l = std::max(line, b.firstLine); l < bEnd; ++l)
+                if (LineMatches(m, l, (LineDir)m_lineDirs[(size_t)(l - m_dirsFirstLine)]) && onMatch(l))
+                    return true;
+        }
+    }
+    line = std::max(line, m_indexedEnd);
+
+    // Cauda ainda não indexada: verificação direta.
+    if (line < end) {
+        std::vector<uint8_t> dirs;
+        TailDirs(&dirs);
+        for (; line < end; ++line)
+            if (LineMatches(m, line, (LineDir)dirs[(size_t)(line - m_indexedEnd)]) && onMatch(line))
+                return true;
+    }
+    return false;
+}
+
+bool ScrollbackIndex::Find(const SearchMatcher& m, uint64_t from, bool forward, uint64_t* line) const {
+    if (forward)
+        return ScanForward(m, from, m_store.EndLine(), [line](uint64_t l) { *line = l; return true; });
+
+    if (m.Empty() || m_store.EndLine() == m_store.FirstLine()) return false;
+    uint64_t first = m_store.FirstLine();
+    if (from < first) return false;
+    int64_t cur = (int64_t)std::min(from, m_store.EndLine() - 1);
+
+    // Cauda, do fim para o começo:
+    if (cur >= (int64_t)m_indexedEnd) {
+        std::vector<uint8_t> dirs;
+        TailDirs(&dirs);
+        for (; cur >= (int64_t)m_indexedEnd; --cur) {
+            if (LineMatches(m, (uint64_t)cur, (LineDir)dirs[(size_t)(cur - (int64_t)m_indexedEnd)])) {
+                *line = (uint64_t)cur;
+                return true;
+            }
+        }
+    }
+    if (m_blocks.empty()) return false;
+
+    for (int64_t bi = (int64_t)BlockOf((uint64_t)cur); bi >= 0; --bi) {
+        const Block& b = m_blocks[(size_t)bi];
+        if (!BlockMayMatch(b, m)) continue;
+        int64_t bFirst = (int64_t)std::max(b.firstLine, first);
+        for (int64_t l = std::min<int64_t>(cur, (int64_t)(b.firstLine + b.lines) - 1); l >= bFirst; --l) {
+            if (LineMatches(m, (uint64_t)l, (LineDir)m_lineDirs[(size_t)((uint64_t)l - m_dirsFirstLine)])) {
+                *line = (uint64_t)l;
+                return true;
+            }
+        }
+        if ((int64_t)b.firstLine <= (int64_t)first) break;
+    }
+    return false;
+}
+
+void ScrollbackIndex::FindAll(const SearchMatcher& m, uint64_t from, uint64_t end,
+                              std::vector<uint64_t>* out) const {
+    ScanForward(m, from, end, [out](uint64_t l) { out->push_back(l); return false; });
+}
@@ -0,0 +1,126 @@
+// ScrollbackSearch.h - Busca e filtro sobre o histórico inteiro (Scrollback)
+// Objetivo: achar texto/regex em sessões de GBs sem copiar nada para um
+//           controle e sem percorrer o log linha a linha a cada tecla.
+//
+// Índice (ScrollbackIndex):
+//  - As linhas fechadas são agrupadas em blocos (até 512 linhas / 16K chars).
+//    Cada bloco guarda um filtro de Bloom (4 KB) com os trigramas das suas
+//    linhas (sem diferenciar maiúsculas) e quais direções (RX/TX) contém.
+//  - Uma busca calcula os trigramas obrigatórios da consulta e só verifica as
+//    linhas dos blocos cujo Bloom tem todos eles: num log de 64 MB são ~2 mil
+//    testes de bits em vez de 32 M caracteres comparados.
+//  - Indexar é incremental e limitado por chamada (Update(budget)): roda num
+//    timer da UI, fora do caminho RX (a thread do reactor não vê o índice).
+//    Linhas ainda não indexadas (a "cauda") são verificadas direto.
+//  - Blocos descartados pela retenção do Scrollback saem do índice junto.
+//
+// Direção da linha: "[RX..." = RX, "[TX..." / "[ERRO TX..." = TX, outro "["
+// = nenhuma; linhas sem "[" (ex.: linhas do dump HEX) herdam a da anterior.
+//
+// Não depende de Win32.
+
+#pragma once
+
+#include "Scrollback.h"
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <regex>
+#include <string>
+#include <vector>
+
+enum class LineDir : uint8_t { Other = 0, Rx = 1, Tx = 2 };
+enum class SearchDir : uint8_t { Any, Rx, Tx };
+
+struct SearchQuery {
+    std::wstring text;
+    bool regex = false;                   // ECMAScript (std::wregex)
+    bool matchCase = false;
+    SearchDir dir = SearchDir::Any;
+};
+
+// Direção de uma linha do log ('previous' = a da linha anterior).
+LineDir ClassifyLine(const wchar_t* text, size_t len, LineDir previous);
+
+// Consulta compilada: verificação de uma linha + trigramas para o índice.
+class SearchMatcher {
+public:
+    // false = regex inválida ('error' explica). Texto vazio compila e não casa nada.
+    bool Compile(const SearchQuery& q, std::string* error);
+    void Clear();
+
+    bool Empty() const { return m_query.text.empty(); }
+    const SearchQuery& Query() const { return m_query; }
+
+    bool AcceptsDir(LineDir d) const;
+    bool Matches(const wchar_t* text, size_t len) const;
+
+    // Hashes dos trigramas que toda linha que casa contém (vazio = sem filtro).
+    const std::vector<uint64_t>& Trigrams() const { return m_trigrams; }
+
+private:
+    SearchQuery m_query;
+    std::wstring m_needle;                // texto literal (normalizado se !matchCase)
+    std::unique_ptr<std::wregex> m_regex;
+    std::vector<uint64_t> m_trigrams;
+};
+
+// Maior trecho literal que toda ocorrência da regex contém ("" se não houver
+// um seguro, ex.: alternação com '|'). Usado para consultar o índice.
+std::wstring RegexRequiredLiteral(const std::wstring& pattern);
+
+class ScrollbackIndex {
+public:
+    static const uint32_t kBlockMaxLines = 512;
+    static const uint32_t kBlockMaxChars = 16 * 1024;
+    static const uint32_t kBloomBits = 32 * 1024;        // 4 KB por bloco
+
+    explicit ScrollbackIndex(const Scrollback& store);
+
+    ScrollbackIndex(const ScrollbackIndex&) = delete;
+    ScrollbackIndex& operator=(const ScrollbackIndex&) = delete;
+
+    // Indexa linhas fechadas ainda fora do índice, até ~'maxChars' caracteres.
+    // true = índice em dia (só a linha aberta ficou de fora).
+    bool Update(size_t maxChars);
+    void Reset();
+
+    uint64_t IndexedEnd() const { return m_indexedEnd; }   // linhas < isso estão no índice
+    size_t MemoryBytes() const;
+
+    // Primeira linha que casa a partir de 'from' (inclusive), para frente ou
+    // para trás. Considera também a linha aberta.
+    bool Find(const SearchMatcher& m, uint64_t from, bool forward, uint64_t* line) const;
+
+    // Acrescenta em 'out' as linhas de [from, end) que casam, em ordem.
+    void FindAll(const SearchMatcher& m, uint64_t from, uint64_t end, std::vector<uint64_t>* out) const;
+
+private:
+    struct Block {
+        uint64_t firstLine = 0;
+        uint32_t lines = 0;
+        uint32_t chars = 0;
+        uint8_t  dirs = 0;                // bits (1 << LineDir) presentes
+        std::unique_ptr<uint64_t[]> bloom;
+    };
+
+    void DropDiscarded();
+    void IndexLine(Block& b, const wchar_t* text, size_t len, LineDir dir);
+    bool BlockMayMatch(const Block& b, const SearchMatcher& m) const;
+    bool LineMatches(const SearchMatcher& m, uint64_t line, LineDir dir) const;
+    size_t BlockOf(uint64_t line) const;  // índice em m_blocks (linha indexada)
+    // Linhas de [from, end) que casam, em ordem, até 'onMatch' retornar true.
+    bool ScanForward(const SearchMatcher& m, uint64_t from, uint64_t end,
+                     const std::function<bool(uint64_t)>& onMatch) const;
+    // Direções da cauda [m_indexedEnd, EndLine()).
+    void TailDirs(std::vector<uint8_t>* dirs) const;
+
+    const Scrollback& m_store;
+    std::deque<Block> m_blocks;           // o último pode estar incompleto
+    std::deque<uint8_t> m_lineDirs;       // LineDir por linha indexada, a partir de m_dirsFirstLine
+    uint64_t m_dirsFirstLine = 0;
+    uint64_t m_indexedEnd = 0;
+    LineDir m_lastDir = LineDir::Other;
+};
@@ -0,0 +1,861 @@
+// SelfTest.cpp - Casos do modo --selftest (ver SelfTest.h)
+
+#include "SelfTest.h"
+
+#include "Capture.h"
+#include "Crc16.h"
+#include "Framing.h"
+#include "LzCodec.h"
+#include "MappedFile.h"
+#include "Replay.h"
+#include "RxRing.h"
+#include "StreamMatcher.h"
+#include "Utf8Decoder.h"
+
+#include <atomic>
+#include <cstdarg>
+#include <cstdlib>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// ============================================================================
+//                              Infraestrutura
+// ============================================================================
+class Checker {
+public:
+    explicit Checker(bool verbose) : m_verbose(verbose) {}
+
+    // Registra uma verificação; as primeiras falhas de cada caso são impressas.
+    bool Expect(bool ok, const char* fmt, ...) {
+        ++m_checks;
+        if (ok) return true;
+        if (++m_failures <= kMaxReported || m_verbose) {
+            char msg[512];
+            va_list ap;
+            va_start(ap, fmt);
+            vsnprintf(msg, sizeof(msg), fmt, ap);
+            va_end(ap);
+            fprintf(stderr, "    %s\n", msg);
+        }
+        return false;
+    }
+
+    uint64_t Checks() const { return m_checks; }
+    uint64_t Failures() const { return m_failures; }
+
+private:
+    static const uint64_t kMaxReported = 5;
+
+    bool m_verbose;
+    uint64_t m_checks = 0;
+    uint64_t m_failures = 0;
+};
+
+struct SelfTestCase {
+    const char* name;
+    void (*run)(Checker& c);
+};
+
+// xorshift64: mesma sequência em toda execução/plataforma.
+struct Rng {
+    uint64_t s = 0x9E3779B97F4A7C15ull;
+    uint32_t Next() {
+        s ^= s << 13;
+        s ^= s >> 7;
+        s ^= s << 17;
+        return (uint32_t)(s >> 16);
+    }
+};
+
+std::string Hex(const uint8_t* p, size_t n) {
+    static const char kHex[] = "0123456789ABCDEF";
+    std::string s;
+    for (size_t i = 0; i < n && i < 24; ++i) {
+        if (i) s.push_back(' ');
+        s.push_back(kHex[p[i] >> 4]);
+        s.push_back(kHex[p[i] & 15]);
+    }
+    if (n > 24) s += " ...";
+    return s;
+}
+
+std::string Hex(const std::string& s) {
+    return Hex((const uint8_t*)s.data(), s.size());
+}
+
+// ============================================================================
+//                 UTF-8: referência byte a byte (Unicode 3.9)
+// ============================================================================
+// Implementação direta da tabela 3-7 com substituição por "maximal subpart":
+// cada trecho inválido máximo vira um U+FFFD e o byte que o interrompeu é
+// reprocessado. Uma sequência cortada no fim da entrada também vira U+FFFD.
+// Sem SIMD e sem estado entre chamadas: é a referência dos testes.
+struct Utf8Reference {
+    std::wstring text;
+    size_t invalid = 0;
+};
+
+void EmitRef(std::wstring& out, uint32_t cp) {
+    if (sizeof(wchar_t) == 2 && cp >= 0x10000) {
+        cp -= 0x10000;
+        out.push_back((wchar_t)(0xD800 + (cp >> 10)));
+        out.push_back((wchar_t)(0xDC00 + (cp & 0x3FF)));
+    }
+    else {
+        out.push_back((wchar_t)cp);
+    }
+}
+
+Utf8Reference DecodeReference(const std::string& in) {
+    Utf8Reference r;
+    const uint8_t* s = (const uint8_t*)in.data();
+    const size_t n = in.size();
+    size_t i = 0;
+    while (i < n) {
+        const uint8_t b = s[i];
+        size_t need;
+        uint8_t lo = 0x80, hi = 0xBF;               // faixa do segundo byte
+        uint32_t cp;
+        if (b <= 0x7F) { EmitRef(r.text, b); ++i; continue; }
+        else if (b >= 0xC2 && b <= 0xDF) { need = 1; cp = b & 0x1F; }
+        else if (b == 0xE0) { need = 2; cp = 0; lo = 0xA0; }
+        else if (b >= 0xE1 && b <= 0xEC) { need = 2; cp = b & 0x0F; }
+        else if (b == 0xED) { need = 2; cp = 0x0D; hi = 0x9F; }
+        else if (b >= 0xEE && b <= 0xEF) { need = 2; cp = b & 0x0F; }
+        else if (b == 0xF0) { need = 3; cp = 0; lo = 0x90; }
+        else if (b >= 0xF1 && b <= 0xF3) { need = 3; cp = b & 0x07; }
+        else if (b == 0xF4) { need = 3; cp = 4; hi = 0x8F; }
+        else {                                      // 80..C1, F5..FF
+            r.text.push_back((wchar_t)0xFFFD);
+            ++r.invalid;
+            ++i;
+            continue;
+        }
+
+        size_t j = i + 1;
+        size_t got = 0;
+        while (got < need && j < n && s[j] >= lo && s[j] <= hi) {
+            cp = (cp << 6) | (s[j] & 0x3F);
+            lo = 0x80;
+            hi = 0xBF;
+            ++j;
+            ++got;
+        }
+        if (got == need) EmitRef(r.text, cp);
+        else {
+            r.text.push_back((wchar_t)0xFFFD);
+            ++r.invalid;
+        }
+        i = j;
+    }
+    return r;
+}
+
+// Decodifica 'in' cortado nos pontos 'cuts' (offsets crescentes). Uma
+// sequência pendente no fim conta como um U+FFFD, como na referência.
+Utf8Reference DecodeSplit(const std::string& in, const std::vector<size_t>& cuts) {
+    Utf8Reference r;
+    Utf8Decoder dec;
+    size_t prev = 0;
+    for (size_t k = 0; k <= cuts.size(); ++k) {
+        size_t at = k < cuts.size() ? cuts[k] : in.size();
+        r.invalid += dec.Decode(in.data() + prev, at - prev, r.text);
+        prev = at;
+    }
+    if (dec.Pending()) {
+        r.text.push_back((wchar_t)0xFFFD);
+        ++r.invalid;
+    }
+    return r;
+}
+
+bool SameDecode(Checker& c, const char* what, const std::string& in, const Utf8Reference& got,
+                const Utf8Reference& want) {
+    return c.Expect(got.text == want.text && got.invalid == want.invalid,
+                    "%s: entrada [%s]: %zu chars/%zu invalidos, esperado %zu/%zu", what, Hex(in).c_str(),
+                    got.text.size(), got.invalid, want.text.size(), want.invalid);
+}
+
+// Entrada com ASCII longo (aciona o SIMD) e sequências válidas/inválidas
+// espalhadas em posições aleatórias.
+std::string RandomUtf8(Rng& rng, size_t size) {
+    static const char* const kPieces[] = {
+        "\xC3\xA7", "\xE2\x82\xAC", "\xF0\x9F\x98\x80", "\xED\x9F\xBF", "\xF4\x8F\xBF\xBF",
+        "\xC0\xAF", "\xE0\x80\xAF", "\xED\xA0\x80", "\xF4\x90\x80\x80", "\xF5", "\xFF", "\x80",
+        "\xE2\x82", "\xF0\x9F\x98", "\xC3",
+    };
+    std::string s;
+    while (s.size() < size) {
+        uint32_t r = rng.Next();
+        if (r % 8 == 0) s += kPieces[(r >> 8) % (sizeof(kPieces) / sizeof(kPieces[0]))];
+        else {
+            size_t run = (r >> 8) % 70;
+            for (size_t i = 0; i < run; ++i) s.push_back((char)(' ' + rng.Next() % 95));
+        }
+    }
+    return s;
+}
+
+// ============================================================================
+//                               Casos UTF-8
+// ============================================================================
+// Vetores conhecidos (Unicode 3.9, tabela 3-8 e vizinhos): número de U+FFFD.
+void TestUtf8Vectors(Checker& c) {
+    struct Vec {
+        const char* in;
+        size_t len;
+        const wchar_t* out;      // U+FFFD escrito como \xFFFD
+        size_t invalid;
+    };
+    static const Vec kVecs[] = {
+        { "abc", 3, L"abc", 0 },
+        { "\xC3\xA7\xC3\xA3o", 5, L"\x00E7\x00E3o", 0 },
+        { "\xE2\x82\xAC", 3, L"\x20AC", 0 },
+        { "\xEF\xBF\xBD", 3, L"\xFFFD", 0 },                               // U+FFFD legítimo
+        // Overlongs: cada byte vira um U+FFFD (o segundo não é continuação válida)
+        { "\xC0\xAF", 2, L"\xFFFD\xFFFD", 2 },
+        { "\xC1\xBF", 2, L"\xFFFD\xFFFD", 2 },
+        { "\xE0\x80\xAF", 3, L"\xFFFD\xFFFD\xFFFD", 3 },
+        { "\xF0\x80\x80\xAF", 4, L"\xFFFD\xFFFD\xFFFD\xFFFD", 4 },
+        // Surrogates (ED A0..BF) e acima de U+10FFFF
+        { "\xED\xA0\x80", 3, L"\xFFFD\xFFFD\xFFFD", 3 },
+        { "\xED\xBF\xBF", 3, L"\xFFFD\xFFFD\xFFFD", 3 },
+        { "\xF4\x90\x80\x80", 4, L"\xFFFD\xFFFD\xFFFD\xFFFD", 4 },
+        { "\xF5\x80\x80\x80", 4, L"\xFFFD\xFFFD\xFFFD\xFFFD", 4 },
+        { "\xFF", 1, L"\xFFFD", 1 },
+        // Maximal subpart: prefixo válido interrompido = UM U+FFFD
+        { "\xE2\x82" "A", 3, L"\xFFFD" L"A", 1 },
+        { "\xF0\x9F\x98" "A", 4, L"\xFFFD" L"A", 1 },
+        { "\xF0\x9F" "\xE2\x82\xAC", 5, L"\xFFFD\x20AC", 1 },
+        { "\x80\x80", 2, L"\xFFFD\xFFFD", 2 },
+        { "\xC3\xC3\xA7", 3, L"\xFFFD\x00E7", 1 },
+        // Tabela 3-8 do padrão: 61 F1 80 80 E1 80 C2 62 80 63 80 BF 64
+        { "\x61\xF1\x80\x80\xE1\x80\xC2\x62\x80\x63\x80\xBF\x64", 13,
+          L"a\xFFFD\xFFFD\xFFFD" L"b\xFFFD" L"c\xFFFD\xFFFD" L"d", 6 },
+    };
+
+    std::wstring smile;
+    EmitRef(smile, 0x1F600);
+    for (const Vec& v : kVecs) {
+        std::string in(v.in, v.len);
+        Utf8Reference want;
+        want.text = v.out;
+        want.invalid = v.invalid;
+        SameDecode(c, "referencia", in, DecodeReference(in), want);
+        SameDecode(c, "vetor", in, DecodeSplit(in, {}), want);
+    }
+    std::string emoji("\xF0\x9F\x98\x80");
+    Utf8Reference want;
+    want.text = smile;
+    SameDecode(c, "fora do BMP", emoji, DecodeSplit(emoji, {}), want);
+}
+
+// Cada vetor e um texto misto cortados em TODOS os pontos (um corte e dois
+// cortes), inclusive no meio de cada sequência: o resultado não pode mudar.
+void TestUtf8Splits(Checker& c) {
+    std::vector<std::string> inputs = {
+        "a\xC3\xA7\xE2\x82\xAC\xF0\x9F\x98\x80z",
+        "\x61\xF1\x80\x80\xE1\x80\xC2\x62\x80\x63\x80\xBF\x64",
+        "\xE0\x80\xAF\xED\xA0\x80\xF4\x90\x80\x80\xF0\x9F\x98",
+        "\xC3\xC3\xA7\xE2\x82" "A" "\xF0\x9F\xE2\x82\xAC",
+    };
+    Rng rng;
+    inputs.push_back(RandomUtf8(rng, 200));
+
+    for (const std::string& in : inputs) {
+        const Utf8Reference want = DecodeReference(in);
+        for (size_t a = 0; a <= in.size(); ++a) {
+            if (!SameDecode(c, "1 corte", in, DecodeSplit(in, { a }), want)) break;
+            for (size_t b = a; b <= in.size(); b += 3)
+                if (!SameDecode(c, "2 cortes", in, DecodeSplit(in, { a, b }), want)) break;
+        }
+    }
+}
+
+// Decodificador com SIMD (blocos grandes, ASCII longo) contra o mesmo
+// decodificador recebendo 1 byte por vez (só o caminho escalar) e contra a
+// referência, em entradas aleatórias e blocos aleatórios.
+void TestUtf8SimdScalar(Checker& c) {
+    Rng rng;
+    for (int round = 0; round < 200; ++round) {
+        const std::string in = RandomUtf8(rng, 1 + rng.Next() % 4096);
+        const Utf8Reference want = DecodeReference(in);
+
+        std::vector<size_t> bytewise;
+        for (size_t i = 1; i < in.size(); ++i) bytewise.push_back(i);
+        std::vector<size_t> blocks;
+        for (size_t at = rng.Next() % 64; at < in.size(); at += 1 + rng.Next() % 1024) blocks.push_back(at);
+
+        SameDecode(c, "inteiro (SIMD)", in, DecodeSplit(in, {}), want);
+        SameDecode(c, "byte a byte (escalar)", in, DecodeSplit(in, bytewise), want);
+        SameDecode(c, "blocos aleatorios", in, DecodeSplit(in, blocks), want);
+    }
+
+    // Primeiro não-ASCII em cada posição de um bloco de 64: a parada do
+    // laço SIMD (16/32 bytes) cai antes, em cima e depois dele.
+    for (size_t pos = 0; pos < 64; ++pos) {
+        std::string in(64, 'x');
+        in.insert(pos, "\xE2\x82\xAC");
+        in.insert(in.size() > pos + 20 ? pos + 20 : in.size(), "\xFF");
+        SameDecode(c, "posicao do nao-ASCII", in, DecodeSplit(in, {}), DecodeReference(in));
+    }
+}
+
+// Estado entre chamadas: InvalidCount() acumula, Reset() descarta o pendente.
+void TestUtf8State(Checker& c) {
+    Utf8Decoder dec;
+    std::wstring out;
+    dec.Decode("\xE2\x82", 2, out);
+    c.Expect(dec.Pending() == 2 && out.empty(), "pendente: %zu bytes, %zu chars", dec.Pending(), out.size());
+    dec.Decode("\xAC", 1, out);
+    c.Expect(out == L"\x20AC" && dec.Pending() == 0, "sequencia completada entre blocos");
+
+    out.clear();
+    dec.Decode("\xC3", 1, out);
+    dec.Reset();
+    size_t bad = dec.Decode("a", 1, out);
+    c.Expect(out == L"a" && bad == 0, "Reset() descarta o pendente");
+
+    bad = dec.Decode("\xFF\xFE", 2, out);
+    c.Expect(bad == 2 && dec.InvalidCount() == 2, "InvalidCount() = %llu", (unsigned long long)dec.InvalidCount());
+}
+
+// ============================================================================
+//                              Fila RX (RxRing)
+// ============================================================================
+// Byte 'i' do fluxo de teste: não se repete com o período do ring, então um
+// bloco lido fora de ordem ou antes de publicado não passa despercebido.
+uint8_t RingByte(uint64_t i) {
+    return (uint8_t)(((i + 1) * 0x9E3779B97F4A7C15ull) >> 56);
+}
+
+// Produtor e consumidor em threads de verdade, ring pequeno (dá a volta e
+// enche o tempo todo): cada byte tem que chegar, na ordem, e os contadores
+// têm que fechar com o que o produtor viu. É o que exercita a ordem
+// acquire/release entre m_head e m_tail; com uma thread só ela não importa.
+void TestRxRingSpsc(Checker& c) {
+    const uint64_t total = 8u << 20;
+    RxRing ring(8 * 1024);
+
+    std::atomic<bool> producerDone{ false };
+    uint64_t dropped = 0;                 // só o produtor escreve; lido depois do join
+    uint64_t overflows = 0;
+    std::thread producer([&] {
+        Rng rng;
+        rng.s ^= 0x5555;
+        std::vector<uint8_t> chunk(3000);
+        uint64_t pos = 0;
+        while (pos < total) {
+            size_t n = 1 + rng.Next() % chunk.size();
+            if (n > total - pos) n = (size_t)(total - pos);
+            for (size_t i = 0; i < n; ++i) chunk[i] = RingByte(pos + i);
+            size_t accepted;
+            if (rng.Next() % 4 == 0) {
+                // Registro em duas partes, tudo ou nada (caminho da captura).
+                size_t a = rng.Next() % (n + 1);
+                accepted = ring.WriteAll(chunk.data(), a, chunk.data() + a, n - a) ? n : 0;
+            }
+            else {
+                accepted = ring.Write(chunk.data(), n);
+            }
+            if (accepted < n) {
+                dropped += n - accepted;
+                ++overflows;
+                std::this_thread::yield();   // o resto vai de novo no próximo Write()
+            }
+            pos += accepted;
+        }
+        producerDone.store(true, std::memory_order_release);
+    });
+
+    Rng rng;
+    std::vector<uint8_t> out(4096);
+    std::vector<uint8_t> peek(4096);
+    uint64_t received = 0;
+    uint64_t bad = 0;
+    uint64_t firstBad = 0;
+    bool peekOk = true;
+    for (;;) {
+        size_t want = 1 + rng.Next() % out.size();
+        size_t peeked = (rng.Next() % 8 == 0) ? ring.Peek(peek.data(), want) : 0;
+        size_t n = ring.Read(out.data(), want);
+        if (n == 0) {
+            // Fim só depois de ver o produtor terminar E a fila vazia.
+            if (producerDone.load(std::memory_order_acquire) && ring.Size() == 0) break;
+            std::this_thread::yield();
+            continue;
+        }
+        if (peeked > n || memcmp(peek.data(), out.data(), peeked) != 0) peekOk = false;
+        for (size_t i = 0; i < n; ++i) {
+            if (out[i] != RingByte(received + i) && bad++ == 0) firstBad = received + i;
+        }
+        received += n;
+    }
+    producer.join();
+
+    c.Expect(bad == 0, "%llu bytes errados (primeiro no offset %llu)", (unsigned long long)bad,
+             (unsigned long long)firstBad);
+    c.Expect(peekOk, "Peek() diferente do Read() seguinte");
+    c.Expect(received == total, "recebidos %llu de %llu bytes", (unsigned long long)received,
+             (unsigned long long)total);
+    c.Expect(ring.TotalWritten() == total, "TotalWritten = %llu", (unsigned long long)ring.TotalWritten());
+    c.Expect(ring.DroppedBytes() == dropped && ring.OverflowEvents() == overflows,
+             "descartes: %llu bytes / %llu eventos, produtor viu %llu / %llu",
+             (unsigned long long)ring.DroppedBytes(), (unsigned long long)ring.OverflowEvents(),
+             (unsigned long long)dropped, (unsigned long long)overflows);
+    c.Expect(ring.HighWater() <= ring.Capacity(), "HighWater = %zu > capacidade", ring.HighWater());
+}
+
+// ============================================================================
+//                                 Framers
+// ============================================================================
+// Frame Modbus RTU aleatório: endereço + função + 'data' bytes + CRC.
+std::string MakeModbusFrame(Rng& rng, size_t data) {
+    std::string f;
+    for (size_t i = 0; i < 2 + data; ++i) f += (char)rng.Next();
+    uint16_t crc = Crc16Modbus((const uint8_t*)f.data(), f.size());
+    f += (char)(uint8_t)crc;
+    f += (char)(uint8_t)(crc >> 8);
+    return f;
+}
+
+// Alimenta 'in' cortado nas posições 'cuts' (crescentes) e junta os frames.
+std::vector<std::string> FeedModbus(ModbusRtuFramer& framer, const std::string& in, const std::vector<size_t>& cuts) {
+    std::vector<std::string> frames;
+    std::vector<uint8_t> work(in.begin(), in.end());
+    size_t from = 0;
+    for (size_t i = 0; i <= cuts.size(); ++i) {
+        size_t to = i < cuts.size() ? cuts[i] : in.size();
+        framer.Feed(work.data() + from, to - from, [&](FrameSpan f) { frames.emplace_back((const char*)f.data, f.len); });
+        from = to;
+    }
+    return frames;
+}
+
+// Vários frames no mesmo bloco saem um a um, em qualquer corte; acumulado
+// sem CRC recomeça nos bytes novos; FeedTimed() descarta o resto no silêncio.
+void TestModbusFramer(Checker& c) {
+    Rng rng;
+    std::vector<std::string> want;
+    std::string in;
+    for (size_t i = 0; i < 200; ++i) {
+        want.push_back(MakeModbusFrame(rng, i < 2 ? 4 : rng.Next() % 60));
+        in += want.back();
+    }
+
+    {
+        ModbusRtuFramer framer;
+        std::string two = want[0] + want[1];           // dois frames de 8 bytes numa leitura
+        std::vector<std::string> got = FeedModbus(framer, two, {});
+        c.Expect(got.size() == 2 && framer.Pending() == 0, "dois frames num bloco: %zu frames, %zu pendentes",
+                 got.size(), framer.Pending());
+        for (size_t cut = 1; cut < two.size(); ++cut) {
+            got = FeedModbus(framer, two, { cut });
+            c.Expect(got.size() == 2 && got[0] == want[0] && got[1] == want[1], "dois frames, corte em %zu", cut);
+        }
+    }
+    {
+        ModbusRtuFramer framer;
+        std::vector<size_t> cuts;
+        for (size_t at = rng.Next() % 64; at < in.size(); at += 1 + rng.Next() % 100) cuts.push_back(at);
+        std::vector<std::string> got = FeedModbus(framer, in, cuts);
+        c.Expect(got == want, "blocos aleatorios: %zu de %zu frames", got.size(), want.size());
+        c.Expect(framer.Stats().frames == want.size() && framer.Pending() == 0, "stats.frames = %llu",
+                 (unsigned long long)framer.Stats().frames);
+    }
+    {
+        // 256 bytes de lixo acumulados entre leituras: o frame seguinte não se perde.
+        ModbusRtuFramer framer;
+        std::string junk(ModbusRtuFramer::kMaxFrame, '\x55');
+        std::string all = junk + want[2];
+        std::vector<std::string> got = FeedModbus(framer, all, { 100, junk.size() });
+        c.Expect(got.size() == 1 && got[0] == want[2], "frame depois do overflow: %zu frames", got.size());
+        c.Expect(framer.Stats().overflows == 1, "stats.overflows = %llu", (unsigned long long)framer.Stats().overflows);
+    }
+    {
+        // Frame truncado + silêncio + frame inteiro.
+        ModbusRtuFramer framer;
+        framer.SetBaudRate(9600);
+        const int64_t gapNs = (int64_t)ModbusRtuFramer::GapMicros(9600) * 1000;
+        std::vector<std::string> got;
+        auto sink = [&](FrameSpan f) { got.emplace_back((const char*)f.data, f.len); };
+        std::vector<uint8_t> a(want[3].begin(), want[3].end() - 1);
+        std::vector<uint8_t> b(want[4].begin(), want[4].end());
+        framer.FeedTimed(a.data(), a.size(), 1000000, sink);
+        framer.FeedTimed(b.data(), b.size(), 1000000 + gapNs, sink);
+        c.Expect(got.size() == 1 && got[0] == want[4], "frame depois do silencio: %zu frames", got.size());
+        c.Expect(framer.Stats().errors == 1, "stats.errors = %llu", (unsigned long long)framer.Stats().errors);
+    }
+}
+
+// Posições (fim do casamento) de 'pattern' em 'text', força bruta.
+std::vector<size_t> FindAllReference(const std::string& text, const std::string& pattern) {
+    std::vector<size_t> at;
+    for (size_t i = 0; i + pattern.size() <= text.size(); ++i)
+        if (text.compare(i, pattern.size(), pattern) == 0) at.push_back(i + pattern.size() - 1);
+    return at;
+}
+
+// StreamMatcher contra a busca direta, com padrões que se sobrepõem a si
+// mesmos (a tabela de falhas é o que importa) sobre alfabeto pequeno.
+void TestStreamMatcher(Checker& c) {
+    static const char* const kPatterns[] = { "a", "OK", "aab", "abab", "aaaa", "abcabd", "ababcabab" };
+    Rng rng;
+    for (const char* pat : kPatterns) {
+        StreamMatcher m;
+        m.Set(pat);
+        for (int round = 0; round < 20; ++round) {
+            std::string text;
+            for (size_t i = 0; i < 2000; ++i) text += (char)('a' + rng.Next() % 3);
+            if (round == 0) text += "xxOKxx";
+            const std::vector<size_t> want = FindAllReference(text, pat);
+            std::vector<size_t> got;
+            for (size_t i = 0; i < text.size(); ++i)
+                if (m.Feed((uint8_t)text[i])) got.push_back(i);
+            c.Expect(got == want, "padrao \"%s\": %zu casamentos, esperado %zu", pat, got.size(), want.size());
+            m.Reset();
+        }
+    }
+    StreamMatcher empty;
+    c.Expect(empty.Empty() && empty.Feed('x'), "padrao vazio casa com qualquer byte");
+}
+
+// ============================================================================
+//                              Compressão (LzCodec)
+// ============================================================================
+const size_t kLzGuard = 64;
+const uint8_t kLzGuardByte = 0xA5;
+
+// Saída com 'kLzGuard' bytes de guarda depois de 'len': escrever fora do
+// destino estraga a guarda. A entrada vai num vetor do tamanho exato (com
+// -fsanitize=address, ler além dela também aparece).
+struct LzOut {
+    std::vector<uint8_t> buf;
+    explicit LzOut(size_t len) : buf(len + kLzGuard, kLzGuardByte) {}
+    uint8_t* Data() { return buf.data(); }
+    bool GuardOk() const {
+        for (size_t i = buf.size() - kLzGuard; i < buf.size(); ++i)
+            if (buf[i] != kLzGuardByte) return false;
+        return true;
+    }
+};
+
+std::vector<uint8_t> LzPack(const std::vector<uint8_t>& in) {
+    std::vector<uint8_t> out(LzCompressBound(in.size()));
+    out.resize(LzCompress(in.data(), in.size(), out.data(), out.size()));
+    return out;
+}
+
+bool LzUnpack(const std::vector<uint8_t>& packed, size_t outLen, std::vector<uint8_t>* out, bool* guardOk) {
+    std::vector<uint8_t> src(packed);            // tamanho exato
+    LzOut dst(outLen);
+    bool ok = LzDecompress(src.data(), src.size(), dst.Data(), outLen);
+    *guardOk = dst.GuardOk();
+    out->assign(dst.buf.begin(), dst.buf.begin() + outLen);
+    return ok;
+}
+
+void CheckLzRoundTrip(Checker& c, const char* what, const std::vector<uint8_t>& in) {
+    std::vector<uint8_t> packed = LzPack(in);
+    if (!c.Expect(!packed.empty(), "%s (%zu bytes): LzCompress com LzCompressBound falhou", what, in.size()))
+        return;
+    c.Expect(packed.size() <= LzCompressBound(in.size()), "%s: %zu bytes > LzCompressBound", what, packed.size());
+    std::vector<uint8_t> out;
+    bool guardOk = false;
+    bool ok = LzUnpack(packed, in.size(), &out, &guardOk);
+    c.Expect(ok && out == in, "%s (%zu bytes): ida e volta diferente", what, in.size());
+    c.Expect(guardOk, "%s: LzDecompress escreveu fora do destino", what);
+
+    // Destino exato aceita; um byte a menos recusa sem passar do limite.
+    LzOut exact(packed.size());
+    size_t n = LzCompress(in.data(), in.size(), exact.Data(), packed.size());
+    c.Expect(n == packed.size() && exact.GuardOk(), "%s: LzCompress com cap exato = %zu", what, n);
+    if (packed.size() > 1) {
+        LzOut small(packed.size() - 1);
+        n = LzCompress(in.data(), in.size(), small.Data(), packed.size() - 1);
+        c.Expect(n == 0 && small.GuardOk(), "%s: LzCompress sem espaco = %zu", what, n);
+    }
+}
+
+std::vector<uint8_t> Bytes(const std::string& s) {
+    return std::vector<uint8_t>(s.begin(), s.end());
+}
+
+// Ida e volta: vazio, curtos (abaixo do limite de match), incompressível,
+// repetitivo, matches sobrepostos (offset < comprimento) e comprimentos nas
+// fronteiras da codificação (15, 15 + 255...).
+void TestLzRoundTrip(Checker& c) {
+    Rng rng;
+    CheckLzRoundTrip(c, "vazio", {});
+    for (size_t n = 1; n <= 40; ++n) {
+        std::vector<uint8_t> in(n);
+        for (auto& b : in) b = (uint8_t)('a' + rng.Next() % 2);
+        CheckLzRoundTrip(c, "curto", in);
+    }
+
+    std::vector<uint8_t> random(256 * 1024);
+    for (auto& b : random) b = (uint8_t)rng.Next();
+    CheckLzRoundTrip(c, "incompressivel", random);
+
+    std::vector<uint8_t> zeros(256 * 1024, 0);
+    CheckLzRoundTrip(c, "zeros", zeros);
+    c.Expect(LzPack(zeros).size() < zeros.size() / 100, "zeros: %zu bytes comprimidos", LzPack(zeros).size());
+
+    // Período 1..7: cada match copia de poucos bytes atrás (sobreposto).
+    for (size_t period = 1; period <= 7; ++period) {
+        std::vector<uint8_t> in;
+        for (size_t i = 0; i < 5000; ++i) in.push_back((uint8_t)("abcdefg"[i % period]));
+        CheckLzRoundTrip(c, "sobreposto", in);
+        c.Expect(LzPack(in).size() < 100, "periodo %zu: %zu bytes comprimidos", period, LzPack(in).size());
+    }
+
+    // Literais e matches nos limites do token (14/15/16, 15 + 254/255/256).
+    static const size_t kEdges[] = { 1, 14, 15, 16, 268, 269, 270, 271, 524, 525, 526, 70000 };
+    for (size_t lit : kEdges) {
+        for (size_t match : kEdges) {
+            if (lit + match > 80000) continue;
+            std::vector<uint8_t> in;
+            std::vector<uint8_t> head(lit);
+            for (auto& b : head) b = (uint8_t)rng.Next();
+            in.insert(in.end(), head.begin(), head.end());
+            in.insert(in.end(), head.begin(), head.begin() + (match < lit ? match : lit));
+            while (in.size() < lit + match) in.push_back(in[in.size() - 1]);
+            for (int i = 0; i < 20; ++i) in.push_back((uint8_t)rng.Next());
+            CheckLzRoundTrip(c, "fronteiras", in);
+        }
+    }
+
+    // Texto de log (o caso do scrollback).
+    std::string log;
+    for (int i = 0; i < 5000; ++i)
+        log += "[RX] t=" + std::to_string(i * 10) + " v=4.9" + std::to_string(rng.Next() % 10) + " estado=OK\r\n";
+    CheckLzRoundTrip(c, "log", Bytes(log));
+}
+
+// Entrada truncada ou corrompida: false (ou, se por acaso ainda for válida,
+// exatamente outLen bytes), sem escrever fora do destino nem ler além da entrada.
+void TestLzCorrupt(Checker& c) {
+    Rng rng;
+    std::string text;
+    for (int i = 0; i < 200; ++i) text += "linha " + std::to_string(i % 17) + " ABABABABAB 0123456789\n";
+    std::vector<uint8_t> in = Bytes(text);
+    for (int i = 0; i < 300; ++i) in.push_back((uint8_t)rng.Next());
+    const std::vector<uint8_t> packed = LzPack(in);
+
+    std::vector<uint8_t> out;
+    bool guardOk = false;
+    for (size_t cut = 0; cut < packed.size(); ++cut) {
+        std::vector<uint8_t> part(packed.begin(), packed.begin() + cut);
+        bool ok = LzUnpack(part, in.size(), &out, &guardOk);
+        c.Expect(!ok && guardOk, "truncado em %zu de %zu: ok=%d, guarda %s", cut, packed.size(), ok,
+                 guardOk ? "ok" : "estragada");
+    }
+    c.Expect(!LzUnpack(packed, in.size() - 1, &out, &guardOk) && guardOk, "outLen menor aceito");
+    c.Expect(!LzUnpack(packed, in.size() + 1, &out, &guardOk) && guardOk, "outLen maior aceito");
+
+    for (int round = 0; round < 5000; ++round) {
+        std::vector<uint8_t> bad = packed;
+        int flips = 1 + (int)(rng.Next() % 4);
+        for (int i = 0; i < flips; ++i) bad[rng.Next() % bad.size()] ^= (uint8_t)(1 + rng.Next() % 255);
+        LzUnpack(bad, in.size(), &out, &guardOk);
+        if (!c.Expect(guardOk, "corrompido (rodada %d): escreveu fora do destino", round)) break;
+    }
+
+    // Sequências feitas à mão: offset 0, offset antes do início, comprimento
+    // enorme e literais que passam do fim da entrada.
+    struct Bad { const char* what; std::vector<uint8_t> data; size_t outLen; };
+    const Bad kBad[] = {
+        { "offset 0", { 0x14, 'a', 0x00, 0x00 }, 9 },
+        { "offset antes do inicio", { 0x14, 'a', 0x02, 0x00 }, 9 },
+        { "match alem de outLen", { 0x1F, 'a', 0x01, 0x00, 0xFF, 0xFF, 0x10 }, 64 },
+        { "literais alem da entrada", { 0xF0, 0x40, 'a', 'b' }, 79 },
+        { "comprimento sem fim", { 0xF0, 0xFF, 0xFF, 0xFF }, 1000 },
+        { "offset cortado", { 0x14, 'a', 0x01 }, 9 },
+    };
+    for (const Bad& b : kBad) {
+        bool ok = LzUnpack(b.data, b.outLen, &out, &guardOk);
+        c.Expect(!ok && guardOk, "%s: ok=%d, guarda %s", b.what, ok, guardOk ? "ok" : "estragada");
+    }
+}
+
+// ============================================================================
+//                          Reprodução de capturas
+// ============================================================================
+// Captura sintética escrita direto no formato do arquivo (Capture.h): só
+// registros, sem índice (o leitor reconstrói). TX intercalado é ignorado.
+struct SyntheticCapture {
+    std::string path;
+    std::string rx;              // fluxo RX esperado
+    size_t rxRecords = 0;
+};
+
+bool WriteSyntheticCapture(SyntheticCapture* cap, size_t records, uint64_t stepNs) {
+    std::FILE* f = FOpenUtf8(cap->path, "wb");
+    if (!f) return false;
+    CaptureHeader h = {};
+    memcpy(h.magic, "SERCAP01", 8);
+    h.version = 1;
+    h.headerSize = sizeof(h);
+    h.baudRate = 115200;
+    bool ok = fwrite(&h, sizeof(h), 1, f) == 1;
+
+    // Tamanhos que caem exatamente no buffer de 1 KB do ReplayToSink, nos
+    // seus múltiplos e em pedaços que somam 1 KB em sequência.
+    static const uint32_t kSizes[] = { 1024, 512, 512, 1, 1023, 2048, 3000, 100, 924, 1024, 4096, 7 };
+    Rng rng;
+    for (size_t i = 0; i < records && ok; ++i) {
+        CaptureRecordHeader r = {};
+        r.tsNs = (uint64_t)i * stepNs;
+        r.dir = (uint8_t)CaptureDir::Rx;
+        r.len = kSizes[i % (sizeof(kSizes) / sizeof(kSizes[0]))];
+        std::string data(r.len, 0);
+        for (char& ch : data) ch = (char)rng.Next();
+        ok = fwrite(&r, sizeof(r), 1, f) == 1 && fwrite(data.data(), 1, data.size(), f) == data.size();
+        cap->rx += data;
+        ++cap->rxRecords;
+        if (i % 5 == 0) {
+            CaptureRecordHeader t = r;
+            t.dir = (uint8_t)CaptureDir::Tx;
+            t.len = 3;
+            ok = ok && fwrite(&t, sizeof(t), 1, f) == 1 && fwrite("TX!", 1, 3, f) == 3;
+        }
+    }
+    return fclose(f) == 0 && ok;
+}
+
+void CheckReplay(Checker& c, const SyntheticCapture& cap, ReplayMode mode, const char* what) {
+    ReplayOptions opt;
+    opt.mode = mode;
+    std::string got;
+    ReplayStats stats;
+    std::string error;
+    bool ok = ReplayToSink(cap.path, opt, [&](const uint8_t* p, size_t n) { got.append((const char*)p, n); },
+                           &stats, &error);
+    if (!c.Expect(ok, "%s: ReplayToSink falhou: %s", what, error.c_str())) return;
+    c.Expect(got.size() == cap.rx.size(), "%s: %zu de %zu bytes entregues", what, got.size(), cap.rx.size());
+    c.Expect(got == cap.rx, "%s: bytes entregues diferem da captura", what);
+    c.Expect(stats.bytes == cap.rx.size(), "%s: stats.bytes = %llu", what, (unsigned long long)stats.bytes);
+    c.Expect(stats.chunks == cap.rxRecords, "%s: stats.chunks = %llu, esperado %zu", what,
+             (unsigned long long)stats.chunks, cap.rxRecords);
+}
+
+// Ida e volta: o que ReplayToSink entrega é exatamente o fluxo RX gravado,
+// nos dois modos. Em tempo real, Read() não pode devolver 0 (= fim) antes
+// do fim só porque um bloco terminou junto com o buffer.
+void TestReplayRoundTrip(Checker& c) {
+    SyntheticCapture cap;
+    cap.path = "selftest_replay.scap";
+    const size_t records = 3000;
+    const uint64_t stepNs = 20000;           // 60 ms de captura em tempo real
+    if (!c.Expect(WriteSyntheticCapture(&cap, records, stepNs), "nao foi possivel criar %s", cap.path.c_str()))
+        return;
+    CheckReplay(c, cap, ReplayMode::MaxSpeed, "MaxSpeed");
+    CheckReplay(c, cap, ReplayMode::RealTime, "RealTime");
+    remove(cap.path.c_str());
+}
+
+// Acrescenta índice (uma entrada: o primeiro registro) e rodapé com 'count'
+// entradas declaradas.
+bool AppendCaptureFooter(const std::string& path, uint64_t count) {
+    std::FILE* f = FOpenUtf8(path, "ab");
+    if (!f) return false;
+    fseek(f, 0, SEEK_END);
+    CaptureIndexEntry e = { 0, sizeof(CaptureHeader) };
+    CaptureFooter foot = {};
+    foot.indexOffset = (uint64_t)ftell(f);
+    foot.indexCount = count;
+    memcpy(foot.magic, "SERCAPIX", 8);
+    bool ok = fwrite(&e, sizeof(e), 1, f) == 1 && fwrite(&foot, sizeof(foot), 1, f) == 1;
+    return fclose(f) == 0 && ok;
+}
+
+// Rodapé íntegro é usado; rodapé cujo indexCount * 16 dá a volta em 64 bits
+// (e por isso "bate" com o tamanho do arquivo) é recusado e o índice é
+// reconstruído, sem alocar nem ler além do arquivo.
+void TestCaptureFooter(Checker& c) {
+    SyntheticCapture cap;
+    cap.path = "selftest_footer.scap";
+    if (!c.Expect(WriteSyntheticCapture(&cap, 12, 1000) && AppendCaptureFooter(cap.path, 1),
+                  "nao foi possivel criar %s", cap.path.c_str()))
+        return;
+    {
+        CaptureReader reader;
+        bool ok = reader.Open(cap.path);
+        c.Expect(ok && reader.HasIndex() && reader.Index().size() == 1, "rodape integro: indice do arquivo nao usado");
+    }
+
+    cap = SyntheticCapture();
+    cap.path = "selftest_footer.scap";
+    const uint64_t wraps = (1ull << 60) + 1;     // * 16 = 16 (mod 2^64)
+    if (!c.Expect(WriteSyntheticCapture(&cap, 12, 1000) && AppendCaptureFooter(cap.path, wraps),
+                  "nao foi possivel criar %s", cap.path.c_str()))
+        return;
+    {
+        CaptureReader reader;
+        bool ok = false;
+        try {
+            ok = reader.Open(cap.path);
+        }
+        catch (...) {
+            c.Expect(false, "rodape com indexCount enorme: Open() lancou excecao");
+        }
+        c.Expect(ok && !reader.HasIndex(), "rodape com indexCount enorme foi aceito");
+        c.Expect(reader.Index().size() < 100, "indice reconstruido com %zu entradas", reader.Index().size());
+    }
+    remove(cap.path.c_str());
+}
+
+const SelfTestCase kCases[] = {
+    { "utf8_vectors", TestUtf8Vectors },
+    { "utf8_splits", TestUtf8Splits },
+    { "utf8_simd_scalar", TestUtf8SimdScalar },
+    { "utf8_state", TestUtf8State },
+    { "rxring_spsc", TestRxRingSpsc },
+    { "frame_modbus", TestModbusFramer },
+    { "stream_matcher", TestStreamMatcher },
+    { "lz_round_trip", TestLzRoundTrip },
+    { "lz_corrupt", TestLzCorrupt },
+    { "replay_round_trip", TestReplayRoundTrip },
+    { "capture_footer", TestCaptureFooter },
+};
+
+void PrintSelfTestUsage() {
+    fprintf(stderr, "uso: --selftest [--filter=nome] [--verbose]\n");
+}
+}
+
+int SelfTestMain(int argc, char** argv) {
+    std::string filter;
+    bool verbose = false;
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        if (strcmp(a, "--selftest") == 0) {}
+        else if (strncmp(a, "--filter=", 9) == 0) filter = a + 9;
+        else if (strcmp(a, "--verbose") == 0) verbose = true;
+        else {
+            fprintf(stderr, "argumento invalido: %s\n", a);
+            PrintSelfTestUsage();
+            return 2;
+        }
+    }
+
+    int ran = 0, failed = 0;
+    for (const SelfTestCase& t : kCases) {
+        if (!filter.empty() && !strstr(t.name, filter.c_str())) continue;
+        fprintf(stderr, "%s\n", t.name);
+        Checker c(verbose);
+        t.run(c);
+        ++ran;
+        if (c.Failures()) ++failed;
+        fprintf(stderr, "  %s (%llu verificacoes, %llu falhas)\n", c.Failures() ? "FALHA" : "ok",
+                (unsigned long long)c.Checks(), (unsigned long long)c.Failures());
+    }
+    fprintf(stderr, "%d casos, %d falharam\n", ran, failed);
+    return failed ? 1 : (ran ? 0 : 2);
+}
@@ -0,0 +1,20 @@
+// SelfTest.h - Testes de correção sem hardware (modo "--selftest")
+// Objetivo: verificar decodificadores, framers e a reprodução de capturas
+//           em qualquer máquina (Windows ou Linux), sem porta serial e sem
+//           depender de ferramentas externas.
+//
+//  - Cada caso compara a saída do código de produção com uma referência
+//    escrita aqui, de forma independente e sem otimização (ex.: um
+//    decodificador UTF-8 byte a byte contra o Utf8Decoder com SIMD).
+//  - Resultado em stderr, um caso por linha ("ok" / "FALHA" + as primeiras
+//    divergências). Código de saída 0 = tudo passou, 1 = alguma falha.
+//
+// Uso (Windows: SerialCPP.exe --selftest ...; Linux: ver MainPosix.cpp):
+//   --selftest [--filter=utf8] [--verbose]
+//
+// Não depende de Win32.
+
+#pragma once
+
+// Ponto de entrada do modo --selftest. Retorna 0 (ok), 1 (falha) ou 2 (argumentos).
+int SelfTestMain(int argc, char** argv);
@@ -10,16 +10,46 @@
 #include <string>
 #include <vector>
 #include <sstream>
-#include <setupapi.h>
-#include <initguid.h>
-#include <devguid.h>
-#include <regstr.h>
+#include <shellapi.h>
+#include <dbt.h>
 #include <thread>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <memory>
+#include <algorithm>
+
+#include "ChunkPool.h"
+#include "Scrollback.h"
+#include "TerminalView.h"
+#include "Telemetry.h"
+#include "TelemetryView.h"
+#include "Utf8Decoder.h"
+#include "HexDump.h"
+#include "SerialPort.h"
+#include "TxQueue.h"
+#include "Capture.h"
+#include "Replay.h"
+#include "Framing.h"
+#include "Bench.h"
+#include "SerialReactor.h"
+#include "SerialSession.h"
+#include "Metrics.h"
+#include "RttDialog.h"
+#include "LoadDialog.h"
+#include "ScrollbackSearch.h"
+#include "PreciseTimer.h"
+#include "Headless.h"
+#include "PortEnumerator.h"
+#include "TcpBridge.h"
+#include "OfflineAnalysis.h"
+#include "SelfTest.h"
 
 #define USE_TERMINAL_DEBUG
 
 #pragma comment(lib, "comctl32.lib")
-#pragma comment(lib, "setupapi.lib")
+#pragma comment(lib, "shell32.lib")
+#pragma comment(lib, "comdlg32.lib")
 
 // ---- IDs dos controles da janela ----
 #define ID_COMBOBOX_COMPORT 101
@@ -31,32 +61,169 @@
 #define ID_EDIT_SEND2        107
 #define ID_RADIO_SEND1       108
 #define ID_RADIO_SEND2       109
+#define ID_BTN_CAPTURE       110
+#define ID_BTN_REPLAY        111
+#define ID_TAB_PORTS         112
+#define ID_STATUS_BAR        113
+#define ID_BTN_RTT           114
+#define ID_EDIT_SEARCH       115
+#define ID_COMBO_SEARCH_DIR  116
+#define ID_CHECK_SEARCH_REGEX 117
+#define ID_BTN_FIND_NEXT     118
+#define ID_BTN_FILTER        119
+#define ID_BTN_LOAD          120
+#define ID_BTN_PLOT          121
+#define ID_TELEMETRY_VIEW    122
+#define ID_BTN_BRIDGE        123
+
+// ---- Mensagens/timers internos ----
+// WM_APP_*: postadas pelas threads de I/O com o id da sessão em wParam.
+// WM_APP_RX_READY: há bytes novos na fila RX da sessão. No máximo UMA fica
+//                  pendente por sessão (ver SerialSession::AckRxReady()).
+#define WM_APP_RX_READY      (WM_APP + 1)
+#define WM_APP_PORT_LOST     (WM_APP + 2)   // Read() falhou de vez (ex.: USB removido)
+#define WM_APP_TX_DONE       (WM_APP + 3)   // a thread de escrita concluiu mensagens
+#define WM_APP_REPLAY_DONE   (WM_APP + 4)   // a reprodução chegou ao fim da captura
+#define WM_APP_RTT_DONE      (WM_APP + 5)   // a medição de ida e volta terminou
+#define WM_APP_PORTS_CHANGED (WM_APP + 6)   // o PortEnumerator tem uma lista nova de portas
+#define WM_APP_LOAD_DONE     (WM_APP + 7)   // o plano de carga (TxScheduler) terminou
+#define ID_TIMER_RX_DRAIN    1        // por aba: TabTimerId(aba, ID_TIMER_RX_DRAIN)
+#define ID_TIMER_METRICS     2        // global (amostra todas as abas)
+#define ID_TIMER_RX_LINE     3        // por aba
+#define ID_TIMER_SEARCH_INDEX 4       // global (indexa todas as abas)
+#define ID_TIMER_SCROLLBACK_COMPACT 5 // global (comprime o histórico frio de todas as abas)
+#define TabTimerId(tab, kind) ((UINT_PTR)(((tab)->id << 4) | (kind)))
+#define METRICS_INTERVAL_MS  1000     // barra de status e export (--metrics=)
+#define RX_DRAIN_INTERVAL_MS 16       // ~1 repintura por frame (60 Hz)
+#define RX_DRAIN_MAX_BYTES   (256 * 1024) // limite drenado por frame
+#define RX_HEX_BYTES_PER_ROW 8        // dump HEX cabe na largura do terminal
+#define RX_LINE_FLUSH_MS     100      // linha sem '\n' (ex.: prompt) aparece após esse silêncio
+#define REACTOR_THREADS      1        // uma thread de RX dá conta de dezenas de portas
+#define TAB_SCROLLBACK_BYTES (64u * 1024 * 1024)  // histórico por aba
+#define SEARCH_INDEX_INTERVAL_MS 50   // fatias de indexação do histórico
+#define SEARCH_INDEX_CHARS   (256 * 1024) // por aba e fatia (~1 ms)
+#define SCROLLBACK_COMPACT_INTERVAL_MS 250  // fatias de compressão do histórico frio
+#define SCROLLBACK_COMPACT_CHARS (256 * 1024) // por aba e fatia (~2 ms de LZ)
+#define BRIDGE_BASE_PORT     7000     // ponte TCP da aba N: 7000 + 2*(N-1) crua, +1 RFC 2217
 
 // ---- Handles globais dos controles ----
-HWND hComboComPort, hComboBaudRate, hBtnConnect, hBtnSend;
-HWND hTerminal, hEditSend1, hEditSend2;
-HWND hRadioSend1, hRadioSend2;
-
-// ---- Estado da serial ----
-HANDLE hSerial = INVALID_HANDLE_VALUE;
-bool isConnected = false;   // conectado à COM?
-bool isReceiving = false;   // thread de RX rodando?
-std::thread serialThread;   // thread de leitura assíncrona
+HWND hComboComPort, hComboBaudRate, hBtnConnect, hBtnSend, hBtnCapture, hBtnReplay, hBtnRtt, hBtnLoad;
+HWND hTabs, hStatus, hEditSend1, hEditSend2;
+HWND hEditSearch, hComboSearchDir, hCheckSearchRegex, hBtnFindNext, hBtnFilter;
+HWND hRadioSend1, hRadioSend2, hBtnPlot, hBtnBridge;
+HWND hMainWnd = nullptr;
+
+// ---- Sessões: uma aba por porta ----
+// Cada aba tem a sua SerialSession (porta, fila RX, TxQueue, captura), o seu
+// histórico e a sua view. Todas as portas são lidas pelo mesmo 'reactor'
+// (epoll/IOCP, ver SerialReactor.h) em vez de uma thread bloqueada por porta.
+// As mensagens WM_APP_* levam o id da sessão em wParam.
+struct TxPending {
+    uint64_t id;
+    std::wstring text;
+};
+
+struct PortTab {
+    uint32_t id = 0;
+    std::wstring portName;                    // "COM6", "replay"; vazio = aba inicial sem porta
+    std::unique_ptr<SerialSession> session;
+    Scrollback log{ TAB_SCROLLBACK_BYTES };   // histórico da aba (a view só desenha)
+    HWND hView = nullptr;
+
+    // Telemetria: valores "nome=valor" das linhas RX e o gráfico (outra view
+    // no mesmo lugar; o botão "Gráfico" alterna entre as duas).
+    TelemetryStore telemetry;
+    HWND hPlot = nullptr;
+
+    // Busca (thread da UI): índice do log, atualizado em fatias por um timer.
+    ScrollbackIndex index{ log };
+    uint64_t searchHit = UINT64_MAX;          // linha do resultado atual
+    std::vector<uint64_t> filterLines;        // linhas que casam (view com filtro)
+    uint64_t filterScanned = 0;               // linhas < isso já passaram pelo filtro
+    uint64_t filterGeneration = 0;            // consulta usada em filterLines
+
+    // RX (thread da UI): a thread do reactor só enfileira o span em
+    // session->Rx() e avisa; decodificar e desenhar acontece aqui, no ritmo da UI.
+    ULONGLONG lastRxDrainTick = 0;
+    bool rxDrainTimerArmed = false;
+    uint64_t rxDroppedReported = 0;
+    Utf8Decoder rxDecoder;                    // guarda sequências partidas entre lotes
+    std::wstring rxText;                      // buffer de saída reutilizado (sem alocar por lote)
+    LineFramer rxLineFramer;                  // junta linhas partidas entre leituras/lotes
+
+    // TX: o "[TX]" só é logado quando a escrita conclui (WM_APP_TX_DONE).
+    std::deque<TxPending> txPending;          // enviadas, aguardando conclusão (ordem FIFO)
+
+    // Métricas: último retrato (cumulativo) e o intervalo que a barra mostra.
+    PortMetricsSnapshot lastMetrics;
+    MetricsSample lastSample;
+};
+
+SerialReactor reactor;
+SessionEvents sessionEvents;                  // postam WM_APP_* para a janela principal
+std::vector<std::unique_ptr<PortTab>> tabs;   // na ordem das abas
+PortTab* activeTab = nullptr;
+uint32_t nextTabId = 1;
+MetricsExporter metricsExport;                // --metrics=: JSON Lines por porta
+RttDialogValues rttSettings;                  // últimos valores da janela de RTT
+std::string loadPlanText =                    // último plano da janela de carga (TxScheduler.h)
+    "# fluxo a cada 10 ms durante 5 s\n"
+    "every 10 \"PING\\r\\n\"\n"
+    "duration 5\n";
+SearchMatcher searchMatcher;                  // consulta da barra de busca
+uint64_t searchGeneration = 0;                // muda a cada consulta nova
+bool filterOn = false;                        // view mostra só as linhas que casam
+bool plotOn = false;                          // abas mostram o gráfico em vez do texto
+PortEnumerator portEnum;                      // lista de portas em cache (thread própria)
+std::vector<PortInfo> comboPorts;             // o que o combo de portas mostra, na ordem
+uint64_t comboPortsGeneration = 0;            // geração do portEnum em comboPorts
+// Dispositivos simulados (DeviceSim.h), no fim do combo: a SerialSession abre
+// "sim:..." sem hardware, com o baud do combo como velocidade da linha.
+static const wchar_t* const kSimPortNames[] = {
+    L"sim:rate", L"sim:burst", L"sim:binary", L"sim:telemetry", L"sim:echo",
+};
 
 
 static std::string WideToUtf8(const std::wstring& w);
-static std::wstring Utf8ToWide(const char* data, int bytes);
+static std::wstring Utf8ToWide(const std::string& s);
 void AppendToTerminal(const std::wstring& text);
-static void SetupSerialTimeouts_BlockingOnChars(HANDLE h);
-static bool ConfigurePort(HANDLE h, DWORD baud);
-void SerialReadLoop();
+static void AppendToTab(PortTab* tab, const std::wstring& text);
+static PortTab* FindTab(uint32_t id);
+static PortTab* FindTabByPort(const std::wstring& portName);
+static PortTab* CreateTab(const std::wstring& portName);
+static void ActivateTab(PortTab* tab);
+static void SetTabTitle(PortTab* tab);
+static void UpdateSessionButtons();
+static std::wstring SelectedPortName();
+static void OnRxReady(HWND hwnd, PortTab* tab);
+static void DrainRxRing(HWND hwnd, PortTab* tab);
+static void AppendRxFrame(PortTab* tab, const FrameSpan& frame, uint64_t streamOffset, bool partial);
+static void FlushRxLine(PortTab* tab);
+static void HandleTxDone(PortTab* tab);
+static void UpdateMetrics();
+static void ShowStatus(PortTab* tab);
 void ListComPorts(HWND hComboBox);
+static void OnPortsChanged();
 void PopulateBaudRates(HWND hComboBox);
-bool OpenSerialPort(const std::wstring& portName, DWORD baudRate);
-void CloseSerialPort();
+static bool OpenSerialPort(PortTab* tab, const std::wstring& portName, DWORD baudRate);
+static void PrepareTabForSession(PortTab* tab);
+static void StartReplay(HWND hwnd);
+static void FinishReplay(PortTab* tab);
+static void CloseSerialPort(PortTab* tab);
 void SendSelectedMessage();
+static void ToggleCapture(HWND hwnd);
+static void ToggleRtt(HWND hwnd);
+static void ToggleLoad(HWND hwnd);
+static void ToggleBridge();
+static std::wstring LoadReportText(const TxScheduleReport& r);
+static void OnSearchChanged();
+static void FindInTab(PortTab* tab, bool next);
+static void ApplyFilter(PortTab* tab);
+static void ExtendFilter(PortTab* tab);
 LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
 static void InitDebugConsole(void);
+static void InitBenchConsole(void);
+static void InitHeadlessConsole(void);
 void RefreshComPortsAndKeepSelection(HWND hComboBox);
 
 
@@ -64,6 +231,36 @@ void RefreshComPortsAndKeepSelection(HWND hComboBox);
 //                                 WinMain
 // ============================================================================
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow) {
+    // Modo benchmark (sem janela): SerialCPP.exe --bench ... (ver Bench.h)
+    if (__argc > 1 && strcmp(__argv[1], "--bench") == 0) {
+        InitBenchConsole();
+        return BenchMain(__argc, __argv);
+    }
+
+    // Testes de correção sem hardware: SerialCPP.exe --selftest (ver SelfTest.h)
+    if (__argc > 1 && strcmp(__argv[1], "--selftest") == 0) {
+        InitBenchConsole();
+        return SelfTestMain(__argc, __argv);
+    }
+
+    // Modo sem janela: porta <-> stdout/stdin/arquivos (ver Headless.h)
+    if (__argc > 1 && strcmp(__argv[1], "--headless") == 0) {
+        InitHeadlessConsole();
+        return HeadlessMain(__argc, __argv);
+    }
+
+    // Ponte TCP sem janela: porta -> vários clientes locais (ver TcpBridge.h)
+    if (__argc > 1 && strcmp(__argv[1], "--bridge") == 0) {
+        InitHeadlessConsole();
+        return BridgeMain(__argc, __argv);
+    }
+
+    // Análise offline de log/captura em todos os núcleos (ver OfflineAnalysis.h)
+    if (__argc > 1 && strncmp(__argv[1], "--analyze=", 10) == 0) {
+        InitHeadlessConsole();
+        return AnalyzeMain(__argc, __argv);
+    }
+
     // Registra classe da janela principal:
     
 #ifdef USE_TERMINAL_DEBUG
@@ -76,6 +273,12 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow) {
     wc.hInstance = hInstance;
     wc.lpszClassName = L"SerialApp";
     RegisterClassW(&wc);
+    RegisterTerminalView(hInstance);
+    RegisterTelemetryView(hInstance);
+
+    // Tab control (abas por porta) e barra de status vêm do comctl32:
+    INITCOMMONCONTROLSEX icc = { sizeof(icc), ICC_TAB_CLASSES | ICC_BAR_CLASSES };
+    InitCommonControlsEx(&icc);
 
     // Janela fixa (sem redimensionar) para simplificar layout:
     DWORD style = (WS_OVERLAPPEDWINDOW & ~WS_THICKFRAME);
@@ -83,7 +286,7 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow) {
     HWND hwnd = CreateWindowW(
         L"SerialApp", L"Terminal Serial (Win32)",
         style,
-        CW_USEDEFAULT, CW_USEDEFAULT, 400, 460,
+        CW_USEDEFAULT, CW_USEDEFAULT, 400, 514,
         nullptr, nullptr, hInstance, nullptr);
 
     ShowWindow(hwnd, nCmdShow);
@@ -119,6 +322,42 @@ static void InitDebugConsole(void)
     // _setmode(_fileno(stdout), _O_U16TEXT);
 }
 
+/*
+    No modo --bench o resumo vai para o console de quem chamou (cmd/PowerShell/CI);
+    sem console pai, cria um. Para comparar execuções, use --json=arquivo.
+*/
+static void InitBenchConsole(void)
+{
+    if (!AttachConsole(ATTACH_PARENT_PROCESS))
+        AllocConsole();
+
+    FILE* fp;
+    freopen_s(&fp, "CONOUT$", "w", stdout);
+    freopen_s(&fp, "CONOUT$", "w", stderr);
+}
+
+/*
+    No modo --headless stdin/stdout costumam vir redirecionados (pipe/arquivo):
+    esses ficam como estão e só os que não foram redirecionados vão para o
+    console de quem chamou. Os handles são lidos antes do AttachConsole.
+*/
+static void InitHeadlessConsole(void)
+{
+    bool hasIn  = GetStdHandle(STD_INPUT_HANDLE)  != nullptr && GetStdHandle(STD_INPUT_HANDLE)  != INVALID_HANDLE_VALUE;
+    bool hasOut = GetStdHandle(STD_OUTPUT_HANDLE) != nullptr && GetStdHandle(STD_OUTPUT_HANDLE) != INVALID_HANDLE_VALUE;
+    bool hasErr = GetStdHandle(STD_ERROR_HANDLE)  != nullptr && GetStdHandle(STD_ERROR_HANDLE)  != INVALID_HANDLE_VALUE;
+    if (hasIn && hasOut && hasErr)
+        return;
+
+    if (!AttachConsole(ATTACH_PARENT_PROCESS))
+        AllocConsole();
+
+    FILE* fp;
+    if (!hasIn)  freopen_s(&fp, "CONIN$", "r", stdin);
+    if (!hasOut) freopen_s(&fp, "CONOUT$", "w", stdout);
+    if (!hasErr) freopen_s(&fp, "CONOUT$", "w", stderr);
+}
+
 
 // ============================================================================
 //                        Utils de encoding UTF-8 <-> UTF-16
@@ -127,7 +366,7 @@ static void InitDebugConsole(void)
 //             trocam bytes "crus" (texto ASCII/UTF-8). Aqui padronizamos:
 //
 //  - No ENVIO:   wide (UI) -> UTF-8 (bytes) -> WriteFile
-//  - Na LEITURA: bytes -> tentamos decodificar como UTF-8 -> wide (UI)
+//  - Na LEITURA: bytes -> Utf8Decoder (incremental, ver Utf8Decoder.h) -> wide (UI)
 //                Se não for texto válido, mostramos em HEX.
 
 static std::string WideToUtf8(const std::wstring& w) {
@@ -140,204 +379,353 @@ static std::string WideToUtf8(const std::wstring& w) {
     return out;
 }
 
-static std::wstring Utf8ToWide(const char* data, int bytes) {
-    if (bytes <= 0) return {};
-    // Decodifica exatamente 'bytes' recebidos (não usamos -1):
-    int wlen = MultiByteToWideChar(CP_UTF8, 0, data, bytes, nullptr, 0);
-    std::wstring w(wlen, 0);
-    MultiByteToWideChar(CP_UTF8, 0, data, bytes, &w[0], wlen);
-    return w;
+// Para textos curtos vindos do backend (mensagens de erro, nomes de porta).
+// O RX NÃO passa por aqui: usa o Utf8Decoder incremental.
+static std::wstring Utf8ToWide(const std::string& s) {
+    if (s.empty()) return {};
+    int len = MultiByteToWideChar(CP_UTF8, 0, s.c_str(), (int)s.size(), nullptr, 0);
+    std::wstring out(len, 0);
+    MultiByteToWideChar(CP_UTF8, 0, s.c_str(), (int)s.size(), &out[0], len);
+    return out;
 }
 
 // ============================================================================
 //                                UI helpers
 // ============================================================================
 
+static void AppendToTab(PortTab* tab, const std::wstring& text) {
+    // Acrescenta no histórico da aba (O(1), não depende do tamanho do log) e
+    // só agenda a repintura da view; o desenho sai no próximo WM_PAINT.
+    tab->log.Append(text);
+    if (filterOn && tab->filterGeneration == searchGeneration && !searchMatcher.Empty()) ExtendFilter(tab);
+    TerminalViewContentChanged(tab->hView);
+}
+
+// Mensagens gerais (erros de diálogo, avisos): vão para a aba ativa.
 void AppendToTerminal(const std::wstring& text) {
-    // Acrescenta no fim do EDIT multi-line (read-only) sem apagar conteúdo.
-    int len = GetWindowTextLength(hTerminal);
-    SendMessage(hTerminal, EM_SETSEL, len, len);
-    // EM_REPLACESEL aceita texto wide diretamente.
-    SendMessage(hTerminal, EM_REPLACESEL, FALSE, (LPARAM)text.c_str());
+    if (activeTab) AppendToTab(activeTab, text);
 }
 
 // ============================================================================
-//                        Configuração/Timeouts da Serial
+//                         Abas (uma sessão por porta)
 // ============================================================================
-static void SetupSerialTimeouts_BlockingOnChars(HANDLE h) {
-    // Modelo de leitura: "quase bloqueante" com timeout curto.
-    // - Se há bytes chegando, ReadFile retorna rapidamente.
-    // - Se não há, devolve após ~50ms, permitindo a thread checar flags/fechamento.
-    COMMTIMEOUTS t = {};
-    t.ReadIntervalTimeout = 1;    // tolera intervalos pequenos entre bytes
-    t.ReadTotalTimeoutMultiplier = 0;    // sem multiplicador por byte
-    t.ReadTotalTimeoutConstant = 50;   // timeout total por chamada (ms)
-    t.WriteTotalTimeoutMultiplier = 0;
-    t.WriteTotalTimeoutConstant = 100;  // timeout de escrita conservador
-    SetCommTimeouts(h, &t);
-}
-
-static bool ConfigurePort(HANDLE h, DWORD baud) {
-    // Sugere buffers internos do driver (entrada/saída):
-    SetupComm(h, 4096, 4096);
-
-    // Limpa buffers e aborta I/O pendente para começar "do zero":
-    PurgeComm(h, PURGE_RXCLEAR | PURGE_TXCLEAR | PURGE_RXABORT | PURGE_TXABORT);
-
-    // Carrega configuração atual, para então ajustar:
-    DCB dcb = {};
-    dcb.DCBlength = sizeof(DCB);
-    if (!GetCommState(h, &dcb)) return false;
-
-    // Parâmetros clássicos 8N1 a 'baud':
-    dcb.BaudRate = baud;
-    dcb.fBinary = TRUE;       // obrigatório
-    dcb.fParity = FALSE;      // sem bit de paridade
-    dcb.ByteSize = 8;
-    dcb.Parity = NOPARITY;
-    dcb.StopBits = ONESTOPBIT;
-
-    // Handshake desativado por padrão (CTS/DSR/XON/XOFF):
-    // Se precisar (ex.: modem/rádio), habilite conforme o hardware.
-    dcb.fOutxCtsFlow = FALSE;
-    dcb.fOutxDsrFlow = FALSE;
-    dcb.fOutX = FALSE;
-    dcb.fInX = FALSE;
-
-    // MUITOS adaptadores/boards só transmitem com DTR/RTS ativos:
-    dcb.fDtrControl = DTR_CONTROL_ENABLE;
-    dcb.fRtsControl = RTS_CONTROL_ENABLE;
-
-    if (!SetCommState(h, &dcb)) return false;
-
-    // Define timeouts de I/O:
-    SetupSerialTimeouts_BlockingOnChars(h);
-
-    // Garante linhas DTR/RTS em nível alto (redundante ao SetCommState, mas seguro):
-    EscapeCommFunction(h, SETDTR);
-    EscapeCommFunction(h, SETRTS);
 
-    return true;
+static PortTab* FindTab(uint32_t id) {
+    for (auto& t : tabs)
+        if (t->id == id) return t.get();
+    return nullptr;   // aviso atrasado de uma aba que já não existe
 }
 
-// ============================================================================
-//                              Thread de Leitura
-// ============================================================================
-// Lê blocos do driver serial, tenta decodificar como UTF-8 e joga no terminal.
-// Se os bytes não formarem texto UTF-8 válido, exibe em HEX (debug útil p/ binário).
-void SerialReadLoop() {
-    const DWORD BUF = 1024;
-    char  buffer[BUF];
-    DWORD bytesRead = 0;
-
-    while (isReceiving && hSerial != INVALID_HANDLE_VALUE) {
-        // ReadFile retorna imediatamente se houver dados, ou após ~50ms se não houver.
-        if (ReadFile(hSerial, buffer, BUF, &bytesRead, nullptr)) {
-            if (bytesRead > 0) {
-                // Tenta decodificar exatamente 'bytesRead' como UTF-8:
-                std::wstring w = Utf8ToWide(buffer, (int)bytesRead);
-                if (!w.empty()) {
-                    // Mostra como texto (sem forçar CRLF: respeita o que veio do device)
-                    AppendToTerminal(L"[RX] " + w);
-                }
-                else {
-                    // UTF-8 inválido: mostra payload em HEX (ex.: dados binários/frames)
-                    std::wstringstream ss;
-                    ss << L"[RX HEX] ";
-                    for (DWORD i = 0; i < bytesRead; ++i) {
-                        wchar_t tmp[8];
-                        StringCchPrintf(tmp, 8, L"%02X ", (unsigned char)buffer[i]);
-                        ss << tmp;
-                    }
-                    ss << L"\r\n";
-                    AppendToTerminal(ss.str());
-                }
+static PortTab* FindTabByPort(const std::wstring& portName) {
+    for (auto& t : tabs)
+        if (t->portName == portName) return t.get();
+    return nullptr;
+}
+
+static int TabIndex(PortTab* tab) {
+    for (size_t i = 0; i < tabs.size(); i++)
+        if (tabs[i].get() == tab) return (int)i;
+    return -1;
+}
+
+// Título da aba: porta (ou "Terminal" antes da primeira conexão); "*" = fechada.
+static void SetTabTitle(PortTab* tab) {
+    std::wstring title = tab->portName.empty() ? L"Terminal" : tab->portName;
+    if (!tab->portName.empty() && !(tab->session && tab->session->IsOpen())) title += L" *";
+
+    TCITEMW item = {};
+    item.mask = TCIF_TEXT;
+    item.pszText = &title[0];
+    SendMessageW(hTabs, TCM_SETITEMW, TabIndex(tab), (LPARAM)&item);
+}
+
+// Nova aba com a sua view, posicionada na área útil do tab control.
+static PortTab* CreateTab(const std::wstring& portName) {
+    std::unique_ptr<PortTab> tab(new PortTab());
+    tab->id = nextTabId++;
+    tab->portName = portName;
+
+    RECT rc;
+    GetWindowRect(hTabs, &rc);
+    MapWindowPoints(nullptr, hMainWnd, (POINT*)&rc, 2);
+    TabCtrl_AdjustRect(hTabs, FALSE, &rc);
+    tab->hView = CreateTerminalView(hMainWnd,
+        rc.left, rc.top, rc.right - rc.left, rc.bottom - rc.top,
+        ID_TERMINAL, &tab->log);
+    SetWindowPos(tab->hView, HWND_TOP, 0, 0, 0, 0, SWP_NOMOVE | SWP_NOSIZE);
+    ShowWindow(tab->hView, SW_HIDE);
+    tab->hPlot = CreateTelemetryView(hMainWnd,
+        rc.left, rc.top, rc.right - rc.left, rc.bottom - rc.top,
+        ID_TELEMETRY_VIEW, &tab->telemetry);
+    SetWindowPos(tab->hPlot, HWND_TOP, 0, 0, 0, 0, SWP_NOMOVE | SWP_NOSIZE);
+
+    TCITEMW item = {};
+    item.mask = TCIF_TEXT;
+    item.pszText = (LPWSTR)L"";
+    SendMessageW(hTabs, TCM_INSERTITEMW, tabs.size(), (LPARAM)&item);
+
+    PortTab* p = tab.get();
+    tabs.push_back(std::move(tab));
+    SetTabTitle(p);
+    return p;
+}
+
+// Mostra só a view da aba (texto ou gráfico) e alinha os controles com ela
+// (porta no combo, rótulos dos botões, estatísticas de TX no título).
+static void ActivateTab(PortTab* tab) {
+    activeTab = tab;
+    TabCtrl_SetCurSel(hTabs, TabIndex(tab));
+    for (auto& t : tabs) {
+        ShowWindow(t->hView, t.get() == tab && !plotOn ? SW_SHOW : SW_HIDE);
+        ShowWindow(t->hPlot, t.get() == tab && plotOn ? SW_SHOW : SW_HIDE);
+    }
+    if (plotOn) TelemetryViewContentChanged(tab->hPlot);
+
+    if (!tab->portName.empty()) {
+        int n = (int)SendMessage(hComboComPort, CB_GETCOUNT, 0, 0);
+        for (int i = 0; i < n; i++) {
+            wchar_t item[256] = {};
+            SendMessage(hComboComPort, CB_GETLBTEXT, i, (LPARAM)item);
+            if (wcsstr(item, (L"(" + tab->portName + L")").c_str()) || tab->portName == item) {
+                SendMessage(hComboComPort, CB_SETCURSEL, i, 0);
+                break;
             }
         }
-        else {
-            // Falha de leitura: pode ser fechamento (CancelIo) ou erro transitório.
-            DWORD err = GetLastError();
-            if (err == ERROR_OPERATION_ABORTED) break; // saímos ao fechar a porta
-            // Evita busy loop caso o driver esteja sinalizando erro repetidamente:
-            Sleep(5);
-        }
+    }
+    UpdateSessionButtons();
+    ShowStatus(tab);
+    ApplyFilter(tab);
+}
+
+// Extrai apenas "COMx" do friendly name do combo (ex.: "USB-Serial (COM6)").
+// Se o nome não tiver "(COMx)", usa a string inteira.
+static std::wstring SelectedPortName() {
+    wchar_t portName[100] = {};
+    GetWindowTextW(hComboComPort, portName, 100);
+
+    std::wstring portStr(portName);
+    size_t b = portStr.find(L"(COM");                 // posição do "(COM"
+    size_t e = portStr.find(L")", (b == std::wstring::npos ? 0 : b)); // fecha ")"
+    return (b != std::wstring::npos && e != std::wstring::npos && e > b)
+        ? portStr.substr(b + 1, e - (b + 1))          // remove parênteses
+        : portStr;
+}
+
+// Rótulos dependem da porta do combo (Conectar) e da aba ativa (Gravar,
+// Reproduzir): várias portas podem estar abertas ao mesmo tempo.
+static void UpdateSessionButtons() {
+    PortTab* sel = FindTabByPort(SelectedPortName());
+    bool selOpen = sel && sel->session && sel->session->IsOpen();
+    SetWindowTextW(hBtnConnect, selOpen ? L"Desconectar" : L"Conectar");
+
+    bool replaying = activeTab && activeTab->session && activeTab->session->Replay();
+    SetWindowTextW(hBtnReplay, replaying ? L"Parar" : L"Reproduzir");
+
+    bool capturing = activeTab && activeTab->session && activeTab->session->Capturing();
+    SetWindowTextW(hBtnCapture, capturing ? L"Parar gravação" : L"Gravar");
+
+    bool measuring = activeTab && activeTab->session && activeTab->session->RttRunning();
+    SetWindowTextW(hBtnRtt, measuring ? L"Parar" : L"RTT");
+
+    bool loading = activeTab && activeTab->session && activeTab->session->LoadRunning();
+    SetWindowTextW(hBtnLoad, loading ? L"Parar carga" : L"Carga...");
+
+    bool bridging = activeTab && activeTab->session && activeTab->session->BridgeRunning();
+    SetWindowTextW(hBtnBridge, bridging ? L"Parar TCP" : L"TCP");
+}
+
+// ============================================================================
+//                        Fila RX -> UI (drenagem em lote)
+// ============================================================================
+// A thread do reactor grava na fila da sessão e posta WM_APP_RX_READY (um
+// aviso pendente por sessão: rajadas viram UMA mensagem, não milhares).
+//
+// Limita a drenagem a ~1 vez por frame: se a última foi há pouco, agenda um
+// timer para o restante do intervalo em vez de repintar de novo agora.
+static void OnRxReady(HWND hwnd, PortTab* tab) {
+    if (tab->rxDrainTimerArmed) return;   // o timer já vai drenar
+
+    ULONGLONG now = GetTickCount64();
+    ULONGLONG elapsed = now - tab->lastRxDrainTick;
+    if (elapsed >= RX_DRAIN_INTERVAL_MS) {
+        DrainRxRing(hwnd, tab);
+    }
+    else {
+        SetTimer(hwnd, TabTimerId(tab, ID_TIMER_RX_DRAIN), (UINT)(RX_DRAIN_INTERVAL_MS - elapsed), nullptr);
+        tab->rxDrainTimerArmed = true;
+    }
+}
+
+// Uma linha (frame do LineFramer) vira "[RX] texto" no rxText. UTF-8
+// inválido: mostra a linha em HEX/ASCII (ex.: dados binários), formatada
+// direto no buffer reutilizado, com o offset da linha no stream RX.
+// Os campos "nome=valor" da linha também vão para a telemetria da aba.
+// Linha fechada por '\n' terminando no meio de uma sequência (ex.:
+// "abc\xC3\n") também é inválida: o '\n' não continua a sequência, e
+// deixar o byte no decodificador corromperia a linha seguinte. Só o trecho
+// parcial do FlushRxLine() ('partial') mantém a sequência pendente, porque
+// o resto dela pode chegar nos próximos bytes.
+static void AppendRxFrame(PortTab* tab, const FrameSpan& frame, uint64_t streamOffset, bool partial) {
+    tab->telemetry.FeedLine(frame.data, frame.len);
+    std::wstring& rxText = tab->rxText;
+    size_t mark = rxText.size();
+    rxText += L"[RX] ";
+    size_t invalid = tab->rxDecoder.Decode((const char*)frame.data, frame.len, rxText);
+    if (!partial && tab->rxDecoder.Pending() > 0) ++invalid;
+    if (invalid == 0) {
+        rxText += L"\r\n";
+        return;
+    }
+
+    tab->rxDecoder.Reset();
+    rxText.resize(mark);
+    rxText += L"[RX HEX]\r\n";
+    HexDumpOptions opt;
+    opt.bytesPerRow = RX_HEX_BYTES_PER_ROW;
+    opt.baseOffset = streamOffset;
+    size_t base = rxText.size();
+    rxText.resize(base + HexDumpBound(frame.len, opt));
+    rxText.resize(base + HexDumpFormat(frame.data, frame.len, &rxText[base], opt));
+}
+
+// Silêncio depois de uma linha incompleta (prompt, binário sem '\n'): mostra
+// o que está pendente no framer.
+static void FlushRxLine(PortTab* tab) {
+    KillTimer(hMainWnd, TabTimerId(tab, ID_TIMER_RX_LINE));
+    tab->rxText.clear();
+    tab->rxLineFramer.Flush([tab](FrameSpan f) { AppendRxFrame(tab, f, tab->rxLineFramer.FrameOffset(), true); });
+    if (!tab->rxText.empty()) AppendToTab(tab, tab->rxText);
+    TelemetryViewContentChanged(tab->hPlot);
+}
+
+// Consome a fila RX da sessão (na thread da UI), separa em linhas e faz UM
+// append na aba por lote. Os bytes são lidos direto dos blocos do reactor
+// (spans, ver ChunkPool.h): linhas partidas entre spans ou lotes ficam no
+// framer, as que cabem inteiras num span não são copiadas. O LineFramer não
+// escreve no bloco (só COBS/SLIP decodificam no lugar), então ler o bloco
+// compartilhado com a captura é seguro.
+static void DrainRxRing(HWND hwnd, PortTab* tab) {
+    tab->lastRxDrainTick = GetTickCount64();
+    if (!tab->session) return;
+    SerialSession& s = *tab->session;
+    int64_t arrivalNs = s.AckRxReady();
+
+    size_t bytes = 0;
+    RxSpan span;
+    tab->rxText.clear();
+    while (bytes < RX_DRAIN_MAX_BYTES && s.Rx().Pop(&span)) {
+        tab->rxLineFramer.Feed(const_cast<uint8_t*>(span.Data()), span.Size(), [tab](FrameSpan f) {
+            AppendRxFrame(tab, f, tab->rxLineFramer.FrameOffset(), false);
+        });
+        bytes += span.Size();
+    }
+    span.Reset();                             // o bloco volta ao pool já
+    if (bytes > 0) {
+        if (!tab->rxText.empty()) AppendToTab(tab, tab->rxText);
+        TelemetryViewContentChanged(tab->hPlot);   // só agenda repintura (se mudou)
+        s.RecordRxShown(arrivalNs);           // atraso RX -> tela (barra de status)
+
+        // Linha incompleta: aparece mesmo sem '\n' se o dispositivo silenciar
+        // (SetTimer de novo só reinicia a contagem).
+        if (tab->rxLineFramer.Pending() > 0) SetTimer(hwnd, TabTimerId(tab, ID_TIMER_RX_LINE), RX_LINE_FLUSH_MS, nullptr);
+        else KillTimer(hwnd, TabTimerId(tab, ID_TIMER_RX_LINE));
+    }
+
+    // Avisa se a fila transbordou desde o último lote:
+    uint64_t dropped = s.Rx().DroppedBytes();
+    if (dropped != tab->rxDroppedReported) {
+        AppendToTab(tab, L"\r\n[AVISO] Fila RX cheia: " + std::to_wstring(dropped - tab->rxDroppedReported) +
+            L" bytes descartados (" + std::to_wstring(s.Rx().OverflowEvents()) + L" eventos)\r\n");
+        tab->rxDroppedReported = dropped;
+    }
+
+    // Sobrou coisa (lote limitado)? Continua no próximo frame.
+    if (!s.Rx().Empty() && !tab->rxDrainTimerArmed) {
+        SetTimer(hwnd, TabTimerId(tab, ID_TIMER_RX_DRAIN), RX_DRAIN_INTERVAL_MS, nullptr);
+        tab->rxDrainTimerArmed = true;
     }
 }
 
 // ============================================================================
 //                       UI: Descoberta/Listagem de portas
 // ============================================================================
-// Percorre a classe de dispositivos "Ports (COM & LPT)" e joga os friendly names
-// no ComboBox (ex.: "USB-Serial (COM6)"). Isso facilita extrair "COMx" depois.
+// A lista vem do cache do 'portEnum' (thread própria, ver PortEnumerator.h):
+// preencher o combo não varre nada. Cada item é o friendly name (ex.:
+// "USB-Serial (COM6)") mais VID:PID/serial quando é USB, o que distingue
+// adaptadores iguais. SelectedPortName() extrai o "COMx" do "(COMx)".
 void ListComPorts(HWND hComboBox) {
     SendMessage(hComboBox, CB_RESETCONTENT, 0, 0);
-    printf("Vai listar as portas COM e LPT conectadas.\r\n");
-    HDEVINFO hDevInfo = SetupDiGetClassDevs(&GUID_DEVCLASS_PORTS, nullptr, nullptr, DIGCF_PRESENT);
-    if (hDevInfo == INVALID_HANDLE_VALUE) return;
-
-    SP_DEVINFO_DATA devInfoData = { sizeof(SP_DEVINFO_DATA) };
-    for (DWORD i = 0; SetupDiEnumDeviceInfo(hDevInfo, i, &devInfoData); i++) {
-        TCHAR buffer[256];
-        if (SetupDiGetDeviceRegistryProperty(hDevInfo, &devInfoData, SPDRP_FRIENDLYNAME,
-            nullptr, (PBYTE)buffer, sizeof(buffer), nullptr)) {
-            std::wstring name(buffer);
-            if (name.find(L"(COM") != std::wstring::npos) {
-                SendMessage(hComboBox, CB_ADDSTRING, 0, (LPARAM)name.c_str());
-            }
-        }
+    comboPorts = portEnum.Ports(&comboPortsGeneration);
+    for (const PortInfo& p : comboPorts) {
+        std::wstring name = Utf8ToWide(p.name);
+        std::wstring text = Utf8ToWide(p.description);
+        if (text.find(L"(" + name + L")") == std::wstring::npos)
+            text += L" (" + name + L")";
+        std::string usb = PortUsbIdText(p);
+        if (!usb.empty())
+            text += L"  [" + Utf8ToWide(usb) + L"]";
+        SendMessage(hComboBox, CB_ADDSTRING, 0, (LPARAM)text.c_str());
     }
-    SetupDiDestroyDeviceInfoList(hDevInfo);
+    for (const wchar_t* sim : kSimPortNames)
+        SendMessage(hComboBox, CB_ADDSTRING, 0, (LPARAM)sim);
 
     // Seleciona o primeiro item por padrão (se houver):
     SendMessage(hComboBox, CB_SETCURSEL, 0, 0);
 }
 
 void RefreshComPortsAndKeepSelection(HWND hComboBox) {
-    // guarda texto selecionado (se houver)
-    int sel = (int)SendMessage(hComboBox, CB_GETCURSEL, 0, 0);
-    std::wstring prev;
-    if (sel != CB_ERR) {
-        int len = (int)SendMessage(hComboBox, CB_GETLBTEXTLEN, sel, 0);
-        if (len > 0) {
-            prev.resize(len);
-            SendMessage(hComboBox, CB_GETLBTEXT, sel, (LPARAM)prev.data());
-        }
-    }
+    // guarda a porta selecionada (se houver): o texto do item pode mudar
+    std::wstring prev = SendMessage(hComboBox, CB_GETCURSEL, 0, 0) != CB_ERR ? SelectedPortName() : L"";
 
     // evita flicker enquanto repovoa
     SendMessage(hComboBox, WM_SETREDRAW, FALSE, 0);
     ListComPorts(hComboBox);
 
-    // tenta restaurar seleção anterior
-    if (!prev.empty()) {
-        int idx = (int)SendMessage(hComboBox, CB_FINDSTRINGEXACT, (WPARAM)-1, (LPARAM)prev.c_str());
-        if (idx != CB_ERR) {
-            SendMessage(hComboBox, CB_SETCURSEL, idx, 0);
-        }
-        else {
-            // se não achou, selecione o primeiro se existir
-            if (SendMessage(hComboBox, CB_GETCOUNT, 0, 0) > 0) {
-                SendMessage(hComboBox, CB_SETCURSEL, 0, 0);
-            }
+    // tenta restaurar seleção anterior (senão fica o primeiro, se existir)
+    bool restored = false;
+    for (size_t i = 0; !prev.empty() && i < comboPorts.size(); i++) {
+        if (Utf8ToWide(comboPorts[i].name) == prev) {
+            SendMessage(hComboBox, CB_SETCURSEL, (WPARAM)i, 0);
+            restored = true;
+            break;
         }
     }
-    else {
-        // sem seleção prévia: selecione o primeiro se existir
-        if (SendMessage(hComboBox, CB_GETCOUNT, 0, 0) > 0) {
-            SendMessage(hComboBox, CB_SETCURSEL, 0, 0);
-        }
+    if (!restored && !prev.empty()) {   // simulado: o item é o próprio nome
+        LRESULT i = SendMessageW(hComboBox, CB_FINDSTRINGEXACT, (WPARAM)-1, (LPARAM)prev.c_str());
+        if (i != CB_ERR) SendMessage(hComboBox, CB_SETCURSEL, (WPARAM)i, 0);
     }
 
     SendMessage(hComboBox, WM_SETREDRAW, TRUE, 0);
     InvalidateRect(hComboBox, nullptr, TRUE);
 }
 
+// Lista nova no cache (dispositivo entrou/saiu): avisa no terminal o que
+// mudou e repovoa o combo. A primeira lista (início do programa) só preenche.
+static void OnPortsChanged() {
+    if (comboPortsGeneration != 0) {
+        std::vector<PortInfo> now = portEnum.Ports();
+        auto has = [](const std::vector<PortInfo>& v, const std::string& name) {
+            return std::any_of(v.begin(), v.end(), [&](const PortInfo& p) { return p.name == name; });
+        };
+        for (const PortInfo& p : now)
+            if (!has(comboPorts, p.name))
+                AppendToTerminal(L"[INFO] Porta conectada: " + Utf8ToWide(p.description) + L"\r\n");
+        for (const PortInfo& p : comboPorts)
+            if (!has(now, p.name))
+                AppendToTerminal(L"[INFO] Porta removida: " + Utf8ToWide(p.description) + L"\r\n");
+    }
+    RefreshComPortsAndKeepSelection(hComboComPort);
+    UpdateSessionButtons();
+}
+
 
-// Preenche baud rates comuns (inclui alguns altos para adaptadores modernos).
+// Preenche baud rates comuns (inclui os altos de FTDI/CP210x: 1..12 Mbaud).
+// O combo é editável: qualquer valor numérico digitado também é aceito.
 void PopulateBaudRates(HWND hComboBox) {
     const std::vector<std::wstring> baudRates = {
         L"9600", L"19200", L"38400", L"57600",
-        L"115200", L"230400", L"460800", L"921600"
+        L"115200", L"230400", L"460800", L"921600",
+        L"1000000", L"1500000", L"2000000", L"3000000", L"12000000"
     };
     for (const auto& rate : baudRates)
         SendMessage(hComboBox, CB_ADDSTRING, 0, (LPARAM)rate.c_str());
@@ -346,86 +734,535 @@ void PopulateBaudRates(HWND hComboBox) {
     SendMessage(hComboBox, CB_SETCURSEL, 4, 0);
 }
 
-// Abre a porta (ex.: "COM6") com CreateFile e aplica configuração via DCB.
-// Observação: portas COM >= 10 exigem o prefixo "\\.\".
-bool OpenSerialPort(const std::wstring& portName, DWORD baudRate) {
-    std::wstring full = L"\\\\.\\" + portName; // COM10+ requer \\.\ prefixo
+// ============================================================================
+//                      Fila TX -> UI (conclusões em lote)
+// ============================================================================
+// A thread de escrita da sessão guarda os resultados e posta WM_APP_TX_DONE
+// (um aviso por rajada, como no RX). Aqui: loga as mensagens concluídas
+// ("[TX]" ou "[ERRO TX]") com UM append.
+static void HandleTxDone(PortTab* tab) {
+    if (!tab->session) return;
+    static std::vector<TxResult> done;
+    tab->session->TakeTxResults(done);
+
+    std::wstring out;
+    for (const TxResult& r : done) {
+        // Conclusões chegam na ordem de envio; descarta entradas órfãs.
+        while (!tab->txPending.empty() && tab->txPending.front().id < r.id) tab->txPending.pop_front();
+        if (tab->txPending.empty() || tab->txPending.front().id != r.id) continue;
+
+        out += r.ok ? L"[TX] " : L"[ERRO TX] ";
+        out += tab->txPending.front().text;
+        out += L"\r\n";
+        tab->txPending.pop_front();
+    }
+    if (!out.empty()) AppendToTab(tab, out);
+}
 
-    hSerial = CreateFileW(full.c_str(),
-        GENERIC_READ | GENERIC_WRITE,   // leitura e escrita
-        0,                              // sem compartilhamento
-        nullptr, OPEN_EXISTING,
-        FILE_ATTRIBUTE_NORMAL, nullptr);
-    if (hSerial == INVALID_HANDLE_VALUE) return false;
+// ============================================================================
+//                     Métricas (barra de status + export)
+// ============================================================================
+// "12.3k" / "1.20M": cabe na barra de status estreita.
+static std::wstring FormatRate(double v) {
+    wchar_t buf[32];
+    if (v < 1000) StringCchPrintfW(buf, 32, L"%.0f", v);
+    else if (v < 1e6) StringCchPrintfW(buf, 32, L"%.1fk", v / 1e3);
+    else StringCchPrintfW(buf, 32, L"%.2fM", v / 1e6);
+    return buf;
+}
 
-    if (!ConfigurePort(hSerial, baudRate)) {
-        CloseHandle(hSerial);
-        hSerial = INVALID_HANDLE_VALUE;
-        return false;
+static std::wstring FormatMicros(uint64_t us) {
+    wchar_t buf[32];
+    if (us < 1000) StringCchPrintfW(buf, 32, L"%llu us", (unsigned long long)us);
+    else StringCchPrintfW(buf, 32, L"%llu ms", (unsigned long long)(us / 1000));
+    return buf;
+}
+
+// Último intervalo da aba ativa: vazão | leitura p50 e RX->tela p99 | filas e erros.
+// O detalhe completo (percentis, erros por tipo) vai para o export JSON.
+static void ShowStatus(PortTab* tab) {
+    if (!tab || !tab->session || !tab->session->IsOpen()) {
+        SendMessageW(hStatus, SB_SETTEXTW, 0, (LPARAM)L"Desconectado");
+        SendMessageW(hStatus, SB_SETTEXTW, 1, (LPARAM)L"");
+        SendMessageW(hStatus, SB_SETTEXTW, 2, (LPARAM)L"");
+        return;
     }
+    const MetricsSample& m = tab->lastSample;
+    std::wstring rate = L"RX " + FormatRate(m.rxBytesPerSec) + L" TX " + FormatRate(m.txBytesPerSec) + L" B/s";
+    std::wstring lat = L"leit. " + std::to_wstring(m.readP50) + L" B | tela " + FormatMicros(m.screenP99Us);
+    uint64_t errors = m.errors.overrun + m.errors.parity + m.errors.framing + m.errors.bufferFull + m.errors.breaks;
+    std::wstring queues = L"fila " + FormatRate((double)m.rxQueued) + L"/" + std::to_wstring(m.txQueuedMessages) +
+        L" | erros " + std::to_wstring(errors);
+    SendMessageW(hStatus, SB_SETTEXTW, 0, (LPARAM)rate.c_str());
+    SendMessageW(hStatus, SB_SETTEXTW, 1, (LPARAM)lat.c_str());
+    SendMessageW(hStatus, SB_SETTEXTW, 2, (LPARAM)queues.c_str());
+}
 
-    // Marca estado e inicia thread de recepção:
-    isConnected = true;
-    isReceiving = true;
-    serialThread = std::thread(SerialReadLoop);
-    return true;
+// 1x por segundo: amostra TODAS as sessões (as taxas ficam certas ao trocar
+// de aba), exporta as abertas e mostra a ativa. Erros de linha novos também
+// aparecem no terminal da aba, para não passarem despercebidos.
+static void UpdateMetrics() {
+    for (auto& t : tabs) {
+        if (!t->session) continue;
+        PortMetricsSnapshot cur = t->session->MetricsNow();
+        bool first = (t->lastMetrics.takenNs == 0);
+        if (!first) {
+            t->lastSample = MakeMetricsSample(WideToUtf8(t->portName), t->lastMetrics, cur);
+            if (metricsExport.Active() && t->session->IsOpen()) metricsExport.Write(t->lastSample);
+
+            const SerialErrorCounts& was = t->lastMetrics.errors;
+            const SerialErrorCounts& now = cur.errors;
+            if (now.overrun > was.overrun || now.parity > was.parity || now.framing > was.framing ||
+                now.bufferFull > was.bufferFull || now.breaks > was.breaks) {
+                wchar_t line[200];
+                StringCchPrintfW(line, 200,
+                    L"[AVISO] Erros de linha: overrun %llu, paridade %llu, framing %llu, buffer cheio %llu, break %llu\r\n",
+                    (unsigned long long)now.overrun, (unsigned long long)now.parity,
+                    (unsigned long long)now.framing, (unsigned long long)now.bufferFull,
+                    (unsigned long long)now.breaks);
+                AppendToTab(t.get(), line);
+            }
+        }
+        t->lastMetrics = cur;
+    }
+    ShowStatus(activeTab);
 }
 
+// --metrics=arquivo.jsonl (ou --metrics=- para o console): uma linha JSON por
+// porta por segundo (ver Metrics.h). Lido como UTF-16 para aceitar acentos.
+static std::string MetricsPathFromCommandLine() {
+    int argc = 0;
+    LPWSTR* argv = CommandLineToArgvW(GetCommandLineW(), &argc);
+    std::string path;
+    for (int i = 1; argv && i < argc; i++) {
+        if (wcsncmp(argv[i], L"--metrics=", 10) == 0) path = WideToUtf8(argv[i] + 10);
+    }
+    if (argv) LocalFree(argv);
+    return path;
+}
 
+// A sessão é criada no primeiro uso da aba (conectar, reproduzir ou gravar)
+// e reaproveitada nas reconexões.
+static SerialSession& EnsureSession(PortTab* tab) {
+    if (!tab->session)
+        tab->session.reset(new SerialSession(tab->id, &reactor, sessionEvents));
+    return *tab->session;
+}
 
+// Antes de (re)abrir: o que sobrou da conexão anterior aparece, e o pipeline
+// de RX da aba começa do zero (Open() zera a fila da sessão).
+static void PrepareTabForSession(PortTab* tab) {
+    if (tab->session) {
+        DrainRxRing(hMainWnd, tab);
+        FlushRxLine(tab);
+    }
+    EnsureSession(tab);
+    tab->rxDroppedReported = 0;
+    tab->rxDecoder.Reset();
+    tab->rxLineFramer.Reset();
+}
 
-// Fecha a porta com segurança:
-// - sinaliza a thread para parar (isReceiving=false)
-// - aborta ReadFile pendente (CancelIo)
-// - junta a thread (join)
-// - fecha handle
-void CloseSerialPort() {
-    isReceiving = false;
+// Abre a porta (ex.: "COM6") na sessão da aba pelo backend nativo: 8N1,
+// DTR/RTS ativos; a leitura passa a ser feita pelo reactor compartilhado.
+static bool OpenSerialPort(PortTab* tab, const std::wstring& portName, DWORD baudRate) {
+    SerialConfig cfg;
+    cfg.baudRate = baudRate;
+
+    PrepareTabForSession(tab);
+    // Leitura adaptativa: em baud alto o reactor lê em lotes de até 5 ms
+    // (abaixo dos 16 ms da drenagem da tela) e aumenta a fila do driver.
+    AdaptiveIoConfig adaptive;
+    adaptive.enabled = true;
+    tab->session->SetAdaptiveIo(adaptive);
+    bool ok = tab->session->Open(WideToUtf8(portName), cfg);
+    SetTabTitle(tab);
+    UpdateSessionButtons();
+    return ok;
+}
 
-    if (hSerial != INVALID_HANDLE_VALUE) {
-        CancelIo(hSerial); // faz ReadFile retornar com ERROR_OPERATION_ABORTED
+// Reproduz uma captura (.scap) pelo mesmo caminho da porta real, numa aba
+// "replay": os bytes RX gravados chegam como se viessem do dispositivo.
+static void StartReplay(HWND hwnd) {
+    wchar_t path[MAX_PATH] = L"";
+    OPENFILENAMEW ofn = {};
+    ofn.lStructSize = sizeof(ofn);
+    ofn.hwndOwner = hwnd;
+    ofn.lpstrFilter = L"Capturas seriais (*.scap)\0*.scap\0Todos os arquivos\0*.*\0";
+    ofn.lpstrFile = path;
+    ofn.nMaxFile = MAX_PATH;
+    ofn.Flags = OFN_FILEMUSTEXIST | OFN_PATHMUSTEXIST | OFN_NOCHANGEDIR;
+    if (!GetOpenFileNameW(&ofn)) return;
+
+    int choice = MessageBoxW(hwnd,
+        L"Reproduzir com o tempo original?\n\n"
+        L"Sim: tempo real (intervalos gravados)\n"
+        L"Não: velocidade máxima (mede a folga do RX)",
+        L"Reproduzir captura", MB_YESNOCANCEL | MB_ICONQUESTION);
+    if (choice == IDCANCEL) return;
+
+    // Reaproveita a aba "replay" (ou a aba inicial ainda sem porta):
+    PortTab* tab = FindTabByPort(L"replay");
+    if (!tab) tab = FindTabByPort(L"");
+    if (!tab) tab = CreateTab(L"replay");
+    tab->portName = L"replay";
+    ActivateTab(tab);
+
+    ReplayOptions opt;
+    opt.mode = (choice == IDYES) ? ReplayMode::RealTime : ReplayMode::MaxSpeed;
+    PrepareTabForSession(tab);
+    if (!tab->session->OpenReplay(WideToUtf8(path), opt)) {
+        AppendToTab(tab, L"[ERRO] Falha ao abrir captura: " + Utf8ToWide(tab->session->LastError()) + L"\r\n");
+        SetTabTitle(tab);
+        return;
     }
-    if (serialThread.joinable())
-        serialThread.join();
 
-    if (isConnected && hSerial != INVALID_HANDLE_VALUE) {
-        CloseHandle(hSerial);
-        hSerial = INVALID_HANDLE_VALUE;
-    }
-    isConnected = false;
+    SetTabTitle(tab);
+    UpdateSessionButtons();
+    AppendToTab(tab, L"[OK] Reproduzindo " + std::wstring(path) +
+        (opt.mode == ReplayMode::RealTime ? L" (tempo real)\r\n" : L" (velocidade máxima)\r\n"));
+}
+
+// Fim da captura: resumo (vazão e atraso do agendamento) e fecha a sessão.
+static void FinishReplay(PortTab* tab) {
+    while (!tab->session->Rx().Empty()) DrainRxRing(hMainWnd, tab);   // o resto aparece antes do resumo
+    FlushRxLine(tab);
+    ReplayStats s = tab->session->Replay()->Stats();
+    CloseSerialPort(tab);
+
+    double secs = s.elapsedNs / 1e9;
+    wchar_t line[256];
+    StringCchPrintfW(line, 256,
+        L"[INFO] Reprodução concluída: %llu bytes em %.3f s (%.2f MB/s), atraso máx %.0f us, médio %.0f us\r\n",
+        (unsigned long long)s.bytes, secs, secs > 0 ? s.bytes / secs / 1e6 : 0.0,
+        s.lateMaxNs / 1e3, s.chunks ? s.lateSumNs / 1e3 / s.chunks : 0.0);
+    AppendToTab(tab, line);
+}
+
+
+
+
+// Fecha a porta da aba com segurança (ver SerialSession::Close()):
+// - para a thread de escrita (pendentes viram "[ERRO TX]")
+// - tira a porta do reactor (síncrono: nenhum byte chega depois)
+// - só então fecha a porta
+// A aba e o histórico ficam (reconectar reaproveita a mesma aba).
+static void CloseSerialPort(PortTab* tab) {
+    if (!tab->session) return;
+    bool measuring = tab->session->RttRunning();
+    bool loading = tab->session->LoadRunning();
+    tab->session->Close();
+    if (measuring)
+        AppendToTab(tab, Utf8ToWide(RttReportToText(tab->session->RttResult())) + L"\r\n");
+    if (loading)
+        AppendToTab(tab, LoadReportText(tab->session->LoadResult()));
+    SetTabTitle(tab);
+    UpdateSessionButtons();
+    ShowStatus(activeTab);
 }
 
-// Envia o conteúdo de uma das caixas de texto.
-// Fluxo: wide (UI) -> UTF-8 (bytes) -> WriteFile.
+// Texto da caixa de envio marcada no rádio.
+static std::wstring SelectedSendText() {
+    wchar_t buf1[1024] = {}, buf2[1024] = {};
+    GetWindowTextW(hEditSend1, buf1, 1024);
+    GetWindowTextW(hEditSend2, buf2, 1024);
+    return (SendMessage(hRadioSend1, BM_GETCHECK, 0, 0) == BST_CHECKED) ? buf1 : buf2;
+}
+
+// Envia o conteúdo de uma das caixas de texto para a porta da aba ativa.
+// Fluxo: wide (UI) -> UTF-8 (bytes) -> TxQueue (não bloqueia a UI).
+// O "[TX]" só aparece quando a escrita conclui (WM_APP_TX_DONE).
 // Opcionalmente, pode-se anexar "\r\n" se o dispositivo exigir ENTER.
 void SendSelectedMessage() {
-    if (!isConnected) {
+    if (!activeTab || !activeTab->session || !activeTab->session->IsOpen()) {
         MessageBox(nullptr, L"Conecte-se a uma porta COM primeiro.", L"Erro", MB_OK | MB_ICONERROR);
         return;
     }
 
-    // Captura o texto das caixas:
-    wchar_t buf1[1024] = {}, buf2[1024] = {};
-    GetWindowTextW(hEditSend1, buf1, 1024);
-    GetWindowTextW(hEditSend2, buf2, 1024);
-
-    // Qual caixa usar?
-    std::wstring wmsg = (SendMessage(hRadioSend1, BM_GETCHECK, 0, 0) == BST_CHECKED) ? buf1 : buf2;
+    std::wstring wmsg = SelectedSendText();
 
     // (Opcional) Se quiser garantir quebra de linha no device:
     // wmsg += L"\r\n";
 
-    // Converte para UTF-8 e envia:
+    // Converte para UTF-8 e enfileira; fila cheia = dispositivo não está
+    // consumindo (flow control/parado): avisa em vez de travar.
     std::string bytes = WideToUtf8(wmsg);
-    DWORD written = 0;
-    if (WriteFile(hSerial, bytes.data(), (DWORD)bytes.size(), &written, nullptr)) {
-        AppendToTerminal(L"[TX] " + wmsg + L"\r\n");
+    uint64_t id = activeTab->session->Send(bytes.data(), bytes.size());
+    if (id != 0) {
+        activeTab->txPending.push_back(TxPending{ id, wmsg });
+    }
+    else {
+        AppendToTab(activeTab, L"[ERRO TX] Fila de envio cheia: " + wmsg + L"\r\n");
+    }
+}
+
+
+
+
+// Liga/desliga a captura binária da aba ativa. Ao ligar, pergunta onde
+// salvar; pode ser ligada antes ou depois de conectar.
+static void ToggleCapture(HWND hwnd) {
+    if (!activeTab) return;
+    SerialSession& session = EnsureSession(activeTab);
+
+    if (session.Capturing()) {
+        std::string error;
+        CaptureStats s = session.StopCapture(&error);
+        UpdateSessionButtons();
+
+        wchar_t line[200];
+        StringCchPrintfW(line, 200, L"[INFO] Captura salva: %llu blocos, %llu bytes (%llu descartados)\r\n",
+            (unsigned long long)s.records, (unsigned long long)s.bytes, (unsigned long long)s.droppedRecords);
+        AppendToTab(activeTab, line);
+        if (!error.empty())
+            AppendToTab(activeTab, L"[ERRO] " + Utf8ToWide(error) + L"\r\n");
+        return;
+    }
+
+    wchar_t path[MAX_PATH] = L"captura.scap";
+    OPENFILENAMEW ofn = {};
+    ofn.lStructSize = sizeof(ofn);
+    ofn.hwndOwner = hwnd;
+    ofn.lpstrFilter = L"Capturas seriais (*.scap)\0*.scap\0Todos os arquivos\0*.*\0";
+    ofn.lpstrFile = path;
+    ofn.nMaxFile = MAX_PATH;
+    ofn.lpstrDefExt = L"scap";
+    ofn.Flags = OFN_OVERWRITEPROMPT | OFN_PATHMUSTEXIST | OFN_NOCHANGEDIR;
+    if (!GetSaveFileNameW(&ofn)) return;
+
+    std::string error;
+    if (session.StartCapture(WideToUtf8(path), &error)) {
+        UpdateSessionButtons();
+        AppendToTab(activeTab, L"[INFO] Gravando captura em " + std::wstring(path) + L"\r\n");
     }
     else {
-        AppendToTerminal(L"[ERRO TX]\r\n");
+        AppendToTab(activeTab, L"[ERRO] " + Utf8ToWide(error) + L"\r\n");
     }
 }
 
+// Liga/desliga a medição de ida e volta na porta da aba ativa. O payload é a
+// caixa de envio marcada; o resto vem da janela de RTT.
+static void ToggleRtt(HWND hwnd) {
+    if (!activeTab || !activeTab->session || !activeTab->session->IsOpen()) {
+        AppendToTerminal(L"[ERRO] Conecte a porta antes de medir o RTT.\r\n");
+        return;
+    }
+    SerialSession& session = *activeTab->session;
+
+    if (session.RttRunning()) {
+        session.StopRtt();
+        UpdateSessionButtons();
+        AppendToTab(activeTab, Utf8ToWide(RttReportToText(session.RttResult())) + L"\r\n");
+        return;
+    }
+
+    std::string payload = WideToUtf8(SelectedSendText());
+    if (payload.empty()) {
+        AppendToTab(activeTab, L"[ERRO] A caixa de envio está vazia.\r\n");
+        return;
+    }
+    if (!ShowRttDialog(hwnd, &rttSettings)) return;
+
+    RttConfig cfg = rttSettings.cfg;
+    cfg.payload = payload;
+    if (rttSettings.appendCrLf) cfg.payload += "\r\n";
+
+    std::string error;
+    if (!session.StartRtt(cfg, &error)) {
+        AppendToTab(activeTab, L"[ERRO] " + Utf8ToWide(error) + L"\r\n");
+        return;
+    }
+    UpdateSessionButtons();
+
+    wchar_t line[200];
+    StringCchPrintfW(line, 200, L"[RTT] Medindo %u trocas a cada %u ms (timeout %u ms)...\r\n",
+        cfg.count, cfg.intervalMs, cfg.timeoutMs);
+    AppendToTab(activeTab, line);
+}
+
+// Relatório do TxScheduler com as quebras de linha do terminal.
+static std::wstring LoadReportText(const TxScheduleReport& r) {
+    std::wstring text;
+    for (wchar_t c : Utf8ToWide(TxScheduleReportToText(r))) {
+        if (c == L'\n') text += L'\r';
+        text += c;
+    }
+    return text + L"\r\n";
+}
+
+// Liga/desliga o gerador de carga na porta da aba ativa. O plano (fluxos
+// periódicos + roteiro) vem da janela de carga; os envios passam pela mesma
+// TxQueue do "Enviar", mas não geram "[TX]" por mensagem (só o relatório).
+static void ToggleLoad(HWND hwnd) {
+    if (!activeTab || !activeTab->session || !activeTab->session->IsOpen()) {
+        AppendToTerminal(L"[ERRO] Conecte a porta antes de gerar carga.\r\n");
+        return;
+    }
+    SerialSession& session = *activeTab->session;
+
+    if (session.LoadRunning()) {
+        session.StopLoad();
+        UpdateSessionButtons();
+        AppendToTab(activeTab, LoadReportText(session.LoadResult()));
+        return;
+    }
+
+    TxPlan plan;
+    if (!ShowLoadDialog(hwnd, &loadPlanText, &plan)) return;
+
+    std::string error;
+    if (!session.StartLoad(plan, &error)) {
+        AppendToTab(activeTab, L"[ERRO] " + Utf8ToWide(error) + L"\r\n");
+        return;
+    }
+    UpdateSessionButtons();
+
+    wchar_t line[200];
+    StringCchPrintfW(line, 200, L"[CARGA] %u fluxos, roteiro de %u passos...\r\n",
+        (unsigned)plan.streams.size(), (unsigned)plan.script.size());
+    AppendToTab(activeTab, line);
+}
+
+// Liga/desliga a ponte TCP da aba ativa: bytes crus em 127.0.0.1:7000 (aba
+// 1, +2 por aba) e RFC 2217 na porta seguinte. Pode ser ligada antes de
+// conectar; os clientes continuam conectados entre reconexões.
+static void ToggleBridge() {
+    if (!activeTab) return;
+    SerialSession& session = EnsureSession(activeTab);
+
+    if (session.BridgeRunning()) {
+        BridgeStats s = session.BridgeStatsNow();
+        session.StopBridge();
+        UpdateSessionButtons();
+
+        wchar_t line[200];
+        StringCchPrintfW(line, 200, L"[INFO] Ponte TCP parada: %llu clientes, %llu bytes enviados (%llu descartados)\r\n",
+            (unsigned long long)s.accepted, (unsigned long long)s.sentBytes, (unsigned long long)s.droppedBytes);
+        AppendToTab(activeTab, line);
+        return;
+    }
+
+    BridgeConfig cfg;
+    cfg.rawPort = BRIDGE_BASE_PORT + 2 * (int)(activeTab->id - 1);
+    cfg.rfc2217Port = cfg.rawPort + 1;
+    std::string error;
+    if (!session.StartBridge(cfg, &error)) {
+        AppendToTab(activeTab, L"[ERRO] Ponte TCP: " + Utf8ToWide(error) + L"\r\n");
+        return;
+    }
+    UpdateSessionButtons();
+
+    wchar_t line[200];
+    StringCchPrintfW(line, 200, L"[INFO] Ponte TCP em %s:%d (bytes crus) e :%d (RFC 2217)\r\n",
+        Utf8ToWide(cfg.bindAddress).c_str(), session.BridgePort(BridgeProtocol::Raw), session.BridgePort(BridgeProtocol::Rfc2217));
+    AppendToTab(activeTab, line);
+}
+
+// ============================================================================
+//                      Busca e filtro no histórico da aba
+// ============================================================================
+// Cada aba tem um ScrollbackIndex que o timer ID_TIMER_SEARCH_INDEX alimenta
+// em fatias (a thread do reactor não participa). A busca incremental anda a
+// partir do resultado atual a cada tecla; "Próx." continua depois dele e dá
+// a volta no fim. O filtro mostra só as linhas que casam e segue as novas.
+
+static void ShowSearchStatus(const wchar_t* text) {
+    SendMessageW(hStatus, SB_SETTEXTW, 3, (LPARAM)text);
+}
+
+// Lê a barra de busca e recompila a consulta. false = regex inválida.
+static bool ReadSearchQuery() {
+    wchar_t text[512] = {};
+    GetWindowTextW(hEditSearch, text, 512);
+
+    SearchQuery q;
+    q.text = text;
+    q.regex = (SendMessage(hCheckSearchRegex, BM_GETCHECK, 0, 0) == BST_CHECKED);
+    int dir = (int)SendMessage(hComboSearchDir, CB_GETCURSEL, 0, 0);
+    q.dir = (dir == 1) ? SearchDir::Rx : (dir == 2) ? SearchDir::Tx : SearchDir::Any;
+
+    ++searchGeneration;
+    std::string error;
+    if (!searchMatcher.Compile(q, &error)) {
+        searchMatcher.Clear();
+        ShowSearchStatus(L"Regex inválida");
+        return false;
+    }
+    return true;
+}
+
+// 'next' = depois do resultado atual; senão a partir dele (busca incremental).
+static void FindInTab(PortTab* tab, bool next) {
+    if (searchMatcher.Empty()) {
+        tab->searchHit = UINT64_MAX;
+        TerminalViewShowLine(tab->hView, UINT64_MAX);
+        ShowSearchStatus(L"");
+        return;
+    }
+
+    uint64_t first = tab->log.FirstLine();
+    uint64_t from = (tab->searchHit == UINT64_MAX) ? first : tab->searchHit + (next ? 1 : 0);
+    int64_t t0 = PreciseTimer::NowNs();
+    uint64_t line = 0;
+    bool found = tab->index.Find(searchMatcher, from, true, &line) ||
+                 (from > first && tab->index.Find(searchMatcher, first, true, &line));
+    double ms = (PreciseTimer::NowNs() - t0) / 1e6;
+
+    wchar_t status[64];
+    if (found) {
+        tab->searchHit = line;
+        StringCchPrintfW(status, 64, L"#%llu %.1f ms", (unsigned long long)line + 1, ms);
+    }
+    else {
+        tab->searchHit = UINT64_MAX;
+        StringCchPrintfW(status, 64, L"Nada %.1f ms", ms);
+        if (next) MessageBeep(MB_OK);
+    }
+    TerminalViewShowLine(tab->hView, tab->searchHit);
+    ShowSearchStatus(status);
+}
+
+// Linhas fechadas novas que casam entram no filtro; as que a retenção
+// descartou saem. A linha aberta entra quando fechar.
+static void ExtendFilter(PortTab* tab) {
+    uint64_t closedEnd = tab->log.EndLine() - 1;
+    if (tab->filterScanned < closedEnd) {
+        tab->index.FindAll(searchMatcher, tab->filterScanned, closedEnd, &tab->filterLines);
+        tab->filterScanned = closedEnd;
+    }
+    std::vector<uint64_t>& f = tab->filterLines;
+    if (!f.empty() && f.front() < tab->log.FirstLine())
+        f.erase(f.begin(), std::lower_bound(f.begin(), f.end(), tab->log.FirstLine()));
+}
+
+// Liga/atualiza o filtro da view da aba com a consulta atual, ou desliga.
+static void ApplyFilter(PortTab* tab) {
+    if (!filterOn || searchMatcher.Empty()) {
+        TerminalViewSetFilter(tab->hView, nullptr);
+        return;
+    }
+    if (tab->filterGeneration != searchGeneration) {
+        tab->filterLines.clear();
+        tab->filterScanned = tab->log.FirstLine();
+        tab->filterGeneration = searchGeneration;
+    }
+
+    int64_t t0 = PreciseTimer::NowNs();
+    ExtendFilter(tab);
+    double ms = (PreciseTimer::NowNs() - t0) / 1e6;
+    TerminalViewSetFilter(tab->hView, &tab->filterLines);
+    TerminalViewContentChanged(tab->hView);
+
+    wchar_t status[64];
+    StringCchPrintfW(status, 64, L"%zu lin. %.1f ms", tab->filterLines.size(), ms);
+    ShowSearchStatus(status);
+}
+
+static void OnSearchChanged() {
+    if (!activeTab || !ReadSearchQuery()) return;
+    if (filterOn) ApplyFilter(activeTab);
+    else FindInTab(activeTab, false);
+}
+
 
 
 
@@ -442,6 +1279,7 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
         // Momento ideal para criar CONTROLES FILHOS (botões, edits, combos, etc.).
         // ------------------------------------------------------------------------
     case WM_CREATE:
+        hMainWnd = hwnd;
 
         // ---- Criação dos controles (COMBOBOX de portas COM) ----
         // - WS_CHILD | WS_VISIBLE  -> controle é filho da janela e visível.
@@ -450,14 +1288,24 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
         hComboComPort = CreateWindowW(
             L"COMBOBOX", nullptr,
             WS_CHILD | WS_VISIBLE | CBS_DROPDOWNLIST,
-            10, 10, 220, 200,                // posição e tamanho
+            10, 10, 165, 200,                // posição e tamanho
             hwnd, (HMENU)ID_COMBOBOX_COMPORT,// ID único do controle
             nullptr, nullptr);                // sem menu/extra data
 
+        // ---- Botão "TCP": ponte da aba ativa para clientes locais ----
+        // Outros programas leem a mesma porta por TCP (ver TcpBridge.h).
+        hBtnBridge = CreateWindowW(
+            L"BUTTON", L"TCP",
+            WS_CHILD | WS_VISIBLE,
+            180, 9, 55, 24,
+            hwnd, (HMENU)ID_BTN_BRIDGE,
+            nullptr, nullptr);
+
         // ---- COMBOBOX de baud rates ----
+        // CBS_DROPDOWN (editável): aceita baud arbitrário digitado pelo usuário.
         hComboBaudRate = CreateWindowW(
             L"COMBOBOX", nullptr,
-            WS_CHILD | WS_VISIBLE | CBS_DROPDOWNLIST,
+            WS_CHILD | WS_VISIBLE | CBS_DROPDOWN,
             240, 10, 140, 200,
             hwnd, (HMENU)ID_COMBOBOX_BAUDRATE,
             nullptr, nullptr);
@@ -466,10 +1314,34 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
         hBtnConnect = CreateWindowW(
             L"BUTTON", L"Conectar",
             WS_CHILD | WS_VISIBLE,
-            10, 40, 100, 26,
+            10, 40, 90, 26,
             hwnd, (HMENU)ID_BTN_CONNECT,
             nullptr, nullptr);
 
+        // ---- Botão "Gravar" (captura binária com timestamps) ----
+        hBtnCapture = CreateWindowW(
+            L"BUTTON", L"Gravar",
+            WS_CHILD | WS_VISIBLE,
+            105, 40, 85, 26,
+            hwnd, (HMENU)ID_BTN_CAPTURE,
+            nullptr, nullptr);
+
+        // ---- Botão "Reproduzir" (captura como porta virtual) ----
+        hBtnReplay = CreateWindowW(
+            L"BUTTON", L"Reproduzir",
+            WS_CHILD | WS_VISIBLE,
+            195, 40, 95, 26,
+            hwnd, (HMENU)ID_BTN_REPLAY,
+            nullptr, nullptr);
+
+        // ---- Botão "Carga...": fluxos periódicos e roteiros de TX ----
+        hBtnLoad = CreateWindowW(
+            L"BUTTON", L"Carga...",
+            WS_CHILD | WS_VISIBLE,
+            295, 40, 85, 26,
+            hwnd, (HMENU)ID_BTN_LOAD,
+            nullptr, nullptr);
+
         // ---- Caixa de texto para envio 1 ----
         // WS_BORDER dá borda fina; é um EDIT de linha única (sem ES_MULTILINE).
         hEditSend1 = CreateWindowW(
@@ -493,7 +1365,7 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
         hRadioSend1 = CreateWindowW(
             L"BUTTON", L"Usar Caixa 1",
             WS_CHILD | WS_VISIBLE | BS_AUTORADIOBUTTON,
-            10, 105, 120, 20,
+            10, 105, 95, 20,
             hwnd, (HMENU)ID_RADIO_SEND1,
             nullptr, nullptr);
 
@@ -501,40 +1373,139 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
         hRadioSend2 = CreateWindowW(
             L"BUTTON", L"Usar Caixa 2",
             WS_CHILD | WS_VISIBLE | BS_AUTORADIOBUTTON,
-            140, 105, 120, 20,
+            108, 105, 95, 20,
             hwnd, (HMENU)ID_RADIO_SEND2,
             nullptr, nullptr);
 
         // Define a Caixa 1 como seleção inicial.
         SendMessage(hRadioSend1, BM_SETCHECK, BST_CHECKED, 0);
 
+        // ---- Botão "Gráfico"/"Texto": alterna a view das abas ----
+        // O gráfico mostra os campos "nome=valor" das linhas RX (Telemetry.h).
+        hBtnPlot = CreateWindowW(
+            L"BUTTON", L"Gráfico",
+            WS_CHILD | WS_VISIBLE,
+            208, 105, 67, 25,
+            hwnd, (HMENU)ID_BTN_PLOT,
+            nullptr, nullptr);
+
         // ---- Botão "Enviar" ----
         hBtnSend = CreateWindowW(
             L"BUTTON", L"Enviar",
             WS_CHILD | WS_VISIBLE,
-            280, 105, 100, 25,
+            280, 105, 50, 25,
             hwnd, (HMENU)ID_BTN_SEND,
             nullptr, nullptr);
 
-        // ---- Janela "terminal" (área de log) ----
-        // ES_MULTILINE   -> múltiplas linhas
-        // ES_AUTOVSCROLL -> rolagem automática conforme texto cresce
-        // ES_READONLY    -> usuário não edita (só leitura)
-        // WS_VSCROLL     -> mostra barra de rolagem vertical
-        hTerminal = CreateWindowW(
+        // ---- Botão "RTT": mede pedido -> resposta com a caixa marcada ----
+        hBtnRtt = CreateWindowW(
+            L"BUTTON", L"RTT",
+            WS_CHILD | WS_VISIBLE,
+            335, 105, 45, 25,
+            hwnd, (HMENU)ID_BTN_RTT,
+            nullptr, nullptr);
+
+        // ---- Barra de status: métricas da aba ativa (1x/s, ver UpdateMetrics) ----
+        // Vazão | tamanho de leitura e atraso RX -> tela | filas e erros de linha.
+        hStatus = CreateWindowW(
+            STATUSCLASSNAMEW, nullptr,
+            WS_CHILD | WS_VISIBLE,
+            0, 0, 0, 0,                      // a barra se posiciona sozinha (rodapé)
+            hwnd, (HMENU)ID_STATUS_BAR,
+            nullptr, nullptr);
+        {
+            int parts[4] = { 115, 215, 300, -1 };   // a última é da busca
+            SendMessage(hStatus, SB_SETPARTS, 4, (LPARAM)parts);
+        }
+
+        // ---- Busca no histórico da aba: texto/regex, RX/TX, filtro ----
+        hEditSearch = CreateWindowW(
             L"EDIT", nullptr,
-            WS_CHILD | WS_VISIBLE | WS_BORDER | WS_VSCROLL |
-            ES_MULTILINE | ES_AUTOVSCROLL | ES_READONLY,
-            10, 160, 370, 260,
-            hwnd, (HMENU)ID_TERMINAL,
+            WS_CHILD | WS_VISIBLE | WS_BORDER | ES_AUTOHSCROLL,
+            10, 160, 130, 22,
+            hwnd, (HMENU)ID_EDIT_SEARCH,
+            nullptr, nullptr);
+        SendMessageW(hEditSearch, EM_SETCUEBANNER, FALSE, (LPARAM)L"Buscar");
+
+        hComboSearchDir = CreateWindowW(
+            L"COMBOBOX", nullptr,
+            CBS_DROPDOWNLIST | WS_CHILD | WS_VISIBLE | WS_VSCROLL,
+            145, 160, 55, 100,
+            hwnd, (HMENU)ID_COMBO_SEARCH_DIR,
+            nullptr, nullptr);
+        SendMessageW(hComboSearchDir, CB_ADDSTRING, 0, (LPARAM)L"Tudo");
+        SendMessageW(hComboSearchDir, CB_ADDSTRING, 0, (LPARAM)L"RX");
+        SendMessageW(hComboSearchDir, CB_ADDSTRING, 0, (LPARAM)L"TX");
+        SendMessage(hComboSearchDir, CB_SETCURSEL, 0, 0);
+
+        hCheckSearchRegex = CreateWindowW(
+            L"BUTTON", L"Regex",
+            WS_CHILD | WS_VISIBLE | BS_AUTOCHECKBOX,
+            205, 160, 55, 22,
+            hwnd, (HMENU)ID_CHECK_SEARCH_REGEX,
+            nullptr, nullptr);
+
+        hBtnFindNext = CreateWindowW(
+            L"BUTTON", L"Próx.",
+            WS_CHILD | WS_VISIBLE,
+            262, 160, 55, 22,
+            hwnd, (HMENU)ID_BTN_FIND_NEXT,
+            nullptr, nullptr);
+
+        hBtnFilter = CreateWindowW(
+            L"BUTTON", L"Filtrar",
+            WS_CHILD | WS_VISIBLE,
+            320, 160, 60, 22,
+            hwnd, (HMENU)ID_BTN_FILTER,
+            nullptr, nullptr);
+
+        // ---- Abas: uma por porta (a view de cada aba fica na área útil) ----
+        // WS_CLIPSIBLINGS: o tab control não pinta por cima das views.
+        hTabs = CreateWindowW(
+            WC_TABCONTROLW, nullptr,
+            WS_CHILD | WS_VISIBLE | WS_CLIPSIBLINGS,
+            10, 190, 370, 260,
+            hwnd, (HMENU)ID_TAB_PORTS,
             nullptr, nullptr);
+        SendMessage(hTabs, WM_SETFONT, (WPARAM)GetStockObject(DEFAULT_GUI_FONT), FALSE);
 
         // ---- Preenche os combos com dados iniciais ----
-        // - Lista portas COM detectadas (ex.: "USB-SERIAL (COM6)").
+        // - Portas: a primeira varredura roda na thread do portEnum e chega
+        //   por WM_APP_PORTS_CHANGED (a janela abre sem esperar o SetupDi).
         // - Lista baud rates comuns e seleciona 115200 por padrão.
-        ListComPorts(hComboComPort);
+        portEnum.Start([] { PostMessage(hMainWnd, WM_APP_PORTS_CHANGED, 0, 0); });
         PopulateBaudRates(hComboBaudRate);
 
+        // ---- Aba inicial ("Terminal"): vira a aba da primeira porta conectada ----
+        // Cada aba tem uma view própria (TerminalView) sobre o seu Scrollback:
+        // desenha só as linhas visíveis, rola sozinha enquanto o usuário
+        // estiver no fim e aceita Ctrl+C para copiar o que está na tela.
+        ActivateTab(CreateTab(L""));
+
+        // ---- Leitura de todas as portas (poucas threads, ver SerialReactor.h) ----
+        sessionEvents.rxReady = [](uint32_t id) { PostMessage(hMainWnd, WM_APP_RX_READY, id, 0); };
+        sessionEvents.txDone = [](uint32_t id) { PostMessage(hMainWnd, WM_APP_TX_DONE, id, 0); };
+        sessionEvents.portLost = [](uint32_t id) { PostMessage(hMainWnd, WM_APP_PORT_LOST, id, 0); };
+        sessionEvents.replayDone = [](uint32_t id) { PostMessage(hMainWnd, WM_APP_REPLAY_DONE, id, 0); };
+        sessionEvents.rttDone = [](uint32_t id) { PostMessage(hMainWnd, WM_APP_RTT_DONE, id, 0); };
+        sessionEvents.loadDone = [](uint32_t id) { PostMessage(hMainWnd, WM_APP_LOAD_DONE, id, 0); };
+        if (!reactor.Start(REACTOR_THREADS))
+            AppendToTerminal(L"[ERRO] Falha ao iniciar leitura serial: " + Utf8ToWide(reactor.LastError()) + L"\r\n");
+        SetTimer(hwnd, ID_TIMER_METRICS, METRICS_INTERVAL_MS, nullptr);
+        SetTimer(hwnd, ID_TIMER_SEARCH_INDEX, SEARCH_INDEX_INTERVAL_MS, nullptr);
+        SetTimer(hwnd, ID_TIMER_SCROLLBACK_COMPACT, SCROLLBACK_COMPACT_INTERVAL_MS, nullptr);
+
+        // ---- Export periódico das métricas (opcional) ----
+        {
+            std::string metricsPath = MetricsPathFromCommandLine();
+            if (!metricsPath.empty()) {
+                if (metricsExport.Open(metricsPath))
+                    AppendToTerminal(L"[INFO] Métricas em " + Utf8ToWide(metricsPath) + L"\r\n");
+                else
+                    AppendToTerminal(L"[ERRO] " + Utf8ToWide(metricsExport.LastError()) + L"\r\n");
+            }
+        }
+
         // Fim do tratamento da criação: retornamos pois já lidamos com WM_CREATE.
         break;
 
@@ -549,56 +1520,54 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
 
             // printf("\r\nAlgo aconteceu na combobox de Portas COM");
             // ...e foi o evento "abrindo o dropdown"
+            // A lista já está no cache; só repovoa se o combo estiver atrasado.
             if (HIWORD(wParam) == CBN_DROPDOWN) {
-                printf("User Pediu para listar portas\r\n");
-                RefreshComPortsAndKeepSelection(hComboComPort);
+                if (portEnum.Generation() != comboPortsGeneration)
+                    RefreshComPortsAndKeepSelection(hComboComPort);
+            }
+            // Outra porta escolhida: "Conectar"/"Desconectar" depende dela.
+            if (HIWORD(wParam) == CBN_SELCHANGE) {
+                UpdateSessionButtons();
             }
             break;
 
             // ---- Clique no botão "Conectar"/"Desconectar" ----
+            // Age sobre a porta do combo: cada porta tem a sua aba.
         case ID_BTN_CONNECT: {
-            if (isConnected) {
-                // Já está conectado → então vamos desconectar.
-                // Fecha a thread de RX, cancela I/O e libera handle.
-                CloseSerialPort();
-
-                // Atualiza rótulo do botão e loga no terminal.
-                SetWindowTextW(hBtnConnect, L"Conectar");
-                AppendToTerminal(L"[INFO] Porta desconectada\r\n");
+            // 1) Extrai apenas "COMx" do friendly name do combo.
+            std::wstring portOnly = SelectedPortName();
+            PortTab* tab = FindTabByPort(portOnly);
+
+            if (tab && tab->session && tab->session->IsOpen()) {
+                // Já está conectada → então vamos desconectar.
+                // Tira a porta do reactor, para a escrita e libera o handle.
+                CloseSerialPort(tab);
+                AppendToTab(tab, L"[INFO] Porta desconectada\r\n");
             }
             else {
-                // Ainda não está conectado → vamos tentar abrir a porta escolhida.
-
-                // 1) Lê o "friendly name" do combo de portas (ex.: "USB-Serial (COM6)").
-                wchar_t portName[100] = {};
-                GetWindowTextW(hComboComPort, portName, 100);
+                // Ainda não está conectada → vamos tentar abrir a porta escolhida.
 
                 // 2) Lê o baud selecionado (string -> número).
                 wchar_t baudStr[20] = {};
                 GetWindowTextW(hComboBaudRate, baudStr, 20);
                 DWORD baud = _wtoi(baudStr);
 
-                // 3) Extrai apenas "COMx" do friendly name.
-                //    Se o nome tiver "(COM6)", capturamos o conteúdo entre parênteses.
-                std::wstring portStr(portName);
-                size_t b = portStr.find(L"(COM");                 // posição do "(COM"
-                size_t e = portStr.find(L")", (b == std::wstring::npos ? 0 : b)); // fecha ")"
-
-                // Se encontrou "(COMx)", extrai "COMx"; caso contrário, usa a string inteira.
-                std::wstring portOnly =
-                    (b != std::wstring::npos && e != std::wstring::npos && e > b)
-                    ? portStr.substr(b + 1, e - (b + 1))  // remove parênteses
-                    : portStr;
+                // 3) Reaproveita a aba da porta (reconexão) ou a aba inicial
+                //    ainda sem porta; senão, abre uma aba nova.
+                if (!tab) tab = FindTabByPort(L"");
+                if (!tab) tab = CreateTab(portOnly);
+                tab->portName = portOnly;
+                ActivateTab(tab);
 
                 // 4) Tenta abrir a porta e configurar (baud, 8N1, DTR/RTS, timeouts).
-                if (OpenSerialPort(portOnly, baud)) {
-                    // Sucesso: atualiza botão para "Desconectar" e loga.
-                    SetWindowTextW(hBtnConnect, L"Desconectar");
-                    AppendToTerminal(L"[OK] Conectado em " + portOnly + L" @ " + std::to_wstring(baud) + L"\r\n");
+                if (OpenSerialPort(tab, portOnly, baud)) {
+                    // Sucesso: loga na aba (o botão já virou "Desconectar").
+                    AppendToTab(tab, L"[OK] Conectado em " + portOnly + L" @ " + std::to_wstring(baud) + L"\r\n");
                 }
                 else {
-                    // Falha ao abrir/configurar.
-                    AppendToTerminal(L"[ERRO] Falha ao conectar\r\n");
+                    // Falha ao abrir/configurar (motivo vem do backend).
+                    AppendToTab(tab, L"[ERRO] Falha ao conectar: " +
+                        Utf8ToWide(tab->session->LastError()) + L"\r\n");
                 }
             }
         } break;
@@ -606,18 +1575,190 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
             // ---- Clique no botão "Enviar" ----
         case ID_BTN_SEND:
             // Encaminha para a rotina de envio: pega texto da caixa escolhida,
-            // converte para UTF-8 e manda via WriteFile.
+            // converte para UTF-8 e enfileira na TxQueue da aba ativa.
             SendSelectedMessage();
             break;
+
+            // ---- Clique no botão "RTT"/"Parar" ----
+        case ID_BTN_RTT:
+            ToggleRtt(hwnd);
+            break;
+
+            // ---- Clique no botão "Carga..."/"Parar carga" ----
+        case ID_BTN_LOAD:
+            ToggleLoad(hwnd);
+            break;
+
+            // ---- Clique no botão "TCP"/"Parar TCP" ----
+        case ID_BTN_BRIDGE:
+            ToggleBridge();
+            break;
+
+            // ---- Clique no botão "Gravar"/"Parar gravação" ----
+        case ID_BTN_CAPTURE:
+            ToggleCapture(hwnd);
+            break;
+
+            // ---- Clique no botão "Reproduzir"/"Parar" ----
+        case ID_BTN_REPLAY:
+            if (activeTab && activeTab->session && activeTab->session->Replay()) {
+                CloseSerialPort(activeTab);
+                AppendToTab(activeTab, L"[INFO] Reprodução interrompida\r\n");
+            }
+            else {
+                StartReplay(hwnd);
+            }
+            break;
+
+            // ---- Busca: cada tecla/opção refaz a busca (ou o filtro) ----
+        case ID_EDIT_SEARCH:
+            if (HIWORD(wParam) == EN_CHANGE) OnSearchChanged();
+            break;
+
+        case ID_COMBO_SEARCH_DIR:
+            if (HIWORD(wParam) == CBN_SELCHANGE) OnSearchChanged();
+            break;
+
+        case ID_CHECK_SEARCH_REGEX:
+            OnSearchChanged();
+            break;
+
+        case ID_BTN_FIND_NEXT:
+            if (activeTab) FindInTab(activeTab, true);
+            break;
+
+        case ID_BTN_PLOT:
+            plotOn = !plotOn;
+            SetWindowTextW(hBtnPlot, plotOn ? L"Texto" : L"Gráfico");
+            if (activeTab) ActivateTab(activeTab);
+            break;
+
+        case ID_BTN_FILTER:
+            filterOn = !filterOn;
+            SetWindowTextW(hBtnFilter, filterOn ? L"Todas" : L"Filtrar");
+            if (activeTab) {
+                ApplyFilter(activeTab);
+                if (!filterOn && activeTab->searchHit != UINT64_MAX)
+                    TerminalViewShowLine(activeTab->hView, activeTab->searchHit);
+            }
+            break;
+        }
+        break;
+
+        // ------------------------------------------------------------------------
+        // Troca de aba: mostra a view da aba e alinha combo/botões com ela.
+        // ------------------------------------------------------------------------
+    case WM_NOTIFY:
+        if (((LPNMHDR)lParam)->hwndFrom == hTabs && ((LPNMHDR)lParam)->code == TCN_SELCHANGE) {
+            int sel = TabCtrl_GetCurSel(hTabs);
+            if (sel >= 0 && sel < (int)tabs.size()) ActivateTab(tabs[sel].get());
+            return 0;
+        }
+        break;
+
+        // ------------------------------------------------------------------------
+        // Bytes novos na fila RX da sessão wParam (postado pelo reactor).
+        // ------------------------------------------------------------------------
+    case WM_APP_RX_READY:
+        if (PortTab* tab = FindTab((uint32_t)wParam)) OnRxReady(hwnd, tab);
+        return 0;
+
+        // O reactor tirou a porta porque ela falhou (ex.: adaptador removido).
+    case WM_APP_PORT_LOST:
+        if (PortTab* tab = FindTab((uint32_t)wParam)) {
+            if (tab->session && tab->session->IsOpen()) {
+                std::string why = tab->session->LastError();
+                DrainRxRing(hwnd, tab);   // o que chegou antes da falha
+                FlushRxLine(tab);
+                CloseSerialPort(tab);
+                AppendToTab(tab, L"\r\n[ERRO] Porta perdida: " +
+                    (why.empty() ? std::wstring(L"dispositivo desconectado") : Utf8ToWide(why)) + L"\r\n");
+            }
+        }
+        return 0;
+
+        // Mensagens concluídas pela thread de escrita da sessão.
+    case WM_APP_TX_DONE:
+        if (PortTab* tab = FindTab((uint32_t)wParam)) HandleTxDone(tab);
+        return 0;
+
+        // A reprodução chegou ao fim (ignorado se o usuário já parou).
+    case WM_APP_REPLAY_DONE:
+        if (PortTab* tab = FindTab((uint32_t)wParam)) {
+            if (tab->session && tab->session->IsOpen() && tab->session->Replay()) FinishReplay(tab);
+        }
+        return 0;
+
+        // O plano de carga terminou sozinho (duration/count/repeat): relatório na aba.
+    case WM_APP_LOAD_DONE:
+        if (PortTab* tab = FindTab((uint32_t)wParam)) {
+            if (tab->session) AppendToTab(tab, LoadReportText(tab->session->LoadResult()));
+            UpdateSessionButtons();
+        }
+        return 0;
+
+        // Lista de portas nova (primeira varredura ou hot-plug).
+    case WM_APP_PORTS_CHANGED:
+        OnPortsChanged();
+        return 0;
+
+        // Dispositivo entrou/saiu: o portEnum varre de novo na thread dele
+        // (eventos em rajada viram uma varredura só).
+    case WM_DEVICECHANGE:
+        if (wParam == DBT_DEVICEARRIVAL || wParam == DBT_DEVICEREMOVECOMPLETE || wParam == DBT_DEVNODES_CHANGED)
+            portEnum.Rescan();
+        return TRUE;
+
+        // A medição de RTT terminou as N trocas: relatório na aba da porta.
+    case WM_APP_RTT_DONE:
+        if (PortTab* tab = FindTab((uint32_t)wParam)) {
+            if (tab->session)
+                AppendToTab(tab, Utf8ToWide(RttReportToText(tab->session->RttResult())) + L"\r\n");
+            UpdateSessionButtons();
+        }
+        return 0;
+
+    case WM_TIMER:
+        if (wParam == ID_TIMER_METRICS) {
+            UpdateMetrics();
+            return 0;
+        }
+        if (wParam == ID_TIMER_SEARCH_INDEX) {
+            for (auto& t : tabs) t->index.Update(SEARCH_INDEX_CHARS);
+            return 0;
+        }
+        if (wParam == ID_TIMER_SCROLLBACK_COMPACT) {
+            for (auto& t : tabs) t->log.Compact(SCROLLBACK_COMPACT_CHARS);
+            return 0;
+        }
+        // Timers por aba: TabTimerId() = (id da aba << 4) | tipo.
+        if (PortTab* tab = FindTab((uint32_t)(wParam >> 4))) {
+            if ((wParam & 0xF) == ID_TIMER_RX_DRAIN) {
+                KillTimer(hwnd, wParam);
+                tab->rxDrainTimerArmed = false;
+                DrainRxRing(hwnd, tab);
+                return 0;
+            }
+            if ((wParam & 0xF) == ID_TIMER_RX_LINE) {
+                FlushRxLine(tab);
+                return 0;
+            }
         }
         break;
 
         // ------------------------------------------------------------------------
         // A janela está sendo destruída (usuário fechou, Alt+F4, etc.)
-        // Limpeza geral: encerre a serial, pare threads, avise ao sistema para sair.
+        // Limpeza geral: encerre as sessões, pare threads, avise ao sistema para sair.
         // ------------------------------------------------------------------------
     case WM_DESTROY:
-        CloseSerialPort();       // garante que nada fica pendurado
+        KillTimer(hwnd, ID_TIMER_METRICS);
+        KillTimer(hwnd, ID_TIMER_SEARCH_INDEX);
+        KillTimer(hwnd, ID_TIMER_SCROLLBACK_COMPACT);
+        for (auto& t : tabs)
+            t->session.reset();  // fecha a porta e a captura (índice e rodapé)
+        reactor.Stop();          // garante que nada fica pendurado
+        portEnum.Stop();
+        metricsExport.Close();
         PostQuitMessage(0);      // pede para o loop principal encerrar
         break;
     }
@@ -626,4 +1767,3 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
     // (o Windows fornece comportamento padrão, como mover/redimensionar, etc.).
     return DefWindowProc(hwnd, msg, wParam, lParam);
 }
-
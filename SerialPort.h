@@ -0,0 +1,126 @@
+// SerialPort.h - Abstração da porta serial (Win32 / Linux termios)
+// Objetivo: tirar CreateFileW/DCB/SetCommState do código da UI e permitir um
+//           backend Linux (termios2) com baud arbitrário e modo low-latency.
+//
+// Contrato de threads:
+//  - Read() é chamado por UMA thread de leitura e bloqueia até haver bytes.
+//    CancelRead() (de qualquer thread) acorda essa thread; a partir daí Read()
+//    retorna 0 até a porta ser fechada.
+//  - Write() é chamado por UMA thread de escrita (pode ser outra).
+//  - Close() só depois que as threads de leitura/escrita terminaram.
+//  - Alternativa ao Read(): a porta é servida por um SerialReactor (epoll/
+//    IOCP, várias portas por thread), que usa NativeHandle() e ReadNow().
+//    Uma porta usa um modo ou o outro, nunca os dois.
+//
+// Backends: SerialPortWin32.cpp (overlapped + WaitCommEvent) e
+//           SerialPortPosix.cpp (Linux: termios2/BOTHER + epoll).
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+enum class SerialParity { None, Odd, Even };
+enum class SerialStopBits { One, Two };
+
+struct SerialConfig {
+    uint32_t baudRate = 115200;    // qualquer valor (Linux: BOTHER, ex. 3000000, 12000000)
+    uint8_t  dataBits = 8;         // 5..8
+    SerialParity parity = SerialParity::None;
+    SerialStopBits stopBits = SerialStopBits::One;
+    bool     dtr = true;           // muitos adaptadores só transmitem com DTR/RTS ativos
+    bool     rts = true;
+    bool     lowLatency = true;    // Linux: ASYNC_LOW_LATENCY (FTDI: latency timer 1 ms)
+    uint8_t  vmin = 1;             // Linux: VMIN  (bytes mínimos por read)
+    uint8_t  vtime = 0;            // Linux: VTIME (décimos de segundo entre bytes)
+    uint32_t rxQueueSize = 4096;   // Win32: SetupComm (sugestão ao driver; AdaptiveIo pode aumentar)
+    uint32_t txQueueSize = 4096;
+    uint32_t writeTimeoutMs = 100; // escrita bloqueante desiste após isso
+};
+
+// Erros de linha contados desde Open() (ver SerialPort::ErrorCounts()).
+struct SerialErrorCounts {
+    uint64_t overrun = 0;      // UART/driver perdeu bytes (FIFO cheio)
+    uint64_t parity = 0;
+    uint64_t framing = 0;      // stop bit errado (baud ou formato diferente)
+    uint64_t bufferFull = 0;   // buffer de entrada do driver transbordou
+    uint64_t breaks = 0;
+};
+
+// Pedaço de uma escrita "gather" (WriteV).
+struct SerialIoVec {
+    const void* data;
+    size_t len;
+};
+
+class SerialPort {
+public:
+    virtual ~SerialPort() {}
+
+    // 'name': "COM6" / "\\\\.\\COM10" no Windows, "/dev/ttyUSB0" no Linux (UTF-8).
+    virtual bool Open(const std::string& name, const SerialConfig& cfg) = 0;
+    virtual void Close() = 0;
+    virtual bool IsOpen() const = 0;
+
+    // Bloqueia até chegar pelo menos 1 byte. Retorna: >0 bytes lidos,
+    // 0 se CancelRead() foi chamado, -1 se a porta falhou de vez (ex.: USB removido).
+    virtual long Read(void* buf, size_t len) = 0;
+
+    // Escreve tudo (bloqueante, limitado por writeTimeoutMs).
+    // Retorna bytes escritos (< len em timeout) ou -1 em erro.
+    virtual long Write(const void* data, size_t len) = 0;
+
+    // Escrita "gather": vários pedaços numa única operação. O padrão junta os
+    // pedaços num buffer e chama Write(); backends com writev sobrescrevem.
+    virtual long WriteV(const SerialIoVec* vec, size_t count);
+
+    // Acorda um Read() bloqueado. Seguro de qualquer thread.
+    virtual void CancelRead() = 0;
+
+    // ---- Modo reactor (ver SerialReactor.h) ----
+    // Handle para registrar no reactor: fd (Linux, epoll) ou HANDLE overlapped
+    // (Windows, IOCP). -1 = sem suporte: o reactor dá à porta uma thread com Read().
+    virtual intptr_t NativeHandle() const { return -1; }
+
+    // Lê o que já chegou, sem esperar. Só é chamado depois de o reactor ver
+    // dados (EPOLLIN / EV_RXCHAR). Retorna >0 bytes, 0 se não há nada, -1 se
+    // a porta falhou de vez.
+    virtual long ReadNow(void* buf, size_t len) { (void)buf; (void)len; return -1; }
+
+    // ---- Ajuste adaptativo do reactor (ver AdaptiveIo.h) ----
+    // Modo lote: o reactor chama ReadNow() por relógio, sem aviso de dados, e
+    // ele precisa voltar na hora (0) com o driver vazio. false = sem suporte
+    // (a porta continua sendo lida por evento).
+    virtual bool SetPolledRead(bool on) { (void)on; return false; }
+
+    // Muda a fila RX do driver com a porta aberta (Win32: SetupComm). false =
+    // o backend não tem essa fila (Linux: buffer fixo da tty).
+    virtual bool SetRxQueueSize(uint32_t bytes) { (void)bytes; return false; }
+
+    // Muda baud, formato (bits/paridade/stop) e DTR/RTS com a porta aberta,
+    // sem limpar os buffers (ex.: pedido de um cliente RFC 2217, ver
+    // TcpBridge.h). Os demais campos de 'cfg' são ignorados. Pode ser chamada
+    // com leitura/escrita em andamento. false = recusado (LastError()) ou sem
+    // suporte (replay, dispositivo simulado).
+    virtual bool SetLineConfig(const SerialConfig& cfg) { (void)cfg; return false; }
+
+    // Erros de linha do driver desde Open(). Consulta o driver (ioctl /
+    // ClearCommError): chamar periodicamente (ex.: 1x/s), não por leitura.
+    // Backends sem essa informação (pty, replay) retornam zeros.
+    virtual SerialErrorCounts ErrorCounts() { return SerialErrorCounts(); }
+
+    // Descrição do último erro (para log/UI).
+    virtual std::string LastError() const = 0;
+};
+
+// Cria o backend nativo da plataforma (ainda fechado).
+std::unique_ptr<SerialPort> CreateSerialPort();
+
+inline long SerialPort::WriteV(const SerialIoVec* vec, size_t count) {
+    if (count == 1) return Write(vec[0].data, vec[0].len);
+    std::string joined;
+    for (size_t i = 0; i < count; ++i) joined.append((const char*)vec[i].data, vec[i].len);
+    return Write(joined.data(), joined.size());
+}
@@ -0,0 +1,343 @@
+// SerialPortPosix.cpp - Backend Linux da SerialPort (ver SerialPort.h)
+//  - termios2 + BOTHER: baud arbitrário (2, 3, 12 Mbaud em FTDI/CP210x).
+//  - ASYNC_LOW_LATENCY via TIOCSSERIAL quando o driver suporta.
+//  - Read(): epoll no fd da tty + eventfd de cancelamento, sem timeout; o
+//    read() em seguida respeita VMIN/VTIME configurados.
+//  - Reactor: NativeHandle() = fd da tty; ReadNow() é um read() simples.
+//    No modo lote (SetPolledRead) o fd fica O_NONBLOCK: read() sem dados
+//    volta com EAGAIN em vez de esperar o VMIN.
+//  - ErrorCounts(): TIOCGICOUNT, descontado o valor lido no Open().
+//  - SetLineConfig(): o mesmo TCSETS2 do Open() (SetLineBits), sem TCFLSH.
+//  - Write(): fd separado O_NONBLOCK + poll(POLLOUT) limitado por
+//    writeTimeoutMs (flow control não trava a thread para sempre).
+// Testável ponta a ponta contra um par de pseudo-terminais (openpty).
+
+#if defined(__linux__)
+
+#include "SerialPort.h"
+
+#include <asm/termbits.h>    // struct termios2, BOTHER (não misturar com <termios.h>)
+#include <sys/ioctl.h>
+#include <linux/serial.h>    // struct serial_struct, ASYNC_LOW_LATENCY
+#include <sys/epoll.h>
+#include <sys/uio.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
+class SerialPortPosix : public SerialPort {
+public:
+    ~SerialPortPosix() override { Close(); }
+
+    bool Open(const std::string& name, const SerialConfig& cfg) override;
+    void Close() override;
+    bool IsOpen() const override { return m_fd >= 0; }
+    long Read(void* buf, size_t len) override;
+    long Write(const void* data, size_t len) override;
+    long WriteV(const SerialIoVec* vec, size_t count) override;
+    void CancelRead() override;
+    intptr_t NativeHandle() const override { return m_fd; }
+    long ReadNow(void* buf, size_t len) override;
+    bool SetPolledRead(bool on) override;
+    bool SetLineConfig(const SerialConfig& cfg) override;
+    SerialErrorCounts ErrorCounts() override;
+    std::string LastError() const override;
+
+private:
+    bool Configure(const SerialConfig& cfg);
+    bool ApplyLine(const SerialConfig& cfg, bool raw);
+    void SetError(const char* what);
+    bool WaitWritable(std::chrono::steady_clock::time_point deadline);
+    bool ReadICount(SerialErrorCounts* out) const;
+
+    int m_fd = -1;          // leitura (bloqueante: VMIN/VTIME valem)
+    int m_wfd = -1;         // escrita (O_NONBLOCK)
+    int m_epoll = -1;
+    int m_cancelFd = -1;    // eventfd: CancelRead() -> legível
+    uint32_t m_writeTimeoutMs = 100;
+    SerialErrorCounts m_errorBase;   // TIOCGICOUNT é cumulativo desde o boot do driver
+    mutable std::mutex m_errLock;
+    std::string m_lastError;
+};
+
+std::unique_ptr<SerialPort> CreateSerialPort() {
+    return std::unique_ptr<SerialPort>(new SerialPortPosix());
+}
+
+void SerialPortPosix::SetError(const char* what) {
+    std::string msg = std::string(what) + ": " + strerror(errno);
+    std::lock_guard<std::mutex> lock(m_errLock);
+    m_lastError = msg;
+}
+
+std::string SerialPortPosix::LastError() const {
+    std::lock_guard<std::mutex> lock(m_errLock);
+    return m_lastError;
+}
+
+bool SerialPortPosix::Open(const std::string& name, const SerialConfig& cfg) {
+    Close();
+
+    m_fd = open(name.c_str(), O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if (m_fd < 0) {
+        SetError("open falhou");
+        return false;
+    }
+    m_wfd = open(name.c_str(), O_WRONLY | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (m_wfd < 0) {
+        SetError("open (escrita) falhou");
+        Close();
+        return false;
+    }
+    if (!Configure(cfg)) {
+        Close();
+        return false;
+    }
+    // Ninguém mais abre a porta enquanto estamos com ela (como no Windows):
+    ioctl(m_fd, TIOCEXCL);
+
+    m_cancelFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    m_epoll = epoll_create1(EPOLL_CLOEXEC);
+    if (m_cancelFd < 0 || m_epoll < 0) {
+        SetError("epoll/eventfd falhou");
+        Close();
+        return false;
+    }
+    epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.fd = m_fd;
+    epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_fd, &ev);
+    ev.data.fd = m_cancelFd;
+    epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_cancelFd, &ev);
+
+    m_writeTimeoutMs = cfg.writeTimeoutMs;
+    m_errorBase = SerialErrorCounts();
+    ReadICount(&m_errorBase);
+    return true;
+}
+
+// Contadores de erro do driver (8250, FTDI, CP210x...); pty e alguns
+// adaptadores não implementam (ENOTTY/EINVAL): ficam em zero.
+bool SerialPortPosix::ReadICount(SerialErrorCounts* out) const {
+    struct serial_icounter_struct ic = {};
+    if (ioctl(m_fd, TIOCGICOUNT, &ic) < 0) return false;
+    out->overrun = (uint64_t)ic.overrun;
+    out->parity = (uint64_t)ic.parity;
+    out->framing = (uint64_t)ic.frame;
+    out->bufferFull = (uint64_t)ic.buf_overrun;
+    out->breaks = (uint64_t)ic.brk;
+    return true;
+}
+
+SerialErrorCounts SerialPortPosix::ErrorCounts() {
+    SerialErrorCounts now;
+    if (m_fd < 0 || !ReadICount(&now)) return SerialErrorCounts();
+    now.overrun -= m_errorBase.overrun;
+    now.parity -= m_errorBase.parity;
+    now.framing -= m_errorBase.framing;
+    now.bufferFull -= m_errorBase.bufferFull;
+    now.breaks -= m_errorBase.breaks;
+    return now;
+}
+
+// Baud e formato; 'raw' (só no Open()) também zera o processamento de linha
+// e aplica VMIN/VTIME.
+bool SerialPortPosix::ApplyLine(const SerialConfig& cfg, bool raw) {
+    struct termios2 tio;
+    if (ioctl(m_fd, TCGETS2, &tio) < 0) {
+        SetError("TCGETS2 falhou (não é uma tty?)");
+        return false;
+    }
+
+    if (raw) {
+        // Modo "raw": sem eco, sem tradução de CR/LF, sem sinais, sem XON/XOFF.
+        tio.c_iflag &= ~(IGNBRK | BRKINT | PARMRK | ISTRIP | INLCR | IGNCR | ICRNL | IXON | IXOFF | IXANY);
+        tio.c_oflag &= ~OPOST;
+        tio.c_lflag &= ~(ECHO | ECHONL | ICANON | ISIG | IEXTEN);
+        tio.c_cc[VMIN] = cfg.vmin;
+        tio.c_cc[VTIME] = cfg.vtime;
+    }
+
+    tio.c_cflag &= ~(CSIZE | PARENB | PARODD | CSTOPB | CRTSCTS);
+    tio.c_cflag |= CREAD | CLOCAL;
+    switch (cfg.dataBits) {
+    case 5:  tio.c_cflag |= CS5; break;
+    case 6:  tio.c_cflag |= CS6; break;
+    case 7:  tio.c_cflag |= CS7; break;
+    default: tio.c_cflag |= CS8; break;
+    }
+    if (cfg.parity != SerialParity::None) {
+        tio.c_cflag |= PARENB;
+        if (cfg.parity == SerialParity::Odd) tio.c_cflag |= PARODD;
+    }
+    if (cfg.stopBits == SerialStopBits::Two) tio.c_cflag |= CSTOPB;
+
+    // Baud arbitrário: BOTHER + c_ispeed/c_ospeed numéricos (entrada = saída).
+    tio.c_cflag &= ~(CBAUD | (CBAUD << IBSHIFT));
+    tio.c_cflag |= BOTHER | (BOTHER << IBSHIFT);
+    tio.c_ispeed = cfg.baudRate;
+    tio.c_ospeed = cfg.baudRate;
+
+    if (ioctl(m_fd, TCSETS2, &tio) < 0) {
+        SetError("TCSETS2 falhou (baud não suportado?)");
+        return false;
+    }
+
+    // DTR/RTS (pty não tem linhas de modem: erro ignorado):
+    int lines = TIOCM_DTR;
+    ioctl(m_fd, cfg.dtr ? TIOCMBIS : TIOCMBIC, &lines);
+    lines = TIOCM_RTS;
+    ioctl(m_fd, cfg.rts ? TIOCMBIS : TIOCMBIC, &lines);
+    return true;
+}
+
+bool SerialPortPosix::SetLineConfig(const SerialConfig& cfg) {
+    if (m_fd < 0 || cfg.baudRate == 0) return false;
+    return ApplyLine(cfg, false);
+}
+
+bool SerialPortPosix::Configure(const SerialConfig& cfg) {
+    if (!ApplyLine(cfg, true)) return false;
+
+    // Low-latency: o driver entrega cada byte sem esperar o timer de
+    // agrupamento (FTDI: 16 ms -> 1 ms). Nem todo driver/pty suporta: ignora falha.
+    if (cfg.lowLatency) {
+        struct serial_struct ss;
+        if (ioctl(m_fd, TIOCGSERIAL, &ss) == 0) {
+            ss.flags |= ASYNC_LOW_LATENCY;
+            ioctl(m_fd, TIOCSSERIAL, &ss);
+        }
+    }
+
+    // Limpa buffers para começar "do zero":
+    ioctl(m_fd, TCFLSH, TCIOFLUSH);
+    return true;
+}
+
+void SerialPortPosix::Close() {
+    int* fds[] = { &m_epoll, &m_cancelFd, &m_wfd, &m_fd };
+    for (int* fd : fds) {
+        if (*fd >= 0) {
+            close(*fd);
+            *fd = -1;
+        }
+    }
+}
+
+void SerialPortPosix::CancelRead() {
+    if (m_cancelFd >= 0) {
+        uint64_t one = 1;
+        ssize_t r = write(m_cancelFd, &one, sizeof(one));
+        (void)r;
+    }
+}
+
+long SerialPortPosix::Read(void* buf, size_t len) {
+    for (;;) {
+        epoll_event ev[2];
+        int n = epoll_wait(m_epoll, ev, 2, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            SetError("epoll_wait falhou");
+            return -1;
+        }
+
+        // Cancelamento tem prioridade; o eventfd não é consumido, então todo
+        // Read() seguinte também retorna 0.
+        bool readable = false;
+        for (int i = 0; i < n; ++i) {
+            if (ev[i].data.fd == m_cancelFd) return 0;
+            readable = true;
+        }
+        if (!readable) continue;
+
+        ssize_t r = read(m_fd, buf, len);
+        if (r > 0) return (long)r;
+        if (r == 0) continue;    // VTIME expirou sem bytes (VMIN=0)
+        if (errno == EINTR || errno == EAGAIN) continue;
+        SetError("read falhou");  // ex.: EIO quando o adaptador USB é removido
+        return -1;
+    }
+}
+
+// Reactor: o epoll (nível) já disse que há bytes, então read() volta na hora
+// com o que está disponível (VMIN/VTIME também valem para a legibilidade).
+long SerialPortPosix::ReadNow(void* buf, size_t len) {
+    for (;;) {
+        ssize_t r = read(m_fd, buf, len);
+        if (r >= 0) return (long)r;
+        if (errno == EINTR) continue;
+        if (errno == EAGAIN) return 0;
+        SetError("read falhou");
+        return -1;
+    }
+}
+
+bool SerialPortPosix::SetPolledRead(bool on) {
+    int flags = fcntl(m_fd, F_GETFL);
+    if (flags < 0) return false;
+    flags = on ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK);
+    return fcntl(m_fd, F_SETFL, flags) == 0;
+}
+
+// Buffer do driver cheio (ou flow control): espera espaço até o prazo.
+bool SerialPortPosix::WaitWritable(std::chrono::steady_clock::time_point deadline) {
+    auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+        deadline - std::chrono::steady_clock::now()).count();
+    if (left <= 0) return false;
+    pollfd pfd = { m_wfd, POLLOUT, 0 };
+    poll(&pfd, 1, (int)left);
+    return true;
+}
+
+long SerialPortPosix::Write(const void* data, size_t len) {
+    SerialIoVec v = { data, len };
+    return WriteV(&v, 1);
+}
+
+// writev() de verdade: as mensagens coalescidas pela TxQueue saem numa
+// única syscall sem serem copiadas para um buffer intermediário.
+long SerialPortPosix::WriteV(const SerialIoVec* vec, size_t count) {
+    const size_t kMaxIov = 64;
+    iovec iov[kMaxIov];
+    size_t total = 0;
+    for (size_t i = 0; i < count; ++i) total += vec[i].len;
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(m_writeTimeoutMs);
+    size_t done = 0;
+    while (done < total) {
+        // Monta o iovec a partir do ponto onde a escrita parou:
+        size_t skip = done, n = 0;
+        for (size_t i = 0; i < count && n < kMaxIov; ++i) {
+            if (skip >= vec[i].len) {
+                skip -= vec[i].len;
+                continue;
+            }
+            iov[n].iov_base = (char*)vec[i].data + skip;
+            iov[n].iov_len = vec[i].len - skip;
+            skip = 0;
+            ++n;
+        }
+
+        ssize_t w = writev(m_wfd, iov, (int)n);
+        if (w > 0) {
+            done += (size_t)w;
+            continue;
+        }
+        if (w < 0 && errno != EAGAIN && errno != EINTR) {
+            SetError("write falhou");
+            return -1;
+        }
+        if (!WaitWritable(deadline)) break;
+    }
+    return (long)done;
+}
+
+#endif /* __linux__ */
@@ -0,0 +1,342 @@
+// SerialPortWin32.cpp - Backend Win32 da SerialPort (ver SerialPort.h)
+// Porta aberta com FILE_FLAG_OVERLAPPED:
+//  - Read(): ReadFile devolve na hora o que já está no driver (timeouts
+//    MAXDWORD/0/0); se não há nada, dorme em WaitCommEvent(EV_RXCHAR) junto
+//    com o evento de cancelamento, sem timeout.
+//  - Write(): WriteFile overlapped, limitado por WriteTotalTimeoutConstant.
+//  - WriteV(): o padrão da base (junta num buffer): WriteFileGather exige
+//    FILE_FLAG_NO_BUFFERING e páginas alinhadas, não serve para porta COM.
+//  - Reactor: o SerialReactor associa o HANDLE a um IOCP e deixa um
+//    WaitCommEvent pendente; ReadNow() é o passo (1) do Read(). Os eventos
+//    dos nossos OVERLAPPED levam o bit 0 ligado, que impede o Windows de
+//    enfileirar essas conclusões no IOCP (só as do reactor vão para lá).
+//  - ErrorCounts(): ClearCommError devolve flags (não contagens); cada flag
+//    vista, na consulta periódica ou numa falha de I/O, soma 1.
+//  - SetLineConfig(): Get/SetCommState só com baud/formato/DTR/RTS, sem
+//    PurgeComm (o I/O overlapped pendente continua).
+
+#ifdef _WIN32
+
+#include "SerialPort.h"
+
+#include <windows.h>
+#include <mutex>
+#include <string>
+
+class SerialPortWin32 : public SerialPort {
+public:
+    ~SerialPortWin32() override { Close(); }
+
+    bool Open(const std::string& name, const SerialConfig& cfg) override;
+    void Close() override;
+    bool IsOpen() const override { return m_h != INVALID_HANDLE_VALUE; }
+    long Read(void* buf, size_t len) override;
+    long Write(const void* data, size_t len) override;
+    void CancelRead() override;
+    std::string LastError() const override;
+    intptr_t NativeHandle() const override { return (intptr_t)m_h; }   // INVALID_HANDLE_VALUE = -1
+    long ReadNow(void* buf, size_t len) override;
+    bool SetPolledRead(bool) override { return true; }   // ReadNow() já não espera (MAXDWORD/0/0)
+    bool SetRxQueueSize(uint32_t bytes) override;
+    bool SetLineConfig(const SerialConfig& cfg) override;
+    SerialErrorCounts ErrorCounts() override;
+
+private:
+    bool Configure(const SerialConfig& cfg);
+    static void SetLineBits(DCB* dcb, const SerialConfig& cfg);
+    bool RecoverFromLineError();
+    bool ClearAndCountErrors();
+    void SetError(const char* what);
+
+    HANDLE m_h = INVALID_HANDLE_VALUE;
+    HANDLE m_cancelEvent = nullptr;   // manual-reset: CancelRead() -> sinalizado
+    OVERLAPPED m_ovRead = {};         // usados só pela thread de leitura
+    OVERLAPPED m_ovWait = {};
+    OVERLAPPED m_ovWrite = {};        // usado só pela thread de escrita
+    mutable std::mutex m_errLock;     // leitura e escrita podem falhar ao mesmo tempo
+    std::string m_lastError;
+    std::mutex m_countLock;           // ErrorCounts() (UI) x falhas de I/O (leitura/escrita)
+    SerialErrorCounts m_errorCounts;
+    uint32_t m_txQueueSize = 4096;    // repetido no SetupComm() de SetRxQueueSize()
+};
+
+// Bit 0 do hEvent = "não enfileirar no IOCP". O kernel ignora os 2 bits baixos
+// de um HANDLE, então Wait/ResetEvent funcionam com o valor marcado.
+static HANDLE TagNoIocp(HANDLE event) {
+    return event ? (HANDLE)((ULONG_PTR)event | 1) : nullptr;
+}
+
+static HANDLE UntagNoIocp(HANDLE event) {
+    return (HANDLE)((ULONG_PTR)event & ~(ULONG_PTR)1);
+}
+
+std::unique_ptr<SerialPort> CreateSerialPort() {
+    return std::unique_ptr<SerialPort>(new SerialPortWin32());
+}
+
+void SerialPortWin32::SetError(const char* what) {
+    std::string msg = std::string(what) + " (erro " + std::to_string(GetLastError()) + ")";
+    std::lock_guard<std::mutex> lock(m_errLock);
+    m_lastError = msg;
+}
+
+std::string SerialPortWin32::LastError() const {
+    std::lock_guard<std::mutex> lock(m_errLock);
+    return m_lastError;
+}
+
+bool SerialPortWin32::Open(const std::string& name, const SerialConfig& cfg) {
+    Close();
+    {
+        std::lock_guard<std::mutex> lock(m_countLock);
+        m_errorCounts = SerialErrorCounts();
+    }
+
+    // "COM6" -> "\\.\COM6" (COM10+ exige o prefixo; inofensivo para os demais):
+    std::string full = (name.compare(0, 4, "\\\\.\\") == 0) ? name : "\\\\.\\" + name;
+    int wlen = MultiByteToWideChar(CP_UTF8, 0, full.c_str(), -1, nullptr, 0);
+    std::wstring wname(wlen, 0);
+    MultiByteToWideChar(CP_UTF8, 0, full.c_str(), -1, &wname[0], wlen);
+
+    m_h = CreateFileW(wname.c_str(),
+        GENERIC_READ | GENERIC_WRITE,   // leitura e escrita
+        0,                              // sem compartilhamento
+        nullptr, OPEN_EXISTING,
+        FILE_FLAG_OVERLAPPED,           // RX orientado a eventos (WaitCommEvent)
+        nullptr);
+    if (m_h == INVALID_HANDLE_VALUE) {
+        SetError("CreateFile falhou");
+        return false;
+    }
+
+    m_cancelEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    m_ovRead.hEvent = TagNoIocp(CreateEventW(nullptr, TRUE, FALSE, nullptr));
+    m_ovWait.hEvent = TagNoIocp(CreateEventW(nullptr, TRUE, FALSE, nullptr));
+    m_ovWrite.hEvent = TagNoIocp(CreateEventW(nullptr, TRUE, FALSE, nullptr));
+
+    if (!Configure(cfg)) {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+bool SerialPortWin32::Configure(const SerialConfig& cfg) {
+    // Sugere buffers internos do driver (entrada/saída):
+    SetupComm(m_h, cfg.rxQueueSize, cfg.txQueueSize);
+    m_txQueueSize = cfg.txQueueSize;
+
+    // Limpa buffers e aborta I/O pendente para começar "do zero":
+    PurgeComm(m_h, PURGE_RXCLEAR | PURGE_TXCLEAR | PURGE_RXABORT | PURGE_TXABORT);
+
+    // Carrega configuração atual, para então ajustar:
+    DCB dcb = {};
+    dcb.DCBlength = sizeof(DCB);
+    if (!GetCommState(m_h, &dcb)) {
+        SetError("GetCommState falhou");
+        return false;
+    }
+
+    SetLineBits(&dcb, cfg);
+
+    // Handshake desativado por padrão (CTS/DSR/XON/XOFF):
+    // Se precisar (ex.: modem/rádio), habilite conforme o hardware.
+    dcb.fOutxCtsFlow = FALSE;
+    dcb.fOutxDsrFlow = FALSE;
+    dcb.fOutX = FALSE;
+    dcb.fInX = FALSE;
+
+    if (!SetCommState(m_h, &dcb)) {
+        SetError("SetCommState falhou");
+        return false;
+    }
+
+    // Leitura orientada a eventos:
+    // - Quem espera é WaitCommEvent(EV_RXCHAR), sem timeout (ver Read()).
+    // - ReadFile devolve NA HORA o que já está no driver
+    //   (MAXDWORD/0/0 = "retorna imediatamente com o disponível").
+    COMMTIMEOUTS t = {};
+    t.ReadIntervalTimeout = MAXDWORD;
+    t.ReadTotalTimeoutMultiplier = 0;
+    t.ReadTotalTimeoutConstant = 0;
+    t.WriteTotalTimeoutMultiplier = 0;
+    t.WriteTotalTimeoutConstant = cfg.writeTimeoutMs;
+    SetCommTimeouts(m_h, &t);
+
+    if (!SetCommMask(m_h, EV_RXCHAR)) {
+        SetError("SetCommMask falhou");
+        return false;
+    }
+
+    // Garante linhas DTR/RTS (redundante ao SetCommState, mas seguro):
+    EscapeCommFunction(m_h, cfg.dtr ? SETDTR : CLRDTR);
+    EscapeCommFunction(m_h, cfg.rts ? SETRTS : CLRRTS);
+    return true;
+}
+
+// Baud, formato e DTR/RTS (o resto do DCB fica como está).
+void SerialPortWin32::SetLineBits(DCB* dcb, const SerialConfig& cfg) {
+    // DCB aceita qualquer baud numérico; o driver arredonda/recusa o que não suporta.
+    dcb->BaudRate = cfg.baudRate;
+    dcb->fBinary = TRUE;      // obrigatório
+    dcb->ByteSize = cfg.dataBits;
+    switch (cfg.parity) {
+    case SerialParity::Odd:  dcb->Parity = ODDPARITY;  dcb->fParity = TRUE;  break;
+    case SerialParity::Even: dcb->Parity = EVENPARITY; dcb->fParity = TRUE;  break;
+    default:                 dcb->Parity = NOPARITY;   dcb->fParity = FALSE; break;
+    }
+    dcb->StopBits = (cfg.stopBits == SerialStopBits::Two) ? TWOSTOPBITS : ONESTOPBIT;
+    dcb->fDtrControl = cfg.dtr ? DTR_CONTROL_ENABLE : DTR_CONTROL_DISABLE;
+    dcb->fRtsControl = cfg.rts ? RTS_CONTROL_ENABLE : RTS_CONTROL_DISABLE;
+}
+
+bool SerialPortWin32::SetLineConfig(const SerialConfig& cfg) {
+    if (m_h == INVALID_HANDLE_VALUE || cfg.baudRate == 0) return false;
+    DCB dcb = {};
+    dcb.DCBlength = sizeof(DCB);
+    if (!GetCommState(m_h, &dcb)) {
+        SetError("GetCommState falhou");
+        return false;
+    }
+    SetLineBits(&dcb, cfg);
+    if (!SetCommState(m_h, &dcb)) {
+        SetError("SetCommState falhou");
+        return false;
+    }
+    EscapeCommFunction(m_h, cfg.dtr ? SETDTR : CLRDTR);
+    EscapeCommFunction(m_h, cfg.rts ? SETRTS : CLRRTS);
+    return true;
+}
+
+void SerialPortWin32::Close() {
+    if (m_h != INVALID_HANDLE_VALUE) {
+        CloseHandle(m_h);
+        m_h = INVALID_HANDLE_VALUE;
+    }
+    HANDLE* events[] = { &m_cancelEvent, &m_ovRead.hEvent, &m_ovWait.hEvent, &m_ovWrite.hEvent };
+    for (HANDLE* e : events) {
+        if (*e) {
+            CloseHandle(UntagNoIocp(*e));
+            *e = nullptr;
+        }
+    }
+}
+
+void SerialPortWin32::CancelRead() {
+    if (m_cancelEvent) SetEvent(m_cancelEvent);
+}
+
+// Erro de linha (overrun/framing/paridade) trava o I/O até ser limpo.
+// Se nem ClearCommError funciona, o dispositivo sumiu (ex.: USB removido).
+bool SerialPortWin32::RecoverFromLineError() {
+    if (!ClearAndCountErrors()) {
+        SetError("porta perdida");
+        return false;
+    }
+    return true;
+}
+
+bool SerialPortWin32::ClearAndCountErrors() {
+    DWORD errors = 0;
+    if (!ClearCommError(m_h, &errors, nullptr)) return false;
+    if (errors) {
+        std::lock_guard<std::mutex> lock(m_countLock);
+        if (errors & CE_OVERRUN) m_errorCounts.overrun++;
+        if (errors & CE_RXPARITY) m_errorCounts.parity++;
+        if (errors & CE_FRAME) m_errorCounts.framing++;
+        if (errors & CE_RXOVER) m_errorCounts.bufferFull++;
+        if (errors & CE_BREAK) m_errorCounts.breaks++;
+    }
+    return true;
+}
+
+SerialErrorCounts SerialPortWin32::ErrorCounts() {
+    if (m_h != INVALID_HANDLE_VALUE) ClearAndCountErrors();
+    std::lock_guard<std::mutex> lock(m_countLock);
+    return m_errorCounts;
+}
+
+long SerialPortWin32::Read(void* buf, size_t len) {
+    DWORD want = (len > MAXDWORD) ? MAXDWORD : (DWORD)len;
+
+    for (;;) {
+        if (WaitForSingleObject(m_cancelEvent, 0) == WAIT_OBJECT_0) return 0;
+
+        // 1) O que já está no driver (não bloqueia):
+        DWORD got = 0;
+        ResetEvent(m_ovRead.hEvent);
+        if (!ReadFile(m_h, buf, want, &got, &m_ovRead)) {
+            if (GetLastError() != ERROR_IO_PENDING ||
+                !GetOverlappedResult(m_h, &m_ovRead, &got, TRUE)) {
+                if (!RecoverFromLineError()) return -1;
+                // Evita busy loop se o driver insistir no erro (e ainda atende o cancelamento):
+                if (WaitForSingleObject(m_cancelEvent, 5) == WAIT_OBJECT_0) return 0;
+                continue;
+            }
+        }
+        if (got > 0) return (long)got;
+
+        // 2) Driver vazio: dorme até EV_RXCHAR ou CancelRead().
+        // Um byte que chegue entre (1) e (2) fica no histórico de eventos do
+        // driver e faz este WaitCommEvent retornar imediatamente.
+        DWORD mask = 0, dummy = 0;
+        ResetEvent(m_ovWait.hEvent);
+        if (!WaitCommEvent(m_h, &mask, &m_ovWait)) {
+            if (GetLastError() != ERROR_IO_PENDING) {
+                if (!RecoverFromLineError()) return -1;
+                if (WaitForSingleObject(m_cancelEvent, 5) == WAIT_OBJECT_0) return 0;
+                continue;
+            }
+            HANDLE waits[2] = { m_ovWait.hEvent, m_cancelEvent };
+            DWORD r = WaitForMultipleObjects(2, waits, FALSE, INFINITE);
+            if (r != WAIT_OBJECT_0) {
+                // Cancelado: CancelIo só vale para o I/O DESTA thread; espera o
+                // WaitCommEvent concluir antes de reutilizar m_ovWait.
+                CancelIo(m_h);
+                GetOverlappedResult(m_h, &m_ovWait, &dummy, TRUE);
+                return 0;
+            }
+            GetOverlappedResult(m_h, &m_ovWait, &dummy, FALSE);
+        }
+    }
+}
+
+// Reactor: devolve o que já está no driver (timeouts MAXDWORD/0/0). O aviso
+// de que chegou algo é o WaitCommEvent do reactor, concluído no IOCP.
+long SerialPortWin32::ReadNow(void* buf, size_t len) {
+    DWORD want = (len > MAXDWORD) ? MAXDWORD : (DWORD)len;
+    DWORD got = 0;
+    ResetEvent(m_ovRead.hEvent);
+    if (!ReadFile(m_h, buf, want, &got, &m_ovRead)) {
+        if (GetLastError() != ERROR_IO_PENDING ||
+            !GetOverlappedResult(m_h, &m_ovRead, &got, TRUE)) {
+            return RecoverFromLineError() ? 0 : -1;
+        }
+    }
+    return (long)got;
+}
+
+// A documentação pede SetupComm antes do primeiro I/O: o reactor aplica o
+// tamanho inicial (da taxa nominal) no Add(), antes de ler. Os aumentos
+// seguintes são sugestão: driver que recusa devolve FALSE e a fila fica.
+bool SerialPortWin32::SetRxQueueSize(uint32_t bytes) {
+    return SetupComm(m_h, bytes, m_txQueueSize) != FALSE;
+}
+
+long SerialPortWin32::Write(const void* data, size_t len) {
+    DWORD want = (len > MAXDWORD) ? MAXDWORD : (DWORD)len;
+    DWORD written = 0;
+    ResetEvent(m_ovWrite.hEvent);
+    BOOL ok = WriteFile(m_h, data, want, &written, &m_ovWrite);
+    if (!ok && GetLastError() == ERROR_IO_PENDING) {
+        ok = GetOverlappedResult(m_h, &m_ovWrite, &written, TRUE);
+    }
+    if (!ok) {
+        SetError("WriteFile falhou");
+        RecoverFromLineError();
+        return -1;
+    }
+    return (long)written;   // < len: timeout de escrita (ex.: flow control)
+}
+
+#endif /* _WIN32 */
@@ -0,0 +1,633 @@
+// SerialReactor.cpp - epoll (Linux) / IOCP (Windows) para várias portas (ver SerialReactor.h)
+
+#include "SerialReactor.h"
+#include "PreciseTimer.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <thread>
+#include <unordered_map>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <time.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#endif
+
+namespace {
+const size_t kReadBytes = 16 * 1024;     // por ReadNow()/Read() (sem AdaptiveIo)
+const size_t kMinTail = 1024;            // resto do bloco menor que isso: pega outro
+const int kMaxEvents = 64;               // epoll_wait: avisos tratados por volta
+
+// Tempo de CPU de uma thread (para medir portas por núcleo).
+uint64_t ThreadCpuNs(std::thread& t) {
+#ifdef _WIN32
+    FILETIME created, exited, kernel, user;
+    if (!GetThreadTimes((HANDLE)t.native_handle(), &created, &exited, &kernel, &user)) return 0;
+    ULARGE_INTEGER k, u;
+    k.LowPart = kernel.dwLowDateTime;
+    k.HighPart = kernel.dwHighDateTime;
+    u.LowPart = user.dwLowDateTime;
+    u.HighPart = user.dwHighDateTime;
+    return (k.QuadPart + u.QuadPart) * 100;   // unidades de 100 ns
+#else
+    clockid_t cid;
+    timespec ts;
+    if (pthread_getcpuclockid(t.native_handle(), &cid) != 0 || clock_gettime(cid, &ts) != 0) return 0;
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+}
+
+struct SerialReactor::Entry {
+    uint64_t id = 0;
+    SerialPort* port = nullptr;
+    DataFn onData;
+    LostFn onLost;
+    bool lost = false;             // parou de ser lida (onLost já chamado)
+    std::thread thread;            // só portas sem handle nativo
+    std::unique_ptr<AdaptiveIo> adaptive;   // nullptr = leitura fixa
+    size_t   chunk = kReadBytes;   // bytes por ReadNow()
+    uint32_t rxQueue = 0;          // último SetRxQueueSize() aplicado
+    uint32_t batchMs = 0;          // != 0: modo lote (lida por relógio)
+    int64_t  dueNs = 0;            // próxima leitura do lote
+    bool     pollable = true;      // false = SetPolledRead() recusou: só por evento
+    RxChunk* cur = nullptr;        // bloco onde a porta está lendo (uma referência nossa)
+    size_t   used = 0;             // bytes de 'cur' já entregues
+#ifdef _WIN32
+    OVERLAPPED ov = {};            // WaitCommEvent do reactor (conclui no IOCP)
+    DWORD mask = 0;
+    bool pending = false;          // WaitCommEvent em andamento
+    Command* removeCmd = nullptr;  // Remove() esperando o cancelamento concluir
+#endif
+
+    ~Entry() {
+        if (cur) ChunkPool::Release(cur);
+    }
+};
+
+// Pedido de outra thread para a thread do shard (quem pede espera 'done').
+struct SerialReactor::Command {
+    enum Kind { Add, Remove, Stop };
+    Kind kind = Stop;
+    std::unique_ptr<Entry> entry;  // Add
+    uint64_t id = 0;               // Remove
+    bool ok = true;
+    std::string error;
+    bool done = false;
+};
+
+struct SerialReactor::Shard {
+    std::thread thread;
+    std::mutex lock;                           // commands, Command::done
+    std::condition_variable doneCv;
+    std::deque<Command*> commands;
+    std::unordered_map<uint64_t, std::unique_ptr<Entry>> entries;   // só a thread do shard mexe
+    std::atomic<size_t> ports{ 0 };
+    std::atomic<uint64_t> wakeups{ 0 };
+    std::atomic<uint64_t> reads{ 0 };
+    std::atomic<uint64_t> emptyReads{ 0 };
+    std::atomic<uint64_t> bytes{ 0 };
+    std::atomic<size_t>   batched{ 0 };
+    std::atomic<uint64_t> profileChanges{ 0 };
+#ifdef _WIN32
+    HANDLE iocp = nullptr;
+#else
+    int epoll = -1;
+    int wakeFd = -1;                           // eventfd: há comandos na fila
+#endif
+
+    ~Shard() {
+#ifdef _WIN32
+        if (iocp) CloseHandle(iocp);
+#else
+        if (epoll >= 0) close(epoll);
+        if (wakeFd >= 0) close(wakeFd);
+#endif
+    }
+};
+
+SerialReactor::SerialReactor(size_t poolChunks) : m_pool(kChunkBytes, poolChunks) {}
+
+SerialReactor::~SerialReactor() {
+    Stop();
+}
+
+std::string SerialReactor::LastError() const {
+    std::lock_guard<std::mutex> lock(m_lock);
+    return m_lastError;
+}
+
+bool SerialReactor::Start(size_t threads) {
+    Stop();
+    if (threads == 0) threads = 1;
+
+    for (size_t i = 0; i < threads; ++i) {
+        std::unique_ptr<Shard> s(new Shard());
+#ifdef _WIN32
+        s->iocp = CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, 1);
+        bool ok = s->iocp != nullptr;
+#else
+        s->epoll = epoll_create1(EPOLL_CLOEXEC);
+        s->wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        bool ok = s->epoll >= 0 && s->wakeFd >= 0;
+        if (ok) {
+            epoll_event ev = {};
+            ev.events = EPOLLIN;
+            ev.data.ptr = nullptr;                 // nullptr = eventfd de comandos
+            ok = epoll_ctl(s->epoll, EPOLL_CTL_ADD, s->wakeFd, &ev) == 0;
+        }
+#endif
+        if (!ok) {
+            {
+                std::lock_guard<std::mutex> lock(m_lock);
+#ifdef _WIN32
+                m_lastError = "CreateIoCompletionPort falhou (erro " + std::to_string(GetLastError()) + ")";
+#else
+                m_lastError = std::string("epoll/eventfd falhou: ") + strerror(errno);
+#endif
+            }
+            Stop();
+            return false;
+        }
+        Shard* raw = s.get();
+        s->thread = std::thread([this, raw] { Run(raw); });
+        m_shards.push_back(std::move(s));
+    }
+    return true;
+}
+
+void SerialReactor::Stop() {
+    std::vector<uint64_t> ids;
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        for (const auto& kv : m_owner) ids.push_back(kv.first);
+        for (const auto& kv : m_threaded) ids.push_back(kv.first);
+    }
+    for (uint64_t id : ids) Remove(id);
+
+    for (auto& s : m_shards) {
+        Command cmd;
+        cmd.kind = Command::Stop;
+        Submit(s.get(), &cmd);
+        s->thread.join();
+    }
+    m_shards.clear();
+}
+
+uint64_t SerialReactor::Add(SerialPort* port, DataFn onData, LostFn onLost,
+                            const AdaptiveIoConfig& adaptive) {
+    std::unique_ptr<Entry> e(new Entry());
+    e->id = m_nextId.fetch_add(1);
+    e->port = port;
+    e->onData = onData;
+    e->onLost = onLost;
+    uint64_t id = e->id;
+    if (adaptive.enabled) e->adaptive.reset(new AdaptiveIo(adaptive));
+
+    // Sem handle nativo: thread própria, como era o SerialReadLoop().
+    if (port->NativeHandle() == -1) {
+        Entry* raw = e.get();
+        std::lock_guard<std::mutex> lock(m_lock);
+        raw->thread = std::thread([this, raw] { ThreadLoop(raw); });
+        m_threaded[id] = std::move(e);
+        return id;
+    }
+
+    if (m_shards.empty()) {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_lastError = "reactor parado";
+        return 0;
+    }
+
+    // Shard com menos portas:
+    Shard* best = m_shards[0].get();
+    for (auto& s : m_shards)
+        if (s->ports.load() < best->ports.load()) best = s.get();
+
+    Command cmd;
+    cmd.kind = Command::Add;
+    cmd.entry = std::move(e);
+    Submit(best, &cmd);
+
+    std::lock_guard<std::mutex> lock(m_lock);
+    if (!cmd.ok) {
+        m_lastError = cmd.error;
+        return 0;
+    }
+    best->ports.fetch_add(1);
+    m_owner[id] = best;
+    return id;
+}
+
+void SerialReactor::Remove(uint64_t id) {
+    std::unique_ptr<Entry> threaded;
+    Shard* s = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        auto t = m_threaded.find(id);
+        if (t != m_threaded.end()) {
+            threaded = std::move(t->second);
+            m_threaded.erase(t);
+        }
+        auto o = m_owner.find(id);
+        if (o != m_owner.end()) {
+            s = o->second;
+            m_owner.erase(o);
+        }
+    }
+
+    if (threaded) {
+        threaded->port->CancelRead();
+        if (threaded->thread.joinable()) threaded->thread.join();
+        return;
+    }
+    if (!s) return;
+
+    Command cmd;
+    cmd.kind = Command::Remove;
+    cmd.id = id;
+    Submit(s, &cmd);
+    s->ports.fetch_sub(1);
+}
+
+ReactorStats SerialReactor::Stats() const {
+    ReactorStats r;
+    r.threads = m_shards.size();
+    for (const auto& s : m_shards) {
+        r.ports += s->ports.load();
+        r.wakeups += s->wakeups.load(std::memory_order_relaxed);
+        r.reads += s->reads.load(std::memory_order_relaxed);
+        r.emptyReads += s->emptyReads.load(std::memory_order_relaxed);
+        r.bytes += s->bytes.load(std::memory_order_relaxed);
+        r.batchedPorts += s->batched.load(std::memory_order_relaxed);
+        r.profileChanges += s->profileChanges.load(std::memory_order_relaxed);
+        r.cpuNs += ThreadCpuNs(s->thread);
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        r.ports += m_threaded.size();
+    }
+    r.reads += m_threadReads.load(std::memory_order_relaxed);
+    r.bytes += m_threadBytes.load(std::memory_order_relaxed);
+    ChunkPoolStats pool = m_pool.Stats();
+    r.chunksInUse = pool.inUse;
+    r.chunkHeapAllocs = pool.heapAllocs;
+    return r;
+}
+
+// Entrega o pedido à thread do shard e espera ela concluir.
+void SerialReactor::Submit(Shard* s, Command* cmd) {
+    std::unique_lock<std::mutex> lock(s->lock);
+    s->commands.push_back(cmd);
+#ifdef _WIN32
+    PostQueuedCompletionStatus(s->iocp, 0, 0, nullptr);
+#else
+    uint64_t one = 1;
+    ssize_t w = write(s->wakeFd, &one, sizeof(one));
+    (void)w;
+#endif
+    s->doneCv.wait(lock, [cmd] { return cmd->done; });
+}
+
+static void CompleteCommand(std::mutex& lock, std::condition_variable& cv, bool* done) {
+    {
+        std::lock_guard<std::mutex> g(lock);
+        *done = true;
+    }
+    cv.notify_all();
+}
+
+// Na thread do shard, entre lotes de eventos: nenhum evento já lido aponta
+// para uma porta que some aqui.
+bool SerialReactor::ProcessCommands(Shard* s) {
+    std::deque<Command*> cmds;
+    {
+        std::lock_guard<std::mutex> lock(s->lock);
+        cmds.swap(s->commands);
+    }
+
+    bool keepRunning = true;
+    for (Command* c : cmds) {
+        bool finished = true;
+        if (c->kind == Command::Add) {
+            Entry* e = c->entry.get();
+#ifdef _WIN32
+            if (!CreateIoCompletionPort((HANDLE)e->port->NativeHandle(), s->iocp, (ULONG_PTR)e, 0)) {
+                c->ok = false;
+                c->error = "CreateIoCompletionPort (porta) falhou (erro " + std::to_string(GetLastError()) + ")";
+            }
+            else {
+                s->entries[e->id] = std::move(c->entry);
+                if (e->adaptive) Apply(s, e);      // fila do driver antes do primeiro ReadFile
+                Service(s, e, 0);                  // drena o que já chegou e arma a espera
+            }
+#else
+            epoll_event ev = {};
+            ev.events = EPOLLIN;
+            ev.data.ptr = e;
+            if (epoll_ctl(s->epoll, EPOLL_CTL_ADD, (int)e->port->NativeHandle(), &ev) != 0) {
+                c->ok = false;
+                c->error = std::string("epoll_ctl falhou: ") + strerror(errno);
+            }
+            else {
+                s->entries[e->id] = std::move(c->entry);
+                if (e->adaptive) Apply(s, e);
+            }
+#endif
+        }
+        else if (c->kind == Command::Remove) {
+            auto it = s->entries.find(c->id);
+            if (it != s->entries.end()) {
+                Entry* e = it->second.get();
+                if (e->batchMs) s->batched.fetch_sub(1, std::memory_order_relaxed);
+#ifdef _WIN32
+                // WaitCommEvent pendente: só libera depois que o cancelamento concluir.
+                if (e->pending) {
+                    e->removeCmd = c;
+                    CancelIoEx((HANDLE)e->port->NativeHandle(), &e->ov);
+                    finished = false;
+                }
+                else {
+                    s->entries.erase(it);
+                }
+#else
+                if (!e->lost) epoll_ctl(s->epoll, EPOLL_CTL_DEL, (int)e->port->NativeHandle(), nullptr);
+                s->entries.erase(it);
+#endif
+            }
+        }
+        else {
+            keepRunning = false;
+        }
+        if (finished) CompleteCommand(s->lock, s->doneCv, &c->done);
+    }
+    return keepRunning;
+}
+
+// Ninguém mais segura o bloco (refs == 1, só a nossa): os consumidores já
+// soltaram tudo e a leitura volta ao início dele. O acquire casa com o
+// release do último Release(): eles terminaram de ler antes de sobrescrevermos.
+uint8_t* SerialReactor::ReadSpace(Entry* e, size_t* len) {
+    const size_t size = m_pool.ChunkBytes();
+    const size_t want = std::min(e->chunk, size);
+    if (e->cur && e->cur->refs.load(std::memory_order_acquire) == 1) e->used = 0;
+    if (e->cur && size - e->used < std::min(want, kMinTail)) {
+        ChunkPool::Release(e->cur);
+        e->cur = nullptr;
+    }
+    if (!e->cur) {
+        e->cur = m_pool.Acquire();
+        e->used = 0;
+    }
+    *len = std::min(want, size - e->used);
+    return e->cur->data + e->used;
+}
+
+void SerialReactor::Deliver(Entry* e, size_t n) {
+    RxSpan span(e->cur, e->cur->data + e->used, n);
+    e->used += n;
+    e->onData(span);
+}
+
+void SerialReactor::ThreadLoop(Entry* e) {
+    for (;;) {
+        size_t len;
+        uint8_t* buf = ReadSpace(e, &len);
+        long n = e->port->Read(buf, len);
+        if (n > 0) {
+            m_threadReads.fetch_add(1, std::memory_order_relaxed);
+            m_threadBytes.fetch_add((uint64_t)n, std::memory_order_relaxed);
+            Deliver(e, (size_t)n);
+        }
+        else if (n == 0) {
+            break;                                 // CancelRead() (Remove) ou fim da reprodução
+        }
+        else {
+            e->lost = true;
+            if (e->onLost) e->onLost();
+            break;
+        }
+    }
+}
+
+// ============================================================================
+//                          Leitura adaptativa (lote)
+// ============================================================================
+// Um Service() = uma "leitura" para o AdaptiveIo (no Windows, a drenagem
+// inteira): o ReadNow() vazio que encerra a drenagem não conta como lote vazio.
+void SerialReactor::Tune(Shard* s, Entry* e, size_t bytes) {
+    if (!e->adaptive) return;
+    int64_t now = PreciseTimer::NowNs();
+    if (e->adaptive->OnRead(bytes, now)) {
+        Apply(s, e);
+        s->profileChanges.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (e->batchMs) e->dueNs = e->adaptive->NextReadNs(bytes, now);
+}
+
+// Entrar/sair do lote: no Linux troca a máscara do epoll (vazia = só
+// EPOLLHUP/EPOLLERR, que continuam avisando a perda da porta); no Windows
+// basta o Service() em andamento não rearmar o WaitCommEvent.
+void SerialReactor::Apply(Shard* s, Entry* e) {
+    const AdaptiveIoProfile& p = e->adaptive->Profile();
+    e->chunk = p.readChunk;                        // limitado ao bloco do pool em ReadSpace()
+    if (p.rxQueue && p.rxQueue != e->rxQueue) {
+        e->port->SetRxQueueSize(p.rxQueue);
+        e->rxQueue = p.rxQueue;
+    }
+
+    uint32_t batch = e->pollable ? p.batchMs : 0;
+    if ((batch != 0) != (e->batchMs != 0)) {
+        if (batch && !e->port->SetPolledRead(true)) {
+            e->pollable = false;                   // backend sem leitura por relógio: fica por evento
+            batch = 0;
+        }
+        else {
+            if (!batch) e->port->SetPolledRead(false);
+#ifndef _WIN32
+            epoll_event ev = {};
+            ev.events = batch ? 0u : (uint32_t)EPOLLIN;
+            ev.data.ptr = e;
+            epoll_ctl(s->epoll, EPOLL_CTL_MOD, (int)e->port->NativeHandle(), &ev);
+#endif
+            if (batch) s->batched.fetch_add(1, std::memory_order_relaxed);
+            else s->batched.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+    e->batchMs = batch;
+}
+
+int SerialReactor::NextDueMs(Shard* s) {
+    if (s->batched.load(std::memory_order_relaxed) == 0) return -1;
+    int64_t next = INT64_MAX;
+    for (const auto& kv : s->entries) {
+        const Entry* e = kv.second.get();
+        if (e->batchMs && !e->lost) next = std::min(next, e->dueNs);
+    }
+    if (next == INT64_MAX) return -1;
+    int64_t left = next - PreciseTimer::NowNs();
+    return left <= 0 ? 0 : (int)((left + 999999) / 1000000);
+}
+
+void SerialReactor::ServiceDue(Shard* s) {
+    if (s->batched.load(std::memory_order_relaxed) == 0) return;
+    int64_t now = PreciseTimer::NowNs();
+    for (auto& kv : s->entries) {
+        Entry* e = kv.second.get();
+        if (e->batchMs && !e->lost && e->dueNs <= now) Service(s, e, 0);
+    }
+}
+
+#ifdef _WIN32
+
+// ============================================================================
+//                               Windows (IOCP)
+// ============================================================================
+void SerialReactor::Run(Shard* s) {
+    for (;;) {
+        ServiceDue(s);
+        int due = NextDueMs(s);
+        DWORD n = 0;
+        ULONG_PTR key = 0;
+        OVERLAPPED* ov = nullptr;
+        BOOL ok = GetQueuedCompletionStatus(s->iocp, &n, &key, &ov, due < 0 ? INFINITE : (DWORD)due);
+        if (!ov) {
+            if (!ok && GetLastError() == WAIT_TIMEOUT) {
+                s->wakeups.fetch_add(1, std::memory_order_relaxed);
+                continue;                          // hora do lote: ServiceDue() no topo
+            }
+            if (!ok) return;                       // IOCP fechado
+            if (!ProcessCommands(s)) return;       // aviso de comando
+            continue;
+        }
+        s->wakeups.fetch_add(1, std::memory_order_relaxed);
+
+        Entry* e = (Entry*)key;
+        e->pending = false;
+        if (e->removeCmd) {
+            FinishRemove(s, e);
+            continue;
+        }
+        Service(s, e, 0);   // concluído (ou falhou: ReadNow() limpa o erro de linha)
+    }
+}
+
+void SerialReactor::FinishRemove(Shard* s, Entry* e) {
+    Command* c = e->removeCmd;
+    s->entries.erase(e->id);
+    CompleteCommand(s->lock, s->doneCv, &c->done);
+}
+
+// (1) Drena o driver; (2) rearma o WaitCommEvent. Um byte que chegue entre
+// (1) e (2) fica no histórico de eventos e conclui a espera na hora.
+// Modo lote: só (1); a próxima drenagem vem do relógio (ServiceDue()).
+void SerialReactor::Service(Shard* s, Entry* e, uint32_t) {
+    if (e->lost) return;
+    HANDLE h = (HANDLE)e->port->NativeHandle();
+
+    for (int attempt = 0; ; ++attempt) {
+        size_t total = 0;
+        for (;;) {
+            size_t len;
+            uint8_t* buf = ReadSpace(e, &len);
+            long n = e->port->ReadNow(buf, len);
+            if (n < 0) {
+                e->lost = true;
+                if (e->onLost) e->onLost();
+                return;
+            }
+            if (n > 0) {
+                s->reads.fetch_add(1, std::memory_order_relaxed);
+                s->bytes.fetch_add((uint64_t)n, std::memory_order_relaxed);
+                Deliver(e, (size_t)n);
+                total += (size_t)n;
+            }
+            else {
+                s->emptyReads.fetch_add(1, std::memory_order_relaxed);
+            }
+            if ((size_t)n < len) break;            // driver vazio
+        }
+        if (attempt == 0) Tune(s, e, total);
+        if (e->batchMs) return;
+
+        ZeroMemory(&e->ov, sizeof(e->ov));
+        e->mask = 0;
+        // Sucesso imediato também gera conclusão no IOCP (sem SKIP_COMPLETION_PORT).
+        if (WaitCommEvent(h, &e->mask, &e->ov) || GetLastError() == ERROR_IO_PENDING) {
+            e->pending = true;
+            return;
+        }
+        // Erro de linha: o ReadNow() da próxima volta limpa (ClearCommError);
+        // se persistir, a porta é dada como perdida.
+        if (attempt > 0) {
+            e->lost = true;
+            if (e->onLost) e->onLost();
+            return;
+        }
+    }
+}
+
+#else
+
+// ============================================================================
+//                               Linux (epoll)
+// ============================================================================
+void SerialReactor::Run(Shard* s) {
+    epoll_event ev[kMaxEvents];
+    for (;;) {
+        if (!ProcessCommands(s)) return;
+        ServiceDue(s);
+        int n = epoll_wait(s->epoll, ev, kMaxEvents, NextDueMs(s));
+        if (n < 0) continue;                       // EINTR
+        s->wakeups.fetch_add(1, std::memory_order_relaxed);
+
+        for (int i = 0; i < n; ++i) {
+            Entry* e = (Entry*)ev[i].data.ptr;
+            if (!e) {                              // comandos: tratados no topo do laço
+                uint64_t v;
+                ssize_t r = read(s->wakeFd, &v, sizeof(v));
+                (void)r;
+                continue;
+            }
+            Service(s, e, ev[i].events);
+        }
+    }
+}
+
+// Por nível: um read() por aviso; se sobrou, o próximo epoll_wait volta na hora
+// e as outras portas do shard são atendidas no meio. Modo lote: um read() por
+// prazo (ServiceDue(), events = 0), com o fd em O_NONBLOCK.
+void SerialReactor::Service(Shard* s, Entry* e, uint32_t events) {
+    if (e->lost) return;
+    size_t len;
+    uint8_t* buf = ReadSpace(e, &len);
+    long n = e->port->ReadNow(buf, len);
+    if (n > 0) {
+        s->reads.fetch_add(1, std::memory_order_relaxed);
+        s->bytes.fetch_add((uint64_t)n, std::memory_order_relaxed);
+        Deliver(e, (size_t)n);
+        Tune(s, e, (size_t)n);
+        return;
+    }
+    if (n == 0) {
+        s->emptyReads.fetch_add(1, std::memory_order_relaxed);
+        Tune(s, e, 0);
+        if (!(events & (EPOLLHUP | EPOLLERR))) return;
+    }
+
+    // Erro ou desligamento (ex.: EIO com o adaptador removido): tira do epoll
+    // para não girar em falso e avisa uma vez.
+    epoll_ctl(s->epoll, EPOLL_CTL_DEL, (int)e->port->NativeHandle(), nullptr);
+    e->lost = true;
+    if (e->onLost) e->onLost();
+}
+
+#endif
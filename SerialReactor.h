@@ -0,0 +1,124 @@
+// SerialReactor.h - Poucas threads de RX servindo muitas portas
+// Objetivo: monitorar 8-16 dispositivos ao mesmo tempo sem uma thread
+//           bloqueada em Read() por porta.
+//
+//  - Linux: epoll (por nível) nos fds das portas; cada aviso = um ReadNow().
+//  - Windows: IOCP; cada porta tem um WaitCommEvent(EV_RXCHAR) overlapped
+//    pendente; a conclusão drena o driver com ReadNow() e rearma a espera.
+//  - Portas sem handle nativo (ex.: ReplaySerialPort) ganham uma thread
+//    própria com o Read() bloqueante de sempre.
+//
+// Leitura adaptativa (opcional, por porta): um AdaptiveIo observa a taxa e
+// ajusta o tamanho da leitura, a fila RX do driver e o modo. No modo lote a
+// porta sai da espera por evento (epoll com máscara vazia / sem
+// WaitCommEvent) e o shard a lê por relógio a cada batchMs, usando o timeout
+// do próprio epoll_wait/GetQueuedCompletionStatus: nenhuma syscall a mais.
+//
+// Buffers: o reactor lê direto em blocos de um ChunkPool (ChunkPool.h) e
+// entrega cada leitura como RxSpan. Leituras seguidas de uma porta continuam
+// no mesmo bloco até ele encher; se todos os spans do bloco já foram soltos,
+// a próxima leitura recomeça do início dele (a porta fica no mesmo bloco,
+// quente no cache, enquanto os consumidores acompanham).
+//
+// Com várias threads ("shards"), cada porta fica presa a uma delas (a que
+// tem menos portas): os callbacks de uma porta nunca rodam em paralelo nem
+// fora de ordem.
+//
+// Callbacks rodam NA THREAD DO REACTOR e atrasam as outras portas do shard:
+// devem só guardar o span (ex.: RxSpanQueue) e avisar, nunca bloquear.
+// O reactor precisa viver mais que todos os spans que entregou.
+//
+// Não depende de Win32 no cabeçalho.
+
+#pragma once
+
+#include "AdaptiveIo.h"
+#include "ChunkPool.h"
+#include "SerialPort.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct ReactorStats {
+    size_t   threads = 0;          // shards (sem contar threads de porta sem handle)
+    size_t   ports = 0;            // portas registradas (todas)
+    uint64_t wakeups = 0;          // retornos do epoll_wait/GetQueuedCompletionStatus
+    uint64_t reads = 0;            // ReadNow()/Read() que trouxeram bytes
+    uint64_t emptyReads = 0;       // ReadNow() sem nada (fim da drenagem, lote vazio)
+    uint64_t bytes = 0;
+    size_t   batchedPorts = 0;     // portas no modo lote agora
+    uint64_t profileChanges = 0;   // perfis do AdaptiveIo aplicados
+    size_t   chunksInUse = 0;      // blocos do pool com spans vivos (ou em leitura)
+    uint64_t chunkHeapAllocs = 0;  // pool vazio: blocos tirados do heap
+    uint64_t cpuNs = 0;            // CPU (usuário + kernel) gasta pelas threads dos shards
+};
+
+class SerialReactor {
+public:
+    // O span vale só durante a chamada; para guardar os bytes, copie o span.
+    using DataFn = std::function<void(const RxSpan& data)>;
+    using LostFn = std::function<void()>;    // porta falhou (ex.: USB removido); chamado uma vez
+
+    // 'poolChunks' blocos de kChunkBytes (o padrão, 4 MB, cobre 16 portas
+    // com ~256 KB de fila cada; além disso os blocos saem do heap).
+    static const size_t kChunkBytes = 16 * 1024;
+    explicit SerialReactor(size_t poolChunks = 256);
+    ~SerialReactor();
+
+    SerialReactor(const SerialReactor&) = delete;
+    SerialReactor& operator=(const SerialReactor&) = delete;
+
+    bool Start(size_t threads = 1);
+    void Stop();                   // remove todas as portas e para as threads
+    bool Running() const { return !m_shards.empty(); }
+
+    // Passa a ler 'port' (já aberta). Retorna um id (> 0) ou 0 em erro
+    // (ver LastError()). A porta precisa viver até Remove().
+    // 'adaptive.enabled': leitura adaptativa (ignorada sem handle nativo).
+    uint64_t Add(SerialPort* port, DataFn onData, LostFn onLost,
+                 const AdaptiveIoConfig& adaptive = AdaptiveIoConfig());
+
+    // Síncrono: ao retornar, nenhum callback da porta está rodando nem vai
+    // rodar. Não chame de dentro de um callback do reactor.
+    void Remove(uint64_t id);
+
+    ReactorStats Stats() const;
+    ChunkPoolStats PoolStats() const { return m_pool.Stats(); }
+    std::string LastError() const;
+
+private:
+    struct Entry;
+    struct Shard;
+    struct Command;
+
+    void Run(Shard* s);
+    bool ProcessCommands(Shard* s);
+    void Submit(Shard* s, Command* cmd);
+    void Service(Shard* s, Entry* e, uint32_t events);
+    void FinishRemove(Shard* s, Entry* e);
+    void Tune(Shard* s, Entry* e, size_t bytes);   // depois de cada Service() com leitura
+    void Apply(Shard* s, Entry* e);
+    int  NextDueMs(Shard* s);                      // -1 = nenhuma porta no modo lote
+    void ServiceDue(Shard* s);
+    void ThreadLoop(Entry* e);
+    uint8_t* ReadSpace(Entry* e, size_t* len);     // onde ler agora (no bloco atual da porta)
+    void Deliver(Entry* e, size_t n);              // entrega os 'n' bytes lidos em ReadSpace()
+
+    ChunkPool m_pool;                                     // antes das portas: sai por último
+    std::vector<std::unique_ptr<Shard>> m_shards;
+    std::atomic<uint64_t> m_nextId{ 1 };
+
+    mutable std::mutex m_lock;                            // m_owner, m_threaded, m_lastError
+    std::map<uint64_t, Shard*> m_owner;                   // porta -> shard
+    std::map<uint64_t, std::unique_ptr<Entry>> m_threaded;  // portas sem handle nativo
+    std::string m_lastError;
+
+    std::atomic<uint64_t> m_threadReads{ 0 };
+    std::atomic<uint64_t> m_threadBytes{ 0 };
+};
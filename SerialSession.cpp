@@ -0,0 +1,316 @@
+// SerialSession.cpp - Pipeline RX/TX de uma porta (ver SerialSession.h)
+
+#include "SerialSession.h"
+#include "DeviceSim.h"
+#include "PreciseTimer.h"
+
+SerialSession::SerialSession(uint32_t id, SerialReactor* reactor, const SessionEvents& events,
+                             size_t rxQueueBytes)
+    : m_id(id), m_reactor(reactor), m_events(events), m_rx(rxQueueBytes) {
+}
+
+SerialSession::~SerialSession() {
+    if (m_bridgeOwner) m_bridgeOwner->Stop();  // usa a TxQueue e a porta
+    Close();
+    if (m_captureOwner) m_captureOwner->Stop();
+}
+
+std::string SerialSession::LastError() const {
+    return m_port ? m_port->LastError() : m_lastError;
+}
+
+// "sim:..." abre o dispositivo simulado (DeviceSim.h) no lugar da porta nativa.
+bool SerialSession::Open(const std::string& portName, const SerialConfig& cfg) {
+    Close();
+    std::unique_ptr<SerialPort> port = IsDeviceSimName(portName)
+        ? std::unique_ptr<SerialPort>(new SimSerialPort()) : CreateSerialPort();
+    if (!port->Open(portName, cfg)) {
+        m_lastError = port->LastError();
+        return false;
+    }
+    m_portName = portName;
+    m_baudRate = cfg.baudRate;
+    {
+        std::lock_guard<std::mutex> lock(m_lineLock);
+        m_line = cfg;
+    }
+    return StartIo(std::move(port));
+}
+
+bool SerialSession::OpenReplay(const std::string& path, const ReplayOptions& opt) {
+    Close();
+    std::unique_ptr<ReplaySerialPort> port(new ReplaySerialPort(opt));
+    if (!port->Open(path, SerialConfig())) {
+        m_lastError = port->LastError();
+        return false;
+    }
+    uint32_t id = m_id;
+    port->SetOnEnd([this, id] { if (m_events.replayDone) m_events.replayDone(id); });
+    m_replay = port.get();
+    m_portName = "replay";
+    m_baudRate = port->Header().baudRate;
+    {
+        std::lock_guard<std::mutex> lock(m_lineLock);
+        m_line = SerialConfig();
+        m_line.baudRate = m_baudRate;
+    }
+    return StartIo(std::move(port));
+}
+
+// Com a porta aberta: fila RX vazia (não há produtor ainda), leitura pelo
+// reactor e thread de escrita. Conclusões de TX da conexão anterior (falhas
+// do Stop()) continuam em m_txDone até a UI buscá-las.
+bool SerialSession::StartIo(std::unique_ptr<SerialPort> port) {
+    m_rx.Reset();
+    m_rxNotifyPending.store(false);
+
+    {
+        std::lock_guard<std::mutex> lock(m_lineLock);
+        m_port = std::move(port);
+    }
+    uint32_t id = m_id;
+    AdaptiveIoConfig adaptive = m_adaptive;
+    if (adaptive.expectedBytesPerSec == 0) adaptive.expectedBytesPerSec = m_baudRate / 10;
+    m_reactorId = m_reactor->Add(m_port.get(),
+        [this](const RxSpan& span) { OnRxData(span); },
+        [this, id] { if (m_events.portLost) m_events.portLost(id); },
+        adaptive);
+    if (m_reactorId == 0) {
+        m_lastError = m_reactor->LastError();
+        std::lock_guard<std::mutex> lock(m_lineLock);
+        m_port->Close();
+        m_port.reset();
+        m_replay = nullptr;
+        return false;
+    }
+
+    m_tx.SetTap([this](const uint8_t* data, size_t len) {
+        CaptureWriter* cap = m_capture.load(std::memory_order_acquire);
+        if (cap) cap->RecordTx(data, len);
+    });
+    m_tx.Start(m_port.get(), [this](const TxResult& r) { OnTxComplete(r); });
+    m_txOpen.store(true);
+    return true;
+}
+
+void SerialSession::Close() {
+    if (m_rttOwner) m_rttOwner->Stop();        // usa Send(): para antes da escrita
+    if (m_loadOwner) m_loadOwner->Stop();
+    m_txOpen.store(false);
+    m_tx.Stop();
+    if (m_reactorId) {
+        m_reactor->Remove(m_reactorId);        // depois disto, nenhum OnRxData()
+        m_reactorId = 0;
+    }
+    if (m_port) {
+        m_lastError = m_port->LastError();
+        m_errorsAtClose = m_port->ErrorCounts();
+        std::lock_guard<std::mutex> lock(m_lineLock);
+        m_port->Close();
+        m_port.reset();
+    }
+    m_replay = nullptr;
+}
+
+// Thread do reactor: captura primeiro (timestamp mais próximo da chegada),
+// depois a fila RX, que nunca bloqueia (excedente é contado e descartado).
+// Captura, fila e ponte guardam o span (uma referência cada, a ponte uma por
+// cliente); RTT e carga só leem os bytes durante a chamada. Nenhum
+// consumidor copia aqui.
+void SerialSession::OnRxData(const RxSpan& span) {
+    const uint8_t* data = span.Data();
+    size_t len = span.Size();
+    CaptureWriter* cap = m_capture.load(std::memory_order_acquire);
+    if (cap) cap->RecordRx(span);
+    RttMeter* rtt = m_rtt.load(std::memory_order_acquire);
+    if (rtt && rtt->Running()) rtt->OnRx(data, len, PreciseTimer::NowNs());
+    TxScheduler* load = m_load.load(std::memory_order_acquire);
+    if (load && load->Running()) load->OnRx(data, len, PreciseTimer::NowNs());
+    TcpBridge* bridge = m_bridge.load(std::memory_order_acquire);
+    if (bridge) bridge->Publish(span);
+    m_rxMetrics.RecordRead(len);
+    m_rx.Push(span);
+    if (!m_rxNotifyPending.exchange(true, std::memory_order_acq_rel)) {
+        m_rxArrivalNs.store(PreciseTimer::NowNs(), std::memory_order_release);
+        if (m_events.rxReady) m_events.rxReady(m_id);
+    }
+}
+
+// Um instante só é entregue uma vez: se a UI drenar (timer) entre o aviso e a
+// gravação do instante, vê o anterior de novo e não mede nada neste lote.
+int64_t SerialSession::AckRxReady() {
+    m_rxNotifyPending.store(false, std::memory_order_release);
+    int64_t arrival = m_rxArrivalNs.load(std::memory_order_acquire);
+    if (arrival == m_rxArrivalSeenNs) return 0;
+    m_rxArrivalSeenNs = arrival;
+    return arrival;
+}
+
+void SerialSession::RecordRxShown(int64_t arrivalNs) {
+    if (arrivalNs <= 0) return;
+    int64_t us = (PreciseTimer::NowNs() - arrivalNs) / 1000;
+    m_rxToScreenUs.Record(us > 0 ? (uint64_t)us : 0);
+}
+
+PortMetricsSnapshot SerialSession::MetricsNow() {
+    PortMetricsSnapshot m;
+    m.takenNs = PreciseTimer::NowNs();
+    m.rxBytes = m_rxMetrics.bytes.load(std::memory_order_relaxed);
+    m.rxReads = m_rxMetrics.reads.load(std::memory_order_relaxed);
+    m.readBytes = m_rxMetrics.readBytes.Snapshot();
+    m.rxToScreenUs = m_rxToScreenUs.Snapshot();
+    m.rxDropped = m_rx.DroppedBytes();
+    m.rxQueued = m_rx.Size();
+    m.rxHighWater = m_rx.HighWater();
+    m.tx = m_tx.Stats();
+    m.errors = m_port ? m_port->ErrorCounts() : m_errorsAtClose;
+    return m;
+}
+
+// Thread de escrita: só guarda o resultado e avisa (um aviso por rajada).
+void SerialSession::OnTxComplete(const TxResult& r) {
+    RttMeter* rtt = m_rtt.load(std::memory_order_acquire);
+    if (rtt && rtt->Running()) rtt->OnTxDone(r);
+    {
+        std::lock_guard<std::mutex> lock(m_txDoneLock);
+        m_txDone.push_back(r);
+    }
+    if (!m_txNotifyPending.exchange(true, std::memory_order_acq_rel) && m_events.txDone)
+        m_events.txDone(m_id);
+}
+
+uint64_t SerialSession::Send(const void* data, size_t len) {
+    if (!m_port) return 0;
+    return m_tx.Enqueue(data, len);
+}
+
+void SerialSession::TakeTxResults(std::vector<TxResult>& out) {
+    m_txNotifyPending.store(false, std::memory_order_release);
+    out.clear();
+    std::lock_guard<std::mutex> lock(m_txDoneLock);
+    out.swap(m_txDone);
+}
+
+bool SerialSession::StartCapture(const std::string& path, std::string* error) {
+    if (!m_captureOwner) {
+        m_captureOwner.reset(new CaptureWriter());
+        m_capture.store(m_captureOwner.get(), std::memory_order_release);
+    }
+    if (!m_captureOwner->Start(path, m_portName, m_baudRate)) {
+        if (error) *error = m_captureOwner->LastError();
+        return false;
+    }
+    return true;
+}
+
+CaptureStats SerialSession::StopCapture(std::string* error) {
+    if (!m_captureOwner) return CaptureStats();
+    m_captureOwner->Stop();
+    if (error) *error = m_captureOwner->LastError();
+    return m_captureOwner->Stats();
+}
+
+bool SerialSession::StartRtt(const RttConfig& cfg, std::string* error) {
+    if (!m_port) {
+        if (error) *error = "porta fechada";
+        return false;
+    }
+    if (!m_rttOwner) {
+        m_rttOwner.reset(new RttMeter());
+        m_rtt.store(m_rttOwner.get(), std::memory_order_release);
+    }
+    uint32_t id = m_id;
+    return m_rttOwner->Start(cfg,
+        [this](const void* data, size_t len) { return Send(data, len); },
+        [this, id] { if (m_events.rttDone) m_events.rttDone(id); });
+}
+
+void SerialSession::StopRtt() {
+    if (m_rttOwner) m_rttOwner->Stop();
+}
+
+bool SerialSession::RttRunning() const {
+    return m_rttOwner && m_rttOwner->Running();
+}
+
+RttReport SerialSession::RttResult() const {
+    return m_rttOwner ? m_rttOwner->Report() : RttReport();
+}
+
+bool SerialSession::StartLoad(const TxPlan& plan, std::string* error) {
+    if (!m_port) {
+        if (error) *error = "porta fechada";
+        return false;
+    }
+    if (!m_loadOwner) {
+        m_loadOwner.reset(new TxScheduler());
+        m_load.store(m_loadOwner.get(), std::memory_order_release);
+    }
+    uint32_t id = m_id;
+    return m_loadOwner->Start(plan,
+        [this](const void* data, size_t len) { return Send(data, len); },
+        [this, id] { if (m_events.loadDone) m_events.loadDone(id); });
+}
+
+void SerialSession::StopLoad() {
+    if (m_loadOwner) m_loadOwner->Stop();
+}
+
+bool SerialSession::LoadRunning() const {
+    return m_loadOwner && m_loadOwner->Running();
+}
+
+TxScheduleReport SerialSession::LoadResult() const {
+    return m_loadOwner ? m_loadOwner->Report() : TxScheduleReport();
+}
+
+// Os callbacks rodam na thread da ponte: TX pela mesma TxQueue (sem contar
+// "cheia" como descarte: a ponte guarda e tenta de novo) e linha sob
+// m_lineLock, que Close() também pega para trocar a porta.
+bool SerialSession::StartBridge(const BridgeConfig& cfg, std::string* error) {
+    if (!m_bridgeOwner) {
+        m_bridgeOwner.reset(new TcpBridge());
+        m_bridge.store(m_bridgeOwner.get(), std::memory_order_release);
+    }
+    BridgeHost host;
+    host.send = [this](const void* data, size_t len) {
+        if (!m_txOpen.load()) return true;         // porta fechada: descarta
+        return m_tx.TryEnqueue(data, len) != 0;
+    };
+    host.setLine = [this](const SerialConfig& want) {
+        std::lock_guard<std::mutex> lock(m_lineLock);
+        if (!m_port || !m_port->SetLineConfig(want)) return false;
+        m_line.baudRate = want.baudRate;
+        m_line.dataBits = want.dataBits;
+        m_line.parity = want.parity;
+        m_line.stopBits = want.stopBits;
+        m_line.dtr = want.dtr;
+        m_line.rts = want.rts;
+        return true;
+    };
+    host.line = [this] {
+        std::lock_guard<std::mutex> lock(m_lineLock);
+        return m_line;
+    };
+    return m_bridgeOwner->Start(cfg, host, error);
+}
+
+void SerialSession::StopBridge() {
+    if (m_bridgeOwner) m_bridgeOwner->Stop();
+}
+
+bool SerialSession::BridgeRunning() const {
+    return m_bridgeOwner && m_bridgeOwner->Running();
+}
+
+int SerialSession::BridgePort(BridgeProtocol protocol) const {
+    return m_bridgeOwner ? m_bridgeOwner->Port(protocol) : -1;
+}
+
+BridgeStats SerialSession::BridgeStatsNow() const {
+    return m_bridgeOwner ? m_bridgeOwner->Stats() : BridgeStats();
+}
+
+bool SerialSession::Capturing() const {
+    return m_captureOwner && m_captureOwner->Active();
+}
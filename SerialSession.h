@@ -0,0 +1,182 @@
+// SerialSession.h - Uma porta com o seu próprio pipeline de RX/TX
+// Objetivo: tirar o estado da serial das globais (uma porta por processo)
+//           para monitorar várias portas ao mesmo tempo (abas na GUI).
+//
+// Cada sessão tem:
+//  - a porta (real, simulada "sim:..." ou reprodução de captura);
+//  - a fila RX (RxSpanQueue), alimentada por um SerialReactor compartilhado:
+//    guarda referências aos blocos lidos (ChunkPool.h), não cópias;
+//  - a TxQueue (escrita coalescida, thread própria que só acorda para enviar);
+//  - a captura binária (criada no primeiro uso);
+//  - métricas (Metrics.h): tamanho das leituras, atraso RX -> tela, filas,
+//    erros de linha do driver;
+//  - o medidor de ida e volta (RttMeter.h), criado no primeiro uso;
+//  - o gerador de carga (TxScheduler.h), idem;
+//  - a ponte TCP (TcpBridge.h), idem: recebe os mesmos spans da fila RX e
+//    continua escutando entre um fechamento e outro da porta.
+//
+// A UI é avisada por SessionEvents, chamados nas threads de I/O com no
+// máximo UM aviso pendente por tipo (rajadas viram um aviso só): a GUI só
+// posta uma mensagem com o id da sessão e drena na sua thread.
+//
+// A sessão pode ser aberta e fechada várias vezes (reconectar na mesma aba).
+// Não depende de Win32.
+
+#pragma once
+
+#include "Capture.h"
+#include "ChunkPool.h"
+#include "Metrics.h"
+#include "Replay.h"
+#include "RttMeter.h"
+#include "SerialPort.h"
+#include "SerialReactor.h"
+#include "TcpBridge.h"
+#include "TxQueue.h"
+#include "TxScheduler.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct SessionEvents {
+    std::function<void(uint32_t id)> rxReady;      // bytes novos em Rx()
+    std::function<void(uint32_t id)> txDone;       // conclusões em TakeTxResults()
+    std::function<void(uint32_t id)> portLost;     // a porta falhou de vez
+    std::function<void(uint32_t id)> replayDone;   // a reprodução chegou ao fim
+    std::function<void(uint32_t id)> rttDone;      // a medição de RTT terminou (RttResult())
+    std::function<void(uint32_t id)> loadDone;     // o plano de carga terminou (LoadResult())
+};
+
+class SerialSession {
+public:
+    // 'rxQueueBytes': limite da fila RX (bytes referenciados, não copiados).
+    // O reactor precisa viver mais que a sessão (os spans vêm do pool dele).
+    SerialSession(uint32_t id, SerialReactor* reactor, const SessionEvents& events,
+                  size_t rxQueueBytes = 1u << 20);
+    ~SerialSession();
+
+    SerialSession(const SerialSession&) = delete;
+    SerialSession& operator=(const SerialSession&) = delete;
+
+    // Abrem a porta (ou a captura, como porta virtual), zeram a fila RX e
+    // iniciam a leitura (reactor) e a escrita (TxQueue). false = LastError().
+    bool Open(const std::string& portName, const SerialConfig& cfg);
+    bool OpenReplay(const std::string& path, const ReplayOptions& opt);
+
+    // Para a escrita (pendentes viram falha), tira a porta do reactor e fecha.
+    // A captura continua até StopCapture().
+    void Close();
+
+    // Leitura adaptativa (AdaptiveIo.h) a partir da próxima Open(). Com
+    // 'expectedBytesPerSec' = 0, a taxa nominal sai do baud (baud / 10).
+    void SetAdaptiveIo(const AdaptiveIoConfig& cfg) { m_adaptive = cfg; }
+
+    uint32_t Id() const { return m_id; }
+    bool IsOpen() const { return m_port != nullptr; }
+    const std::string& PortName() const { return m_portName; }
+    uint32_t BaudRate() const { return m_baudRate; }
+    ReplaySerialPort* Replay() const { return m_replay; }   // != nullptr: reprodução
+    std::string LastError() const;
+
+    // ---- RX (consumidor: thread da UI) ----
+    RxSpanQueue& Rx() { return m_rx; }
+    // Limpa o aviso ANTES de ler Rx(): bytes que chegarem depois geram novo aviso.
+    // Retorna quando chegou o primeiro byte ainda não visto (PreciseTimer::NowNs)
+    // ou 0; depois de mostrar o lote, passe-o a RecordRxShown().
+    int64_t AckRxReady();
+    void RecordRxShown(int64_t arrivalNs);
+
+    // ---- TX ----
+    uint64_t Send(const void* data, size_t len);         // 0 = fila cheia (ou fechada)
+    void TakeTxResults(std::vector<TxResult>& out);      // limpa o aviso e entrega as conclusões
+    TxStats TxStatsNow() const { return m_tx.Stats(); }
+
+    // ---- Captura (RX + TX com timestamps, ver Capture.h) ----
+    bool StartCapture(const std::string& path, std::string* error);
+    CaptureStats StopCapture(std::string* error);
+    bool Capturing() const;
+
+    // ---- Medição de ida e volta (ver RttMeter.h) ----
+    // Envia pela mesma TxQueue; para sozinha com a porta (Close()).
+    bool StartRtt(const RttConfig& cfg, std::string* error);
+    void StopRtt();
+    bool RttRunning() const;
+    RttReport RttResult() const;
+
+    // ---- Gerador de carga: fluxos periódicos e roteiro (ver TxScheduler.h) ----
+    // Também envia pela TxQueue; para sozinho com a porta (Close()).
+    bool StartLoad(const TxPlan& plan, std::string* error);
+    void StopLoad();
+    bool LoadRunning() const;
+    TxScheduleReport LoadResult() const;
+
+    // ---- Ponte TCP: outros programas leem (e um escreve) a porta (ver TcpBridge.h) ----
+    // Independe da porta estar aberta; com ela fechada, o TX dos clientes é
+    // descartado e as mudanças RFC 2217 são recusadas.
+    bool StartBridge(const BridgeConfig& cfg, std::string* error);
+    void StopBridge();
+    bool BridgeRunning() const;
+    int BridgePort(BridgeProtocol protocol) const;
+    BridgeStats BridgeStatsNow() const;
+
+    // ---- Métricas (thread da UI, ~1x/s: consulta o driver) ----
+    PortMetricsSnapshot MetricsNow();
+
+private:
+    bool StartIo(std::unique_ptr<SerialPort> port);
+    void OnRxData(const RxSpan& span);
+    void OnTxComplete(const TxResult& r);
+
+    const uint32_t m_id;
+    SerialReactor* m_reactor;
+    SessionEvents m_events;
+
+    std::unique_ptr<SerialPort> m_port;
+    ReplaySerialPort* m_replay = nullptr;
+    uint64_t m_reactorId = 0;
+    std::string m_portName;
+    uint32_t m_baudRate = 0;
+    std::string m_lastError;
+    AdaptiveIoConfig m_adaptive;
+
+    // Configuração de linha em vigor: a ponte (RFC 2217) consulta e muda da
+    // thread dela; Close() troca m_port sob a mesma trava.
+    mutable std::mutex m_lineLock;
+    SerialConfig m_line;
+    std::atomic<bool> m_txOpen{ false };           // TxQueue aceitando (ponte descarta se não)
+
+    RxSpanQueue m_rx;
+    std::atomic<bool> m_rxNotifyPending{ false };
+    RxMetrics m_rxMetrics;                         // escrito pela thread do reactor
+    std::atomic<int64_t> m_rxArrivalNs{ 0 };       // idem: instante do aviso pendente
+    int64_t m_rxArrivalSeenNs = 0;                 // UI
+    LogHistogram m_rxToScreenUs;                   // UI
+    SerialErrorCounts m_errorsAtClose;             // a contagem some com a porta
+
+    TxQueue m_tx;
+    std::mutex m_txDoneLock;
+    std::vector<TxResult> m_txDone;
+    std::atomic<bool> m_txNotifyPending{ false };
+
+    // Criada no primeiro StartCapture() (4 MB de ring por direção) e mantida
+    // até o fim da sessão: as threads de I/O leem o ponteiro sem trava.
+    std::unique_ptr<CaptureWriter> m_captureOwner;
+    std::atomic<CaptureWriter*> m_capture{ nullptr };
+
+    // Idem para o medidor de RTT (ganchos no RX e nas conclusões de TX).
+    std::unique_ptr<RttMeter> m_rttOwner;
+    std::atomic<RttMeter*> m_rtt{ nullptr };
+
+    // Idem para o gerador de carga (gancho no RX para os expects).
+    std::unique_ptr<TxScheduler> m_loadOwner;
+    std::atomic<TxScheduler*> m_load{ nullptr };
+
+    // Idem para a ponte TCP (gancho no RX).
+    std::unique_ptr<TcpBridge> m_bridgeOwner;
+    std::atomic<TcpBridge*> m_bridge{ nullptr };
+};
@@ -0,0 +1,56 @@
+// StreamMatcher.h - Procura incremental de um padrão literal num fluxo de bytes
+// Objetivo: achar um padrão (ex.: "OK") no RX mesmo quando ele chega partido
+//           entre leituras, sem guardar os bytes já vistos: Feed() recebe um
+//           byte de cada vez e o estado entre chamadas é só quantos bytes do
+//           padrão já casaram.
+//
+// KMP: a tabela de falhas é montada uma vez em Set(); cada byte custa O(1)
+// amortizado, sem voltar no fluxo. Usado pelo RttMeter (resposta de cada
+// troca) e pelo TxScheduler (expect do roteiro).
+//
+// Não depende de Win32.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class StreamMatcher {
+public:
+    // Troca o padrão e recomeça do zero.
+    void Set(const std::string& pattern) {
+        m_pattern = pattern;
+        m_matched = 0;
+        m_fail.assign(m_pattern.size(), 0);
+        for (size_t i = 1, k = 0; i < m_pattern.size(); ++i) {
+            while (k > 0 && m_pattern[i] != m_pattern[k]) k = m_fail[k - 1];
+            if (m_pattern[i] == m_pattern[k]) ++k;
+            m_fail[i] = k;
+        }
+    }
+
+    // true = este byte completou o padrão (padrão vazio: sempre true). Depois
+    // de um casamento a procura continua (ocorrências sobrepostas contam).
+    bool Feed(uint8_t b) {
+        if (m_pattern.empty()) return true;
+        char c = (char)b;
+        if (m_matched == m_pattern.size()) m_matched = m_fail[m_matched - 1];
+        while (m_matched > 0 && c != m_pattern[m_matched]) m_matched = m_fail[m_matched - 1];
+        if (c == m_pattern[m_matched]) ++m_matched;
+        return m_matched == m_pattern.size();
+    }
+
+    // Esquece o que já casou (ex.: fim de linha, nova troca); mantém o padrão.
+    void Reset() { m_matched = 0; }
+
+    const std::string& Pattern() const { return m_pattern; }
+    bool Empty() const { return m_pattern.empty(); }
+    size_t Matched() const { return m_matched; }
+
+private:
+    std::string m_pattern;
+    std::vector<size_t> m_fail;           // tabela de falhas (KMP)
+    size_t m_matched = 0;                 // bytes do padrão já casados
+};
@@ -0,0 +1,928 @@
+// TcpBridge.cpp - Ponte serial <-> TCP (ver TcpBridge.h)
+//  - Sockets BSD no Linux, Winsock no Windows; a diferença fica nas funções
+//    do namespace abaixo (poll/WSAPoll, sendmsg/WSASend, não bloqueante).
+//  - RFC 2217: só o necessário para um cliente abrir a porta remota como
+//    serial: negociação telnet (BINARY, SGA, COM-PORT-OPTION), SIGNATURE,
+//    SET-BAUDRATE/DATASIZE/PARITY/STOPSIZE, SET-CONTROL (DTR/RTS, sem
+//    controle de fluxo), máscaras, FLOWCONTROL-SUSPEND/RESUME e PURGE-DATA.
+//    Sem NOTIFY-LINESTATE/MODEMSTATE (a porta não expõe as linhas de modem).
+
+#include "TcpBridge.h"
+#include "DeviceSim.h"
+#include "PreciseTimer.h"
+#include "SerialSession.h"
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+namespace {
+#ifdef _WIN32
+typedef SOCKET SockFd;
+typedef WSAPOLLFD PollFd;
+const SockFd kNoSock = INVALID_SOCKET;
+#else
+typedef int SockFd;
+typedef pollfd PollFd;
+const SockFd kNoSock = -1;
+#endif
+
+const size_t kReadBytes = 16 * 1024;     // recv() por cliente e volta
+const size_t kMaxIov = 64;               // pedaços por envio
+const int kIdlePollMs = 500;             // sem nada pendente (Wake() acorda antes)
+const int kTxRetryMs = 2;                // escritor esperando a fila de TX
+
+// Telnet (RFC 854) e COM-PORT-OPTION (RFC 2217).
+const uint8_t kIac = 255, kDont = 254, kDo = 253, kWont = 252, kWill = 251;
+const uint8_t kSb = 250, kSe = 240;
+const uint8_t kOptBinary = 0, kOptSga = 3, kOptComPort = 44;
+const uint8_t kCpSignature = 0, kCpBaud = 1, kCpDataSize = 2, kCpParity = 3, kCpStopSize = 4;
+const uint8_t kCpControl = 5, kCpSuspend = 8, kCpResume = 9;
+const uint8_t kCpLineMask = 10, kCpModemMask = 11, kCpPurge = 12;
+const uint8_t kCpServerOffset = 100;     // resposta = comando + 100
+const size_t kMaxSubneg = 64;
+const char kSignature[] = "SerialCPP";
+
+SockFd ToSock(intptr_t s) { return (SockFd)s; }
+
+int LastSockError() {
+#ifdef _WIN32
+    return WSAGetLastError();
+#else
+    return errno;
+#endif
+}
+
+bool WouldBlock(int err) {
+#ifdef _WIN32
+    return err == WSAEWOULDBLOCK;
+#else
+    return err == EAGAIN || err == EWOULDBLOCK || err == EINTR;
+#endif
+}
+
+void CloseSock(SockFd s) {
+    if (s == kNoSock) return;
+#ifdef _WIN32
+    closesocket(s);
+#else
+    close(s);
+#endif
+}
+
+bool SetNonBlocking(SockFd s) {
+#ifdef _WIN32
+    u_long on = 1;
+    return ioctlsocket(s, FIONBIO, &on) == 0;
+#else
+    int fl = fcntl(s, F_GETFL, 0);
+    return fl >= 0 && fcntl(s, F_SETFL, fl | O_NONBLOCK) == 0;
+#endif
+}
+
+int Poll(PollFd* fds, size_t n, int timeoutMs) {
+#ifdef _WIN32
+    return WSAPoll(fds, (ULONG)n, timeoutMs);
+#else
+    return poll(fds, (nfds_t)n, timeoutMs);
+#endif
+}
+
+// Envio "gather" direto dos blocos. Retorna bytes aceitos, 0 se o socket está
+// cheio, -1 se a conexão caiu.
+long SendV(SockFd s, const SerialIoVec* vec, size_t count) {
+#ifdef _WIN32
+    WSABUF bufs[kMaxIov];
+    for (size_t i = 0; i < count; ++i) {
+        bufs[i].buf = (char*)vec[i].data;
+        bufs[i].len = (ULONG)vec[i].len;
+    }
+    DWORD sent = 0;
+    if (WSASend(s, bufs, (DWORD)count, &sent, 0, nullptr, nullptr) == 0) return (long)sent;
+#else
+    struct iovec iov[kMaxIov];
+    for (size_t i = 0; i < count; ++i) {
+        iov[i].iov_base = (void*)vec[i].data;
+        iov[i].iov_len = vec[i].len;
+    }
+    msghdr msg = {};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = count;
+    ssize_t sent = sendmsg(s, &msg, MSG_NOSIGNAL);   // cliente que saiu vira EPIPE, não SIGPIPE
+    if (sent >= 0) return (long)sent;
+#endif
+    return WouldBlock(LastSockError()) ? 0 : -1;
+}
+
+std::string SockError(const char* what) {
+    return std::string(what) + " (erro " + std::to_string(LastSockError()) + ")";
+}
+
+std::string PeerName(const sockaddr_in& a) {
+    char ip[INET_ADDRSTRLEN] = "?";
+    inet_ntop(AF_INET, (void*)&a.sin_addr, ip, sizeof(ip));
+    return std::string(ip) + ":" + std::to_string(ntohs(a.sin_port));
+}
+}
+
+struct TcpBridge::Listener {
+    SockFd sock = kNoSock;
+    BridgeProtocol protocol = BridgeProtocol::Raw;
+    int port = -1;
+};
+
+struct TcpBridge::Client {
+    Client(size_t queueBytes, size_t queueSpans) : queue(queueBytes, queueSpans) {}
+
+    SockFd sock = kNoSock;
+    BridgeProtocol protocol = BridgeProtocol::Raw;
+    std::string peer;
+    RxSpanQueue queue;                         // Publish() -> thread da ponte
+    std::atomic<bool> kick{ false };           // fila cheia com slowPolicy Disconnect
+    std::atomic<bool> writer{ false };         // só para Stats()
+    std::atomic<uint64_t> sent{ 0 };
+
+    // Daqui para baixo, só a thread da ponte.
+    std::deque<RxSpan> out;                    // tirados da fila, em envio
+    size_t outOffset = 0;                      // já enviado de out.front()
+    std::string ctrl;                          // telnet para o cliente (antes dos dados)
+    bool iacPending = false;                   // RFC 2217: falta o 2o 0xFF de um 0xFF dos dados
+    bool wantWrite = false;                    // socket cheio: espera POLLOUT
+    bool suspended = false;                    // FLOWCONTROL-SUSPEND
+    bool dead = false;
+    std::string txPending;                     // do escritor, esperando a fila de TX
+
+    // Parser telnet (entrada).
+    int state = 0;
+    uint8_t command = 0;
+    std::string subneg;
+    bool sentWill[256] = {};
+    bool sentDo[256] = {};
+};
+
+enum TelnetState { kTsData, kTsIac, kTsOption, kTsSub, kTsSubIac };
+
+TcpBridge::TcpBridge() {
+}
+
+TcpBridge::~TcpBridge() {
+    Stop();
+}
+
+// ============================================================================
+//                            Start / Stop
+// ============================================================================
+bool TcpBridge::Start(const BridgeConfig& cfg, const BridgeHost& host, std::string* error) {
+    Stop();
+#ifdef _WIN32
+    WSADATA wsa;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) {
+        if (error) *error = "WSAStartup falhou";
+        return false;
+    }
+#endif
+    m_cfg = cfg;
+    m_host = host;
+    m_stop.store(false);
+    m_wakePending.store(false);
+
+    auto fail = [&](const std::string& msg) {
+        if (error) *error = msg;
+        for (auto& l : m_listeners) CloseSock(l->sock);
+        m_listeners.clear();
+        CloseSock(ToSock(m_wakeSock));
+        m_wakeSock = -1;
+#ifdef _WIN32
+        WSACleanup();
+#endif
+        return false;
+    };
+
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    if (inet_pton(AF_INET, cfg.bindAddress.c_str(), &addr.sin_addr) != 1)
+        return fail("endereco invalido: " + cfg.bindAddress);
+
+    const struct { int port; BridgeProtocol protocol; } wanted[] = {
+        { cfg.rawPort, BridgeProtocol::Raw },
+        { cfg.rfc2217Port, BridgeProtocol::Rfc2217 },
+    };
+    for (const auto& w : wanted) {
+        if (w.port < 0) continue;
+        std::unique_ptr<Listener> l(new Listener());
+        l->protocol = w.protocol;
+        l->sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (l->sock == kNoSock) return fail(SockError("socket falhou"));
+        m_listeners.push_back(std::move(l));
+        Listener& ls = *m_listeners.back();
+#ifdef _WIN32
+        BOOL excl = TRUE;                       // ninguém mais escuta na mesma porta
+        setsockopt(ls.sock, SOL_SOCKET, SO_EXCLUSIVEADDRUSE, (const char*)&excl, sizeof(excl));
+#else
+        int reuse = 1;                          // reinicia logo após fechar (TIME_WAIT)
+        setsockopt(ls.sock, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+#endif
+        addr.sin_port = htons((uint16_t)w.port);
+        if (bind(ls.sock, (const sockaddr*)&addr, sizeof(addr)) != 0)
+            return fail(SockError(("bind " + cfg.bindAddress + ":" + std::to_string(w.port) + " falhou").c_str()));
+        if (listen(ls.sock, 16) != 0 || !SetNonBlocking(ls.sock)) return fail(SockError("listen falhou"));
+        sockaddr_in bound = {};
+        socklen_t len = sizeof(bound);
+        getsockname(ls.sock, (sockaddr*)&bound, &len);
+        ls.port = ntohs(bound.sin_port);
+    }
+    if (m_listeners.empty()) return fail("nenhuma porta TCP configurada");
+
+    // Despertador: UDP local "conectado" a si mesmo (funciona igual no Winsock,
+    // que não tem pipe/eventfd para o poll).
+    SockFd wake = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (wake == kNoSock) return fail(SockError("socket (despertador) falhou"));
+    m_wakeSock = (intptr_t)wake;
+    sockaddr_in loop = {};
+    loop.sin_family = AF_INET;
+    loop.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t loopLen = sizeof(loop);
+    if (bind(wake, (const sockaddr*)&loop, sizeof(loop)) != 0 ||
+        getsockname(wake, (sockaddr*)&loop, &loopLen) != 0 ||
+        connect(wake, (const sockaddr*)&loop, sizeof(loop)) != 0 || !SetNonBlocking(wake))
+        return fail(SockError("despertador UDP falhou"));
+
+    m_accepted = 0;
+    m_refused = 0;
+    m_kicked = 0;
+    m_published = 0;
+    m_sentClosed = 0;
+    m_droppedClosed = 0;
+    m_txBytes = 0;
+    m_txRejected = 0;
+    m_control = 0;
+    m_wakeups = 0;
+    m_thread = std::thread([this] { Run(); });
+    return true;
+}
+
+void TcpBridge::Stop() {
+    if (!m_thread.joinable()) return;
+    m_stop.store(true);
+    Wake();
+    m_thread.join();
+
+    std::vector<std::unique_ptr<Client>> clients;
+    {
+        std::lock_guard<std::mutex> lock(m_clientsLock);
+        clients.swap(m_clients);
+    }
+    for (auto& c : clients) CloseSock(c->sock);
+    clients.clear();                           // solta os spans pendentes
+    m_writer = nullptr;
+    for (auto& l : m_listeners) CloseSock(l->sock);
+    m_listeners.clear();
+    CloseSock(ToSock(m_wakeSock));
+    m_wakeSock = -1;
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+int TcpBridge::Port(BridgeProtocol protocol) const {
+    for (const auto& l : m_listeners)
+        if (l->protocol == protocol) return l->port;
+    return -1;
+}
+
+void TcpBridge::Wake() {
+    if (m_wakeSock < 0) return;
+    char one = 1;
+    send(ToSock(m_wakeSock), &one, 1, 0);
+}
+
+// ============================================================================
+//                       RX: reactor -> clientes
+// ============================================================================
+// Um aviso por rajada: só chama Wake() se a thread da ponte já consumiu o
+// anterior (ela zera m_wakePending ANTES de esvaziar as filas).
+void TcpBridge::Publish(const RxSpan& span) {
+    if (span.Empty()) return;
+    m_published.fetch_add(span.Size(), std::memory_order_relaxed);
+    bool any = false;
+    {
+        std::lock_guard<std::mutex> lock(m_clientsLock);
+        for (auto& c : m_clients) {
+            if (c->kick.load(std::memory_order_relaxed)) continue;
+            if (!c->queue.Push(span) && m_cfg.slowPolicy == BridgeSlowPolicy::Disconnect)
+                c->kick.store(true, std::memory_order_relaxed);
+            any = true;
+        }
+    }
+    if (any && !m_wakePending.exchange(true, std::memory_order_acq_rel)) Wake();
+}
+
+// Envia o que der, sem bloquear: 0xFF pendente, telnet e spans (direto dos
+// blocos). RFC 2217 dobra cada 0xFF dos dados com um pedaço extra de 1 byte
+// apontando para uma constante, sem copiar o span.
+bool TcpBridge::FlushClient(Client* c) {
+    static const uint8_t kIacByte = kIac;
+    enum PartKind { kPartIac, kPartCtrl, kPartData };
+    struct Part {
+        PartKind kind;
+        size_t len;
+        bool endsIac;                          // dados terminados em 0xFF (RFC 2217)
+    };
+
+    for (;;) {
+        while (c->out.size() < kMaxIov) {
+            RxSpan s;
+            if (!c->queue.Pop(&s)) break;
+            c->out.push_back(std::move(s));
+        }
+
+        SerialIoVec vec[kMaxIov];
+        Part parts[kMaxIov];
+        size_t n = 0;
+        auto add = [&](const void* p, size_t len, PartKind kind, bool endsIac) {
+            vec[n] = SerialIoVec{ p, len };
+            parts[n] = Part{ kind, len, endsIac };
+            ++n;
+        };
+        if (c->iacPending) add(&kIacByte, 1, kPartIac, false);
+        if (!c->ctrl.empty()) add(c->ctrl.data(), c->ctrl.size(), kPartCtrl, false);
+        if (!c->suspended) {
+            size_t offset = c->outOffset;
+            for (size_t i = 0; i < c->out.size() && n < kMaxIov - 1; ++i, offset = 0) {
+                const uint8_t* p = c->out[i].Data() + offset;
+                size_t len = c->out[i].Size() - offset;
+                if (c->protocol == BridgeProtocol::Raw) {
+                    add(p, len, kPartData, false);
+                    continue;
+                }
+                while (len > 0 && n < kMaxIov - 1) {
+                    const uint8_t* ff = (const uint8_t*)memchr(p, kIac, len);
+                    size_t k = ff ? (size_t)(ff - p) + 1 : len;
+                    add(p, k, kPartData, ff != nullptr);
+                    if (ff) add(&kIacByte, 1, kPartIac, false);
+                    p += k;
+                    len -= k;
+                }
+                if (len > 0) break;            // sem pedaços livres: o resto fica para a próxima
+            }
+        }
+        if (n == 0) {
+            c->wantWrite = false;
+            return true;
+        }
+
+        long sent = SendV(c->sock, vec, n);
+        if (sent < 0) return false;
+
+        size_t left = (size_t)sent;
+        size_t total = 0;
+        uint64_t data = 0;
+        for (size_t i = 0; i < n; ++i) {
+            total += parts[i].len;
+            size_t take = std::min(left, parts[i].len);
+            left -= take;
+            if (parts[i].kind == kPartIac) {
+                if (take == 1) c->iacPending = false;
+            }
+            else if (parts[i].kind == kPartCtrl) {
+                c->ctrl.erase(0, take);
+            }
+            else {
+                data += take;
+                c->outOffset += take;
+                if (c->outOffset == c->out.front().Size()) {
+                    c->out.pop_front();        // última referência: o bloco pode voltar ao pool
+                    c->outOffset = 0;
+                }
+                if (take == parts[i].len && parts[i].endsIac) c->iacPending = true;
+            }
+            if (take < parts[i].len) break;
+        }
+        if (data) c->sent.fetch_add(data, std::memory_order_relaxed);
+        if ((size_t)sent < total) {
+            c->wantWrite = true;               // socket cheio: o cliente está lendo devagar
+            return true;
+        }
+    }
+}
+
+// ============================================================================
+//                       TX e controle: clientes -> porta
+// ============================================================================
+bool TcpBridge::PushTx(Client* c) {
+    if (!m_host.send || m_host.send(c->txPending.data(), c->txPending.size())) {
+        m_txBytes.fetch_add(c->txPending.size(), std::memory_order_relaxed);
+        c->txPending.clear();
+        return true;
+    }
+    return false;
+}
+
+void TcpBridge::ReadClient(Client* c) {
+    uint8_t buf[kReadBytes];
+    long n = (long)recv(c->sock, (char*)buf, (int)sizeof(buf), 0);
+    if (n == 0 || (n < 0 && !WouldBlock(LastSockError()))) {
+        c->dead = true;
+        return;
+    }
+    if (n < 0) return;
+
+    size_t len = (size_t)n;
+    if (c->protocol == BridgeProtocol::Rfc2217) ParseTelnet(c, buf, (size_t)n, &len);
+    if (len == 0) return;
+    if (!m_writer) {
+        m_writer = c;
+        c->writer.store(true);
+    }
+    if (m_writer != c) {
+        m_txRejected.fetch_add(len, std::memory_order_relaxed);
+        return;
+    }
+    c->txPending.assign((const char*)buf, len);
+    PushTx(c);
+}
+
+void TcpBridge::SendControl(Client* c, const uint8_t* data, size_t len) {
+    c->ctrl.append((const char*)data, len);
+}
+
+// Tira os comandos telnet de 'data' (no lugar); sobram os dados, em *dataLen.
+// Negociação: aceita BINARY e SGA nos dois sentidos e COM-PORT-OPTION do
+// cliente; recusa o resto. Só responde o que ainda não anunciou (sem laço).
+void TcpBridge::ParseTelnet(Client* c, uint8_t* data, size_t len, size_t* dataLen) {
+    size_t o = 0;
+    for (size_t i = 0; i < len; ++i) {
+        const uint8_t b = data[i];
+        switch (c->state) {
+        case kTsData:
+            if (b == kIac) c->state = kTsIac;
+            else data[o++] = b;
+            break;
+        case kTsIac:
+            c->state = kTsData;
+            if (b == kIac) data[o++] = b;
+            else if (b >= kWill && b <= kDont) {
+                c->command = b;
+                c->state = kTsOption;
+            }
+            else if (b == kSb) {
+                c->subneg.clear();
+                c->state = kTsSub;
+            }
+            break;                             // NOP, GA, AYT...: ignorados
+        case kTsOption: {
+            c->state = kTsData;
+            uint8_t reply[3] = { kIac, 0, b };
+            if (c->command == kWill) {
+                bool ok = b == kOptBinary || b == kOptSga || b == kOptComPort;
+                if (ok && c->sentDo[b]) break;
+                reply[1] = ok ? kDo : kDont;
+                c->sentDo[b] = ok;
+            }
+            else if (c->command == kDo) {
+                bool ok = b == kOptBinary || b == kOptSga;
+                if (ok && c->sentWill[b]) break;
+                reply[1] = ok ? kWill : kWont;
+                c->sentWill[b] = ok;
+            }
+            else {
+                break;                         // WONT/DONT: nada a confirmar
+            }
+            SendControl(c, reply, sizeof(reply));
+            break;
+        }
+        case kTsSub:
+            if (b == kIac) c->state = kTsSubIac;
+            else if (c->subneg.size() < kMaxSubneg) c->subneg += (char)b;
+            break;
+        case kTsSubIac:
+            if (b == kIac) {
+                if (c->subneg.size() < kMaxSubneg) c->subneg += (char)b;
+                c->state = kTsSub;
+                break;
+            }
+            c->state = kTsData;
+            if (b == kSe && !c->subneg.empty() && (uint8_t)c->subneg[0] == kOptComPort)
+                HandleComPort(c, c->subneg);
+            break;
+        }
+    }
+    *dataLen = o;
+}
+
+// Um comando COM-PORT-OPTION ("44 cmd valor..."). Mudanças só do escritor
+// (ou de quem pedir primeiro, que vira o escritor); consultas de qualquer um.
+// A resposta leva sempre o valor em vigor depois do pedido.
+void TcpBridge::HandleComPort(Client* c, const std::string& sb) {
+    m_control.fetch_add(1, std::memory_order_relaxed);
+    if (sb.size() < 2) return;
+    const uint8_t cmd = (uint8_t)sb[1];
+    const uint8_t* v = (const uint8_t*)sb.data() + 2;
+    const size_t vlen = sb.size() - 2;
+
+    SerialConfig cur = m_host.line ? m_host.line() : SerialConfig();
+    SerialConfig want = cur;
+    bool change = false;
+    std::string value(sb, 2);                  // resposta padrão: ecoa o pedido
+
+    switch (cmd) {
+    case kCpSignature:
+        if (vlen > 0) return;                  // assinatura do cliente: só informativa
+        value = kSignature;
+        break;
+    case kCpBaud:
+        if (vlen < 4) return;
+        want.baudRate = ((uint32_t)v[0] << 24) | ((uint32_t)v[1] << 16) | ((uint32_t)v[2] << 8) | v[3];
+        change = want.baudRate != 0;
+        break;
+    case kCpDataSize:
+        if (vlen < 1) return;
+        change = v[0] >= 5 && v[0] <= 8;
+        if (change) want.dataBits = v[0];
+        break;
+    case kCpParity:
+        if (vlen < 1) return;
+        change = v[0] >= 1 && v[0] <= 3;     // MARK/SPACE: sem suporte
+        if (change) want.parity = v[0] == 2 ? SerialParity::Odd : v[0] == 3 ? SerialParity::Even : SerialParity::None;
+        break;
+    case kCpStopSize:
+        if (vlen < 1) return;
+        change = v[0] == 1 || v[0] == 2;       // 1.5: sem suporte
+        if (change) want.stopBits = v[0] == 2 ? SerialStopBits::Two : SerialStopBits::One;
+        break;
+    case kCpControl:
+        if (vlen < 1) return;
+        switch (v[0]) {
+        case 8:  want.dtr = true;  change = true; break;
+        case 9:  want.dtr = false; change = true; break;
+        case 11: want.rts = true;  change = true; break;
+        case 12: want.rts = false; change = true; break;
+        default: break;
+        }
+        break;
+    case kCpSuspend:
+        c->suspended = true;                   // o cliente pediu pausa no RX: sem resposta
+        return;
+    case kCpResume:
+        c->suspended = false;
+        return;
+    case kCpLineMask:
+    case kCpModemMask:
+        break;                                 // aceita (e não notifica nada)
+    case kCpPurge:
+        if (vlen < 1) return;
+        if (v[0] == 1 || v[0] == 3) {          // RX ainda não enviado a ESTE cliente
+            RxSpan s;
+            while (c->queue.Pop(&s)) {}
+            c->out.clear();
+            c->outOffset = 0;
+        }
+        if ((v[0] == 2 || v[0] == 3) && m_writer == c) c->txPending.clear();
+        break;
+    default:
+        return;
+    }
+
+    if (change) {
+        if (!m_writer) {
+            m_writer = c;
+            c->writer.store(true);
+        }
+        if (m_writer == c && m_host.setLine && m_host.setLine(want)) cur = want;
+    }
+
+    // Valor em vigor (consultas e mudanças recusadas caem aqui também).
+    switch (cmd) {
+    case kCpBaud: {
+        uint8_t b[4] = { (uint8_t)(cur.baudRate >> 24), (uint8_t)(cur.baudRate >> 16),
+                         (uint8_t)(cur.baudRate >> 8), (uint8_t)cur.baudRate };
+        value.assign((const char*)b, 4);
+        break;
+    }
+    case kCpDataSize:
+        value.assign(1, (char)cur.dataBits);
+        break;
+    case kCpParity:
+        value.assign(1, (char)(cur.parity == SerialParity::Odd ? 2 : cur.parity == SerialParity::Even ? 3 : 1));
+        break;
+    case kCpStopSize:
+        value.assign(1, (char)(cur.stopBits == SerialStopBits::Two ? 2 : 1));
+        break;
+    case kCpControl: {
+        uint8_t r = v[0];
+        if (r <= 3) r = 1;                     // controle de fluxo: sempre "nenhum"
+        else if (r <= 6) r = 6;                // BREAK: sempre desligado
+        else if (r <= 9) r = cur.dtr ? 8 : 9;
+        else if (r <= 12) r = cur.rts ? 11 : 12;
+        else r = 14;                           // fluxo de entrada: "nenhum"
+        value.assign(1, (char)r);
+        break;
+    }
+    default:
+        break;
+    }
+
+    std::string reply;
+    reply += (char)kIac;
+    reply += (char)kSb;
+    reply += (char)kOptComPort;
+    reply += (char)(cmd + kCpServerOffset);
+    for (char ch : value) {
+        reply += ch;
+        if ((uint8_t)ch == kIac) reply += ch;
+    }
+    reply += (char)kIac;
+    reply += (char)kSe;
+    SendControl(c, (const uint8_t*)reply.data(), reply.size());
+}
+
+// ============================================================================
+//                          Thread da ponte
+// ============================================================================
+void TcpBridge::Accept(Listener& l) {
+    for (;;) {
+        sockaddr_in peer = {};
+        socklen_t len = sizeof(peer);
+        SockFd s = accept(l.sock, (sockaddr*)&peer, &len);
+        if (s == kNoSock) return;
+
+        size_t count;
+        {
+            std::lock_guard<std::mutex> lock(m_clientsLock);
+            count = m_clients.size();
+        }
+        if (count >= m_cfg.maxClients || !SetNonBlocking(s)) {
+            CloseSock(s);
+            m_refused.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        int one = 1;                           // respostas RFC 2217 e linhas curtas sem atraso de Nagle
+        setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (const char*)&one, sizeof(one));
+
+        std::unique_ptr<Client> c(new Client(m_cfg.clientQueueBytes, m_cfg.clientQueueSpans));
+        c->sock = s;
+        c->protocol = l.protocol;
+        c->peer = PeerName(peer);
+        if (l.protocol == BridgeProtocol::Rfc2217) {
+            const uint8_t hello[] = {
+                kIac, kWill, kOptBinary, kIac, kDo, kOptBinary,
+                kIac, kWill, kOptSga, kIac, kDo, kOptSga,
+                kIac, kDo, kOptComPort,
+            };
+            SendControl(c.get(), hello, sizeof(hello));
+            c->sentWill[kOptBinary] = c->sentDo[kOptBinary] = true;
+            c->sentWill[kOptSga] = c->sentDo[kOptSga] = true;
+            c->sentDo[kOptComPort] = true;
+        }
+        std::lock_guard<std::mutex> lock(m_clientsLock);
+        m_clients.push_back(std::move(c));
+        m_accepted.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void TcpBridge::RemoveClient(Client* c) {
+    if (m_writer == c) m_writer = nullptr;
+    if (c->kick.load()) m_kicked.fetch_add(1, std::memory_order_relaxed);
+    CloseSock(c->sock);
+    std::unique_ptr<Client> gone;
+    {
+        std::lock_guard<std::mutex> lock(m_clientsLock);
+        for (auto it = m_clients.begin(); it != m_clients.end(); ++it) {
+            if (it->get() != c) continue;
+            m_sentClosed.fetch_add(c->sent.load(), std::memory_order_relaxed);
+            m_droppedClosed.fetch_add(c->queue.DroppedBytes(), std::memory_order_relaxed);
+            gone = std::move(*it);
+            m_clients.erase(it);
+            break;
+        }
+    }
+}                                               // 'gone' solta os spans fora da trava
+
+// Uma volta: espera (poll), aceita, lê os clientes e esvazia as filas. Só
+// esta thread inclui/remove clientes, então percorre m_clients sem a trava.
+void TcpBridge::Run() {
+    std::vector<PollFd> fds;
+    std::vector<Client*> polled;
+    while (!m_stop.load()) {
+        fds.clear();
+        polled.clear();
+        bool txBlocked = false;
+        auto add = [&](SockFd s, short events) {
+            PollFd p = {};
+            p.fd = s;
+            p.events = events;
+            fds.push_back(p);
+        };
+        add(ToSock(m_wakeSock), POLLIN);
+        for (auto& l : m_listeners) add(l->sock, POLLIN);
+        for (auto& c : m_clients) {
+            short events = 0;
+            if (c->txPending.empty()) events |= POLLIN;   // escritor travado: o TCP segura o remetente
+            else txBlocked = true;
+            if (c->wantWrite || !c->ctrl.empty()) events |= POLLOUT;
+            add(c->sock, events);
+            polled.push_back(c.get());
+        }
+
+        Poll(fds.data(), fds.size(), txBlocked ? kTxRetryMs : kIdlePollMs);
+        m_wakeups.fetch_add(1, std::memory_order_relaxed);
+        if (m_stop.load()) break;
+
+        if (fds[0].revents & POLLIN) {
+            char drain[64];
+            while (recv(ToSock(m_wakeSock), drain, sizeof(drain), 0) > 0) {}
+        }
+        m_wakePending.store(false, std::memory_order_seq_cst);   // antes de esvaziar as filas
+
+        const size_t first = 1 + m_listeners.size();
+        for (size_t i = 0; i < m_listeners.size(); ++i)
+            if (fds[1 + i].revents & POLLIN) Accept(*m_listeners[i]);
+
+        for (size_t i = 0; i < polled.size(); ++i) {
+            Client* c = polled[i];
+            short rev = fds[first + i].revents;
+            if (rev & (POLLIN | POLLHUP | POLLERR)) ReadClient(c);
+            if (!c->txPending.empty()) PushTx(c);
+        }
+        for (auto& c : m_clients)
+            if (!c->dead && !c->kick.load(std::memory_order_relaxed) && !FlushClient(c.get())) c->dead = true;
+
+        std::vector<Client*> gone;
+        for (auto& c : m_clients)
+            if (c->dead || c->kick.load(std::memory_order_relaxed)) gone.push_back(c.get());
+        for (Client* c : gone) RemoveClient(c);
+    }
+}
+
+BridgeStats TcpBridge::Stats() const {
+    BridgeStats s;
+    s.accepted = m_accepted.load();
+    s.refused = m_refused.load();
+    s.kicked = m_kicked.load();
+    s.publishedBytes = m_published.load();
+    s.sentBytes = m_sentClosed.load();
+    s.droppedBytes = m_droppedClosed.load();
+    s.txBytes = m_txBytes.load();
+    s.txRejectedBytes = m_txRejected.load();
+    s.controlCommands = m_control.load();
+    s.wakeups = m_wakeups.load();
+    std::lock_guard<std::mutex> lock(m_clientsLock);
+    s.clients = m_clients.size();
+    for (const auto& c : m_clients) {
+        BridgeClientInfo info;
+        info.peer = c->peer;
+        info.protocol = c->protocol;
+        info.writer = c->writer.load();
+        info.sentBytes = c->sent.load();
+        info.droppedBytes = c->queue.DroppedBytes();
+        info.queuedBytes = c->queue.Size();
+        s.sentBytes += info.sentBytes;
+        s.droppedBytes += info.droppedBytes;
+        s.perClient.push_back(info);
+    }
+    return s;
+}
+
+// ============================================================================
+//                         Modo --bridge (sem GUI)
+// ============================================================================
+namespace {
+std::atomic<bool> g_bridgeStop{ false };
+
+void OnBridgeStopSignal(int) {
+    g_bridgeStop.store(true);
+}
+
+void PrintBridgeUsage() {
+    fprintf(stderr,
+            "uso: --bridge --port=COM6|/dev/ttyUSB0|sim:... [--baud=115200] [--raw-port=7000]\n"
+            "              [--rfc2217-port=7001] [--bind=127.0.0.1] [--max-clients=16]\n"
+            "              [--client-queue=BYTES] [--slow=drop|disconnect] [--seconds=S] [--quiet]\n"
+            "     porta TCP -1 = desligada, 0 = qualquer livre (ver TcpBridge.h)\n");
+}
+}
+
+int BridgeMain(int argc, char** argv) {
+    std::string portName;
+    SerialConfig line;
+    BridgeConfig cfg;
+    double seconds = 0;
+    bool quiet = false;
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        const char* eq = strchr(a, '=');
+        std::string key = eq ? std::string(a, eq) : std::string(a);
+        std::string val = eq ? eq + 1 : "";
+        bool ok = true;
+        if (key == "--bridge") {}
+        else if (key == "--port") ok = !(portName = val).empty();
+        else if (key == "--baud") ok = (line.baudRate = (uint32_t)strtoul(val.c_str(), nullptr, 10)) > 0;
+        else if (key == "--raw-port") ok = !val.empty() && (cfg.rawPort = atoi(val.c_str())) <= 65535;
+        else if (key == "--rfc2217-port") ok = !val.empty() && (cfg.rfc2217Port = atoi(val.c_str())) <= 65535;
+        else if (key == "--bind") ok = !(cfg.bindAddress = val).empty();
+        else if (key == "--max-clients") ok = (cfg.maxClients = strtoul(val.c_str(), nullptr, 10)) > 0;
+        else if (key == "--client-queue") ok = (cfg.clientQueueBytes = strtoul(val.c_str(), nullptr, 10)) > 0;
+        else if (key == "--slow") {
+            if (val == "drop") cfg.slowPolicy = BridgeSlowPolicy::Drop;
+            else if (val == "disconnect") cfg.slowPolicy = BridgeSlowPolicy::Disconnect;
+            else ok = false;
+        }
+        else if (key == "--seconds") ok = (seconds = atof(val.c_str())) > 0;
+        else if (key == "--quiet") quiet = true;
+        else ok = false;
+        if (!ok) {
+            fprintf(stderr, "argumento invalido: %s\n", a);
+            PrintBridgeUsage();
+            return 2;
+        }
+    }
+    if (portName.empty()) {
+        fprintf(stderr, "falta --port=\n");
+        PrintBridgeUsage();
+        return 2;
+    }
+
+#ifndef _WIN32
+    signal(SIGPIPE, SIG_IGN);
+#endif
+    signal(SIGINT, OnBridgeStopSignal);
+    signal(SIGTERM, OnBridgeStopSignal);
+
+    // Mesmo caminho da GUI: reactor -> spans -> sessão -> ponte.
+    SerialReactor reactor;
+    if (!reactor.Start(1)) {
+        fprintf(stderr, "reactor: %s\n", reactor.LastError().c_str());
+        return 1;
+    }
+    std::atomic<bool> lost{ false };
+    SessionEvents events;
+    events.portLost = [&lost](uint32_t) { lost.store(true); };
+    SerialSession session(1, &reactor, events);
+    if (!session.Open(portName, line)) {
+        fprintf(stderr, "%s: %s\n", portName.c_str(), session.LastError().c_str());
+        return 1;
+    }
+    std::string error;
+    if (!session.StartBridge(cfg, &error)) {
+        fprintf(stderr, "ponte: %s\n", error.c_str());
+        return 1;
+    }
+    // Portas em stdout (uma por linha), para scripts: "raw 7000", "rfc2217 7001".
+    if (session.BridgePort(BridgeProtocol::Raw) >= 0) printf("raw %d\n", session.BridgePort(BridgeProtocol::Raw));
+    if (session.BridgePort(BridgeProtocol::Rfc2217) >= 0)
+        printf("rfc2217 %d\n", session.BridgePort(BridgeProtocol::Rfc2217));
+    fflush(stdout);
+
+    // Sem UI: a fila RX da sessão é só esvaziada (os clientes são os consumidores).
+    const int64_t t0 = PreciseTimer::NowNs();
+    const int64_t deadline = seconds > 0 ? t0 + (int64_t)(seconds * 1e9) : INT64_MAX;
+    RxSpan discard;
+    while (!g_bridgeStop.load() && !lost.load() && PreciseTimer::NowNs() < deadline) {
+        session.AckRxReady();
+        while (session.Rx().Pop(&discard)) {}
+        discard.Reset();
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    const double elapsed = (PreciseTimer::NowNs() - t0) / 1e9;
+    BridgeStats s = session.BridgeStatsNow();
+    session.StopBridge();
+    session.Close();
+    reactor.Stop();
+
+    if (!quiet) {
+        fprintf(stderr, "ponte: %.2f s, RX %llu B (%.1f KB/s), %llu clientes aceitos (%llu recusados, "
+                        "%llu derrubados), enviado %llu B, descartado %llu B, TX %llu B (%llu B recusados), "
+                        "%llu comandos RFC 2217\n",
+                elapsed, (unsigned long long)s.publishedBytes,
+                elapsed > 0 ? s.publishedBytes / elapsed / 1e3 : 0.0,
+                (unsigned long long)s.accepted, (unsigned long long)s.refused, (unsigned long long)s.kicked,
+                (unsigned long long)s.sentBytes, (unsigned long long)s.droppedBytes,
+                (unsigned long long)s.txBytes, (unsigned long long)s.txRejectedBytes,
+                (unsigned long long)s.controlCommands);
+        for (const BridgeClientInfo& c : s.perClient)
+            fprintf(stderr, "  %s %s%s: enviado %llu B, descartado %llu B\n", c.peer.c_str(),
+                    c.protocol == BridgeProtocol::Raw ? "raw" : "rfc2217", c.writer ? " (escritor)" : "",
+                    (unsigned long long)c.sentBytes, (unsigned long long)c.droppedBytes);
+    }
+    return lost.load() ? 1 : 0;
+}
@@ -0,0 +1,161 @@
+// TcpBridge.h - Ponte serial <-> TCP com vários clientes locais
+// Objetivo: vários programas de análise acompanharem a MESMA porta (a porta
+//           é aberta sem compartilhamento: CreateFileW/TIOCEXCL) sem uma
+//           ferramenta externa de ponte.
+//
+//  - Dois listeners opcionais: "raw" (bytes crus nos dois sentidos, ex.: nc,
+//    socat) e RFC 2217 (telnet + COM-PORT-OPTION: o cliente muda baud,
+//    formato e DTR/RTS da porta, ex.: pyserial "rfc2217://").
+//  - RX: cada cliente tem a sua RxSpanQueue (ChunkPool.h). Publish() só
+//    guarda o span do reactor (uma referência ao bloco) na fila de cada
+//    cliente; a thread da ponte manda direto do bloco para o socket
+//    (writev/WSASend com vários spans). Nenhuma cópia por cliente.
+//  - Cliente lento: a fila dele é limitada (bytes e spans). Cheia = descarta
+//    o excedente só para ele (BridgeSlowPolicy::Drop, contado) ou derruba a
+//    conexão (Disconnect). Publish() nunca espera: nem o reactor nem os
+//    outros clientes sentem o cliente parado.
+//  - TX: um escritor por vez. O primeiro cliente que manda dados fica com a
+//    escrita até desconectar; dados (e comandos RFC 2217 de mudança) dos
+//    outros são descartados e contados. Fila de TX cheia: o escritor para de
+//    ser lido (o TCP segura o remetente) até a fila aceitar.
+//  - Uma thread só (poll/WSAPoll) para aceitar, ler e escrever: os sockets
+//    são não bloqueantes; um socket UDP local ligado a si mesmo acorda a
+//    thread quando chegam spans para clientes sem nada pendente.
+//  - Por padrão escuta só em 127.0.0.1.
+//
+// A ponte pode sobreviver ao fechamento da porta (ver SerialSession): os
+// clientes ficam conectados e voltam a receber quando a porta reabre.
+// Não depende de Win32 no cabeçalho.
+
+#pragma once
+
+#include "ChunkPool.h"
+#include "SerialPort.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class BridgeProtocol { Raw, Rfc2217 };
+enum class BridgeSlowPolicy { Drop, Disconnect };
+
+struct BridgeConfig {
+    std::string bindAddress = "127.0.0.1";    // "0.0.0.0" = todas as interfaces
+    int      rawPort = 7000;                  // -1 = desligado, 0 = porta livre qualquer
+    int      rfc2217Port = -1;                // idem
+    size_t   maxClients = 16;
+    size_t   clientQueueBytes = 1u << 20;     // por cliente (bytes referenciados)
+    size_t   clientQueueSpans = 1024;         // por cliente (limita blocos presos)
+    BridgeSlowPolicy slowPolicy = BridgeSlowPolicy::Drop;
+};
+
+// O que a ponte usa da porta. Chamados na thread da ponte.
+struct BridgeHost {
+    // Dados do escritor para a porta: true = aceito (ou descartado com a porta
+    // fechada), false = fila de TX cheia, tente de novo.
+    std::function<bool(const void* data, size_t len)> send;
+    // RFC 2217: aplica baud/formato/DTR/RTS. false = recusado.
+    std::function<bool(const SerialConfig& cfg)> setLine;
+    // Configuração de linha atual (respostas às consultas RFC 2217).
+    std::function<SerialConfig()> line;
+};
+
+struct BridgeClientInfo {
+    std::string peer;                         // "127.0.0.1:54012"
+    BridgeProtocol protocol = BridgeProtocol::Raw;
+    bool     writer = false;
+    uint64_t sentBytes = 0;                   // RX entregue ao socket
+    uint64_t droppedBytes = 0;                // RX descartado (cliente lento)
+    size_t   queuedBytes = 0;
+};
+
+struct BridgeStats {
+    size_t   clients = 0;
+    uint64_t accepted = 0;
+    uint64_t refused = 0;                     // acima de maxClients
+    uint64_t kicked = 0;                      // derrubados por lentidão (Disconnect)
+    uint64_t publishedBytes = 0;              // RX da porta oferecido aos clientes
+    uint64_t sentBytes = 0;                   // soma entregue a todos os clientes
+    uint64_t droppedBytes = 0;                // soma descartada (clientes lentos)
+    uint64_t txBytes = 0;                     // do escritor para a porta
+    uint64_t txRejectedBytes = 0;             // de quem não é o escritor
+    uint64_t controlCommands = 0;             // RFC 2217 recebidos
+    uint64_t wakeups = 0;                     // voltas do poll
+    std::vector<BridgeClientInfo> perClient;
+};
+
+class TcpBridge {
+public:
+    TcpBridge();
+    ~TcpBridge();
+
+    TcpBridge(const TcpBridge&) = delete;
+    TcpBridge& operator=(const TcpBridge&) = delete;
+
+    // Abre os listeners e inicia a thread. false = 'error' (porta TCP em uso...).
+    bool Start(const BridgeConfig& cfg, const BridgeHost& host, std::string* error);
+    // Fecha listeners e clientes (os spans pendentes são soltos).
+    void Stop();
+    bool Running() const { return m_thread.joinable(); }
+
+    // Porta TCP efetivamente aberta (útil com 0 na configuração); -1 = desligado.
+    int Port(BridgeProtocol protocol) const;
+
+    // Thread do reactor: oferece o span a todos os clientes. Nunca bloqueia
+    // (trava só o tempo de enfileirar nos clientes) e não copia bytes.
+    void Publish(const RxSpan& span);
+
+    BridgeStats Stats() const;
+
+private:
+    struct Client;
+    struct Listener;
+
+    void Run();
+    void Accept(Listener& l);
+    void ReadClient(Client* c);
+    void ParseTelnet(Client* c, uint8_t* data, size_t len, size_t* dataLen);
+    void HandleComPort(Client* c, const std::string& sb);
+    void SendControl(Client* c, const uint8_t* data, size_t len);
+    bool FlushClient(Client* c);       // false = conexão caiu
+    bool PushTx(Client* c);            // entrega c->txPending ao host; false = fila cheia
+    void RemoveClient(Client* c);
+    void Wake();
+
+    BridgeConfig m_cfg;
+    BridgeHost m_host;
+    std::vector<std::unique_ptr<Listener>> m_listeners;
+    intptr_t m_wakeSock = -1;                  // UDP 127.0.0.1 conectado a si mesmo
+    std::atomic<bool> m_wakePending{ false };
+    std::atomic<bool> m_stop{ false };
+    std::thread m_thread;
+
+    // Lista de clientes: a thread da ponte inclui/remove, Publish() percorre.
+    mutable std::mutex m_clientsLock;
+    std::vector<std::unique_ptr<Client>> m_clients;
+    Client* m_writer = nullptr;                // só a thread da ponte
+
+    std::atomic<uint64_t> m_accepted{ 0 };
+    std::atomic<uint64_t> m_refused{ 0 };
+    std::atomic<uint64_t> m_kicked{ 0 };
+    std::atomic<uint64_t> m_published{ 0 };
+    std::atomic<uint64_t> m_sentClosed{ 0 };   // enviado/descartado por clientes que já saíram
+    std::atomic<uint64_t> m_droppedClosed{ 0 };
+    std::atomic<uint64_t> m_txBytes{ 0 };
+    std::atomic<uint64_t> m_txRejected{ 0 };
+    std::atomic<uint64_t> m_control{ 0 };
+    std::atomic<uint64_t> m_wakeups{ 0 };
+};
+
+// Modo --bridge (sem GUI): abre a porta (ou sim:...) como a GUI (SerialSession
+// + SerialReactor) e a expõe por TCP até Ctrl+C ou --seconds; resumo em
+// stderr. Retorna 0, 1 (erro) ou 2 (argumentos).
+//   --bridge --port=COM6|/dev/ttyUSB0|sim:... [--baud=N] [--raw-port=7000]
+//            [--rfc2217-port=7001] [--bind=127.0.0.1] [--max-clients=16]
+//            [--client-queue=BYTES] [--slow=drop|disconnect] [--seconds=S]
+int BridgeMain(int argc, char** argv);
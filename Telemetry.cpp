@@ -0,0 +1,218 @@
+// Telemetry.cpp - Extração de valores e decimação min/max (ver Telemetry.h)
+
+#include "Telemetry.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// ============================================================================
+//                          Número sem locale
+// ============================================================================
+namespace {
+const double kPow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+const int kMaxDigits = 19;                 // cabem em uint64_t
+const uint64_t kExactMantissa = 1ull << 53;
+
+inline bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+}
+
+const char* ParseNumber(const char* p, const char* end, double* out) {
+    bool neg = false;
+    if (p < end && (*p == '+' || *p == '-')) {
+        neg = (*p == '-');
+        ++p;
+    }
+
+    // Dígitos além do 19º só mexem no expoente (parte inteira) ou somem.
+    uint64_t mant = 0;
+    int digits = 0;
+    int exp10 = 0;
+    bool any = false;
+    for (; p < end && IsDigit(*p); ++p) {
+        any = true;
+        if (digits < kMaxDigits) {
+            mant = mant * 10 + (uint64_t)(*p - '0');
+            if (mant) ++digits;
+        }
+        else {
+            ++exp10;
+        }
+    }
+    if (p < end && *p == '.') {
+        for (++p; p < end && IsDigit(*p); ++p) {
+            any = true;
+            if (digits < kMaxDigits) {
+                mant = mant * 10 + (uint64_t)(*p - '0');
+                if (mant) ++digits;
+                --exp10;
+            }
+        }
+    }
+    if (!any) return nullptr;
+
+    // Expoente só se vier com dígito ("5e" é 5 seguido de unidade "e").
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        const char* q = p + 1;
+        bool expNeg = false;
+        if (q < end && (*q == '+' || *q == '-')) {
+            expNeg = (*q == '-');
+            ++q;
+        }
+        if (q < end && IsDigit(*q)) {
+            int e = 0;
+            for (; q < end && IsDigit(*q); ++q)
+                if (e < 10000) e = e * 10 + (*q - '0');
+            exp10 += expNeg ? -e : e;
+            p = q;
+        }
+    }
+
+    double v;
+    if (mant == 0) {
+        v = 0.0;
+    }
+    else if (mant <= kExactMantissa && exp10 >= -22 && exp10 <= 22) {
+        // Clinger: mantissa e 10^|e| exatos em double -> uma operação arredondada.
+        v = exp10 >= 0 ? (double)mant * kPow10[exp10] : (double)mant / kPow10[-exp10];
+    }
+    else {
+        v = (double)((long double)mant * std::pow(10.0L, (long double)exp10));
+    }
+    *out = neg ? -v : v;
+    return p;
+}
+
+// ============================================================================
+//                       Canal: coluna em ring + resumos
+// ============================================================================
+TelemetryChannel::TelemetryChannel(const std::string& name, size_t capacity)
+    : m_name(name) {
+    size_t minCap = (size_t)1 << (kLevels * kLevelShift);
+    m_cap = minCap;
+    while (m_cap < capacity) m_cap <<= 1;
+    m_mask = m_cap - 1;
+}
+
+void TelemetryChannel::Push(float v) {
+    const uint64_t i = m_end++;
+    if (i < m_cap) m_values.push_back(v);
+    else m_values[(size_t)(i & m_mask)] = v;
+
+    for (int L = 0; L < kLevels; ++L) {
+        const int shift = (L + 1) * kLevelShift;
+        const uint64_t block = i >> shift;
+        std::vector<MinMax>& s = m_summary[L];
+        if ((i & (((uint64_t)1 << shift) - 1)) == 0) {       // primeira amostra do bloco
+            if (block < (m_cap >> shift)) s.push_back(MinMax());
+            else s[(size_t)(block & ((m_cap >> shift) - 1))] = MinMax();
+        }
+        s[(size_t)(block & ((m_cap >> shift) - 1))].Add(v);
+    }
+}
+
+// Anda de 'a' até 'b' sempre pelo maior bloco alinhado que cabe: no máximo
+// 63 passos por nível em cada ponta. Um bloco inteiro dentro de [a, b) está
+// todo retido, e o slot dele ainda não foi reusado (isso só acontece quando
+// chega a amostra a + capacidade, depois de EndIndex()).
+MinMax TelemetryChannel::Range(uint64_t a, uint64_t b) const {
+    MinMax r;
+    a = std::max(a, FirstIndex());
+    b = std::min(b, m_end);
+    while (a < b) {
+        int L = kLevels;
+        for (; L > 0; --L) {
+            const uint64_t bs = (uint64_t)1 << (L * kLevelShift);
+            if ((a & (bs - 1)) == 0 && b - a >= bs) break;
+        }
+        if (L == 0) {
+            r.Add(At(a));
+            ++a;
+            continue;
+        }
+        const int shift = L * kLevelShift;
+        r.Add(m_summary[L - 1][(size_t)((a >> shift) & ((m_cap >> shift) - 1))]);
+        a += (uint64_t)1 << shift;
+    }
+    return r;
+}
+
+size_t TelemetryChannel::MemoryBytes() const {
+    size_t bytes = m_values.capacity() * sizeof(float);
+    for (int L = 0; L < kLevels; ++L) bytes += m_summary[L].capacity() * sizeof(MinMax);
+    return bytes;
+}
+
+void DecimateMinMax(const TelemetryChannel& ch, uint64_t first, uint64_t end,
+                    size_t columns, MinMax* out) {
+    const uint64_t span = end > first ? end - first : 0;
+    for (size_t c = 0; c < columns; ++c) {
+        uint64_t a = first + span * c / columns;
+        uint64_t b = first + span * (c + 1) / columns;
+        out[c] = ch.Range(a, b);
+    }
+}
+
+// ============================================================================
+//                                 Store
+// ============================================================================
+TelemetryStore::TelemetryStore(size_t samplesPerChannel, size_t maxChannels)
+    : m_samples(samplesPerChannel), m_maxChannels(maxChannels) {}
+
+void TelemetryStore::Clear() {
+    m_channels.clear();
+    m_fieldHint.clear();
+    m_stats = TelemetryStats();
+}
+
+TelemetryChannel* TelemetryStore::FindChannel(const char* name, size_t len, size_t field) {
+    auto same = [&](size_t i) {
+        const std::string& n = m_channels[i]->Name();
+        return n.size() == len && memcmp(n.data(), name, len) == 0;
+    };
+
+    if (field < m_fieldHint.size() && m_fieldHint[field] < m_channels.size() && same(m_fieldHint[field]))
+        return m_channels[m_fieldHint[field]].get();
+
+    size_t idx = SIZE_MAX;
+    for (size_t i = 0; i < m_channels.size(); ++i) {
+        if (same(i)) {
+            idx = i;
+            break;
+        }
+    }
+    if (idx == SIZE_MAX) {
+        if (m_channels.size() >= m_maxChannels) return nullptr;
+        idx = m_channels.size();
+        m_channels.emplace_back(new TelemetryChannel(std::string(name, len), m_samples));
+    }
+    if (field >= m_fieldHint.size()) m_fieldHint.resize(field + 1, SIZE_MAX);
+    m_fieldHint[field] = idx;
+    return m_channels[idx].get();
+}
+
+size_t TelemetryStore::FeedLine(const uint8_t* data, size_t len) {
+    ++m_stats.lines;
+    size_t field = 0;
+    size_t stored = 0;
+
+    ForEachTelemetryField(data, len, [&](const char* name, size_t nameLen, double v) {
+        TelemetryChannel* ch = FindChannel(name, nameLen, field++);
+        if (ch) {
+            ch->Push((float)v);
+            ++stored;
+        }
+        else {
+            ++m_stats.droppedFields;
+        }
+    });
+
+    if (stored) {
+        ++m_stats.valueLines;
+        m_stats.values += stored;
+    }
+    return stored;
+}
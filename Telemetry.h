@@ -0,0 +1,170 @@
+// Telemetry.h - Valores numéricos extraídos das linhas RX (gráfico ao vivo)
+// Objetivo: dispositivos que mandam "t=123 v=4.95 i=0.31" a kHz viram
+//           canais numéricos em vez de texto que ninguém consegue ler.
+//
+// Funcionamento:
+//  - TelemetryStore::FeedLine() recebe cada linha do LineFramer (mesmos
+//    bytes que vão para o terminal) e extrai os campos "nome=valor" ou
+//    "nome:valor" separados por espaço, ',', ';' ou tab. Sufixo de unidade
+//    é aceito ("v=4.95V"); o resto da linha é ignorado.
+//  - ParseNumber(): conversão própria, sem locale (strtod troca '.' por ','
+//    em pt-BR) e sem alocar. Mantissa até 2^53 (~15-16 dígitos) com
+//    expoente até +-22 sai exata (caminho rápido de Clinger); mantissas
+//    maiores (até 19 dígitos são acumulados) ou expoentes fora disso vão
+//    por long double/pow, com erro de ~1 ulp, irrelevante para um gráfico.
+//  - Cada canal é uma coluna (float) em ring: o eixo X é o índice da amostra
+//    no canal, então não há coluna de tempo. Junto vão resumos min/max por
+//    blocos de 64, 4096 e 262144 amostras, atualizados a cada Push().
+//  - DecimateMinMax(): para desenhar N colunas de pixel, cada coluna pede o
+//    min/max da sua faixa de amostras aos resumos. O custo depende de N (e
+//    de log da faixa), não do número de amostras na tela: 4 M pontos por
+//    canal desenham no mesmo tempo que 4 mil.
+//
+// Thread única (a da UI, que já drena a fila RX). Não depende de Win32.
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Número em [p, end): [+-]dígitos[.dígitos][e[+-]dígitos]. Retorna o fim do
+// número ou nullptr (nenhum dígito). Não depende de locale.
+const char* ParseNumber(const char* p, const char* end, double* out);
+
+inline bool IsTelemetrySeparator(char c) {
+    return c == ' ' || c == '\t' || c == ',' || c == ';';
+}
+
+inline bool IsTelemetryNameStart(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+inline bool IsTelemetryNameChar(char c) {
+    return IsTelemetryNameStart(c) || (c >= '0' && c <= '9') || c == '.' || c == '-';
+}
+
+// Campos "nome=valor" / "nome:valor" de uma linha (sem '\n'), na ordem:
+// fn(nome, tamanho do nome, valor) só para valores finitos em float. Mesmo
+// tokenizador de TelemetryStore::FeedLine() (a análise offline também usa).
+template <class Fn>
+void ForEachTelemetryField(const uint8_t* data, size_t len, Fn&& fn) {
+    const char* p = (const char*)data;
+    const char* end = p + len;
+
+    while (p < end) {
+        while (p < end && IsTelemetrySeparator(*p)) ++p;
+        if (p >= end) break;
+
+        // nome=valor | nome:valor (com unidade opcional colada no valor)
+        const char* name = p;
+        if (IsTelemetryNameStart(*p)) {
+            while (p < end && IsTelemetryNameChar(*p)) ++p;
+            if (p < end && (*p == '=' || *p == ':')) {
+                double v;
+                const char* q = ParseNumber(p + 1, end, &v);
+                if (q && std::isfinite((float)v)) {
+                    fn(name, (size_t)(p - name), v);
+                    p = q;
+                }
+            }
+        }
+        while (p < end && !IsTelemetrySeparator(*p)) ++p;   // resto do campo (unidade, texto)
+    }
+}
+
+struct MinMax {
+    float min = 0;
+    float max = 0;
+    bool empty = true;
+
+    void Add(float v) {
+        if (empty) { min = max = v; empty = false; return; }
+        if (v < min) min = v;
+        if (v > max) max = v;
+    }
+    void Add(const MinMax& o) {
+        if (o.empty) return;
+        if (empty) { *this = o; return; }
+        if (o.min < min) min = o.min;
+        if (o.max > max) max = o.max;
+    }
+};
+
+class TelemetryChannel {
+public:
+    // 'capacity' é arredondada para potência de 2 (mínimo 262144 = um bloco
+    // do maior resumo). A memória cresce com as amostras, até a capacidade.
+    TelemetryChannel(const std::string& name, size_t capacity);
+
+    void Push(float v);
+
+    const std::string& Name() const { return m_name; }
+    // Amostras retidas: índices [FirstIndex(), EndIndex()).
+    uint64_t FirstIndex() const { return m_end > m_cap ? m_end - m_cap : 0; }
+    uint64_t EndIndex() const { return m_end; }
+    float At(uint64_t i) const { return m_values[(size_t)(i & m_mask)]; }
+    float Last() const { return m_end ? At(m_end - 1) : 0.0f; }
+
+    // Min/max de [a, b) (limitado ao retido), pelos resumos.
+    MinMax Range(uint64_t a, uint64_t b) const;
+
+    size_t MemoryBytes() const;
+
+private:
+    static const int kLevels = 3;
+    static const int kLevelShift = 6;      // bloco do nível L: 64^L amostras
+
+    std::string m_name;
+    size_t m_cap;
+    size_t m_mask;
+    uint64_t m_end = 0;
+    std::vector<float> m_values;                // ring (cresce até m_cap)
+    std::vector<MinMax> m_summary[kLevels];     // idem, um por bloco
+};
+
+// Uma coluna de pixel por entrada de 'out': faixa [first, end) do canal
+// dividida em 'columns' partes iguais (colunas sem amostra ficam vazias).
+void DecimateMinMax(const TelemetryChannel& ch, uint64_t first, uint64_t end,
+                    size_t columns, MinMax* out);
+
+struct TelemetryStats {
+    uint64_t lines = 0;          // linhas recebidas
+    uint64_t valueLines = 0;     // linhas com pelo menos um valor
+    uint64_t values = 0;         // valores guardados
+    uint64_t droppedFields = 0;  // campos de canais além de maxChannels
+};
+
+class TelemetryStore {
+public:
+    static const size_t kDefaultSamples = 1u << 22;   // por canal (16 MB de floats)
+    static const size_t kDefaultChannels = 16;
+
+    explicit TelemetryStore(size_t samplesPerChannel = kDefaultSamples,
+                            size_t maxChannels = kDefaultChannels);
+
+    // Uma linha (sem '\n'). Retorna quantos valores foram guardados.
+    size_t FeedLine(const uint8_t* data, size_t len);
+
+    void Clear();
+
+    size_t ChannelCount() const { return m_channels.size(); }
+    const TelemetryChannel& Channel(size_t i) const { return *m_channels[i]; }
+    // Muda a cada linha com valores (a view só repinta se mudou).
+    uint64_t Generation() const { return m_stats.valueLines; }
+    const TelemetryStats& Stats() const { return m_stats; }
+
+private:
+    TelemetryChannel* FindChannel(const char* name, size_t len, size_t field);
+
+    size_t m_samples;
+    size_t m_maxChannels;
+    std::vector<std::unique_ptr<TelemetryChannel>> m_channels;
+    // Canal do campo N na linha anterior: linhas de telemetria costumam ter
+    // sempre o mesmo formato, então a busca pelo nome quase nunca roda.
+    std::vector<size_t> m_fieldHint;
+    TelemetryStats m_stats;
+};
@@ -0,0 +1,347 @@
+// TelemetryView.cpp - View do gráfico de telemetria (ver TelemetryView.h)
+
+#include "TelemetryView.h"
+#include "Telemetry.h"
+
+#include <strsafe.h>
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Estado por janela (guardado em GWLP_USERDATA):
+struct TelemetryViewState {
+    TelemetryStore* store = nullptr;
+    HFONT font = nullptr;
+    int lineHeight = 16;
+    uint64_t span = 0;          // amostras na largura da janela (0 = todo o retido)
+    uint64_t back = 0;          // amostras entre a borda direita e o fim (0 = acompanhando)
+    uint64_t drawnGeneration = UINT64_MAX;
+    uint64_t refEnd = 0;        // fim do 1º canal no último aviso (mede o que chegou)
+    int wheelAccum = 0;
+    std::vector<MinMax> columns;   // reutilizados a cada repintura
+    std::vector<POINT> points;
+};
+
+static const int kMaxLanes = 8;           // canais além disso não aparecem
+static const int kMarginX = 3;
+static const uint64_t kMinSpan = 64;
+static const COLORREF kLaneColors[kMaxLanes] = {
+    RGB(0, 90, 200), RGB(200, 60, 0), RGB(0, 140, 60), RGB(150, 0, 150),
+    RGB(180, 140, 0), RGB(0, 140, 160), RGB(120, 70, 30), RGB(90, 90, 90),
+};
+
+static TelemetryViewState* GetState(HWND hwnd) {
+    return (TelemetryViewState*)GetWindowLongPtrW(hwnd, GWLP_USERDATA);
+}
+
+// Maior histórico entre os canais: define o zoom máximo e a rolagem.
+static uint64_t RetainedSamples(const TelemetryViewState* st) {
+    uint64_t n = 0;
+    for (size_t i = 0; i < st->store->ChannelCount(); ++i) {
+        const TelemetryChannel& ch = st->store->Channel(i);
+        n = std::max(n, ch.EndIndex() - ch.FirstIndex());
+    }
+    return n;
+}
+
+static uint64_t VisibleSpan(const TelemetryViewState* st) {
+    uint64_t all = std::max<uint64_t>(RetainedSamples(st), kMinSpan);
+    return st->span ? std::min(st->span, all) : all;
+}
+
+static uint64_t MaxBack(const TelemetryViewState* st) {
+    uint64_t all = RetainedSamples(st);
+    uint64_t span = VisibleSpan(st);
+    return all > span ? all - span : 0;
+}
+
+// Barra horizontal em amostras (limitada a INT_MAX: só a escala muda).
+static void UpdateScrollBar(HWND hwnd, TelemetryViewState* st) {
+    uint64_t all = RetainedSamples(st);
+    uint64_t span = VisibleSpan(st);
+    uint64_t scale = all / INT_MAX + 1;
+
+    SCROLLINFO si = {};
+    si.cbSize = sizeof(si);
+    si.fMask = SIF_RANGE | SIF_PAGE | SIF_POS | SIF_DISABLENOSCROLL;
+    si.nMin = 0;
+    si.nMax = (int)(all ? (all - 1) / scale : 0);
+    si.nPage = (UINT)(span / scale);
+    si.nPos = (int)((MaxBack(st) - std::min(st->back, MaxBack(st))) / scale);
+    SetScrollInfo(hwnd, SB_HORZ, &si, TRUE);
+}
+
+static void ScrollBack(HWND hwnd, TelemetryViewState* st, int64_t back) {
+    if (back < 0) back = 0;
+    st->back = std::min<uint64_t>((uint64_t)back, MaxBack(st));
+    UpdateScrollBar(hwnd, st);
+    InvalidateRect(hwnd, nullptr, FALSE);
+}
+
+void TelemetryViewContentChanged(HWND view) {
+    TelemetryViewState* st = GetState(view);
+    if (!st || st->store->Generation() == st->drawnGeneration) return;
+
+    // Olhando o passado: a mesma janela de amostras fica parada na tela.
+    uint64_t end = st->store->ChannelCount() ? st->store->Channel(0).EndIndex() : 0;
+    if (st->back && end > st->refEnd) st->back = std::min(st->back + (end - st->refEnd), MaxBack(st));
+    st->refEnd = end;
+    UpdateScrollBar(view, st);
+    InvalidateRect(view, nullptr, FALSE);
+}
+
+// Uma faixa: curva min/max por coluna, escala pela faixa visível e legenda.
+static void PaintLane(HDC hdc, TelemetryViewState* st, const TelemetryChannel& ch,
+                      const RECT& lane, COLORREF color, uint64_t span) {
+    const int width = lane.right - lane.left - 2 * kMarginX;
+    if (width <= 0) return;
+
+    uint64_t end = ch.EndIndex() - std::min(st->back, ch.EndIndex());
+    uint64_t first = end > span ? end - span : 0;
+    // Canal com menos amostras que a janela: ocupa só a parte da direita.
+    int x0 = lane.left + kMarginX;
+    size_t cols = (size_t)width;
+    if (end - first < span) {
+        cols = (size_t)((double)width * (double)(end - first) / (double)span);
+        x0 += width - (int)cols;
+    }
+    st->columns.resize(cols);
+    DecimateMinMax(ch, first, end, cols, st->columns.data());
+
+    MinMax all;
+    for (const MinMax& m : st->columns) all.Add(m);
+
+    wchar_t label[128];
+    if (all.empty) {
+        StringCchPrintfW(label, 128, L"%S", ch.Name().c_str());
+    }
+    else {
+        StringCchPrintfW(label, 128, L"%S = %.6g   [%.6g .. %.6g]",
+            ch.Name().c_str(), (double)ch.Last(), (double)all.min, (double)all.max);
+    }
+    SetTextColor(hdc, color);
+    TextOutW(hdc, lane.left + kMarginX, lane.top, label, (int)wcslen(label));
+    if (all.empty) return;
+
+    // Área da curva: abaixo da legenda, com 2 px de folga.
+    const int top = lane.top + st->lineHeight + 2;
+    const int bottom = lane.bottom - 3;
+    if (bottom <= top) return;
+    double lo = all.min, hi = all.max;
+    if (hi - lo < 1e-12) {
+        double pad = std::max(std::abs(hi) * 0.05, 1e-6);
+        lo -= pad;
+        hi += pad;
+    }
+    const double scale = (double)(bottom - top) / (hi - lo);
+    auto toY = [&](float v) { return bottom - (int)(((double)v - lo) * scale + 0.5); };
+
+    // Zigue-zague max -> min por coluna: cobre o traço vertical de cada
+    // coluna e liga uma coluna à seguinte num Polyline só.
+    st->points.clear();
+    for (size_t c = 0; c < cols; ++c) {
+        const MinMax& m = st->columns[c];
+        if (m.empty) continue;
+        int x = x0 + (int)c;
+        st->points.push_back(POINT{ x, toY(m.max) });
+        st->points.push_back(POINT{ x, toY(m.min) });
+    }
+    if (st->points.empty()) return;
+    HPEN pen = CreatePen(PS_SOLID, 1, color);
+    HGDIOBJ oldPen = SelectObject(hdc, pen);
+    Polyline(hdc, st->points.data(), (int)st->points.size());
+    SelectObject(hdc, oldPen);
+    DeleteObject(pen);
+}
+
+static void Paint(HWND hwnd, TelemetryViewState* st) {
+    PAINTSTRUCT ps;
+    HDC hdc = BeginPaint(hwnd, &ps);
+
+    RECT rc;
+    GetClientRect(hwnd, &rc);
+
+    // Desenha num bitmap fora da tela para não piscar:
+    HDC mem = CreateCompatibleDC(hdc);
+    HBITMAP bmp = CreateCompatibleBitmap(hdc, rc.right, rc.bottom);
+    HGDIOBJ oldBmp = SelectObject(mem, bmp);
+    HGDIOBJ oldFont = SelectObject(mem, st->font);
+
+    FillRect(mem, &rc, GetSysColorBrush(COLOR_WINDOW));
+    SetBkMode(mem, TRANSPARENT);
+
+    const TelemetryStore& store = *st->store;
+    int lanes = (int)std::min<size_t>(store.ChannelCount(), kMaxLanes);
+    if (lanes == 0) {
+        SetTextColor(mem, GetSysColor(COLOR_GRAYTEXT));
+        const wchar_t* hint = L"Sem telemetria: linhas como \"t=1 v=4.95 i=0.31\" aparecem aqui.";
+        TextOutW(mem, kMarginX, kMarginX, hint, (int)wcslen(hint));
+    }
+    else {
+        uint64_t span = VisibleSpan(st);
+        int laneHeight = rc.bottom / lanes;
+        for (int i = 0; i < lanes; ++i) {
+            RECT lane = { 0, i * laneHeight, rc.right, (i + 1) * laneHeight };
+            if (i > 0) {
+                RECT sep = { 0, lane.top, rc.right, lane.top + 1 };
+                FillRect(mem, &sep, GetSysColorBrush(COLOR_3DLIGHT));
+            }
+            PaintLane(mem, st, store.Channel(i), lane, kLaneColors[i], span);
+        }
+
+        // Rodapé: quantas amostras a largura mostra e quantas por pixel.
+        wchar_t info[96];
+        int width = std::max(1, (int)rc.right - 2 * kMarginX);
+        StringCchPrintfW(info, 96, L"%llu amostras (%.1f/px)%s",
+            (unsigned long long)span, (double)span / width, st->back ? L"" : L" - ao vivo");
+        SIZE sz;
+        GetTextExtentPoint32W(mem, info, (int)wcslen(info), &sz);
+        SetTextColor(mem, GetSysColor(COLOR_GRAYTEXT));
+        TextOutW(mem, rc.right - sz.cx - kMarginX, rc.bottom - st->lineHeight, info, (int)wcslen(info));
+    }
+    st->drawnGeneration = store.Generation();
+
+    BitBlt(hdc, ps.rcPaint.left, ps.rcPaint.top,
+        ps.rcPaint.right - ps.rcPaint.left, ps.rcPaint.bottom - ps.rcPaint.top,
+        mem, ps.rcPaint.left, ps.rcPaint.top, SRCCOPY);
+
+    SelectObject(mem, oldFont);
+    SelectObject(mem, oldBmp);
+    DeleteObject(bmp);
+    DeleteDC(mem);
+    EndPaint(hwnd, &ps);
+}
+
+// Zoom em torno da borda direita: 'notches' > 0 aproxima (metade das amostras).
+static void Zoom(HWND hwnd, TelemetryViewState* st, int notches) {
+    uint64_t span = VisibleSpan(st);
+    for (; notches > 0; --notches) span = std::max(span / 2, kMinSpan);
+    for (; notches < 0; ++notches) span *= 2;
+    st->span = span >= RetainedSamples(st) ? 0 : span;   // tudo: acompanha o crescimento
+    ScrollBack(hwnd, st, (int64_t)st->back);
+}
+
+static LRESULT CALLBACK TelemetryViewProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
+    TelemetryViewState* st = GetState(hwnd);
+
+    switch (msg) {
+    case WM_NCCREATE: {
+        // lpCreateParams traz o TelemetryStore passado em CreateTelemetryView:
+        CREATESTRUCTW* cs = (CREATESTRUCTW*)lParam;
+        TelemetryViewState* ns = new TelemetryViewState();
+        ns->store = (TelemetryStore*)cs->lpCreateParams;
+        SetWindowLongPtrW(hwnd, GWLP_USERDATA, (LONG_PTR)ns);
+        break;
+    }
+
+    case WM_CREATE: {
+        st->font = (HFONT)GetStockObject(DEFAULT_GUI_FONT);
+        HDC hdc = GetDC(hwnd);
+        HGDIOBJ old = SelectObject(hdc, st->font);
+        TEXTMETRICW tm;
+        GetTextMetricsW(hdc, &tm);
+        st->lineHeight = tm.tmHeight + tm.tmExternalLeading;
+        SelectObject(hdc, old);
+        ReleaseDC(hwnd, hdc);
+        UpdateScrollBar(hwnd, st);
+        return 0;
+    }
+
+    case WM_SIZE:
+        if (st) InvalidateRect(hwnd, nullptr, FALSE);
+        return 0;
+
+    case WM_ERASEBKGND:
+        return 1;   // o fundo é pintado no WM_PAINT (double buffer)
+
+    case WM_PAINT:
+        Paint(hwnd, st);
+        return 0;
+
+    case WM_HSCROLL: {
+        // A barra cresce da esquerda (mais antigo) para a direita (fim).
+        int64_t back = (int64_t)st->back;
+        int64_t page = (int64_t)VisibleSpan(st);
+        switch (LOWORD(wParam)) {
+        case SB_LINELEFT:  back += page / 8; break;
+        case SB_LINERIGHT: back -= page / 8; break;
+        case SB_PAGELEFT:  back += page; break;
+        case SB_PAGERIGHT: back -= page; break;
+        case SB_LEFT:      back = INT64_MAX / 2; break;
+        case SB_RIGHT:     back = 0; break;
+        case SB_THUMBTRACK:
+        case SB_THUMBPOSITION: {
+            SCROLLINFO si = {};
+            si.cbSize = sizeof(si);
+            si.fMask = SIF_TRACKPOS;
+            GetScrollInfo(hwnd, SB_HORZ, &si);
+            uint64_t scale = RetainedSamples(st) / INT_MAX + 1;
+            back = (int64_t)MaxBack(st) - (int64_t)((uint64_t)si.nTrackPos * scale);
+            break;
+        }
+        default: return 0;
+        }
+        ScrollBack(hwnd, st, back);
+        return 0;
+    }
+
+    case WM_MOUSEWHEEL: {
+        st->wheelAccum += GET_WHEEL_DELTA_WPARAM(wParam);
+        int notches = st->wheelAccum / WHEEL_DELTA;
+        st->wheelAccum -= notches * WHEEL_DELTA;
+        if (notches) Zoom(hwnd, st, notches);
+        return 0;
+    }
+
+    case WM_LBUTTONDOWN:
+        SetFocus(hwnd);
+        return 0;
+
+    case WM_KEYDOWN: {
+        int64_t back = (int64_t)st->back;
+        int64_t page = (int64_t)VisibleSpan(st);
+        switch (wParam) {
+        case VK_LEFT:  ScrollBack(hwnd, st, back + page / 8); break;
+        case VK_RIGHT: ScrollBack(hwnd, st, back - page / 8); break;
+        case VK_PRIOR: ScrollBack(hwnd, st, back + page); break;
+        case VK_NEXT:  ScrollBack(hwnd, st, back - page); break;
+        case VK_HOME:  ScrollBack(hwnd, st, INT64_MAX / 2); break;
+        case VK_END:   ScrollBack(hwnd, st, 0); break;
+        case VK_ADD:
+        case VK_OEM_PLUS:  Zoom(hwnd, st, 1); break;
+        case VK_SUBTRACT:
+        case VK_OEM_MINUS: Zoom(hwnd, st, -1); break;
+        }
+        return 0;
+    }
+
+    case WM_NCDESTROY:
+        if (st) {
+            delete st;   // a fonte é de estoque: não se apaga
+            SetWindowLongPtrW(hwnd, GWLP_USERDATA, 0);
+        }
+        break;
+    }
+    return DefWindowProcW(hwnd, msg, wParam, lParam);
+}
+
+bool RegisterTelemetryView(HINSTANCE hInstance) {
+    WNDCLASSW wc = {};
+    wc.lpfnWndProc = TelemetryViewProc;
+    wc.hInstance = hInstance;
+    wc.hCursor = LoadCursor(nullptr, IDC_ARROW);
+    wc.lpszClassName = TELEMETRY_VIEW_CLASS;
+    return RegisterClassW(&wc) != 0;
+}
+
+HWND CreateTelemetryView(HWND parent, int x, int y, int w, int h, int id, TelemetryStore* store) {
+    return CreateWindowExW(
+        0, TELEMETRY_VIEW_CLASS, nullptr,
+        WS_CHILD | WS_BORDER | WS_HSCROLL | WS_TABSTOP,
+        x, y, w, h,
+        parent, (HMENU)(INT_PTR)id,
+        GetModuleHandleW(nullptr), store);
+}
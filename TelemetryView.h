@@ -0,0 +1,30 @@
+// TelemetryView.h - Gráfico ao vivo dos canais de um TelemetryStore
+// Objetivo: ver as grandezas que o dispositivo manda a kHz ("v=4.95") como
+//           curvas, sem travar a UI com milhões de pontos.
+//
+// Uma faixa por canal (escala automática pela faixa visível), com nome,
+// último valor e min/max. Cada coluna de pixel é o min/max das amostras que
+// caem nela (DecimateMinMax, ver Telemetry.h): o custo de repintar depende
+// da largura da janela, não de quantas amostras estão na tela.
+//
+// Eixo X: índice da amostra, alinhado pelo fim (a amostra mais recente de
+// cada canal fica na borda direita). Roda do mouse: zoom; barra horizontal
+// ou setas: volta no histórico; End: volta a acompanhar o fim.
+
+#pragma once
+
+#include <windows.h>
+
+class TelemetryStore;
+
+#define TELEMETRY_VIEW_CLASS L"SerialTelemetryView"
+
+// Registra a classe da janela (uma vez, antes de criar a view).
+bool RegisterTelemetryView(HINSTANCE hInstance);
+
+// Cria a view como filha de 'parent'. 'store' precisa viver mais que a janela.
+HWND CreateTelemetryView(HWND parent, int x, int y, int w, int h, int id, TelemetryStore* store);
+
+// Avisa que chegaram amostras: agenda repintura se o store mudou desde o
+// último desenho. Barato: não desenha nada.
+void TelemetryViewContentChanged(HWND view);
@@ -0,0 +1,327 @@
+// TerminalView.cpp - View customizada do terminal (ver TerminalView.h)
+
+#include "TerminalView.h"
+#include "Scrollback.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Estado por janela (guardado em GWLP_USERDATA):
+struct TerminalViewState {
+    Scrollback* store = nullptr;
+    HFONT font = nullptr;
+    int lineHeight = 16;
+    const std::vector<uint64_t>* filter = nullptr;   // só estas linhas (ver TerminalViewSetFilter)
+    uint64_t topRow = 0;      // fileira no topo: linha absoluta, ou índice em 'filter'
+    uint64_t markLine = UINT64_MAX;   // linha destacada (resultado da busca)
+    bool follow = true;       // acompanhando o fim do log?
+    int wheelAccum = 0;
+};
+
+static const int kTextMarginX = 3;
+static const size_t kMaxDrawChars = 2048;  // linhas maiores são cortadas no desenho
+
+static TerminalViewState* GetState(HWND hwnd) {
+    return (TerminalViewState*)GetWindowLongPtrW(hwnd, GWLP_USERDATA);
+}
+
+// Fileiras: sem filtro, cada linha retida do Scrollback; com filtro, cada
+// entrada de 'filter' (linhas que a retenção já descartou ficam em branco).
+static uint64_t FirstRow(const TerminalViewState* st) {
+    return st->filter ? 0 : st->store->FirstLine();
+}
+
+static uint64_t EndRow(const TerminalViewState* st) {
+    return st->filter ? st->filter->size() : st->store->EndLine();
+}
+
+static uint64_t LineOfRow(const TerminalViewState* st, uint64_t row) {
+    if (!st->filter) return row;
+    return row < st->filter->size() ? (*st->filter)[(size_t)row] : UINT64_MAX;
+}
+
+static int VisibleRows(HWND hwnd, const TerminalViewState* st) {
+    RECT rc;
+    GetClientRect(hwnd, &rc);
+    int rows = (rc.bottom - rc.top) / st->lineHeight;
+    return rows > 0 ? rows : 1;
+}
+
+// Maior topo possível: última página mostra as últimas linhas.
+static uint64_t MaxTopRow(HWND hwnd, const TerminalViewState* st) {
+    uint64_t first = FirstRow(st);
+    uint64_t end = EndRow(st);
+    uint64_t rows = (uint64_t)VisibleRows(hwnd, st);
+    return (end - first > rows) ? end - rows : first;
+}
+
+static void UpdateScrollBar(HWND hwnd, TerminalViewState* st) {
+    uint64_t first = FirstRow(st);
+    uint64_t count = EndRow(st) - first;
+
+    SCROLLINFO si = {};
+    si.cbSize = sizeof(si);
+    si.fMask = SIF_RANGE | SIF_PAGE | SIF_POS;
+    si.nMin = 0;
+    si.nMax = (int)std::min<uint64_t>(count ? count - 1 : 0, INT_MAX);
+    si.nPage = (UINT)VisibleRows(hwnd, st);
+    si.nPos = (int)std::min<uint64_t>(st->topRow - first, INT_MAX);
+    SetScrollInfo(hwnd, SB_VERT, &si, TRUE);
+}
+
+// Move o topo para 'top' (limitado à faixa retida) e repinta.
+static void ScrollTo(HWND hwnd, TerminalViewState* st, int64_t top) {
+    int64_t first = (int64_t)FirstRow(st);
+    int64_t maxTop = (int64_t)MaxTopRow(hwnd, st);
+    if (top < first) top = first;
+    if (top > maxTop) top = maxTop;
+
+    st->topRow = (uint64_t)top;
+    st->follow = (st->topRow == (uint64_t)maxTop);
+    UpdateScrollBar(hwnd, st);
+    InvalidateRect(hwnd, nullptr, FALSE);
+}
+
+void TerminalViewContentChanged(HWND view) {
+    TerminalViewState* st = GetState(view);
+    if (!st) return;
+
+    if (st->follow) {
+        st->topRow = MaxTopRow(view, st);
+    }
+    else if (st->topRow < FirstRow(st)) {
+        // As linhas que o usuário estava vendo foram descartadas pela retenção:
+        st->topRow = FirstRow(st);
+    }
+    else if (st->topRow > MaxTopRow(view, st)) {
+        st->topRow = MaxTopRow(view, st);   // o filtro encolheu
+    }
+    UpdateScrollBar(view, st);
+    InvalidateRect(view, nullptr, FALSE);
+}
+
+void TerminalViewSetFilter(HWND view, const std::vector<uint64_t>* lines) {
+    TerminalViewState* st = GetState(view);
+    if (!st || st->filter == lines) return;
+    st->filter = lines;
+    st->follow = true;
+    TerminalViewContentChanged(view);
+}
+
+void TerminalViewShowLine(HWND view, uint64_t line) {
+    TerminalViewState* st = GetState(view);
+    if (!st) return;
+    st->markLine = line;
+    if (line == UINT64_MAX) {
+        InvalidateRect(view, nullptr, FALSE);
+        return;
+    }
+
+    // Com filtro, a fileira é a posição da linha na lista (ou a seguinte).
+    uint64_t row = line;
+    if (st->filter) row = (uint64_t)(std::lower_bound(st->filter->begin(), st->filter->end(), line) - st->filter->begin());
+
+    // Centraliza, a menos que já esteja visível:
+    int rows = VisibleRows(view, st);
+    if (row < st->topRow || row >= st->topRow + rows) ScrollTo(view, st, (int64_t)row - rows / 2);
+    else InvalidateRect(view, nullptr, FALSE);
+}
+
+// Copia as linhas visíveis para a área de transferência (Ctrl+C).
+static void CopyVisibleLines(HWND hwnd, TerminalViewState* st) {
+    std::wstring text;
+    uint64_t end = std::min<uint64_t>(st->topRow + VisibleRows(hwnd, st), EndRow(st));
+    for (uint64_t row = st->topRow; row < end; ++row) {
+        const wchar_t* p;
+        size_t n;
+        if (st->store->GetLine(LineOfRow(st, row), &p, &n)) {
+            text.append(p, n);
+            text += L"\r\n";
+        }
+    }
+    if (!OpenClipboard(hwnd)) return;
+    EmptyClipboard();
+    size_t bytes = (text.size() + 1) * sizeof(wchar_t);
+    HGLOBAL mem = GlobalAlloc(GMEM_MOVEABLE, bytes);
+    if (mem) {
+        void* dst = GlobalLock(mem);
+        memcpy(dst, text.c_str(), bytes);
+        GlobalUnlock(mem);
+        if (!SetClipboardData(CF_UNICODETEXT, mem)) GlobalFree(mem);
+    }
+    CloseClipboard();
+}
+
+static void Paint(HWND hwnd, TerminalViewState* st) {
+    PAINTSTRUCT ps;
+    HDC hdc = BeginPaint(hwnd, &ps);
+
+    RECT rc;
+    GetClientRect(hwnd, &rc);
+
+    // Desenha num bitmap fora da tela para não piscar:
+    HDC mem = CreateCompatibleDC(hdc);
+    HBITMAP bmp = CreateCompatibleBitmap(hdc, rc.right, rc.bottom);
+    HGDIOBJ oldBmp = SelectObject(mem, bmp);
+    HGDIOBJ oldFont = SelectObject(mem, st->font);
+
+    FillRect(mem, &rc, GetSysColorBrush(COLOR_WINDOW));
+    SetBkMode(mem, TRANSPARENT);
+    SetTextColor(mem, GetSysColor(COLOR_WINDOWTEXT));
+
+    // Só as linhas que interceptam a região inválida:
+    int firstRow = ps.rcPaint.top / st->lineHeight;
+    int lastRow = (ps.rcPaint.bottom + st->lineHeight - 1) / st->lineHeight;
+    for (int row = firstRow; row < lastRow; ++row) {
+        uint64_t absRow = st->topRow + row;
+        if (absRow >= EndRow(st)) break;
+        uint64_t line = LineOfRow(st, absRow);
+        if (line == st->markLine) {
+            RECT mark = { 0, row * st->lineHeight, rc.right, (row + 1) * st->lineHeight };
+            FillRect(mem, &mark, GetSysColorBrush(COLOR_INFOBK));
+        }
+        const wchar_t* p;
+        size_t n;
+        if (!st->store->GetLine(line, &p, &n)) continue;
+        if (n == 0) continue;
+        TabbedTextOutW(mem, kTextMarginX, row * st->lineHeight, p,
+            (int)std::min(n, kMaxDrawChars), 0, nullptr, kTextMarginX);
+    }
+
+    BitBlt(hdc, ps.rcPaint.left, ps.rcPaint.top,
+        ps.rcPaint.right - ps.rcPaint.left, ps.rcPaint.bottom - ps.rcPaint.top,
+        mem, ps.rcPaint.left, ps.rcPaint.top, SRCCOPY);
+
+    SelectObject(mem, oldFont);
+    SelectObject(mem, oldBmp);
+    DeleteObject(bmp);
+    DeleteDC(mem);
+    EndPaint(hwnd, &ps);
+}
+
+static LRESULT CALLBACK TerminalViewProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
+    TerminalViewState* st = GetState(hwnd);
+
+    switch (msg) {
+    case WM_NCCREATE: {
+        // lpCreateParams traz o Scrollback passado em CreateTerminalView:
+        CREATESTRUCTW* cs = (CREATESTRUCTW*)lParam;
+        TerminalViewState* ns = new TerminalViewState();
+        ns->store = (Scrollback*)cs->lpCreateParams;
+        SetWindowLongPtrW(hwnd, GWLP_USERDATA, (LONG_PTR)ns);
+        break;
+    }
+
+    case WM_CREATE: {
+        // Fonte monoespaçada: colunas de log/HEX alinhadas.
+        st->font = CreateFontW(-13, 0, 0, 0, FW_NORMAL, FALSE, FALSE, FALSE,
+            DEFAULT_CHARSET, OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS,
+            CLEARTYPE_QUALITY, FIXED_PITCH | FF_MODERN, L"Consolas");
+        HDC hdc = GetDC(hwnd);
+        HGDIOBJ old = SelectObject(hdc, st->font);
+        TEXTMETRICW tm;
+        GetTextMetricsW(hdc, &tm);
+        st->lineHeight = tm.tmHeight + tm.tmExternalLeading;
+        SelectObject(hdc, old);
+        ReleaseDC(hwnd, hdc);
+        TerminalViewContentChanged(hwnd);
+        return 0;
+    }
+
+    case WM_SIZE:
+        if (st) TerminalViewContentChanged(hwnd);
+        return 0;
+
+    case WM_ERASEBKGND:
+        return 1;   // o fundo é pintado no WM_PAINT (double buffer)
+
+    case WM_PAINT:
+        Paint(hwnd, st);
+        return 0;
+
+    case WM_VSCROLL: {
+        int64_t top = (int64_t)st->topRow;
+        int64_t page = VisibleRows(hwnd, st);
+        switch (LOWORD(wParam)) {
+        case SB_LINEUP:   top -= 1; break;
+        case SB_LINEDOWN: top += 1; break;
+        case SB_PAGEUP:   top -= page; break;
+        case SB_PAGEDOWN: top += page; break;
+        case SB_TOP:      top = 0; break;
+        case SB_BOTTOM:   top = INT64_MAX / 2; break;
+        case SB_THUMBTRACK:
+        case SB_THUMBPOSITION: {
+            SCROLLINFO si = {};
+            si.cbSize = sizeof(si);
+            si.fMask = SIF_TRACKPOS;
+            GetScrollInfo(hwnd, SB_VERT, &si);
+            top = (int64_t)FirstRow(st) + si.nTrackPos;
+            break;
+        }
+        default: return 0;
+        }
+        ScrollTo(hwnd, st, top);
+        return 0;
+    }
+
+    case WM_MOUSEWHEEL: {
+        st->wheelAccum += GET_WHEEL_DELTA_WPARAM(wParam);
+        int notches = st->wheelAccum / WHEEL_DELTA;
+        st->wheelAccum -= notches * WHEEL_DELTA;
+        if (notches) ScrollTo(hwnd, st, (int64_t)st->topRow - notches * 3);
+        return 0;
+    }
+
+    case WM_LBUTTONDOWN:
+        SetFocus(hwnd);
+        return 0;
+
+    case WM_KEYDOWN: {
+        int64_t top = (int64_t)st->topRow;
+        int64_t page = VisibleRows(hwnd, st);
+        switch (wParam) {
+        case VK_UP:    ScrollTo(hwnd, st, top - 1); break;
+        case VK_DOWN:  ScrollTo(hwnd, st, top + 1); break;
+        case VK_PRIOR: ScrollTo(hwnd, st, top - page); break;
+        case VK_NEXT:  ScrollTo(hwnd, st, top + page); break;
+        case VK_HOME:  ScrollTo(hwnd, st, 0); break;
+        case VK_END:   ScrollTo(hwnd, st, INT64_MAX / 2); break;
+        case 'C':
+            if (GetKeyState(VK_CONTROL) & 0x8000) CopyVisibleLines(hwnd, st);
+            break;
+        }
+        return 0;
+    }
+
+    case WM_NCDESTROY:
+        if (st) {
+            if (st->font) DeleteObject(st->font);
+            delete st;
+            SetWindowLongPtrW(hwnd, GWLP_USERDATA, 0);
+        }
+        break;
+    }
+    return DefWindowProcW(hwnd, msg, wParam, lParam);
+}
+
+bool RegisterTerminalView(HINSTANCE hInstance) {
+    WNDCLASSW wc = {};
+    wc.lpfnWndProc = TerminalViewProc;
+    wc.hInstance = hInstance;
+    wc.hCursor = LoadCursor(nullptr, IDC_IBEAM);
+    wc.lpszClassName = TERMINAL_VIEW_CLASS;
+    return RegisterClassW(&wc) != 0;
+}
+
+HWND CreateTerminalView(HWND parent, int x, int y, int w, int h, int id, Scrollback* store) {
+    return CreateWindowExW(
+        0, TERMINAL_VIEW_CLASS, nullptr,
+        WS_CHILD | WS_VISIBLE | WS_BORDER | WS_VSCROLL | WS_TABSTOP,
+        x, y, w, h,
+        parent, (HMENU)(INT_PTR)id,
+        GetModuleHandleW(nullptr), store);
+}
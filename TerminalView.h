@@ -0,0 +1,33 @@
+// TerminalView.h - Janela "terminal" desenhada sob medida sobre um Scrollback
+// Objetivo: exibir o histórico sem copiá-lo para um controle EDIT. Só as
+//           linhas visíveis são desenhadas; o custo de repintar independe
+//           do tamanho do log.
+
+#pragma once
+
+#include <windows.h>
+
+#include <cstdint>
+#include <vector>
+
+class Scrollback;
+
+#define TERMINAL_VIEW_CLASS L"SerialTerminalView"
+
+// Registra a classe da janela (uma vez, antes de criar a view).
+bool RegisterTerminalView(HINSTANCE hInstance);
+
+// Cria a view como filha de 'parent'. 'store' precisa viver mais que a janela.
+HWND CreateTerminalView(HWND parent, int x, int y, int w, int h, int id, Scrollback* store);
+
+// Avisa que o Scrollback mudou: ajusta barra de rolagem, segue o fim (se o
+// usuário não rolou para cima) e agenda repintura. Barato: não desenha nada.
+void TerminalViewContentChanged(HWND view);
+
+// Filtro: mostra só as linhas absolutas de 'lines' (ordem crescente; quem
+// chama acrescenta/remove e avisa com TerminalViewContentChanged). nullptr =
+// todas. 'lines' precisa viver enquanto estiver em uso.
+void TerminalViewSetFilter(HWND view, const std::vector<uint64_t>* lines);
+
+// Destaca a linha absoluta 'line' e rola até ela (UINT64_MAX = sem destaque).
+void TerminalViewShowLine(HWND view, uint64_t line);
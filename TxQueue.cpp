@@ -0,0 +1,183 @@
+// TxQueue.cpp - Fila de transmissão assíncrona (ver TxQueue.h)
+
+#include "TxQueue.h"
+#include "SerialPort.h"
+
+#include <chrono>
+
+static uint64_t SteadyNowNs() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+TxQueue::TxQueue(size_t maxMessages, size_t maxBytes, size_t coalesceBytes)
+    : m_maxMessages(maxMessages ? maxMessages : 1),
+      m_maxBytes(maxBytes ? maxBytes : 1),
+      m_coalesceBytes(coalesceBytes ? coalesceBytes : 1) {
+}
+
+TxQueue::~TxQueue() {
+    Stop();
+}
+
+void TxQueue::Start(SerialPort* port, Completion onDone) {
+    Stop();
+    m_port = port;
+    m_onDone = onDone;
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_stop = false;
+        m_running = true;
+    }
+    m_thread = std::thread(&TxQueue::WriterLoop, this);
+}
+
+// m_thread só é tocado aqui e em Start() (thread dona da fila); quem
+// enfileira de outras threads (ex.: a ponte TCP) olha só m_running.
+void TxQueue::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        if (!m_running) return;
+        m_running = false;
+        m_stop = true;
+    }
+    m_hasWork.notify_all();
+    m_hasRoom.notify_all();
+    m_thread.join();
+
+    // Reporta o que não chegou a ser enviado:
+    std::deque<Message> left;
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        left.swap(m_queue);
+        m_queuedBytes = 0;
+        m_stats.messagesFailed += left.size();
+    }
+    uint64_t now = SteadyNowNs();
+    for (const Message& m : left) {
+        if (m_onDone) m_onDone(TxResult{ m.id, m.data.size(), false, now });
+    }
+    m_port = nullptr;
+}
+
+// Uma mensagem maior que o limite de bytes é aceita com a fila vazia;
+// caso contrário nunca caberia.
+bool TxQueue::HasRoom(size_t len) const {
+    if (m_queue.empty()) return true;
+    return m_queue.size() < m_maxMessages && m_queuedBytes + len <= m_maxBytes;
+}
+
+uint64_t TxQueue::PushLocked(const void* data, size_t len) {
+    Message m;
+    m.id = m_nextId++;
+    m.data.assign((const uint8_t*)data, (const uint8_t*)data + len);
+    m_queue.push_back(std::move(m));
+    m_queuedBytes += len;
+    return m_queue.back().id;
+}
+
+uint64_t TxQueue::Enqueue(const void* data, size_t len) {
+    uint64_t id;
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        if (!m_running || !HasRoom(len)) {
+            ++m_stats.dropped;
+            return 0;
+        }
+        id = PushLocked(data, len);
+    }
+    m_hasWork.notify_one();
+    return id;
+}
+
+uint64_t TxQueue::TryEnqueue(const void* data, size_t len) {
+    uint64_t id;
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        if (!m_running || !HasRoom(len)) return 0;
+        id = PushLocked(data, len);
+    }
+    m_hasWork.notify_one();
+    return id;
+}
+
+uint64_t TxQueue::EnqueueWait(const void* data, size_t len, uint32_t timeoutMs) {
+    uint64_t id;
+    {
+        std::unique_lock<std::mutex> lock(m_lock);
+        bool room = m_hasRoom.wait_for(lock, std::chrono::milliseconds(timeoutMs), [&] {
+            return m_stop || HasRoom(len);
+        });
+        if (!room || !m_running) {
+            ++m_stats.dropped;
+            return 0;
+        }
+        id = PushLocked(data, len);
+    }
+    m_hasWork.notify_one();
+    return id;
+}
+
+TxStats TxQueue::Stats() const {
+    std::lock_guard<std::mutex> lock(m_lock);
+    TxStats s = m_stats;
+    s.queuedMessages = m_queue.size();
+    s.queuedBytes = m_queuedBytes;
+    return s;
+}
+
+void TxQueue::WriterLoop() {
+    std::vector<Message> batch;
+    std::vector<SerialIoVec> iov;
+
+    for (;;) {
+        // Retira da fila tudo que cabe numa escrita (no mínimo uma mensagem):
+        batch.clear();
+        {
+            std::unique_lock<std::mutex> lock(m_lock);
+            m_hasWork.wait(lock, [&] { return m_stop || !m_queue.empty(); });
+            if (m_stop) return;
+
+            size_t bytes = 0;
+            while (!m_queue.empty()) {
+                size_t len = m_queue.front().data.size();
+                if (!batch.empty() && bytes + len > m_coalesceBytes) break;
+                bytes += len;
+                m_queuedBytes -= len;
+                batch.push_back(std::move(m_queue.front()));
+                m_queue.pop_front();
+            }
+        }
+        m_hasRoom.notify_all();
+
+        iov.clear();
+        for (const Message& m : batch) iov.push_back(SerialIoVec{ m.data.data(), m.data.size() });
+        long written = m_port->WriteV(iov.data(), iov.size());
+        uint64_t now = SteadyNowNs();
+
+        // Mensagem só conta como enviada se saiu inteira; numa escrita parcial
+        // (timeout) as que ficaram pela metade ou de fora falham.
+        size_t done = (written > 0) ? (size_t)written : 0;
+        if (m_tap) {
+            size_t left = done;
+            for (size_t i = 0; i < iov.size() && left > 0; ++i) {
+                size_t n = (iov[i].len < left) ? iov[i].len : left;
+                m_tap((const uint8_t*)iov[i].data, n);
+                left -= n;
+            }
+        }
+        size_t end = 0, sent = 0;
+        for (const Message& m : batch) {
+            end += m.data.size();
+            bool ok = (written >= 0) && end <= done;
+            if (ok) ++sent;
+            if (m_onDone) m_onDone(TxResult{ m.id, m.data.size(), ok, now });
+        }
+
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_stats.bytesWritten += done;
+        m_stats.writeCalls += 1;
+        m_stats.messagesSent += sent;
+        m_stats.messagesFailed += batch.size() - sent;
+    }
+}
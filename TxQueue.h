@@ -0,0 +1,116 @@
+// TxQueue.h - Fila de transmissão assíncrona (thread de escrita dedicada)
+// Objetivo: tirar o WriteFile síncrono da thread da UI. Um dispositivo parado
+//           ou em flow control não congela mais a janela, e rajadas de envios
+//           viram poucas escritas grandes em vez de muitas pequenas.
+//
+// Funcionamento:
+//  - Enqueue() copia a mensagem para uma fila limitada (mensagens e bytes).
+//    Fila cheia: Enqueue() recusa na hora (retorna 0, conta em 'dropped') e
+//    EnqueueWait() espera espaço até um prazo (backpressure para produtores
+//    que podem esperar, ex.: scripts).
+//  - A thread de escrita junta as mensagens pendentes (até 'coalesceBytes')
+//    e manda tudo num único SerialPort::WriteV (writev no Linux).
+//  - Cada mensagem gera um TxResult no callback de conclusão, chamado NA
+//    THREAD DE ESCRITA: o callback deve só repassar (ex.: PostMessage).
+//  - Opcional: um "tap" recebe os bytes que o driver aceitou, também na
+//    thread de escrita (ex.: captura de TX).
+//
+// Não depende de Win32.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class SerialPort;
+
+struct TxResult {
+    uint64_t id;          // o mesmo retornado por Enqueue()
+    size_t   bytes;       // tamanho da mensagem
+    bool     ok;          // false: timeout/erro de escrita ou Stop() antes do envio
+    uint64_t doneNs;      // steady_clock (ns) em que a escrita terminou
+};
+
+struct TxStats {
+    size_t   queuedMessages = 0;   // profundidade atual da fila
+    size_t   queuedBytes = 0;
+    uint64_t bytesWritten = 0;     // total aceito pelo driver
+    uint64_t writeCalls = 0;       // escritas (WriteV) feitas
+    uint64_t messagesSent = 0;
+    uint64_t messagesFailed = 0;
+    uint64_t dropped = 0;          // recusadas por fila cheia
+};
+
+class TxQueue {
+public:
+    using Completion = std::function<void(const TxResult&)>;
+    using Tap = std::function<void(const uint8_t* data, size_t len)>;
+
+    TxQueue(size_t maxMessages = 1024, size_t maxBytes = 1u << 20, size_t coalesceBytes = 16 * 1024);
+    ~TxQueue();
+
+    TxQueue(const TxQueue&) = delete;
+    TxQueue& operator=(const TxQueue&) = delete;
+
+    // Inicia a thread de escrita sobre 'port' (aberta; não é dono dela).
+    void Start(SerialPort* port, Completion onDone);
+
+    // Para a thread (espera a escrita em andamento, limitada por writeTimeoutMs).
+    // O que ainda estava na fila é reportado com ok=false.
+    void Stop();
+
+    bool Running() const {
+        std::lock_guard<std::mutex> lock(m_lock);
+        return m_running;
+    }
+
+    // Define o tap de bytes escritos. Só com a thread parada (antes de Start()).
+    void SetTap(Tap tap) { m_tap = tap; }
+
+    // Retorna o id da mensagem (>0) ou 0 se a fila está cheia/parada.
+    uint64_t Enqueue(const void* data, size_t len);
+
+    // Como Enqueue(), mas fila cheia não conta em 'dropped': para quem guarda
+    // a mensagem e tenta de novo (ex.: escritor da ponte TCP, TcpBridge.h).
+    uint64_t TryEnqueue(const void* data, size_t len);
+
+    // Como Enqueue(), mas espera até 'timeoutMs' por espaço na fila.
+    uint64_t EnqueueWait(const void* data, size_t len, uint32_t timeoutMs);
+
+    TxStats Stats() const;
+
+private:
+    struct Message {
+        uint64_t id;
+        std::vector<uint8_t> data;
+    };
+
+    bool HasRoom(size_t len) const;
+    uint64_t PushLocked(const void* data, size_t len);
+    void WriterLoop();
+
+    const size_t m_maxMessages;
+    const size_t m_maxBytes;
+    const size_t m_coalesceBytes;
+
+    SerialPort* m_port = nullptr;
+    Completion m_onDone;
+    Tap m_tap;
+    std::thread m_thread;
+
+    mutable std::mutex m_lock;
+    std::condition_variable m_hasWork;   // fila não vazia ou Stop()
+    std::condition_variable m_hasRoom;   // espaço liberado (EnqueueWait)
+    std::deque<Message> m_queue;
+    size_t m_queuedBytes = 0;
+    bool m_stop = false;                 // pede o fim à thread de escrita
+    bool m_running = false;              // Start() .. Stop(): aceita mensagens
+    uint64_t m_nextId = 1;
+    TxStats m_stats;
+};
@@ -0,0 +1,553 @@
+// TxScheduler.cpp - Gerador de carga TX (ver TxScheduler.h)
+
+#include "TxScheduler.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// ============================================================================
+//                                 TimerWheel
+// ============================================================================
+TimerWheel::TimerWheel(int64_t tickNs)
+    : m_slots(kSlots), m_tickNs(tickNs > 0 ? tickNs : 1) {
+}
+
+void TimerWheel::Clear(int64_t nowNs) {
+    for (auto& s : m_slots) s.clear();
+    m_cursor = nowNs / m_tickNs;
+    m_size = 0;
+}
+
+void TimerWheel::Insert(uint32_t id, int64_t deadlineNs) {
+    int64_t tick = std::max(deadlineNs / m_tickNs, m_cursor);   // vencido: vai na posição atual
+    m_slots[(size_t)(tick % kSlots)].push_back(Entry{ deadlineNs, id });
+    m_size++;
+}
+
+int64_t TimerWheel::NextDeadline() const {
+    if (m_size == 0) return INT64_MAX;
+    // Uma volta a partir do cursor: a primeira posição com prazo desta volta
+    // tem o menor prazo (posições anteriores já foram esvaziadas).
+    for (uint32_t i = 0; i < kSlots; i++) {
+        int64_t tick = m_cursor + i;
+        int64_t best = INT64_MAX;
+        for (const Entry& e : m_slots[(size_t)(tick % kSlots)])
+            if (std::max(e.deadlineNs / m_tickNs, m_cursor) == tick) best = std::min(best, e.deadlineNs);
+        if (best != INT64_MAX) return best;
+    }
+    // Tudo a mais de uma volta (períodos longos): menor de todos.
+    int64_t best = INT64_MAX;
+    for (const auto& s : m_slots)
+        for (const Entry& e : s) best = std::min(best, e.deadlineNs);
+    return best;
+}
+
+void TimerWheel::PopDue(int64_t nowNs, std::vector<Entry>* out) {
+    out->clear();
+    int64_t nowTick = nowNs / m_tickNs;
+    int64_t steps = std::min<int64_t>(nowTick - m_cursor + 1, kSlots);
+    for (int64_t i = 0; i < steps; i++) {
+        std::vector<Entry>& slot = m_slots[(size_t)((m_cursor + i) % kSlots)];
+        size_t keep = 0;
+        for (size_t k = 0; k < slot.size(); k++) {
+            if (slot[k].deadlineNs <= nowNs) out->push_back(slot[k]);
+            else slot[keep++] = slot[k];
+        }
+        slot.resize(keep);
+    }
+    if (nowTick > m_cursor) m_cursor = nowTick;
+    m_size -= out->size();
+    if (out->size() > 1)
+        std::sort(out->begin(), out->end(),
+                  [](const Entry& a, const Entry& b) { return a.deadlineNs < b.deadlineNs; });
+}
+
+// ============================================================================
+//                                ParseTxPlan
+// ============================================================================
+namespace {
+
+const char* SkipSpaces(const char* p) {
+    while (*p == ' ' || *p == '\t') p++;
+    return p;
+}
+
+int HexDigit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// "texto" com escapes ou "hex 01 02 AA". 'p' avança até depois do payload.
+bool ParsePayload(const char*& p, std::string* out, std::string* error) {
+    p = SkipSpaces(p);
+    out->clear();
+    if (*p == '"') {
+        for (p++; *p && *p != '"'; p++) {
+            if (*p != '\\') {
+                out->push_back(*p);
+                continue;
+            }
+            p++;
+            switch (*p) {
+            case 'r': out->push_back('\r'); break;
+            case 'n': out->push_back('\n'); break;
+            case 't': out->push_back('\t'); break;
+            case '0': out->push_back('\0'); break;
+            case '\\': out->push_back('\\'); break;
+            case '"': out->push_back('"'); break;
+            case 'x': {
+                int hi = HexDigit(p[1]), lo = hi < 0 ? -1 : HexDigit(p[2]);
+                if (lo < 0) {
+                    *error = "\\x precisa de 2 digitos hex";
+                    return false;
+                }
+                out->push_back((char)(hi * 16 + lo));
+                p += 2;
+                break;
+            }
+            default:
+                *error = "escape invalido";
+                return false;
+            }
+        }
+        if (*p != '"') {
+            *error = "aspas sem fechar";
+            return false;
+        }
+        p++;
+        return true;
+    }
+    if (strncmp(p, "hex", 3) == 0 && (p[3] == ' ' || p[3] == '\t')) {
+        p = SkipSpaces(p + 3);
+        while (HexDigit(*p) >= 0) {
+            int hi = HexDigit(p[0]), lo = HexDigit(p[1]);
+            if (lo < 0) break;                  // ex.: "count=": fica para quem chamou
+            out->push_back((char)(hi * 16 + lo));
+            p = SkipSpaces(p + 2);
+        }
+        if (out->empty()) *error = "hex sem bytes";
+        return !out->empty();
+    }
+    *error = "payload deve ser \"texto\" ou hex ...";
+    return false;
+}
+
+bool ParseNumber(const char*& p, double* v) {
+    p = SkipSpaces(p);
+    char* end = nullptr;
+    *v = strtod(p, &end);
+    if (end == p || !std::isfinite(*v)) return false;
+    p = end;
+    return true;
+}
+
+// Payload legível para o relatório: escapes e no máximo ~24 caracteres.
+std::string Printable(const std::string& s) {
+    std::string out = "\"";
+    size_t i = 0;
+    for (; i < s.size() && out.size() < 24; i++) {
+        unsigned char c = (unsigned char)s[i];
+        if (c == '\r') out += "\\r";
+        else if (c == '\n') out += "\\n";
+        else if (c == '"' || c == '\\') (out += '\\') += (char)c;
+        else if (c < 32 || c >= 127) {
+            char b[8];
+            snprintf(b, sizeof(b), "\\x%02X", c);
+            out += b;
+        }
+        else out += (char)c;
+    }
+    out += i < s.size() ? "...\"" : "\"";
+    return out;
+}
+
+std::string FormatMs(double ms) {
+    char b[32];
+    snprintf(b, sizeof(b), "%g", ms);
+    return b;
+}
+
+} // namespace
+
+bool ParseTxPlan(const std::string& text, TxPlan* plan, std::string* error) {
+    TxPlan out;
+    std::string err;
+    size_t lineNo = 0;
+    for (size_t pos = 0; pos <= text.size() && err.empty();) {
+        size_t eol = text.find('\n', pos);
+        if (eol == std::string::npos) eol = text.size();
+        std::string line = text.substr(pos, eol - pos);
+        pos = eol + 1;
+        lineNo++;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+
+        const char* p = SkipSpaces(line.c_str());
+        if (*p == 0 || *p == '#') continue;
+        const char* word = p;
+        while (*p && *p != ' ' && *p != '\t') p++;
+        std::string kw(word, p);
+
+        double v = 0;
+        if (kw == "every") {
+            TxPlanStream s;
+            if (!ParseNumber(p, &v) || v < 0.01) err = "periodo invalido (ms, >= 0.01)";
+            else if (ParsePayload(p, &s.payload, &err)) {
+                s.periodNs = (int64_t)(v * 1e6 + 0.5);
+                p = SkipSpaces(p);
+                if (strncmp(p, "count=", 6) == 0) {
+                    p += 6;
+                    double c = 0;
+                    if (!ParseNumber(p, &c) || c < 1) err = "count invalido";
+                    s.count = (uint64_t)c;
+                }
+                s.label = "every " + FormatMs(v) + " ms " + Printable(s.payload);
+                out.streams.push_back(s);
+            }
+        }
+        else if (kw == "send") {
+            TxPlanStep st;
+            st.kind = TxPlanStep::Send;
+            if (ParsePayload(p, &st.data, &err)) out.script.push_back(st);
+        }
+        else if (kw == "wait") {
+            TxPlanStep st;
+            st.kind = TxPlanStep::Wait;
+            if (!ParseNumber(p, &v) || v < 0) err = "wait invalido (ms)";
+            st.ns = (int64_t)(v * 1e6 + 0.5);
+            out.script.push_back(st);
+        }
+        else if (kw == "expect") {
+            TxPlanStep st;
+            st.kind = TxPlanStep::Expect;
+            if (ParsePayload(p, &st.data, &err)) {
+                v = 1000;
+                if (*SkipSpaces(p) && (!ParseNumber(p, &v) || v <= 0)) err = "timeout invalido (ms)";
+                st.ns = (int64_t)(v * 1e6 + 0.5);
+                out.script.push_back(st);
+            }
+        }
+        else if (kw == "repeat") {
+            if (!ParseNumber(p, &v) || v < 0) err = "repeat invalido";
+            out.repeat = (uint32_t)v;
+        }
+        else if (kw == "duration") {
+            if (!ParseNumber(p, &v) || v <= 0) err = "duration invalido (s)";
+            out.seconds = v;
+        }
+        else {
+            err = "diretiva desconhecida: " + kw;
+        }
+        if (err.empty() && *SkipSpaces(p) != 0) err = std::string("sobrou texto: ") + SkipSpaces(p);
+        if (!err.empty()) err = "linha " + std::to_string(lineNo) + ": " + err;
+    }
+
+    if (err.empty() && out.streams.empty() && out.script.empty())
+        err = "plano vazio";
+    if (err.empty() && !out.script.empty() && out.repeat == 0) {
+        bool waits = std::any_of(out.script.begin(), out.script.end(),
+                                 [](const TxPlanStep& s) { return s.kind != TxPlanStep::Send && s.ns > 0; });
+        if (!waits) err = "repeat 0 precisa de wait/expect no roteiro";
+    }
+    if (!err.empty()) {
+        if (error) *error = err;
+        return false;
+    }
+    *plan = out;
+    return true;
+}
+
+// ============================================================================
+//                                TxScheduler
+// ============================================================================
+std::string TxScheduleReportToText(const TxScheduleReport& r) {
+    char buf[512];
+    double secs = r.seconds > 0 ? r.seconds : 1e-9;
+    snprintf(buf, sizeof(buf),
+        "[CARGA] %.2f s, %llu bytes (%.1f KB/s)%s | atraso p50 %.1f us, p99 %.1f, p99.9 %.1f, max %.1f us, média %.1f us",
+        r.seconds, (unsigned long long)r.bytes, r.bytes / secs / 1024.0,
+        r.finished ? "" : " [interrompido]",
+        r.lateP50Us, r.lateP99Us, r.lateP999Us, r.lateMaxUs, r.lateMeanUs);
+    std::string out = buf;
+
+    for (const TxStreamReport& s : r.streams) {
+        snprintf(buf, sizeof(buf),
+            "\n[CARGA] %s: %llu envios, %.1f/s (alvo %.1f/s), %llu recusados, %llu pulados | "
+            "atraso médio %.1f us (max %.1f), desvio do intervalo %.1f us",
+            s.label.c_str(), (unsigned long long)s.sent, s.rateHz, s.targetHz,
+            (unsigned long long)s.sendFailed, (unsigned long long)s.missed,
+            s.lateMeanUs, s.lateMaxUs, s.intervalJitterUs);
+        out += buf;
+    }
+    if (r.scriptSent || r.scriptFailed || r.loops || r.expectOk || r.expectTimeouts) {
+        snprintf(buf, sizeof(buf),
+            "\n[CARGA] roteiro: %u execuções, %llu envios (%llu recusados), expect %llu ok / %llu timeouts",
+            r.loops, (unsigned long long)r.scriptSent, (unsigned long long)r.scriptFailed,
+            (unsigned long long)r.expectOk, (unsigned long long)r.expectTimeouts);
+        out += buf;
+    }
+    return out;
+}
+
+bool TxScheduler::Start(const TxPlan& plan, SendFn send, DoneFn onDone) {
+    Stop();
+    m_plan = plan;
+    m_send = send;
+    m_onDone = onDone;
+    m_state.assign(m_plan.streams.size(), StreamState());
+    m_armed.store(false);
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_late.Reset();
+        m_report = TxScheduleReport();
+        m_report.streams.resize(m_plan.streams.size());
+        for (size_t i = 0; i < m_plan.streams.size(); i++) {
+            m_report.streams[i].label = m_plan.streams[i].label;
+            m_report.streams[i].targetHz = 1e9 / (double)m_plan.streams[i].periodNs;
+        }
+        m_startNs = PreciseTimer::NowNs();
+        m_endNs = 0;
+        m_hitNs = 0;
+    }
+    m_stop.store(false);
+    m_timer.Reset();
+    m_running.store(true, std::memory_order_release);
+    m_thread = std::thread(&TxScheduler::Run, this);
+    return true;
+}
+
+void TxScheduler::Stop() {
+    if (!m_thread.joinable()) return;
+    m_stop.store(true);
+    m_timer.Cancel();
+    m_thread.join();
+    m_armed.store(false);
+    m_running.store(false, std::memory_order_release);
+}
+
+void TxScheduler::Run() {
+    const uint32_t streams = (uint32_t)m_plan.streams.size();
+    const int64_t start = m_startNs;
+    const int64_t stopAt = m_plan.seconds > 0 ? start + (int64_t)(m_plan.seconds * 1e9) : INT64_MAX;
+
+    m_wheel.Clear(start);
+    size_t active = streams;
+    for (uint32_t i = 0; i < streams; i++) m_wheel.Insert(i, start);
+    m_step = 0;
+    m_expecting = false;
+    m_scriptDone = m_plan.script.empty();
+    if (!m_scriptDone) ScheduleScript(start);
+
+    bool completed = true;
+    std::vector<TimerWheel::Entry> due;
+    for (;;) {
+        if (m_stop.load()) {
+            completed = false;
+            break;
+        }
+        if (active == 0 && m_scriptDone) break;
+
+        // Cancel() sem Stop() = o RX casou o expect: retoma o roteiro já.
+        if (!m_timer.SleepUntil(std::min(m_wheel.NextDeadline(), stopAt)))
+            m_timer.Reset();
+        if (m_stop.load()) {
+            completed = false;
+            break;
+        }
+        int64_t now = PreciseTimer::NowNs();
+        if (now >= stopAt) break;
+
+        if (m_expecting) {
+            int64_t hit;
+            {
+                std::lock_guard<std::mutex> lock(m_lock);
+                hit = m_hitNs;
+                if (hit) {
+                    m_armed.store(false);
+                    m_report.expectOk++;
+                }
+            }
+            if (hit) {
+                m_expecting = false;
+                m_scriptToken++;              // o timeout pendente vira lixo
+                RunScript(hit);
+            }
+        }
+
+        m_wheel.PopDue(now, &due);
+        for (const TimerWheel::Entry& e : due) {
+            if (e.id < streams) {
+                FireStream(e.id, e.deadlineNs);
+                uint64_t count = m_plan.streams[e.id].count;
+                if (count && m_state[e.id].fired >= count) active--;
+                continue;
+            }
+            if (e.id - streams != m_scriptToken) continue;
+            if (m_expecting) {
+                {
+                    std::lock_guard<std::mutex> lock(m_lock);
+                    m_armed.store(false);
+                    if (m_hitNs) m_report.expectOk++;
+                    else m_report.expectTimeouts++;
+                }
+                m_expecting = false;
+            }
+            RunScript(e.deadlineNs);
+        }
+    }
+
+    m_armed.store(false);
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_endNs = PreciseTimer::NowNs();
+        m_report.finished = completed;
+    }
+    m_running.store(false, std::memory_order_release);
+    if (completed && m_onDone) m_onDone();
+}
+
+void TxScheduler::FireStream(uint32_t index, int64_t deadlineNs) {
+    const TxPlanStream& s = m_plan.streams[index];
+    StreamState& st = m_state[index];
+    int64_t now = PreciseTimer::NowNs();
+    uint64_t id = m_send(s.payload.data(), s.payload.size());
+
+    int64_t next = deadlineNs + s.periodNs;
+    uint64_t skipped = 0;
+    int64_t after = PreciseTimer::NowNs();
+    if (after - next >= s.periodNs) {
+        skipped = (uint64_t)((after - next) / s.periodNs);
+        next += (int64_t)skipped * s.periodNs;
+    }
+    st.fired += 1 + skipped;
+    bool more = !s.count || st.fired < s.count;
+    if (more) m_wheel.Insert(index, next);
+
+    std::lock_guard<std::mutex> lock(m_lock);
+    if (!more) st.doneNs = next;          // a taxa conta só o tempo em que o fluxo existiu
+    TxStreamReport& r = m_report.streams[index];
+    r.missed += skipped;
+    if (id == 0) {
+        r.sendFailed++;
+        return;
+    }
+    int64_t late = now - deadlineNs;
+    RecordLate(late);
+    st.lateSumNs += (double)late;
+    st.lateMaxNs = std::max(st.lateMaxNs, late);
+    if (st.lastSendNs) {
+        st.intervalDevSumNs += std::fabs((double)(now - st.lastSendNs - s.periodNs));
+        st.intervals++;
+    }
+    st.lastSendNs = now;
+    r.sent++;
+    r.bytes += s.payload.size();
+    m_report.bytes += s.payload.size();
+}
+
+void TxScheduler::ScheduleScript(int64_t deadlineNs) {
+    m_scriptToken++;
+    m_wheel.Insert((uint32_t)m_plan.streams.size() + m_scriptToken, deadlineNs);
+}
+
+void TxScheduler::RunScript(int64_t nowNs) {
+    const std::vector<TxPlanStep>& script = m_plan.script;
+    for (;;) {
+        if (m_step >= script.size()) {
+            uint32_t loops;
+            {
+                std::lock_guard<std::mutex> lock(m_lock);
+                loops = ++m_report.loops;
+            }
+            if (m_plan.repeat != 0 && loops >= m_plan.repeat) {
+                m_scriptDone = true;
+                return;
+            }
+            m_step = 0;
+        }
+
+        const TxPlanStep& st = script[m_step++];
+        if (st.kind == TxPlanStep::Wait) {
+            if (st.ns > 0) {
+                ScheduleScript(nowNs + st.ns);
+                return;
+            }
+            continue;
+        }
+
+        if (st.kind == TxPlanStep::Expect) {
+            // Já armado pelo send anterior? (a resposta pode ter chegado).
+            if (!m_armed.load()) ArmExpect(st.data);
+            m_expecting = true;
+            ScheduleScript(nowNs + st.ns);
+            return;
+        }
+
+        // Send: arma o expect seguinte antes (ver TxScheduler.h).
+        if (m_step < script.size() && script[m_step].kind == TxPlanStep::Expect)
+            ArmExpect(script[m_step].data);
+        int64_t late = PreciseTimer::NowNs() - nowNs;
+        uint64_t id = m_send(st.data.data(), st.data.size());
+        std::lock_guard<std::mutex> lock(m_lock);
+        if (id == 0) {
+            m_report.scriptFailed++;
+            continue;
+        }
+        RecordLate(late);
+        m_report.scriptSent++;
+        m_report.bytes += st.data.size();
+    }
+}
+
+// O padrão pode chegar partido entre leituras (StreamMatcher).
+void TxScheduler::ArmExpect(const std::string& pattern) {
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_match.Set(pattern);
+    m_hitNs = 0;
+    m_armed.store(true, std::memory_order_release);
+}
+
+void TxScheduler::RecordLate(int64_t lateNs) {
+    m_late.Record(lateNs > 0 ? (uint64_t)lateNs : 0);
+}
+
+// Casamento incremental no fluxo RX, atravessando leituras.
+void TxScheduler::OnRx(const uint8_t* data, size_t len, int64_t nowNs) {
+    if (!m_armed.load(std::memory_order_acquire)) return;
+    bool hit = false;
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        if (!m_armed.load() || m_hitNs != 0) return;
+        hit = m_match.Empty();
+        for (size_t i = 0; i < len && !hit; ++i) hit = m_match.Feed(data[i]);
+        if (hit) m_hitNs = nowNs;
+    }
+    if (hit) m_timer.Cancel();
+}
+
+TxScheduleReport TxScheduler::Report() const {
+    std::lock_guard<std::mutex> lock(m_lock);
+    TxScheduleReport r = m_report;
+    int64_t end = m_endNs ? m_endNs : PreciseTimer::NowNs();
+    r.seconds = (end - m_startNs) / 1e9;
+    for (size_t i = 0; i < r.streams.size() && i < m_state.size(); i++) {
+        TxStreamReport& s = r.streams[i];
+        const StreamState& st = m_state[i];
+        double secs = st.doneNs ? (std::min(st.doneNs, end) - m_startNs) / 1e9 : r.seconds;
+        s.rateHz = secs > 0 ? s.sent / secs : 0;
+        s.lateMeanUs = s.sent ? st.lateSumNs / s.sent / 1000.0 : 0;
+        s.lateMaxUs = st.lateMaxNs / 1000.0;
+        s.intervalJitterUs = st.intervals ? st.intervalDevSumNs / st.intervals / 1000.0 : 0;
+    }
+    r.lateP50Us = m_late.Percentile(0.50) / 1000.0;
+    r.lateP99Us = m_late.Percentile(0.99) / 1000.0;
+    r.lateP999Us = m_late.Percentile(0.999) / 1000.0;
+    r.lateMaxUs = m_late.Max() / 1000.0;
+    r.lateMeanUs = m_late.Mean() / 1000.0;
+    return r;
+}
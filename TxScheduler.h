@@ -0,0 +1,206 @@
+// TxScheduler.h - Envios periódicos e roteiros de TX (gerador de carga)
+// Objetivo: gerar carga sem clicar em "Enviar": vários fluxos independentes,
+//           cada um com o seu período (até 1 ms ou menos), e um roteiro
+//           sequencial que espera padrões no RX, com a taxa obtida e o
+//           atraso de cada envio medidos no fim.
+//
+// Agendamento:
+//  - Uma thread só. Os prazos (absolutos, em ns) ficam numa TimerWheel de
+//    512 posições de 100 us: inserir é O(1) e achar o próximo prazo olha no
+//    máximo uma volta, com milhares de fluxos.
+//  - A espera até o prazo é a do PreciseTimer (dorme no SO e termina em
+//    espera ativa curta): o atraso fica em microssegundos, não nos 15,6 ms
+//    do tick do Windows.
+//  - O próximo envio de um fluxo é prazo + período (sem deriva). Atrasou mais
+//    de um período (fila TX cheia, CPU ocupada)? Os envios perdidos não saem
+//    em rajada: contam em 'missed' e o fluxo segue no próximo prazo futuro.
+//  - Medições: atraso = instante do envio - prazo (HDR, todos os fluxos) e,
+//    por fluxo, desvio do intervalo entre envios em relação ao período.
+//
+// Roteiro: passos send/wait/expect executados em ordem, 'repeat' vezes. O
+// expect é armado antes do send anterior (a resposta pode chegar antes de
+// Send() voltar) e procura o padrão no fluxo RX, mesmo partido entre leituras.
+// Timeout do expect conta em 'expectTimeouts' e o roteiro segue.
+//
+// Texto do plano (ParseTxPlan), uma diretiva por linha, '#' = comentário:
+//   every 1 "PING\r\n" [count=1000]   fluxo: a cada 1 ms (0.25 = 250 us)
+//   every 10 hex 55 AA 01             payload binário
+//   send "AT\r\n"                     roteiro: envia
+//   wait 5                            roteiro: espera 5 ms
+//   expect "OK" 1000                  roteiro: espera "OK" no RX (timeout em ms)
+//   repeat 10                         roteiro: executa 10 vezes (0 = sem fim)
+//   duration 30                       para tudo depois de 30 s
+// Escapes nas aspas: \r \n \t \0 \\ \" \xHH.
+//
+// Threads: thread própria; OnRx() na thread do reactor toma uma trava curta
+// (e nem isso sem expect armado).
+//
+// Não depende de Win32.
+
+#pragma once
+
+#include "PreciseTimer.h"
+#include "RttMeter.h"             // HdrHistogram
+#include "StreamMatcher.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Roda de tempo de um nível: prazo absoluto -> posição (prazo / tick) % kSlots.
+// Prazos mais de uma volta à frente dividem a posição e são ignorados até a
+// volta certa. Não é thread-safe (só a thread do agendador usa).
+class TimerWheel {
+public:
+    static const uint32_t kSlots = 512;
+
+    struct Entry {
+        int64_t  deadlineNs;
+        uint32_t id;
+    };
+
+    explicit TimerWheel(int64_t tickNs = 100000);
+
+    void Clear(int64_t nowNs);
+    void Insert(uint32_t id, int64_t deadlineNs);
+    size_t Size() const { return m_size; }
+
+    // Menor prazo (INT64_MAX se vazia).
+    int64_t NextDeadline() const;
+
+    // Tira em 'out' (substitui o conteúdo) tudo com prazo <= nowNs, em ordem de prazo.
+    void PopDue(int64_t nowNs, std::vector<Entry>* out);
+
+private:
+    std::vector<std::vector<Entry>> m_slots;
+    int64_t m_tickNs;
+    int64_t m_cursor = 0;         // tick da posição atual (tudo antes dela já saiu)
+    size_t  m_size = 0;
+};
+
+struct TxPlanStream {
+    std::string payload;
+    int64_t  periodNs = 0;
+    uint64_t count = 0;           // 0 = sem fim
+    std::string label;            // "every 1 PING\r\n" (para o relatório)
+};
+
+struct TxPlanStep {
+    enum Kind : uint8_t { Send, Wait, Expect };
+    Kind kind = Send;
+    std::string data;             // Send: payload; Expect: padrão
+    int64_t ns = 0;               // Wait: duração; Expect: timeout
+};
+
+struct TxPlan {
+    std::vector<TxPlanStream> streams;
+    std::vector<TxPlanStep> script;
+    uint32_t repeat = 1;          // execuções do roteiro (0 = sem fim)
+    double   seconds = 0;         // 0 = até os fluxos/roteiro acabarem ou Stop()
+};
+
+// false = plano inválido ('error' = "linha N: ...").
+bool ParseTxPlan(const std::string& text, TxPlan* plan, std::string* error);
+
+struct TxStreamReport {
+    std::string label;
+    uint64_t sent = 0;
+    uint64_t sendFailed = 0;      // fila TX cheia
+    uint64_t missed = 0;          // prazos pulados por atraso > período
+    uint64_t bytes = 0;
+    double   targetHz = 0;
+    double   rateHz = 0;          // envios aceitos / duração
+    double   lateMeanUs = 0;
+    double   lateMaxUs = 0;
+    double   intervalJitterUs = 0;   // média de |intervalo - período|
+};
+
+struct TxScheduleReport {
+    std::vector<TxStreamReport> streams;
+    uint64_t scriptSent = 0;
+    uint64_t scriptFailed = 0;
+    uint64_t expectOk = 0;
+    uint64_t expectTimeouts = 0;
+    uint32_t loops = 0;           // execuções completas do roteiro
+    uint64_t bytes = 0;           // fluxos + roteiro
+    double   seconds = 0;
+    // Atraso de todos os envios agendados (fluxos + roteiro), em us:
+    double   lateP50Us = 0, lateP99Us = 0, lateP999Us = 0, lateMaxUs = 0, lateMeanUs = 0;
+    bool     finished = false;    // false = interrompido por Stop()
+};
+
+// Linhas legíveis ("[CARGA] ..."), separadas por "\n".
+std::string TxScheduleReportToText(const TxScheduleReport& r);
+
+class TxScheduler {
+public:
+    using SendFn = std::function<uint64_t(const void* data, size_t len)>;   // id da TxQueue (0 = recusado)
+    using DoneFn = std::function<void()>;
+
+    TxScheduler() {}
+    ~TxScheduler() { Stop(); }
+
+    TxScheduler(const TxScheduler&) = delete;
+    TxScheduler& operator=(const TxScheduler&) = delete;
+
+    // 'onDone' roda na thread do agendador quando o plano termina sozinho
+    // (não depois de Stop()).
+    bool Start(const TxPlan& plan, SendFn send, DoneFn onDone);
+    void Stop();                          // interrompe e junta a thread
+    bool Running() const { return m_running.load(std::memory_order_acquire); }
+
+    // Gancho do pipeline da sessão (thread de RX).
+    void OnRx(const uint8_t* data, size_t len, int64_t nowNs);
+
+    TxScheduleReport Report() const;
+
+private:
+    struct StreamState {
+        int64_t  lastSendNs = 0;
+        uint64_t fired = 0;           // prazos atendidos ou pulados (para 'count')
+        double   lateSumNs = 0;
+        int64_t  lateMaxNs = 0;
+        double   intervalDevSumNs = 0;
+        uint64_t intervals = 0;
+        int64_t  doneNs = 0;          // 'count' atingido: fim do último período
+    };
+
+    void Run();
+    void FireStream(uint32_t index, int64_t deadlineNs);
+    // Executa passos do roteiro a partir de 'nowNs' até um wait/expect ou o fim.
+    void RunScript(int64_t nowNs);
+    void ScheduleScript(int64_t deadlineNs);
+    void ArmExpect(const std::string& pattern);
+    void RecordLate(int64_t lateNs);      // com m_lock
+
+    TxPlan m_plan;
+    SendFn m_send;
+    DoneFn m_onDone;
+    std::thread m_thread;
+    PreciseTimer m_timer;
+    std::atomic<bool> m_running{ false };
+    std::atomic<bool> m_stop{ false };
+
+    // Só a thread do agendador (as medições de m_state são lidas com m_lock):
+    TimerWheel m_wheel;
+    std::vector<StreamState> m_state;
+    size_t   m_step = 0;
+    uint32_t m_scriptToken = 0;           // ids de roteiro antigos (timeout já resolvido) são ignorados
+    bool     m_scriptDone = true;
+    bool     m_expecting = false;
+    int64_t  m_startNs = 0;
+
+    // Expect (com m_lock; 'm_armed' evita a trava no RX sem expect):
+    std::atomic<bool> m_armed{ false };
+    StreamMatcher m_match;
+    int64_t  m_hitNs = 0;
+
+    mutable std::mutex m_lock;
+    HdrHistogram m_late;                  // ns
+    TxScheduleReport m_report;
+    int64_t  m_endNs = 0;                 // 0 = ainda rodando
+};
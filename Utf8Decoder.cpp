@@ -0,0 +1,207 @@
+// Utf8Decoder.cpp - Decodificação UTF-8 incremental (ver Utf8Decoder.h)
+
+#include "Utf8Decoder.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define UTF8_USE_AVX2 1
+#endif
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#include <emmintrin.h>
+#define UTF8_USE_SSE2 1
+#endif
+
+static const wchar_t kReplacement = 0xFFFD;
+
+// Tamanho da sequência a partir do byte líder (0 = líder inválido).
+static inline size_t SeqLen(uint8_t lead) {
+    if (lead < 0x80) return 1;
+    if (lead < 0xC2) return 0;        // continuação solta ou overlong C0/C1
+    if (lead < 0xE0) return 2;
+    if (lead < 0xF0) return 3;
+    if (lead < 0xF5) return 4;
+    return 0;                         // F5..FF nunca aparecem em UTF-8
+}
+
+// Faixa válida do SEGUNDO byte (tabela 3-7): elimina overlong, surrogates
+// (ED A0..BF) e code points acima de U+10FFFF.
+static inline bool ValidSecond(uint8_t lead, uint8_t b) {
+    switch (lead) {
+    case 0xE0: return b >= 0xA0 && b <= 0xBF;
+    case 0xED: return b >= 0x80 && b <= 0x9F;
+    case 0xF0: return b >= 0x90 && b <= 0xBF;
+    case 0xF4: return b >= 0x80 && b <= 0x8F;
+    default:   return b >= 0x80 && b <= 0xBF;
+    }
+}
+
+static inline bool ValidCont(uint8_t b) { return (b & 0xC0) == 0x80; }
+
+static inline uint32_t DecodeSeq(const uint8_t* s, size_t n) {
+    switch (n) {
+    case 2: return ((uint32_t)(s[0] & 0x1F) << 6) | (s[1] & 0x3F);
+    case 3: return ((uint32_t)(s[0] & 0x0F) << 12) | ((uint32_t)(s[1] & 0x3F) << 6) | (s[2] & 0x3F);
+    default:
+        return ((uint32_t)(s[0] & 0x07) << 18) | ((uint32_t)(s[1] & 0x3F) << 12) |
+               ((uint32_t)(s[2] & 0x3F) << 6) | (s[3] & 0x3F);
+    }
+}
+
+static inline wchar_t* Emit(wchar_t* d, uint32_t cp) {
+    if (sizeof(wchar_t) == 2 && cp >= 0x10000) {
+        cp -= 0x10000;
+        *d++ = (wchar_t)(0xD800 + (cp >> 10));
+        *d++ = (wchar_t)(0xDC00 + (cp & 0x3FF));
+    }
+    else {
+        *d++ = (wchar_t)cp;
+    }
+    return d;
+}
+
+// Copia o prefixo só-ASCII de 'p' alargando para wchar_t. Retorna quantos
+// bytes consumiu (para no primeiro byte >= 0x80).
+static size_t WidenAscii(const uint8_t* p, size_t len, wchar_t* d) {
+    size_t i = 0;
+
+#if defined(UTF8_USE_AVX2)
+    while (i + 32 <= len) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(p + i));
+        if (_mm256_movemask_epi8(v)) break;
+        if (sizeof(wchar_t) == 2) {
+            __m256i lo = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(p + i)));
+            __m256i hi = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(p + i + 16)));
+            _mm256_storeu_si256((__m256i*)(d + i), lo);
+            _mm256_storeu_si256((__m256i*)(d + i + 16), hi);
+        }
+        else {
+            for (size_t k = 0; k < 32; k += 8) {
+                __m256i w = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(p + i + k)));
+                _mm256_storeu_si256((__m256i*)(d + i + k), w);
+            }
+        }
+        i += 32;
+    }
+#endif
+
+#if defined(UTF8_USE_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    while (i + 16 <= len) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(p + i));
+        if (_mm_movemask_epi8(v)) break;   // algum byte >= 0x80
+        __m128i lo = _mm_unpacklo_epi8(v, zero);
+        __m128i hi = _mm_unpackhi_epi8(v, zero);
+        if (sizeof(wchar_t) == 2) {
+            _mm_storeu_si128((__m128i*)(d + i), lo);
+            _mm_storeu_si128((__m128i*)(d + i + 8), hi);
+        }
+        else {
+            _mm_storeu_si128((__m128i*)(d + i), _mm_unpacklo_epi16(lo, zero));
+            _mm_storeu_si128((__m128i*)(d + i + 4), _mm_unpackhi_epi16(lo, zero));
+            _mm_storeu_si128((__m128i*)(d + i + 8), _mm_unpacklo_epi16(hi, zero));
+            _mm_storeu_si128((__m128i*)(d + i + 12), _mm_unpackhi_epi16(hi, zero));
+        }
+        i += 16;
+    }
+#endif
+
+    // Resto (ou CPU sem SIMD): byte a byte até o primeiro não-ASCII.
+    while (i < len && p[i] < 0x80) {
+        d[i] = (wchar_t)p[i];
+        ++i;
+    }
+    return i;
+}
+
+size_t Utf8Decoder::DecodeBody(const uint8_t* p, size_t len, wchar_t* dst, size_t* written) {
+    const uint8_t* end = p + len;
+    wchar_t* d = dst;
+    size_t invalid = 0;
+
+    while (p < end) {
+        if (*p < 0x80) {
+            size_t n = WidenAscii(p, (size_t)(end - p), d);
+            p += n;
+            d += n;
+            continue;
+        }
+
+        size_t n = SeqLen(*p);
+        if (n == 0) {
+            *d++ = kReplacement;
+            ++invalid;
+            ++p;
+            continue;
+        }
+
+        // Valida as continuações disponíveis; no primeiro byte ruim, o trecho
+        // válido até ali vira UM U+FFFD e o byte ruim é reprocessado.
+        size_t avail = (size_t)(end - p);
+        size_t check = n < avail ? n : avail;
+        size_t k = 1;
+        for (; k < check; ++k) {
+            bool ok = (k == 1) ? ValidSecond(p[0], p[1]) : ValidCont(p[k]);
+            if (!ok) break;
+        }
+        if (k < check) {
+            *d++ = kReplacement;
+            ++invalid;
+            p += k;
+            continue;
+        }
+
+        if (avail < n) {
+            // Sequência válida até aqui, mas cortada pelo fim do bloco: guarda.
+            for (size_t j = 0; j < avail; ++j) m_pending[j] = p[j];
+            m_pendingLen = avail;
+            m_pendingNeed = n;
+            p = end;
+            break;
+        }
+
+        d = Emit(d, DecodeSeq(p, n));
+        p += n;
+    }
+
+    *written = (size_t)(d - dst);
+    return invalid;
+}
+
+size_t Utf8Decoder::Decode(const char* data, size_t len, std::wstring& out) {
+    const uint8_t* p = (const uint8_t*)data;
+    const uint8_t* end = p + len;
+
+    size_t base = out.size();
+    out.resize(base + MaxOutput(len));   // só cresce a capacidade na 1ª vez
+    wchar_t* dst = &out[base];
+    wchar_t* d = dst;
+    size_t invalid = 0;
+
+    // 1) Completa a sequência que ficou pendente do bloco anterior:
+    while (m_pendingLen > 0 && p < end) {
+        uint8_t b = *p;
+        bool ok = (m_pendingLen == 1) ? ValidSecond(m_pending[0], b) : ValidCont(b);
+        if (!ok) {
+            // Sequência interrompida: U+FFFD e reprocessa 'b' normalmente.
+            *d++ = kReplacement;
+            ++invalid;
+            Reset();
+            break;
+        }
+        m_pending[m_pendingLen++] = b;
+        ++p;
+        if (m_pendingLen == m_pendingNeed) {
+            d = Emit(d, DecodeSeq(m_pending, m_pendingNeed));
+            Reset();
+        }
+    }
+
+    // 2) Corpo do bloco:
+    size_t written = 0;
+    if (p < end) invalid += DecodeBody(p, (size_t)(end - p), d, &written);
+    d += written;
+
+    out.resize(base + (size_t)(d - dst));
+    m_invalidTotal += invalid;
+    return invalid;
+}
@@ -0,0 +1,48 @@
+// Utf8Decoder.h - Decodificador UTF-8 -> wide incremental (streaming)
+// Objetivo: decodificar o RX bloco a bloco sem perder caracteres cujos bytes
+//           chegaram em ReadFile diferentes.
+//
+//  - Guarda a sequência multibyte incompleta do fim de um bloco e a completa
+//    com o início do próximo.
+//  - Valida conforme a tabela 3-7 do Unicode (sem overlong, sem surrogates,
+//    nada acima de U+10FFFF). Cada trecho inválido vira U+FFFD e é contado.
+//  - Caminho rápido vetorizado (SSE2/AVX2) para trechos só-ASCII, que são
+//    quase todo o tráfego dos nossos dispositivos.
+//  - Escreve num buffer do chamador que é reutilizado: sem alocação por bloco
+//    depois que ele atinge o tamanho de regime.
+//
+// wchar_t de 16 bits (Windows) recebe pares surrogate; de 32 bits (Linux),
+// o code point direto. Não depende de Win32.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class Utf8Decoder {
+public:
+    // Decodifica 'len' bytes e ACRESCENTA o texto em 'out' (não limpa 'out').
+    // Retorna quantos trechos inválidos foram encontrados neste bloco.
+    size_t Decode(const char* data, size_t len, std::wstring& out);
+
+    // Descarta a sequência pendente (ex.: ao trocar de porta).
+    void Reset() { m_pendingLen = 0; m_pendingNeed = 0; }
+
+    // Bytes de uma sequência incompleta aguardando o próximo bloco (0..3).
+    size_t Pending() const { return m_pendingLen; }
+
+    // Total de trechos inválidos desde a criação.
+    uint64_t InvalidCount() const { return m_invalidTotal; }
+
+    // Máximo de wchar_t que Decode() pode gerar para 'len' bytes de entrada.
+    static size_t MaxOutput(size_t len) { return len + 4; }
+
+private:
+    size_t DecodeBody(const uint8_t* p, size_t len, wchar_t* dst, size_t* written);
+
+    uint8_t m_pending[4] = {};
+    size_t m_pendingLen = 0;     // bytes já guardados
+    size_t m_pendingNeed = 0;    // tamanho total esperado da sequência
+    uint64_t m_invalidTotal = 0;
+};